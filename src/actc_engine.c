@@ -0,0 +1,772 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	libastroctc - video capture to file sessions (no Gtk, no preferences or session file)
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code (pipeline moved from headless.c)
+**	19-Oct-2026	Capture branch (file sink choice and linking) shared with the application
+**	19-Oct-2026	Limits counted on the capture queue as in the application
+**	19-Oct-2026	MJPEG cameras
+**	19-Oct-2026	Description narrowed to what the library does
+**
+*/
+
+/*
+    The capture pipeline has no display branch:
+
+    | Camera  |  | Caps   |  | Queue |  | Video   |  | Encoder or |  | Muxer |  | File |
+    | v4l2src |->| Filter |->|       |->| convert |->| caps filt. |->|       |->| sink |-> Video file
+
+    Without an encoder or raw format the camera format goes straight to the muxer. Frame and
+    time limits are counted by a probe on the capture queue, as the application does, from the
+    buffers' running time: the last buffer inside the limit is written and then an end of
+    stream is pushed down the branch so the file is always finalised. The file sink is astrodirectsink (direct_sink.c) when direct i/o or a
+    RAM budget is asked for, otherwise filesink.
+
+    An MJPEG camera (format MJPG or JPEG) is asked for image/jpeg. The frames are recorded as
+    they are without an encoder or raw format (the muxer must take jpeg, eg. avimux), otherwise
+    they are decoded after the caps filter.
+
+    The caller owns the main loop unless actc_run is used. See astroctc.h.
+
+    The writing side, from the capture queue to the file sink, is the same as the capture branch
+    of the application's own pipeline (gst_view_capture.c), which uses the actc_sink and
+    actc_branch functions below for it. The application keeps its elements between recordings,
+    so it creates them itself and only the choice of sink and the linking are shared.
+*/
+
+
+
+/* Includes */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <gst/gst.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <cam.h>
+#include <astroctc.h>
+
+
+/* Defines */
+
+#define ACTC_QUEUE_BUFS 200
+
+
+/* Structures and Typedefs required */
+
+struct _actc_session
+{
+    actc_config_t cfg;						// Strings are copies
+    actc_callbacks_t cb;
+    gpointer user_data;
+    GstElement *pipeline;
+    GstElement *file_sink;
+    GMainLoop *loop;						// actc_run only
+    guint bus_watch_id;
+    guint status_id;
+    frame_chk_t fchk;
+    guint64 buf_count;						// Streaming thread
+    guint64 capt_count;						// Streaming thread (limits)
+    GstClockTime rt_start;
+    int limit_hit;						// 1 last buffer passed, 2 ended
+    guint64 last_count;
+    gint64 start_t;
+    int direct;
+    int eos_sent;
+    int finished;
+    int ok;
+};
+
+
+/* Prototypes */
+
+int actc_api_version();
+int actc_init();
+actc_session_t * actc_session_new(const actc_config_t *, const actc_callbacks_t *, gpointer);
+int actc_start(actc_session_t *);
+void actc_stop(actc_session_t *);
+void actc_abort(actc_session_t *);
+int actc_run(actc_session_t *);
+int actc_stopping(actc_session_t *);
+void actc_get_status(actc_session_t *, actc_status_t *);
+guint64 actc_base_time(actc_session_t *);
+void actc_session_free(actc_session_t *);
+const char * actc_sink_factory(int, guint64);
+int actc_sink_props(GstElement *, int, guint64);
+int actc_branch_list(const actc_branch_t *, GstElement **);
+int actc_branch_link(const actc_branch_t *);
+static int actc_pipeline(actc_session_t *);
+static GstElement * actc_element(char *, char *, const char *, actc_session_t *);
+static int actc_is_jpeg(const char *);
+static GstPadProbeReturn actc_frame_probe(GstPad *, GstPadProbeInfo *, gpointer);
+static GstPadProbeReturn actc_limit_probe(GstPad *, GstPadProbeInfo *, gpointer);
+static gboolean actc_bus_watch(GstBus *, GstMessage *, gpointer);
+static gboolean actc_status_fn(gpointer);
+static void actc_finish(actc_session_t *, int);
+static void actc_msg(actc_session_t *, char *, char *, char *);
+
+extern int direct_sink_register();
+extern void frame_chk_init(frame_chk_t *, int);
+extern void frame_check(frame_chk_t *, gint64, guint64);
+extern void frame_chk_str(frame_chk_t *, char *, int);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-actc_engine.c ";
+static gint actc_ready = FALSE;
+
+
+/* Interface version the library was built with */
+
+int actc_api_version()
+{
+    return ACTC_API_VERSION;
+}
+
+
+/* Initialise GStreamer (if the caller has not) and register the engine's own elements */
+
+int actc_init()
+{
+    if (! gst_is_initialized ())
+	gst_init (NULL, NULL);
+
+    if (g_atomic_int_compare_and_exchange (&actc_ready, FALSE, TRUE))
+	direct_sink_register();
+
+    return TRUE;
+}
+
+
+/* New capture session - the pipeline is built but not started */
+
+actc_session_t * actc_session_new(const actc_config_t *cfg, const actc_callbacks_t *cb, gpointer user_data)
+{
+    actc_session_t *sess;
+
+    sess = (actc_session_t *) calloc(1, sizeof(actc_session_t));
+    sess->cfg = *cfg;
+    sess->user_data = user_data;
+
+    if (cb != NULL)
+	sess->cb = *cb;
+
+    sess->cfg.device = g_strdup (cfg->device);
+    sess->cfg.format = g_strdup (cfg->format);
+    sess->cfg.encoder = g_strdup (cfg->encoder);
+    sess->cfg.raw_format = g_strdup (cfg->raw_format);
+    sess->cfg.muxer = g_strdup (cfg->muxer);
+    sess->cfg.location = g_strdup (cfg->location);
+
+    if (sess->cfg.queue_bufs <= 0)
+	sess->cfg.queue_bufs = ACTC_QUEUE_BUFS;
+
+    frame_chk_init(&(sess->fchk), cfg->fps);
+
+    if (sess->cfg.device == NULL || sess->cfg.muxer == NULL || sess->cfg.location == NULL)
+    {
+	actc_msg(sess, "APP0003", "camera, muxer and location", "");
+	actc_session_free(sess);
+	return NULL;
+    }
+
+    if (actc_pipeline(sess) == FALSE)
+    {
+	actc_session_free(sess);
+	return NULL;
+    }
+
+    return sess;
+}
+
+
+/* Start capturing - bus messages and progress run on the default main context */
+
+int actc_start(actc_session_t *sess)
+{
+    GstBus *bus;
+
+    bus = gst_pipeline_get_bus (GST_PIPELINE (sess->pipeline));
+    sess->bus_watch_id = gst_bus_add_watch (bus, actc_bus_watch, sess);
+    gst_object_unref (bus);
+
+    sess->status_id = g_timeout_add_seconds (1, actc_status_fn, sess);
+
+    if (gst_element_set_state (sess->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    {
+	actc_msg(sess, "CAM0022", "PLAYING", "");
+	actc_finish(sess, FALSE);
+	return FALSE;
+    }
+
+    sess->start_t = g_get_monotonic_time ();
+
+    return TRUE;
+}
+
+
+/* End of stream (the muxer finishes the file and the bus watch ends the session) */
+
+void actc_stop(actc_session_t *sess)
+{
+    if (sess->eos_sent == TRUE || sess->finished == TRUE)
+    	return;
+
+    sess->eos_sent = TRUE;
+    gst_element_send_event (sess->pipeline, gst_event_new_eos ());
+
+    return;
+}
+
+
+/* Give up without waiting for the file to be finished */
+
+void actc_abort(actc_session_t *sess)
+{
+    actc_finish(sess, FALSE);
+
+    return;
+}
+
+
+/* Start and run a main loop until the capture finishes */
+
+int actc_run(actc_session_t *sess)
+{
+    if (actc_start(sess) == FALSE)
+    	return FALSE;
+
+    if (sess->finished == FALSE)
+    {
+	sess->loop = g_main_loop_new (NULL, FALSE);
+	g_main_loop_run (sess->loop);
+	g_main_loop_unref (sess->loop);
+	sess->loop = NULL;
+    }
+
+    return sess->ok;
+}
+
+
+/* End of stream has been sent */
+
+int actc_stopping(actc_session_t *sess)
+{
+    return sess->eos_sent;
+}
+
+
+/* Current progress */
+
+void actc_get_status(actc_session_t *sess, actc_status_t *st)
+{
+    guint64 count;
+
+    memset(st, 0, sizeof(actc_status_t));
+
+    count = sess->buf_count;
+    st->frames = count;
+    st->fps = count - sess->last_count;
+
+    if (sess->start_t > 0)
+	st->secs = (gdouble) (g_get_monotonic_time () - sess->start_t) / G_USEC_PER_SEC;
+
+    st->dropped = sess->fchk.dropped;
+    st->duplicated = sess->fchk.duplicated;
+    st->late = sess->fchk.late;
+    frame_chk_str(&(sess->fchk), st->checks, sizeof(st->checks));
+
+    if (sess->direct == TRUE)
+    {
+	st->direct = TRUE;
+	g_object_get (sess->file_sink, "write-rate", &(st->disk_rate), NULL);
+    }
+
+    return;
+}
+
+
+/* Pipeline base time (add to the frame timestamps for the clock time) */
+
+guint64 actc_base_time(actc_session_t *sess)
+{
+    return gst_element_get_base_time (sess->pipeline);
+}
+
+
+/* Stop and release everything */
+
+void actc_session_free(actc_session_t *sess)
+{
+    if (sess == NULL)
+    	return;
+
+    if (sess->pipeline != NULL)
+    {
+	gst_element_set_state (sess->pipeline, GST_STATE_NULL);
+	gst_object_unref (sess->pipeline);
+    }
+
+    if (sess->bus_watch_id != 0)
+	g_source_remove (sess->bus_watch_id);
+
+    if (sess->status_id != 0)
+	g_source_remove (sess->status_id);
+
+    g_free ((gchar *) sess->cfg.device);
+    g_free ((gchar *) sess->cfg.format);
+    g_free ((gchar *) sess->cfg.encoder);
+    g_free ((gchar *) sess->cfg.raw_format);
+    g_free ((gchar *) sess->cfg.muxer);
+    g_free ((gchar *) sess->cfg.location);
+    free(sess);
+
+    return;
+}
+
+
+/* Create, add and link the capture elements */
+
+static int actc_pipeline(actc_session_t *sess)
+{
+    GstElement *src, *v_filter, *dec, *queue, *convert, *enc, *muxer;
+    GstCaps *caps;
+    GstPad *pad;
+    actc_config_t *cfg;
+    actc_branch_t br;
+    int jpeg;
+
+    cfg = &(sess->cfg);
+    sess->pipeline = gst_pipeline_new ("actc_pipeline");
+    dec = convert = enc = NULL;
+    jpeg = actc_is_jpeg(cfg->format);
+
+    /* Camera source and the video wanted from it */
+    if ((src = actc_element("v4l2src", "v4l2_src", "source", sess)) == NULL)
+    	return FALSE;
+
+    g_object_set (src, "device", cfg->device, NULL);
+
+    if ((v_filter = actc_element("capsfilter", "v_filter", NULL, sess)) == NULL)
+    	return FALSE;
+
+    caps = gst_caps_new_empty_simple ((jpeg == TRUE) ? "image/jpeg" : "video/x-raw");
+
+    if (cfg->width > 0 && cfg->height > 0)
+	gst_caps_set_simple (caps, "width", G_TYPE_INT, cfg->width, "height", G_TYPE_INT, cfg->height, NULL);
+
+    if (cfg->fps > 0)
+	gst_caps_set_simple (caps, "framerate", GST_TYPE_FRACTION, cfg->fps, 1, NULL);
+
+    if (cfg->format != NULL && jpeg == FALSE)
+	gst_caps_set_simple (caps, "format", G_TYPE_STRING, cfg->format, NULL);
+
+    g_object_set (v_filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+
+    /* Jpeg is decoded only if it is to be converted or encoded */
+    if (jpeg == TRUE && (cfg->encoder != NULL || cfg->raw_format != NULL))
+    {
+	if ((dec = actc_element("jpegdec", "j_dec", NULL, sess)) == NULL)
+	    return FALSE;
+    }
+
+    /* Generous queue - the writing side may stall briefly */
+    if ((queue = actc_element("queue", "c_queue", NULL, sess)) == NULL)
+    	return FALSE;
+
+    g_object_set (queue, "max-size-buffers", cfg->queue_bufs, "max-size-bytes", 0,
+    			 "max-size-time", (guint64) 0, NULL);
+
+    /* Encoder or raw format (neither - the camera format is captured as is) */
+    if (cfg->encoder != NULL || cfg->raw_format != NULL)
+    {
+	if ((convert = actc_element("videoconvert", "c_convert", NULL, sess)) == NULL)
+	    return FALSE;
+
+	if (cfg->encoder != NULL)
+	{
+	    if ((enc = actc_element((char *) cfg->encoder, "encoder", "encoder", sess)) == NULL)
+		return FALSE;
+	}
+	else
+	{
+	    if ((enc = actc_element("capsfilter", "c_filter", NULL, sess)) == NULL)
+		return FALSE;
+
+	    caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, cfg->raw_format, NULL);
+	    g_object_set (enc, "caps", caps, NULL);
+	    gst_caps_unref (caps);
+	}
+    }
+
+    if ((muxer = actc_element((char *) cfg->muxer, "muxer", "muxer", sess)) == NULL)
+    	return FALSE;
+
+    /* File sink */
+    if ((sess->file_sink = actc_element((char *) actc_sink_factory(cfg->direct, cfg->ram_budget),
+    					"file_sink", NULL, sess)) == NULL)
+	return FALSE;
+
+    sess->direct = actc_sink_props(sess->file_sink, cfg->direct, cfg->ram_budget);
+    g_object_set (sess->file_sink, "location", cfg->location, NULL);
+
+    if (sess->cb.element != NULL)
+	sess->cb.element(sess, "file_sink", sess->file_sink, sess->user_data);
+
+    /* Link */
+    br.queue = queue;
+    br.convert = convert;
+    br.encoder = enc;
+    br.muxer = muxer;
+    br.file_sink = sess->file_sink;
+
+    if (! gst_element_link (src, v_filter) ||
+	(dec != NULL && ! gst_element_link_many (v_filter, dec, queue, NULL)) ||
+	(dec == NULL && ! gst_element_link (v_filter, queue)) ||
+	actc_branch_link(&br) == FALSE)
+    {
+	actc_msg(sess, "CAM0021", NULL, "");
+	return FALSE;
+    }
+
+    /* Count frames, driver checks and timestamps straight off the camera */
+    pad = gst_element_get_static_pad (src, "src");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, actc_frame_probe, sess, NULL);
+    gst_object_unref (pad);
+
+    /* Limits on what is written */
+    if (cfg->frames > 0 || cfg->secs > 0)
+    {
+	pad = gst_element_get_static_pad (queue, "src");
+	gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, actc_limit_probe, sess, NULL);
+	gst_object_unref (pad);
+    }
+
+    return TRUE;
+}
+
+
+/* File sink element for a capture - the direct sink for direct i/o or RAM staging */
+
+const char * actc_sink_factory(int direct, guint64 ram_budget)
+{
+    if (direct || ram_budget > 0)
+    	return "astrodirectsink";
+    else
+    	return "filesink";
+}
+
+
+/* Set the file sink properties (none for filesink), returns TRUE if it is the direct sink */
+
+int actc_sink_props(GstElement *sink, int direct, guint64 ram_budget)
+{
+    if (strcmp(GST_OBJECT_NAME (gst_element_get_factory (sink)), "astrodirectsink") != 0)
+    	return FALSE;
+
+    g_object_set (sink, "direct", (gboolean) direct, "ram-budget", ram_budget, NULL);
+
+    return TRUE;
+}
+
+
+/* Capture branch elements after the queue (upstream first, the optional ones skipped) */
+
+int actc_branch_list(const actc_branch_t *br, GstElement **elements)
+{
+    int n;
+
+    n = 0;
+
+    if (br->convert != NULL)
+	elements[n++] = br->convert;
+
+    if (br->encoder != NULL)
+	elements[n++] = br->encoder;
+
+    elements[n++] = br->muxer;
+    elements[n++] = br->file_sink;
+
+    return n;
+}
+
+
+/* Link a capture branch from the queue to the file sink (all the elements already added) */
+
+int actc_branch_link(const actc_branch_t *br)
+{
+    GstElement *elements[ACTC_BRANCH_MAX];
+    int i, n;
+
+    n = actc_branch_list(br, elements);
+
+    if (! gst_element_link (br->queue, elements[0]))
+    	return FALSE;
+
+    for(i = 1; i < n; i++)
+    {
+	if (! gst_element_link (elements[i - 1], elements[i]))
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* MJPEG camera format */
+
+static int actc_is_jpeg(const char *format)
+{
+    if (format == NULL)
+    	return FALSE;
+
+    return (strcmp(format, "MJPG") == 0 || strcmp(format, "JPEG") == 0);
+}
+
+
+/* Create an element and add it to the pipeline (the caller may set properties on some) */
+
+static GstElement * actc_element(char *factory_nm, char *nm, const char *role, actc_session_t *sess)
+{
+    GstElement *element;
+    char s[100];
+
+    if ((element = gst_element_factory_make (factory_nm, nm)) == NULL)
+    {
+	snprintf(s, sizeof(s), "Element: %s", factory_nm);
+	actc_msg(sess, "CAM0020", NULL, s);
+	return NULL;
+    }
+
+    gst_bin_add (GST_BIN (sess->pipeline), element);
+
+    if (role != NULL && sess->cb.element != NULL)
+	sess->cb.element(sess, role, element, sess->user_data);
+
+    return element;
+}
+
+
+/* Probe (streaming thread) - frame count, driver checks and the caller's frame callback */
+
+static GstPadProbeReturn actc_frame_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    actc_session_t *sess;
+    GstBuffer *buf;
+    gint64 seq;
+
+    sess = (actc_session_t *) user_data;
+    buf = GST_PAD_PROBE_INFO_BUFFER (info);
+    sess->buf_count++;
+
+    if (! GST_BUFFER_PTS_IS_VALID (buf))
+    	return GST_PAD_PROBE_OK;
+
+    seq = (GST_BUFFER_OFFSET_IS_VALID (buf)) ? (gint64) GST_BUFFER_OFFSET (buf) : -1;
+    frame_check(&(sess->fchk), seq, GST_BUFFER_PTS (buf));
+
+    if (sess->cb.frame != NULL)
+	sess->cb.frame(sess, sess->buf_count, seq, GST_BUFFER_PTS (buf), sess->user_data);
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+// Probe (streaming thread) - count buffers and running time on the capture queue. The rules
+// are those of the application's capture limit probe (gst_view_capture.c) so both stop on the
+// same frame: the last buffer within the limit is passed, then the branch is ended and any
+// later buffers are dropped. The end of stream reaching the sink finishes the session.
+
+static GstPadProbeReturn actc_limit_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    actc_session_t *sess;
+    GstBuffer *buf;
+    GstEvent *seg_ev;
+    const GstSegment *segment;
+    GstClockTime rt, dur, limit;
+
+    sess = (actc_session_t *) user_data;
+
+    /* Past the limit - make sure the branch is ended and drop */
+    if (sess->limit_hit != 0)
+    {
+    	if (sess->limit_hit == 1)
+    	{
+	    sess->limit_hit = 2;
+	    gst_pad_push_event (pad, gst_event_new_eos ());
+    	}
+
+	return GST_PAD_PROBE_DROP;
+    }
+
+    /* Running time of the buffer */
+    buf = GST_PAD_PROBE_INFO_BUFFER (info);
+    rt = GST_BUFFER_PTS (buf);
+    dur = GST_BUFFER_DURATION (buf);
+
+    if ((seg_ev = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0)) != NULL)
+    {
+	gst_event_parse_segment (seg_ev, &segment);
+	rt = gst_segment_to_running_time (segment, GST_FORMAT_TIME, rt);
+	gst_event_unref (seg_ev);
+    }
+
+    if (! GST_CLOCK_TIME_IS_VALID (dur))
+    	dur = 0;
+
+    if (sess->capt_count == 0)
+	sess->rt_start = rt;
+
+    /* Check the limits */
+    if (sess->cfg.secs > 0 && GST_CLOCK_TIME_IS_VALID (rt))
+    {
+	limit = (GstClockTime) sess->cfg.secs * GST_SECOND;
+
+	if (rt - sess->rt_start >= limit)
+	{
+	    sess->limit_hit = 2;
+	    gst_pad_push_event (pad, gst_event_new_eos ());
+	    return GST_PAD_PROBE_DROP;
+	}
+
+	if (rt - sess->rt_start + dur >= limit)
+	    sess->limit_hit = 1;
+    }
+
+    if (sess->cfg.frames > 0 && sess->capt_count + 1 >= (guint64) sess->cfg.frames)
+	sess->limit_hit = 1;
+
+    sess->capt_count++;
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+/* Bus messages - errors and end of stream finish the session */
+
+static gboolean actc_bus_watch(GstBus *bus, GstMessage *msg, gpointer user_data)
+{
+    actc_session_t *sess;
+    GError *err = NULL;
+    gchar *msg_str = NULL;
+    char s[1000];
+
+    sess = (actc_session_t *) user_data;
+
+    switch GST_MESSAGE_TYPE (msg)
+    {
+	case GST_MESSAGE_ERROR:
+	    gst_message_parse_error (msg, &err, &msg_str);
+	    snprintf(s, sizeof(s), "Error received from element %s: %s (%s)",
+		     GST_OBJECT_NAME (msg->src), err->message, (msg_str != NULL) ? msg_str : "");
+	    actc_msg(sess, "CAM0023", "Capture", s);
+	    g_error_free (err);
+	    g_free (msg_str);
+	    actc_finish(sess, FALSE);
+	    break;
+
+	case GST_MESSAGE_WARNING:
+	    gst_message_parse_warning (msg, &err, &msg_str);
+	    snprintf(s, sizeof(s), "Warning received from element %s: %s",
+		     GST_OBJECT_NAME (msg->src), err->message);
+	    actc_msg(sess, "CAM0023", "Capture", s);
+	    g_error_free (err);
+	    g_free (msg_str);
+	    break;
+
+	case GST_MESSAGE_EOS:
+	    actc_finish(sess, TRUE);
+	    break;
+
+	default:
+	    break;
+    }
+
+    return TRUE;
+}
+
+
+/* Progress once a second */
+
+static gboolean actc_status_fn(gpointer user_data)
+{
+    actc_session_t *sess;
+    actc_status_t st;
+
+    sess = (actc_session_t *) user_data;
+    actc_get_status(sess, &st);
+    sess->last_count = st.frames;
+
+    if (sess->cb.status != NULL)
+	sess->cb.status(sess, &st, sess->user_data);
+
+    return TRUE;
+}
+
+
+/* The session is over - stop the timers and tell the caller (once) */
+
+static void actc_finish(actc_session_t *sess, int ok)
+{
+    if (sess->finished == TRUE)
+    	return;
+
+    sess->finished = TRUE;
+    sess->ok = ok;
+
+    if (sess->status_id != 0)
+    {
+	g_source_remove (sess->status_id);
+	sess->status_id = 0;
+    }
+
+    if (sess->cb.finished != NULL)
+	sess->cb.finished(sess, ok, sess->user_data);
+
+    if (sess->loop != NULL)
+	g_main_loop_quit (sess->loop);
+
+    return;
+}
+
+
+/* Pass a message to the caller (stderr if there is no message callback) */
+
+static void actc_msg(actc_session_t *sess, char *msg_id, char *opt, char *detail)
+{
+    if (sess->cb.message != NULL)
+    {
+	sess->cb.message(sess, msg_id, opt, detail, sess->user_data);
+	return;
+    }
+
+    fprintf(stderr, "libastroctc: %s %s %s\n", msg_id, (opt != NULL) ? opt : "", detail);
+
+    return;
+}
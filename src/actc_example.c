@@ -0,0 +1,101 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+** Description:	Example libastroctc consumer - capture a number of frames, as captured, to a
+**		Matroska file with no display, preferences or Gtk.
+**
+**		actc_example /dev/video0 500 /tmp/test.mkv
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Includes */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <astroctc.h>
+
+
+/* Prototypes */
+
+static void ex_msg(actc_session_t *, const char *, const char *, const char *, gpointer);
+static void ex_status(actc_session_t *, const actc_status_t *, gpointer);
+
+
+/* Capture and report */
+
+int main(int argc, char *argv[])
+{
+    actc_config_t cfg;
+    actc_callbacks_t cb;
+    actc_session_t *sess;
+    int ok;
+
+    if (argc != 4)
+    {
+	fprintf(stderr, "usage: %s device frames file.mkv\n", argv[0]);
+	return EXIT_FAILURE;
+    }
+
+    actc_init();
+
+    memset(&cfg, 0, sizeof(actc_config_t));
+    cfg.device = argv[1];
+    cfg.frames = atol(argv[2]);
+    cfg.muxer = "matroskamux";
+    cfg.location = argv[3];
+
+    memset(&cb, 0, sizeof(actc_callbacks_t));
+    cb.message = ex_msg;
+    cb.status = ex_status;
+
+    if ((sess = actc_session_new(&cfg, &cb, NULL)) == NULL)
+    	return EXIT_FAILURE;
+
+    ok = actc_run(sess);
+    actc_session_free(sess);
+
+    return (ok == TRUE) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/* Engine messages */
+
+static void ex_msg(actc_session_t *sess, const char *msg_id, const char *opt, const char *detail, gpointer user_data)
+{
+    fprintf(stderr, "%s %s %s\n", msg_id, (opt != NULL) ? opt : "", detail);
+}
+
+
+/* Progress */
+
+static void ex_status(actc_session_t *sess, const actc_status_t *st, gpointer user_data)
+{
+    printf("%.0fs  %" G_GUINT64_FORMAT " frames  %" G_GUINT64_FORMAT " fps%s\n",
+    	   st->secs, st->frames, st->fps, st->checks);
+}
@@ -0,0 +1,1655 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Frame processing elements - statistics, dark calibration, binning, stacking, stretch
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+/*
+    Video filters for the usual astro frame processing. They are registered by the application
+    at start up (so they may be used in the processing preferences, see gst_view_capture.c) and
+    are also built as a GStreamer plugin (astro_plugin.c) for use with gst-launch-1.0, eg.
+
+	GST_PLUGIN_PATH=. gst-launch-1.0 -m filesrc location=m42.mkv ! matroskademux ! \
+		videoconvert ! astrobin factor=2 ! astrostack frames=8 ! astrostretch auto=true ! \
+		videoconvert ! autovideosink
+
+    All work on GRAY8, GRAY16_LE and the 8 bit packed RGB formats (colour first). Each colour
+    sample is processed independently; padding and alpha are left alone. The base transform
+    does the caps negotiation and buffer pools; all but astrobin work in place.
+
+	astrostats	Passthrough. Mean, standard deviation, minimum, maximum and saturated
+			fraction every 'interval' frames, posted as an 'astrostats' element message.
+	astrocalib	Dark subtraction. Setting 'learn' averages the next 'frames' frames into
+			a master dark (lens capped) which is then subtracted, plus an 'offset'.
+			The dark may be saved to and loaded from 'location'.
+	astrobin	Software binning, 'factor' x 'factor' samples averaged (or summed).
+	astrostack	Running mean of the last 'frames' frames.
+	astrostretch	Linear stretch between 'black' and 'white' with 'gamma', or automatically
+			from the frame histogram.
+*/
+
+
+/* Defines */
+
+#define AF_FORMATS "{ GRAY8, GRAY16_LE, RGB, BGR, RGBx, BGRx, RGBA, BGRA }"
+#define AF_AUTO_FRAMES 10
+#define AF_DARK_MAGIC "ACTCDARK"
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/video/gstvideofilter.h>
+
+
+/* Structures and Typedefs required */
+
+typedef struct _af_layout
+{
+    int depth;							// Bits per sample (8 or 16)
+    int bps;							// Bytes per sample
+    int ncomp;							// Colour samples per pixel
+    int pstride;						// Bytes per pixel
+    guint maxval;
+} af_layout_t;
+
+typedef struct _AstroStats
+{
+    GstVideoFilter parent;
+    guint interval;						// Properties
+    gdouble mean, stddev, saturated;
+    guint min, max;
+    guint64 count;
+    af_layout_t lay;
+} AstroStats;
+
+typedef struct _AstroCalib
+{
+    GstVideoFilter parent;
+    guint frames;						// Properties
+    guint offset;
+    gchar *location;
+    gboolean learn;
+    gboolean has_dark;
+    gboolean learn_req;
+    guint32 *acc;						// Learning
+    guint got;
+    guint16 *dark;						// Master dark
+    gsize n_samples;
+    int width, height;
+    af_layout_t lay;
+} AstroCalib;
+
+typedef struct _AstroBin
+{
+    GstVideoFilter parent;
+    guint factor;						// Properties
+    gboolean sum;
+    af_layout_t lay;
+} AstroBin;
+
+typedef struct _AstroStack
+{
+    GstVideoFilter parent;
+    guint frames;						// Property
+    guint n;							// Ring in use
+    guint16 *ring;
+    guint32 *acc;
+    guint head, filled;
+    gsize n_samples;
+    af_layout_t lay;
+} AstroStack;
+
+typedef struct _AstroStretch
+{
+    GstVideoFilter parent;
+    gdouble black, white, gamma;				// Properties
+    gboolean autolvl;
+    gboolean dirty;
+    guint16 *lut;
+    guint64 count;
+    af_layout_t lay;
+} AstroStretch;
+
+typedef struct _AstroStatsClass { GstVideoFilterClass parent_class; } AstroStatsClass;
+typedef struct _AstroCalibClass { GstVideoFilterClass parent_class; } AstroCalibClass;
+typedef struct _AstroBinClass { GstVideoFilterClass parent_class; } AstroBinClass;
+typedef struct _AstroStackClass { GstVideoFilterClass parent_class; } AstroStackClass;
+typedef struct _AstroStretchClass { GstVideoFilterClass parent_class; } AstroStretchClass;
+
+enum { ST_PROP_0, ST_PROP_INTERVAL, ST_PROP_MEAN, ST_PROP_STDDEV, ST_PROP_MIN, ST_PROP_MAX, ST_PROP_SATURATED };
+enum { CL_PROP_0, CL_PROP_FRAMES, CL_PROP_OFFSET, CL_PROP_LOCATION, CL_PROP_LEARN, CL_PROP_HAS_DARK };
+enum { BN_PROP_0, BN_PROP_FACTOR, BN_PROP_SUM };
+enum { SK_PROP_0, SK_PROP_FRAMES };
+enum { SR_PROP_0, SR_PROP_BLACK, SR_PROP_WHITE, SR_PROP_GAMMA, SR_PROP_AUTO };
+
+
+/* Prototypes */
+
+GType astro_stats_get_type(void);
+GType astro_calib_get_type(void);
+GType astro_bin_get_type(void);
+GType astro_stack_get_type(void);
+GType astro_stretch_get_type(void);
+int astro_filters_register(GstPlugin *);
+static void af_class_common(GstElementClass *, const char *, const char *);
+static void af_layout(GstVideoInfo *, af_layout_t *);
+static inline guint af_get(const guint8 *, int);
+static inline void af_put(guint8 *, int, guint);
+
+static void astro_stats_class_init(AstroStatsClass *);
+static void astro_stats_init(AstroStats *);
+static void st_set_property(GObject *, guint, const GValue *, GParamSpec *);
+static void st_get_property(GObject *, guint, GValue *, GParamSpec *);
+static gboolean st_set_info(GstVideoFilter *, GstCaps *, GstVideoInfo *, GstCaps *, GstVideoInfo *);
+static GstFlowReturn st_transform_ip(GstVideoFilter *, GstVideoFrame *);
+
+static void astro_calib_class_init(AstroCalibClass *);
+static void astro_calib_init(AstroCalib *);
+static void cl_set_property(GObject *, guint, const GValue *, GParamSpec *);
+static void cl_get_property(GObject *, guint, GValue *, GParamSpec *);
+static void cl_finalize(GObject *);
+static gboolean cl_set_info(GstVideoFilter *, GstCaps *, GstVideoInfo *, GstCaps *, GstVideoInfo *);
+static GstFlowReturn cl_transform_ip(GstVideoFilter *, GstVideoFrame *);
+static void cl_dark_done(AstroCalib *);
+static int cl_dark_load(AstroCalib *);
+static int cl_dark_save(AstroCalib *);
+
+static void astro_bin_class_init(AstroBinClass *);
+static void astro_bin_init(AstroBin *);
+static void bn_set_property(GObject *, guint, const GValue *, GParamSpec *);
+static void bn_get_property(GObject *, guint, GValue *, GParamSpec *);
+static GstCaps * bn_transform_caps(GstBaseTransform *, GstPadDirection, GstCaps *, GstCaps *);
+static void bn_scale_dim(GstStructure *, const char *, guint, int);
+static gboolean bn_set_info(GstVideoFilter *, GstCaps *, GstVideoInfo *, GstCaps *, GstVideoInfo *);
+static GstFlowReturn bn_transform(GstVideoFilter *, GstVideoFrame *, GstVideoFrame *);
+
+static void astro_stack_class_init(AstroStackClass *);
+static void astro_stack_init(AstroStack *);
+static void sk_set_property(GObject *, guint, const GValue *, GParamSpec *);
+static void sk_get_property(GObject *, guint, GValue *, GParamSpec *);
+static void sk_finalize(GObject *);
+static gboolean sk_set_info(GstVideoFilter *, GstCaps *, GstVideoInfo *, GstCaps *, GstVideoInfo *);
+static gboolean sk_sink_event(GstBaseTransform *, GstEvent *);
+static gboolean sk_stop(GstBaseTransform *);
+static GstFlowReturn sk_transform_ip(GstVideoFilter *, GstVideoFrame *);
+static void sk_reset(AstroStack *);
+
+static void astro_stretch_class_init(AstroStretchClass *);
+static void astro_stretch_init(AstroStretch *);
+static void sr_set_property(GObject *, guint, const GValue *, GParamSpec *);
+static void sr_get_property(GObject *, guint, GValue *, GParamSpec *);
+static void sr_finalize(GObject *);
+static gboolean sr_set_info(GstVideoFilter *, GstCaps *, GstVideoInfo *, GstCaps *, GstVideoInfo *);
+static GstFlowReturn sr_transform_ip(GstVideoFilter *, GstVideoFrame *);
+static void sr_auto_levels(AstroStretch *, GstVideoFrame *);
+static void sr_build_lut(AstroStretch *);
+
+#define ASTRO_TYPE_STATS (astro_stats_get_type())
+#define ASTRO_TYPE_CALIB (astro_calib_get_type())
+#define ASTRO_TYPE_BIN (astro_bin_get_type())
+#define ASTRO_TYPE_STACK (astro_stack_get_type())
+#define ASTRO_TYPE_STRETCH (astro_stretch_get_type())
+#define ASTRO_STATS(obj) ((AstroStats *) (obj))
+#define ASTRO_CALIB(obj) ((AstroCalib *) (obj))
+#define ASTRO_BIN(obj) ((AstroBin *) (obj))
+#define ASTRO_STACK(obj) ((AstroStack *) (obj))
+#define ASTRO_STRETCH(obj) ((AstroStretch *) (obj))
+
+G_DEFINE_TYPE (AstroStats, astro_stats, GST_TYPE_VIDEO_FILTER);
+G_DEFINE_TYPE (AstroCalib, astro_calib, GST_TYPE_VIDEO_FILTER);
+G_DEFINE_TYPE (AstroBin, astro_bin, GST_TYPE_VIDEO_FILTER);
+G_DEFINE_TYPE (AstroStack, astro_stack, GST_TYPE_VIDEO_FILTER);
+G_DEFINE_TYPE (AstroStretch, astro_stretch, GST_TYPE_VIDEO_FILTER);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-astro_filters.c ";
+
+static GstStaticPadTemplate af_sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+								      GST_PAD_SINK,
+								      GST_PAD_ALWAYS,
+								      GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (AF_FORMATS)));
+
+static GstStaticPadTemplate af_src_template = GST_STATIC_PAD_TEMPLATE ("src",
+								     GST_PAD_SRC,
+								     GST_PAD_ALWAYS,
+								     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (AF_FORMATS)));
+
+
+/* Register the elements - with the application (plugin NULL) or as a plugin */
+
+int astro_filters_register(GstPlugin *plugin)
+{
+    if (! gst_element_register (plugin, "astrostats", GST_RANK_NONE, ASTRO_TYPE_STATS))
+    	return FALSE;
+
+    if (! gst_element_register (plugin, "astrocalib", GST_RANK_NONE, ASTRO_TYPE_CALIB))
+    	return FALSE;
+
+    if (! gst_element_register (plugin, "astrobin", GST_RANK_NONE, ASTRO_TYPE_BIN))
+    	return FALSE;
+
+    if (! gst_element_register (plugin, "astrostack", GST_RANK_NONE, ASTRO_TYPE_STACK))
+    	return FALSE;
+
+    if (! gst_element_register (plugin, "astrostretch", GST_RANK_NONE, ASTRO_TYPE_STRETCH))
+    	return FALSE;
+
+    return TRUE;
+}
+
+
+/* Pad templates and metadata common to all the elements */
+
+static void af_class_common(GstElementClass *element_class, const char *nm, const char *desc)
+{
+    gst_element_class_add_static_pad_template (element_class, &af_sink_template);
+    gst_element_class_add_static_pad_template (element_class, &af_src_template);
+    gst_element_class_set_static_metadata (element_class, nm, "Filter/Effect/Video", desc,
+					   "Anthony Buckley <tony.buckley000@gmail.com>");
+
+    return;
+}
+
+
+/* Sample layout of the negotiated format */
+
+static void af_layout(GstVideoInfo *info, af_layout_t *lay)
+{
+    lay->depth = GST_VIDEO_INFO_COMP_DEPTH (info, 0);
+    lay->bps = (lay->depth > 8) ? 2 : 1;
+    lay->ncomp = GST_VIDEO_INFO_IS_GRAY (info) ? 1 : 3;
+    lay->pstride = GST_VIDEO_INFO_COMP_PSTRIDE (info, 0);
+    lay->maxval = (1 << lay->depth) - 1;
+
+    return;
+}
+
+
+/* Read a sample */
+
+static inline guint af_get(const guint8 *p, int depth)
+{
+    return (depth > 8) ? GST_READ_UINT16_LE (p) : *p;
+}
+
+
+/* Write a sample */
+
+static inline void af_put(guint8 *p, int depth, guint v)
+{
+    if (depth > 8)
+	GST_WRITE_UINT16_LE (p, v);
+    else
+	*p = (guint8) v;
+
+    return;
+}
+
+
+
+
+/*  ** astrostats **  */
+
+
+/* Class setup */
+
+static void astro_stats_class_init(AstroStatsClass *klass)
+{
+    GObjectClass *gobject_class;
+    GstBaseTransformClass *trans_class;
+    GstVideoFilterClass *vfilter_class;
+
+    gobject_class = G_OBJECT_CLASS (klass);
+    trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+    vfilter_class = GST_VIDEO_FILTER_CLASS (klass);
+
+    gobject_class->set_property = st_set_property;
+    gobject_class->get_property = st_get_property;
+
+    g_object_class_install_property (gobject_class, ST_PROP_INTERVAL,
+	g_param_spec_uint ("interval", "Interval", "Frames between measurements",
+			   1, G_MAXUINT, 25, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, ST_PROP_MEAN,
+	g_param_spec_double ("mean", "Mean", "Mean sample value (last measurement)",
+			     0, G_MAXDOUBLE, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, ST_PROP_STDDEV,
+	g_param_spec_double ("stddev", "Standard deviation", "Sample standard deviation (last measurement)",
+			     0, G_MAXDOUBLE, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, ST_PROP_MIN,
+	g_param_spec_uint ("min", "Minimum", "Lowest sample value (last measurement)",
+			   0, G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, ST_PROP_MAX,
+	g_param_spec_uint ("max", "Maximum", "Highest sample value (last measurement)",
+			   0, G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, ST_PROP_SATURATED,
+	g_param_spec_double ("saturated", "Saturated", "Fraction of samples at full scale (last measurement)",
+			     0, 1, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+    af_class_common (GST_ELEMENT_CLASS (klass), "AstroCTC frame statistics",
+		     "Frame level statistics posted as element messages");
+
+    trans_class->transform_ip_on_passthrough = TRUE;
+    vfilter_class->set_info = st_set_info;
+    vfilter_class->transform_frame_ip = st_transform_ip;
+
+    return;
+}
+
+
+/* Instance defaults - the frames are only looked at */
+
+static void astro_stats_init(AstroStats *st)
+{
+    st->interval = 25;
+    gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (st), TRUE);
+
+    return;
+}
+
+
+/* Set a property */
+
+static void st_set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    AstroStats *st = ASTRO_STATS (object);
+
+    switch (prop_id)
+    {
+	case ST_PROP_INTERVAL:
+	    GST_OBJECT_LOCK (st);
+	    st->interval = g_value_get_uint (value);
+	    GST_OBJECT_UNLOCK (st);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    return;
+}
+
+
+/* Get a property */
+
+static void st_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    AstroStats *st = ASTRO_STATS (object);
+
+    GST_OBJECT_LOCK (st);
+
+    switch (prop_id)
+    {
+	case ST_PROP_INTERVAL:
+	    g_value_set_uint (value, st->interval);
+	    break;
+
+	case ST_PROP_MEAN:
+	    g_value_set_double (value, st->mean);
+	    break;
+
+	case ST_PROP_STDDEV:
+	    g_value_set_double (value, st->stddev);
+	    break;
+
+	case ST_PROP_MIN:
+	    g_value_set_uint (value, st->min);
+	    break;
+
+	case ST_PROP_MAX:
+	    g_value_set_uint (value, st->max);
+	    break;
+
+	case ST_PROP_SATURATED:
+	    g_value_set_double (value, st->saturated);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    GST_OBJECT_UNLOCK (st);
+
+    return;
+}
+
+
+/* Negotiated format */
+
+static gboolean st_set_info(GstVideoFilter *filter, GstCaps *incaps, GstVideoInfo *in_info,
+			    GstCaps *outcaps, GstVideoInfo *out_info)
+{
+    af_layout(in_info, &(ASTRO_STATS (filter)->lay));
+
+    return TRUE;
+}
+
+
+/* Measure a frame every interval and post the results */
+
+static GstFlowReturn st_transform_ip(GstVideoFilter *filter, GstVideoFrame *frame)
+{
+    AstroStats *st = ASTRO_STATS (filter);
+    af_layout_t *lay = &(st->lay);
+    const guint8 *row, *p;
+    guint64 n, sat;
+    gdouble sum, sumsq, mean, sd;
+    guint v, lo, hi, interval;
+    int x, y, c, w, h, stride;
+
+    GST_OBJECT_LOCK (st);
+    interval = st->interval;
+    GST_OBJECT_UNLOCK (st);
+
+    if ((st->count++ % interval) != 0)
+    	return GST_FLOW_OK;
+
+    w = GST_VIDEO_FRAME_WIDTH (frame);
+    h = GST_VIDEO_FRAME_HEIGHT (frame);
+    stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+    row = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+
+    sum = 0;
+    sumsq = 0;
+    sat = 0;
+    lo = lay->maxval;
+    hi = 0;
+
+    for(y = 0; y < h; y++, row += stride)
+    {
+	for(x = 0, p = row; x < w; x++, p += lay->pstride)
+	{
+	    for(c = 0; c < lay->ncomp; c++)
+	    {
+		v = af_get(p + c * lay->bps, lay->depth);
+		sum += v;
+		sumsq += (gdouble) v * v;
+
+		if (v < lo)
+		    lo = v;
+
+		if (v > hi)
+		    hi = v;
+
+		if (v >= lay->maxval)
+		    sat++;
+	    }
+	}
+    }
+
+    n = (guint64) w * h * lay->ncomp;
+
+    if (n == 0)
+    	return GST_FLOW_OK;
+
+    mean = sum / n;
+    sd = sqrt(MAX(sumsq / n - mean * mean, 0));
+
+    GST_OBJECT_LOCK (st);
+    st->mean = mean;
+    st->stddev = sd;
+    st->min = lo;
+    st->max = hi;
+    st->saturated = (gdouble) sat / n;
+    GST_OBJECT_UNLOCK (st);
+
+    gst_element_post_message (GST_ELEMENT (st),
+    			      gst_message_new_element (GST_OBJECT (st),
+			      	  gst_structure_new ("astrostats",
+						     "frame", G_TYPE_UINT64, st->count - 1,
+						     "timestamp", G_TYPE_UINT64, GST_BUFFER_PTS (frame->buffer),
+						     "mean", G_TYPE_DOUBLE, mean,
+						     "stddev", G_TYPE_DOUBLE, sd,
+						     "min", G_TYPE_UINT, lo,
+						     "max", G_TYPE_UINT, hi,
+						     "saturated", G_TYPE_DOUBLE, (gdouble) sat / n,
+						     NULL)));
+
+    return GST_FLOW_OK;
+}
+
+
+
+
+/*  ** astrocalib **  */
+
+
+/* Class setup */
+
+static void astro_calib_class_init(AstroCalibClass *klass)
+{
+    GObjectClass *gobject_class;
+    GstVideoFilterClass *vfilter_class;
+
+    gobject_class = G_OBJECT_CLASS (klass);
+    vfilter_class = GST_VIDEO_FILTER_CLASS (klass);
+
+    gobject_class->set_property = cl_set_property;
+    gobject_class->get_property = cl_get_property;
+    gobject_class->finalize = cl_finalize;
+
+    g_object_class_install_property (gobject_class, CL_PROP_FRAMES,
+	g_param_spec_uint ("frames", "Dark frames", "Frames averaged for the master dark",
+			   1, 1024, 16, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, CL_PROP_OFFSET,
+	g_param_spec_uint ("offset", "Offset", "Pedestal added after the dark is subtracted",
+			   0, 65535, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, CL_PROP_LOCATION,
+	g_param_spec_string ("location", "Dark file", "Master dark is loaded from and saved to this file",
+			     NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, CL_PROP_LEARN,
+	g_param_spec_boolean ("learn", "Learn", "Take a new master dark from the next frames (TRUE while doing so)",
+			      FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, CL_PROP_HAS_DARK,
+	g_param_spec_boolean ("has-dark", "Has dark", "A master dark is being subtracted",
+			      FALSE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+    af_class_common (GST_ELEMENT_CLASS (klass), "AstroCTC dark calibration",
+		     "Subtracts a master dark taken from the stream or loaded from file");
+
+    vfilter_class->set_info = cl_set_info;
+    vfilter_class->transform_frame_ip = cl_transform_ip;
+
+    return;
+}
+
+
+/* Instance defaults */
+
+static void astro_calib_init(AstroCalib *cl)
+{
+    cl->frames = 16;
+
+    return;
+}
+
+
+/* Set a property */
+
+static void cl_set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    AstroCalib *cl = ASTRO_CALIB (object);
+
+    GST_OBJECT_LOCK (cl);
+
+    switch (prop_id)
+    {
+	case CL_PROP_FRAMES:
+	    cl->frames = g_value_get_uint (value);
+	    break;
+
+	case CL_PROP_OFFSET:
+	    cl->offset = g_value_get_uint (value);
+	    break;
+
+	case CL_PROP_LOCATION:
+	    g_free (cl->location);
+	    cl->location = g_value_dup_string (value);
+	    break;
+
+	case CL_PROP_LEARN:
+	    cl->learn_req = g_value_get_boolean (value);
+	    cl->learn = cl->learn_req;
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    GST_OBJECT_UNLOCK (cl);
+
+    return;
+}
+
+
+/* Get a property */
+
+static void cl_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    AstroCalib *cl = ASTRO_CALIB (object);
+
+    GST_OBJECT_LOCK (cl);
+
+    switch (prop_id)
+    {
+	case CL_PROP_FRAMES:
+	    g_value_set_uint (value, cl->frames);
+	    break;
+
+	case CL_PROP_OFFSET:
+	    g_value_set_uint (value, cl->offset);
+	    break;
+
+	case CL_PROP_LOCATION:
+	    g_value_set_string (value, cl->location);
+	    break;
+
+	case CL_PROP_LEARN:
+	    g_value_set_boolean (value, cl->learn);
+	    break;
+
+	case CL_PROP_HAS_DARK:
+	    g_value_set_boolean (value, cl->has_dark);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    GST_OBJECT_UNLOCK (cl);
+
+    return;
+}
+
+
+/* Free */
+
+static void cl_finalize(GObject *object)
+{
+    AstroCalib *cl = ASTRO_CALIB (object);
+
+    g_free (cl->location);
+    g_free (cl->acc);
+    g_free (cl->dark);
+
+    G_OBJECT_CLASS (astro_calib_parent_class)->finalize (object);
+
+    return;
+}
+
+
+/* Negotiated format - a dark of a different size or format no longer applies */
+
+static gboolean cl_set_info(GstVideoFilter *filter, GstCaps *incaps, GstVideoInfo *in_info,
+			    GstCaps *outcaps, GstVideoInfo *out_info)
+{
+    AstroCalib *cl = ASTRO_CALIB (filter);
+    af_layout_t lay;
+
+    af_layout(in_info, &lay);
+
+    if (cl->width != GST_VIDEO_INFO_WIDTH (in_info) || cl->height != GST_VIDEO_INFO_HEIGHT (in_info)
+    	|| memcmp(&lay, &(cl->lay), sizeof(af_layout_t)) != 0)
+    {
+	g_free (cl->dark);
+	g_free (cl->acc);
+	cl->dark = NULL;
+	cl->acc = NULL;
+
+	GST_OBJECT_LOCK (cl);
+	cl->has_dark = FALSE;
+	GST_OBJECT_UNLOCK (cl);
+    }
+
+    cl->lay = lay;
+    cl->width = GST_VIDEO_INFO_WIDTH (in_info);
+    cl->height = GST_VIDEO_INFO_HEIGHT (in_info);
+    cl->n_samples = (gsize) cl->width * cl->height * lay.ncomp;
+
+    if (cl->dark == NULL)
+	cl_dark_load(cl);
+
+    return TRUE;
+}
+
+
+/* Learn the dark or subtract it */
+
+static GstFlowReturn cl_transform_ip(GstVideoFilter *filter, GstVideoFrame *frame)
+{
+    AstroCalib *cl = ASTRO_CALIB (filter);
+    af_layout_t *lay = &(cl->lay);
+    guint8 *row, *p;
+    guint16 *d;
+    guint32 *a;
+    gint v;
+    guint offset;
+    gboolean learn;
+    int x, y, c, w, h, stride;
+
+    GST_OBJECT_LOCK (cl);
+
+    if (cl->learn_req == TRUE)
+    {
+	cl->learn_req = FALSE;
+	cl->got = 0;
+	g_free (cl->acc);
+	cl->acc = g_malloc0 (cl->n_samples * sizeof(guint32));
+    }
+
+    learn = cl->learn;
+    offset = cl->offset;
+    GST_OBJECT_UNLOCK (cl);
+
+    if (learn == FALSE && cl->dark == NULL)
+    	return GST_FLOW_OK;
+
+    w = GST_VIDEO_FRAME_WIDTH (frame);
+    h = GST_VIDEO_FRAME_HEIGHT (frame);
+    stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+    row = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+
+    /* Accumulate (the frames pass unchanged) */
+    if (learn == TRUE)
+    {
+	a = cl->acc;
+
+	for(y = 0; y < h; y++, row += stride)
+	    for(x = 0, p = row; x < w; x++, p += lay->pstride)
+		for(c = 0; c < lay->ncomp; c++)
+		    *(a++) += af_get(p + c * lay->bps, lay->depth);
+
+	if (++cl->got >= cl->frames)
+	    cl_dark_done(cl);
+
+	return GST_FLOW_OK;
+    }
+
+    /* Subtract */
+    d = cl->dark;
+
+    for(y = 0; y < h; y++, row += stride)
+    {
+	for(x = 0, p = row; x < w; x++, p += lay->pstride)
+	{
+	    for(c = 0; c < lay->ncomp; c++, d++)
+	    {
+		v = (gint) af_get(p + c * lay->bps, lay->depth) - *d + offset;
+		af_put(p + c * lay->bps, lay->depth, CLAMP (v, 0, (gint) lay->maxval));
+	    }
+	}
+    }
+
+    return GST_FLOW_OK;
+}
+
+
+/* Master dark complete - average, keep and save */
+
+static void cl_dark_done(AstroCalib *cl)
+{
+    gsize i;
+
+    g_free (cl->dark);
+    cl->dark = g_malloc (cl->n_samples * sizeof(guint16));
+
+    for(i = 0; i < cl->n_samples; i++)
+    	cl->dark[i] = (guint16) ((cl->acc[i] + cl->got / 2) / cl->got);
+
+    g_free (cl->acc);
+    cl->acc = NULL;
+
+    GST_OBJECT_LOCK (cl);
+    cl->learn = FALSE;
+    cl->has_dark = TRUE;
+    GST_OBJECT_UNLOCK (cl);
+
+    cl_dark_save(cl);
+
+    gst_element_post_message (GST_ELEMENT (cl),
+    			      gst_message_new_element (GST_OBJECT (cl),
+			      	  gst_structure_new ("astrocalib",
+						     "dark-frames", G_TYPE_UINT, cl->got,
+						     NULL)));
+
+    return;
+}
+
+
+/* Load a saved dark (if it matches the stream) */
+
+static int cl_dark_load(AstroCalib *cl)
+{
+    FILE *fd;
+    char magic[8];
+    guint32 hdr[4];
+    guint16 *dark;
+    int ok;
+
+    GST_OBJECT_LOCK (cl);
+    fd = (cl->location != NULL) ? fopen(cl->location, "rb") : NULL;
+    GST_OBJECT_UNLOCK (cl);
+
+    if (fd == NULL)
+    	return FALSE;
+
+    ok = (fread(magic, 1, 8, fd) == 8 && memcmp(magic, AF_DARK_MAGIC, 8) == 0
+	  && fread(hdr, sizeof(guint32), 4, fd) == 4
+	  && hdr[0] == (guint32) cl->width && hdr[1] == (guint32) cl->height
+	  && hdr[2] == (guint32) cl->lay.depth && hdr[3] == (guint32) cl->lay.ncomp);
+
+    if (ok == TRUE)
+    {
+	dark = g_malloc (cl->n_samples * sizeof(guint16));
+
+	if (fread(dark, sizeof(guint16), cl->n_samples, fd) == cl->n_samples)
+	{
+	    cl->dark = dark;
+
+	    GST_OBJECT_LOCK (cl);
+	    cl->has_dark = TRUE;
+	    GST_OBJECT_UNLOCK (cl);
+	}
+	else
+	{
+	    g_free (dark);
+	    ok = FALSE;
+	}
+    }
+
+    if (ok == FALSE)
+	GST_ELEMENT_WARNING (cl, RESOURCE, READ, ("Dark file does not match the stream"), (NULL));
+
+    fclose(fd);
+
+    return ok;
+}
+
+
+/* Save the dark - small header (size and format) then the samples */
+
+static int cl_dark_save(AstroCalib *cl)
+{
+    FILE *fd;
+    guint32 hdr[4];
+    int ok;
+
+    GST_OBJECT_LOCK (cl);
+    fd = (cl->location != NULL) ? fopen(cl->location, "wb") : NULL;
+    GST_OBJECT_UNLOCK (cl);
+
+    if (fd == NULL)
+    	return FALSE;
+
+    hdr[0] = cl->width;
+    hdr[1] = cl->height;
+    hdr[2] = cl->lay.depth;
+    hdr[3] = cl->lay.ncomp;
+
+    ok = (fwrite(AF_DARK_MAGIC, 1, 8, fd) == 8 && fwrite(hdr, sizeof(guint32), 4, fd) == 4
+	  && fwrite(cl->dark, sizeof(guint16), cl->n_samples, fd) == cl->n_samples);
+
+    if (fclose(fd) != 0 || ok == FALSE)
+    {
+	GST_ELEMENT_WARNING (cl, RESOURCE, WRITE, ("Could not save the dark file"), (NULL));
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+
+
+/*  ** astrobin **  */
+
+
+/* Class setup */
+
+static void astro_bin_class_init(AstroBinClass *klass)
+{
+    GObjectClass *gobject_class;
+    GstBaseTransformClass *trans_class;
+    GstVideoFilterClass *vfilter_class;
+
+    gobject_class = G_OBJECT_CLASS (klass);
+    trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+    vfilter_class = GST_VIDEO_FILTER_CLASS (klass);
+
+    gobject_class->set_property = bn_set_property;
+    gobject_class->get_property = bn_get_property;
+
+    g_object_class_install_property (gobject_class, BN_PROP_FACTOR,
+	g_param_spec_uint ("factor", "Factor", "Samples binned in each direction",
+			   1, 8, 2, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, BN_PROP_SUM,
+	g_param_spec_boolean ("sum", "Sum", "Sum the samples (clipped at full scale) rather than average",
+			      FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    af_class_common (GST_ELEMENT_CLASS (klass), "AstroCTC binning",
+		     "Software pixel binning");
+
+    trans_class->transform_caps = bn_transform_caps;
+    vfilter_class->set_info = bn_set_info;
+    vfilter_class->transform_frame = bn_transform;
+
+    return;
+}
+
+
+/* Instance defaults */
+
+static void astro_bin_init(AstroBin *bn)
+{
+    bn->factor = 2;
+
+    return;
+}
+
+
+/* Set a property - a new factor means new caps */
+
+static void bn_set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    AstroBin *bn = ASTRO_BIN (object);
+
+    switch (prop_id)
+    {
+	case BN_PROP_FACTOR:
+	    GST_OBJECT_LOCK (bn);
+	    bn->factor = g_value_get_uint (value);
+	    GST_OBJECT_UNLOCK (bn);
+	    gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (bn));
+	    break;
+
+	case BN_PROP_SUM:
+	    GST_OBJECT_LOCK (bn);
+	    bn->sum = g_value_get_boolean (value);
+	    GST_OBJECT_UNLOCK (bn);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    return;
+}
+
+
+/* Get a property */
+
+static void bn_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    AstroBin *bn = ASTRO_BIN (object);
+
+    GST_OBJECT_LOCK (bn);
+
+    switch (prop_id)
+    {
+	case BN_PROP_FACTOR:
+	    g_value_set_uint (value, bn->factor);
+	    break;
+
+	case BN_PROP_SUM:
+	    g_value_set_boolean (value, bn->sum);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    GST_OBJECT_UNLOCK (bn);
+
+    return;
+}
+
+
+/* Caps on the other side - the frame size divided (downstream) or multiplied (upstream) */
+
+static GstCaps * bn_transform_caps(GstBaseTransform *trans, GstPadDirection direction, GstCaps *caps, GstCaps *filter)
+{
+    AstroBin *bn = ASTRO_BIN (trans);
+    GstCaps *ret, *tmp;
+    GstStructure *s;
+    guint factor, i;
+
+    GST_OBJECT_LOCK (bn);
+    factor = bn->factor;
+    GST_OBJECT_UNLOCK (bn);
+
+    ret = gst_caps_copy (caps);
+
+    for(i = 0; i < gst_caps_get_size (ret); i++)
+    {
+	s = gst_caps_get_structure (ret, i);
+	bn_scale_dim(s, "width", factor, direction == GST_PAD_SINK);
+	bn_scale_dim(s, "height", factor, direction == GST_PAD_SINK);
+    }
+
+    if (filter != NULL)
+    {
+	tmp = gst_caps_intersect_full (filter, ret, GST_CAPS_INTERSECT_FIRST);
+	gst_caps_unref (ret);
+	ret = tmp;
+    }
+
+    return ret;
+}
+
+
+/* Scale one dimension - anything other than a value or range is left open */
+
+static void bn_scale_dim(GstStructure *s, const char *nm, guint f, int down)
+{
+    const GValue *v;
+    gint lo, hi;
+
+    if ((v = gst_structure_get_value (s, nm)) == NULL)
+    	return;
+
+    if (G_VALUE_HOLDS_INT (v))
+    {
+	lo = g_value_get_int (v);
+	hi = lo;
+    }
+    else if (GST_VALUE_HOLDS_INT_RANGE (v))
+    {
+	lo = gst_value_get_int_range_min (v);
+	hi = gst_value_get_int_range_max (v);
+    }
+    else
+    {
+	gst_structure_set (s, nm, GST_TYPE_INT_RANGE, 1, G_MAXINT, NULL);
+	return;
+    }
+
+    if (down)
+    {
+	lo = MAX (lo / (gint) f, 1);
+	hi = MAX (hi / (gint) f, 1);
+    }
+    else
+    {
+	lo = (lo > G_MAXINT / (gint) f) ? G_MAXINT : lo * (gint) f;
+	hi = (hi > G_MAXINT / (gint) f - 1) ? G_MAXINT : hi * (gint) f + (gint) f - 1;
+    }
+
+    if (lo == hi)
+	gst_structure_set (s, nm, G_TYPE_INT, lo, NULL);
+    else
+	gst_structure_set (s, nm, GST_TYPE_INT_RANGE, lo, hi, NULL);
+
+    return;
+}
+
+
+/* Negotiated format - no work at factor 1 */
+
+static gboolean bn_set_info(GstVideoFilter *filter, GstCaps *incaps, GstVideoInfo *in_info,
+			    GstCaps *outcaps, GstVideoInfo *out_info)
+{
+    AstroBin *bn = ASTRO_BIN (filter);
+
+    af_layout(in_info, &(bn->lay));
+    gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (bn),
+    					GST_VIDEO_INFO_WIDTH (in_info) == GST_VIDEO_INFO_WIDTH (out_info) &&
+    					GST_VIDEO_INFO_HEIGHT (in_info) == GST_VIDEO_INFO_HEIGHT (out_info));
+
+    return TRUE;
+}
+
+
+/* Bin - the factor is taken from the negotiated sizes */
+
+static GstFlowReturn bn_transform(GstVideoFilter *filter, GstVideoFrame *in_frame, GstVideoFrame *out_frame)
+{
+    AstroBin *bn = ASTRO_BIN (filter);
+    af_layout_t *lay = &(bn->lay);
+    const guint8 *in_row, *p;
+    guint8 *out_row, *q;
+    guint acc, n;
+    gboolean sum;
+    int f, x, y, dx, dy, c, w, h, in_stride, out_stride;
+
+    w = GST_VIDEO_FRAME_WIDTH (out_frame);
+    h = GST_VIDEO_FRAME_HEIGHT (out_frame);
+    f = GST_VIDEO_FRAME_WIDTH (in_frame) / w;
+    in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
+    out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+    in_row = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+    out_row = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+    n = f * f;
+
+    GST_OBJECT_LOCK (bn);
+    sum = bn->sum;
+    GST_OBJECT_UNLOCK (bn);
+
+    for(y = 0; y < h; y++, in_row += in_stride * f, out_row += out_stride)
+    {
+	for(x = 0, q = out_row; x < w; x++, q += lay->pstride)
+	{
+	    /* Padding and alpha from the first pixel of the block */
+	    p = in_row + x * f * lay->pstride;
+	    memcpy(q, p, lay->pstride);
+
+	    for(c = 0; c < lay->ncomp; c++)
+	    {
+		acc = 0;
+
+		for(dy = 0; dy < f; dy++)
+		    for(dx = 0, p = in_row + dy * in_stride + x * f * lay->pstride + c * lay->bps;
+		    	dx < f; dx++, p += lay->pstride)
+			acc += af_get(p, lay->depth);
+
+		acc = sum ? MIN (acc, lay->maxval) : (acc + n / 2) / n;
+		af_put(q + c * lay->bps, lay->depth, acc);
+	    }
+	}
+    }
+
+    return GST_FLOW_OK;
+}
+
+
+
+
+/*  ** astrostack **  */
+
+
+/* Class setup */
+
+static void astro_stack_class_init(AstroStackClass *klass)
+{
+    GObjectClass *gobject_class;
+    GstBaseTransformClass *trans_class;
+    GstVideoFilterClass *vfilter_class;
+
+    gobject_class = G_OBJECT_CLASS (klass);
+    trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+    vfilter_class = GST_VIDEO_FILTER_CLASS (klass);
+
+    gobject_class->set_property = sk_set_property;
+    gobject_class->get_property = sk_get_property;
+    gobject_class->finalize = sk_finalize;
+
+    g_object_class_install_property (gobject_class, SK_PROP_FRAMES,
+	g_param_spec_uint ("frames", "Frames", "Frames in the running mean",
+			   1, 64, 4, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    af_class_common (GST_ELEMENT_CLASS (klass), "AstroCTC stacking",
+		     "Running mean of the last frames");
+
+    trans_class->sink_event = sk_sink_event;
+    trans_class->stop = sk_stop;
+    vfilter_class->set_info = sk_set_info;
+    vfilter_class->transform_frame_ip = sk_transform_ip;
+
+    return;
+}
+
+
+/* Instance defaults */
+
+static void astro_stack_init(AstroStack *sk)
+{
+    sk->frames = 4;
+
+    return;
+}
+
+
+/* Set a property */
+
+static void sk_set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    AstroStack *sk = ASTRO_STACK (object);
+
+    switch (prop_id)
+    {
+	case SK_PROP_FRAMES:
+	    GST_OBJECT_LOCK (sk);
+	    sk->frames = g_value_get_uint (value);
+	    GST_OBJECT_UNLOCK (sk);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    return;
+}
+
+
+/* Get a property */
+
+static void sk_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    AstroStack *sk = ASTRO_STACK (object);
+
+    switch (prop_id)
+    {
+	case SK_PROP_FRAMES:
+	    GST_OBJECT_LOCK (sk);
+	    g_value_set_uint (value, sk->frames);
+	    GST_OBJECT_UNLOCK (sk);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    return;
+}
+
+
+/* Free */
+
+static void sk_finalize(GObject *object)
+{
+    sk_reset(ASTRO_STACK (object));
+
+    G_OBJECT_CLASS (astro_stack_parent_class)->finalize (object);
+
+    return;
+}
+
+
+/* Negotiated format - start again */
+
+static gboolean sk_set_info(GstVideoFilter *filter, GstCaps *incaps, GstVideoInfo *in_info,
+			    GstCaps *outcaps, GstVideoInfo *out_info)
+{
+    AstroStack *sk = ASTRO_STACK (filter);
+
+    sk_reset(sk);
+    af_layout(in_info, &(sk->lay));
+    sk->n_samples = (gsize) GST_VIDEO_INFO_WIDTH (in_info) * GST_VIDEO_INFO_HEIGHT (in_info) * sk->lay.ncomp;
+
+    return TRUE;
+}
+
+
+/* Frames before a flush are not stacked with those after */
+
+static gboolean sk_sink_event(GstBaseTransform *trans, GstEvent *event)
+{
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+    	sk_reset(ASTRO_STACK (trans));
+
+    return GST_BASE_TRANSFORM_CLASS (astro_stack_parent_class)->sink_event (trans, event);
+}
+
+
+/* Stopped */
+
+static gboolean sk_stop(GstBaseTransform *trans)
+{
+    sk_reset(ASTRO_STACK (trans));
+
+    return TRUE;
+}
+
+
+/* Add the frame to the ring and replace it with the mean */
+
+static GstFlowReturn sk_transform_ip(GstVideoFilter *filter, GstVideoFrame *frame)
+{
+    AstroStack *sk = ASTRO_STACK (filter);
+    af_layout_t *lay = &(sk->lay);
+    guint8 *row, *p;
+    guint16 *r;
+    guint32 *a;
+    guint v, frames;
+    gboolean full;
+    int x, y, c, w, h, stride;
+
+    GST_OBJECT_LOCK (sk);
+    frames = sk->frames;
+    GST_OBJECT_UNLOCK (sk);
+
+    /* Ring (re)allocated for the number of frames */
+    if (sk->ring == NULL || sk->n != frames)
+    {
+	sk_reset(sk);
+	sk->n = frames;
+	sk->ring = g_try_malloc (sk->n_samples * frames * sizeof(guint16));
+	sk->acc = g_try_malloc0 (sk->n_samples * sizeof(guint32));
+
+	if (sk->ring == NULL || sk->acc == NULL)
+	{
+	    sk_reset(sk);
+	    GST_ELEMENT_ERROR (sk, RESOURCE, NO_SPACE_LEFT, ("Not enough memory to stack %u frames", frames), (NULL));
+	    return GST_FLOW_ERROR;
+	}
+    }
+
+    w = GST_VIDEO_FRAME_WIDTH (frame);
+    h = GST_VIDEO_FRAME_HEIGHT (frame);
+    stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+    row = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+    r = sk->ring + sk->head * sk->n_samples;
+    a = sk->acc;
+
+    /* Once the ring is full the oldest frame (in this slot) drops out */
+    if ((full = (sk->filled == sk->n)) == FALSE)
+    	sk->filled++;
+
+    for(y = 0; y < h; y++, row += stride)
+    {
+	for(x = 0, p = row; x < w; x++, p += lay->pstride)
+	{
+	    for(c = 0; c < lay->ncomp; c++, r++, a++)
+	    {
+		v = af_get(p + c * lay->bps, lay->depth);
+
+		if (full == TRUE)
+		    *a -= *r;
+
+		*r = v;
+		*a += v;
+		af_put(p + c * lay->bps, lay->depth, (*a + sk->filled / 2) / sk->filled);
+	    }
+	}
+    }
+
+    sk->head = (sk->head + 1) % sk->n;
+
+    return GST_FLOW_OK;
+}
+
+
+/* Empty the ring */
+
+static void sk_reset(AstroStack *sk)
+{
+    g_free (sk->ring);
+    g_free (sk->acc);
+    sk->ring = NULL;
+    sk->acc = NULL;
+    sk->n = 0;
+    sk->head = 0;
+    sk->filled = 0;
+
+    return;
+}
+
+
+
+
+/*  ** astrostretch **  */
+
+
+/* Class setup */
+
+static void astro_stretch_class_init(AstroStretchClass *klass)
+{
+    GObjectClass *gobject_class;
+    GstVideoFilterClass *vfilter_class;
+
+    gobject_class = G_OBJECT_CLASS (klass);
+    vfilter_class = GST_VIDEO_FILTER_CLASS (klass);
+
+    gobject_class->set_property = sr_set_property;
+    gobject_class->get_property = sr_get_property;
+    gobject_class->finalize = sr_finalize;
+
+    g_object_class_install_property (gobject_class, SR_PROP_BLACK,
+	g_param_spec_double ("black", "Black point", "Level shown as black (fraction of full scale)",
+			     0, 1, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, SR_PROP_WHITE,
+	g_param_spec_double ("white", "White point", "Level shown as white (fraction of full scale)",
+			     0, 1, 1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, SR_PROP_GAMMA,
+	g_param_spec_double ("gamma", "Gamma", "Gamma applied after the stretch",
+			     0.1, 10, 1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, SR_PROP_AUTO,
+	g_param_spec_boolean ("auto", "Auto", "Set the black and white points from the histogram",
+			      FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    af_class_common (GST_ELEMENT_CLASS (klass), "AstroCTC stretch",
+		     "Linear histogram stretch with gamma");
+
+    vfilter_class->set_info = sr_set_info;
+    vfilter_class->transform_frame_ip = sr_transform_ip;
+
+    return;
+}
+
+
+/* Instance defaults */
+
+static void astro_stretch_init(AstroStretch *sr)
+{
+    sr->white = 1;
+    sr->gamma = 1;
+    sr->dirty = TRUE;
+
+    return;
+}
+
+
+/* Set a property - the table is rebuilt with the next frame */
+
+static void sr_set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    AstroStretch *sr = ASTRO_STRETCH (object);
+
+    GST_OBJECT_LOCK (sr);
+
+    switch (prop_id)
+    {
+	case SR_PROP_BLACK:
+	    sr->black = g_value_get_double (value);
+	    break;
+
+	case SR_PROP_WHITE:
+	    sr->white = g_value_get_double (value);
+	    break;
+
+	case SR_PROP_GAMMA:
+	    sr->gamma = g_value_get_double (value);
+	    break;
+
+	case SR_PROP_AUTO:
+	    sr->autolvl = g_value_get_boolean (value);
+	    sr->count = 0;
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    sr->dirty = TRUE;
+    GST_OBJECT_UNLOCK (sr);
+
+    return;
+}
+
+
+/* Get a property */
+
+static void sr_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    AstroStretch *sr = ASTRO_STRETCH (object);
+
+    GST_OBJECT_LOCK (sr);
+
+    switch (prop_id)
+    {
+	case SR_PROP_BLACK:
+	    g_value_set_double (value, sr->black);
+	    break;
+
+	case SR_PROP_WHITE:
+	    g_value_set_double (value, sr->white);
+	    break;
+
+	case SR_PROP_GAMMA:
+	    g_value_set_double (value, sr->gamma);
+	    break;
+
+	case SR_PROP_AUTO:
+	    g_value_set_boolean (value, sr->autolvl);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+	    break;
+    }
+
+    GST_OBJECT_UNLOCK (sr);
+
+    return;
+}
+
+
+/* Free */
+
+static void sr_finalize(GObject *object)
+{
+    g_free (ASTRO_STRETCH (object)->lut);
+
+    G_OBJECT_CLASS (astro_stretch_parent_class)->finalize (object);
+
+    return;
+}
+
+
+/* Negotiated format - table for the sample depth */
+
+static gboolean sr_set_info(GstVideoFilter *filter, GstCaps *incaps, GstVideoInfo *in_info,
+			    GstCaps *outcaps, GstVideoInfo *out_info)
+{
+    AstroStretch *sr = ASTRO_STRETCH (filter);
+
+    af_layout(in_info, &(sr->lay));
+    g_free (sr->lut);
+    sr->lut = g_malloc ((sr->lay.maxval + 1) * sizeof(guint16));
+
+    GST_OBJECT_LOCK (sr);
+    sr->dirty = TRUE;
+    GST_OBJECT_UNLOCK (sr);
+
+    return TRUE;
+}
+
+
+/* Map every sample through the table */
+
+static GstFlowReturn sr_transform_ip(GstVideoFilter *filter, GstVideoFrame *frame)
+{
+    AstroStretch *sr = ASTRO_STRETCH (filter);
+    af_layout_t *lay = &(sr->lay);
+    guint8 *row, *p;
+    int x, y, c, w, h, stride;
+
+    GST_OBJECT_LOCK (sr);
+
+    if (sr->autolvl == TRUE && (sr->count++ % AF_AUTO_FRAMES) == 0)
+	sr_auto_levels(sr, frame);
+
+    if (sr->dirty == TRUE)
+    {
+	sr_build_lut(sr);
+	sr->dirty = FALSE;
+    }
+
+    GST_OBJECT_UNLOCK (sr);
+
+    w = GST_VIDEO_FRAME_WIDTH (frame);
+    h = GST_VIDEO_FRAME_HEIGHT (frame);
+    stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+    row = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+
+    for(y = 0; y < h; y++, row += stride)
+	for(x = 0, p = row; x < w; x++, p += lay->pstride)
+	    for(c = 0; c < lay->ncomp; c++)
+		af_put(p + c * lay->bps, lay->depth, sr->lut[af_get(p + c * lay->bps, lay->depth)]);
+
+    return GST_FLOW_OK;
+}
+
+
+/* Black and white points at 0.1% and 99.9% of a coarse histogram (object lock held) */
+
+static void sr_auto_levels(AstroStretch *sr, GstVideoFrame *frame)
+{
+    af_layout_t *lay = &(sr->lay);
+    const guint8 *row, *p;
+    guint64 hist[256], n, tot;
+    int x, y, c, w, h, stride, shift, i;
+
+    w = GST_VIDEO_FRAME_WIDTH (frame);
+    h = GST_VIDEO_FRAME_HEIGHT (frame);
+    stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+    row = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+    shift = lay->depth - 8;
+    memset(hist, 0, sizeof(hist));
+
+    for(y = 0; y < h; y++, row += stride)
+	for(x = 0, p = row; x < w; x++, p += lay->pstride)
+	    for(c = 0; c < lay->ncomp; c++)
+		hist[af_get(p + c * lay->bps, lay->depth) >> shift]++;
+
+    tot = (guint64) w * h * lay->ncomp;
+
+    for(i = 0, n = 0; i < 255 && (n + hist[i]) * 1000 <= tot; i++)
+    	n += hist[i];
+
+    sr->black = i / 256.0;
+
+    for(i = 255, n = 0; i > 0 && (n + hist[i]) * 1000 <= tot; i--)
+    	n += hist[i];
+
+    sr->white = (i + 1) / 256.0;
+    sr->dirty = TRUE;
+
+    return;
+}
+
+
+/* Stretch table (object lock held) */
+
+static void sr_build_lut(AstroStretch *sr)
+{
+    gdouble lo, range, v;
+    guint i, max;
+
+    max = sr->lay.maxval;
+    lo = sr->black;
+    range = MAX (sr->white - sr->black, 1.0 / (max + 1));
+
+    for(i = 0; i <= max; i++)
+    {
+    	v = CLAMP (((gdouble) i / max - lo) / range, 0, 1);
+
+	if (sr->gamma != 1)
+	    v = pow(v, 1 / sr->gamma);
+
+	sr->lut[i] = (guint16) (v * max + 0.5);
+    }
+
+    return;
+}
@@ -30,6 +30,12 @@
 **
 ** History
 **	26-Dec-2013	Initial code
+**	19-Oct-2026	Register the direct i/o capture file sink
+**	19-Oct-2026	Headless capture option (no display)
+**	19-Oct-2026	Local control socket
+**	19-Oct-2026	Headless capture uses the engine library
+**	19-Oct-2026	Register the frame processing elements
+**	19-Oct-2026	Camera hotplug watch
 **
 */
 
@@ -71,6 +77,14 @@ extern void close_log();
 extern void gst_view(CamData *, MainUi *);
 extern void capture_cleanup();
 extern void log_msg(char*, char*, char*, GtkWidget*);
+extern int direct_sink_register();
+extern int astro_filters_register(GstPlugin *);
+extern int headless_opt(int, char *[]);
+extern int headless_main(int, char *[]);
+extern int ctl_socket_init(CamData *, MainUi *);
+extern void ctl_socket_close();
+extern int hotplug_init(CamData *, MainUi *);
+extern void hotplug_close();
 //extern void debug_session();
 
 
@@ -86,18 +100,36 @@ int main(int argc, char *argv[])
 {  
     CamData cam_data;
     MainUi m_ui;
+    int rc;
 
     /* Initial work */
     initialise(&cam_data, &m_ui);
 
+    /* Headless capture - Gtk is not initialised (no display required, the engine library sets up GStreamer) */
+    if (headless_opt(argc, argv) == TRUE)
+    {
+	rc = headless_main(argc, argv);
+
+	final();
+	exit(rc);
+    }
+
     /* Initialise Gtk & GStreamer */
     gtk_init(&argc, &argv);  
     gst_init (&argc, &argv);
+    direct_sink_register();
+    astro_filters_register(NULL);
 
     main_ui(&cam_data, &m_ui);
 
     gst_view(&cam_data, &m_ui);
 
+    /* Scripted control */
+    ctl_socket_init(&cam_data, &m_ui);
+
+    /* Cameras plugged in or out */
+    hotplug_init(&cam_data, &m_ui);
+
     gtk_main();  
 
     final();
@@ -145,6 +177,12 @@ void initialise(CamData *cam_data, MainUi *m_ui)
 
 void final()
 {
+    /* Control socket */
+    ctl_socket_close();
+
+    /* Camera hotplug */
+    hotplug_close();
+
     /* Capture cleanup */
     capture_cleanup();
 
@@ -0,0 +1,59 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	GStreamer plugin (libgstastroctc.so) for the frame processing elements
+**		(see astro_filters.c), so they can be used outside the application eg.
+**
+**		GST_PLUGIN_PATH=. gst-inspect-1.0 astroctc
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Includes */
+
+#include <gst/gst.h>
+#include <version.h>
+
+
+/* Prototypes */
+
+static gboolean astro_plugin_init(GstPlugin *);
+
+extern int astro_filters_register(GstPlugin *);
+
+
+/* Plugin entry */
+
+static gboolean astro_plugin_init(GstPlugin *plugin)
+{
+    return astro_filters_register(plugin);
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR, GST_VERSION_MINOR, astroctc,
+		   "AstroCTC frame processing (statistics, calibration, binning, stacking, stretch)",
+		   astro_plugin_init, VERSION, "GPL", "AstroCTC", "https://github.com/mr-headwind/AstroCTC")
@@ -0,0 +1,154 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+** Description:	libastroctc - capture engine public interface (no Gtk)
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial
+**	19-Oct-2026	Capture branch functions (shared with the application's capture pipeline)
+**	19-Oct-2026	Limits are on what is written
+**	19-Oct-2026	MJPEG camera format
+**	19-Oct-2026	Scope of the interface stated
+**
+*/
+
+/*
+    A capture session records video from a V4L2 camera to a file. The session is opaque; all
+    the details are given up front in an actc_config_t and everything the engine has to report
+    comes back through the callbacks (any of which may be NULL). Messages carry the AstroCTC
+    message id and substitution text (see utility.c) plus any detail, so a consumer can log
+    them the same way as the application does.
+
+    	actc_init();
+    	sess = actc_session_new(&cfg, &cb, user_data);
+    	ok = actc_run(sess);			(or actc_start and a main loop of your own)
+    	actc_session_free(sess);
+
+    The callbacks are called from the main loop, except 'frame' which is called on the
+    streaming thread for every buffer from the camera and must be quick.
+
+    The writing side of a capture (queue, optional convert and encoder or caps filter, muxer
+    and file sink) is also available on its own for pipelines built elsewhere, such as one
+    that records a tee branch while displaying:
+
+    	sink = gst_element_factory_make (actc_sink_factory(direct, budget), NULL);
+    	actc_sink_props(sink, direct, budget);
+    	... add the branch elements to the pipeline ...
+    	ok = actc_branch_link(&br);
+
+    That is all the library provides. Camera controls, snapshots, display, sequences and the
+    frame processing elements are in the application and are not part of this interface.
+
+    Add a member to the end of a structure only, and bump ACTC_API_VERSION when doing so.
+*/
+
+
+/* Defines */
+
+#ifndef ACTC_HDR
+#define ACTC_HDR
+
+#define ACTC_API_VERSION 2
+#define ACTC_BRANCH_MAX 4				// Elements after the queue
+
+
+/* Includes */
+
+#include <glib.h>
+#include <gst/gst.h>
+
+
+/* Types */
+
+typedef struct _actc_session actc_session_t;
+
+typedef struct _actc_config
+{
+    const char *device;				// eg. /dev/video0
+    int width;					// 0 = camera default
+    int height;
+    int fps;					// 0 = camera default
+    const char *format;				// Camera format (eg. YUY2 or MJPG), NULL = any raw
+    const char *encoder;			// Encoder element, NULL = none
+    const char *raw_format;			// No encoder - format to convert to, NULL = as captured
+    const char *muxer;				// Container element (required)
+    const char *location;			// Output file
+    int direct;					// Direct i/o file sink
+    guint64 ram_budget;				// Bytes staged in RAM (direct sink), 0 = none
+    long frames;				// Frame limit (frames written), 0 = none
+    int secs;					// Time limit (running time written), 0 = none
+    int queue_bufs;				// Capture queue, 0 = default
+} actc_config_t;
+
+typedef struct _actc_status
+{
+    guint64 frames;				// Buffers from the camera
+    gdouble secs;				// Since the start
+    guint64 fps;				// Frames in the last second
+    long dropped;				// Driver frame checks
+    long duplicated;
+    long late;
+    int direct;					// Direct sink in use (disk_rate is valid)
+    gdouble disk_rate;				// MB/s
+    char checks[100];				// Frame check summary (empty if nothing to report)
+} actc_status_t;
+
+typedef struct _actc_callbacks
+{
+    void (*message) (actc_session_t *, const char *msg_id, const char *opt, const char *detail, gpointer);
+    void (*element) (actc_session_t *, const char *role, GstElement *, gpointer);	// Set properties
+    void (*frame) (actc_session_t *, guint64 count, gint64 seq, guint64 ts, gpointer);	// Streaming thread
+    void (*status) (actc_session_t *, const actc_status_t *, gpointer);		// Once a second
+    void (*finished) (actc_session_t *, int ok, gpointer);
+} actc_callbacks_t;
+
+typedef struct _actc_branch
+{
+    GstElement *queue;				// Capture queue (start of the branch)
+    GstElement *convert;			// Video convert, NULL = none
+    GstElement *encoder;			// Encoder or caps filter, NULL = none
+    GstElement *muxer;
+    GstElement *file_sink;
+} actc_branch_t;
+
+
+/* Functions */
+
+int actc_api_version();
+int actc_init();
+actc_session_t * actc_session_new(const actc_config_t *, const actc_callbacks_t *, gpointer);
+int actc_start(actc_session_t *);
+void actc_stop(actc_session_t *);
+void actc_abort(actc_session_t *);
+int actc_run(actc_session_t *);
+int actc_stopping(actc_session_t *);
+void actc_get_status(actc_session_t *, actc_status_t *);
+guint64 actc_base_time(actc_session_t *);
+void actc_session_free(actc_session_t *);
+const char * actc_sink_factory(int, guint64);
+int actc_sink_props(GstElement *, int, guint64);
+int actc_branch_list(const actc_branch_t *, GstElement **);
+int actc_branch_link(const actc_branch_t *);
+
+#endif
@@ -0,0 +1,884 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+** Description:	Encoder throughput benchmark and codec / preset recommendation
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Container (muxer) included, cpu less the baseline run
+**	19-Oct-2026	No benchmark prompt when not interactive
+**
+*/
+
+/*
+    Each codec (and some alternative encoder settings) is run against synthetic frames for
+    the current session resolution, colour format and frame rate:
+
+  | Video   |  | Caps   |  | Video   |  | Encoder or |  | Muxer |  | Fake |
+  | testsrc |->| Filter |->| convert |->| Caps       |->|       |->| sink |
+
+    A baseline run (source direct to sink) is subtracted from the timings and the cpu. The cpu
+    is the process cpu time (all threads, so anything else the application is doing, such as
+    camera tiles, is included) over the elapsed time. Results are cached per machine (host
+    name) in the application directory.
+*/
+
+
+/* Defines */
+
+#define BENCH_FILE "bench_"
+#define BENCH_REPORT "bench_report"
+#define BENCH_MAX 40
+#define BENCH_PROPS_SZ 200
+#define BENCH_MIN_FRAMES 30
+#define BENCH_TIMEOUT 60
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <session.h>
+#include <main.h>
+#include <codec.h>
+#include <cam.h>
+#include <defs.h>
+#include <preferences.h>
+
+
+/* Structures and Typedefs required */
+
+typedef struct _bench_res
+{
+    char fourcc[5];
+    char props[BENCH_PROPS_SZ];
+    double fps;
+    double cpu;
+    long bpf;
+} bench_res_t;
+
+enum { BN_IDLE, BN_IN_PROGRESS, BN_DONE, BN_FAIL };
+
+
+/* Prototypes */
+
+int bench_control(CamData *, MainUi *);
+gboolean bench_main_loop_fn(gpointer);
+void * bench_main(void *);
+int bench_run(bench_res_t *, int, double *);
+GstElement * bench_pipeline(codec_t *, char *, int, GstElement **);
+void bench_set_props(GstElement *, char *);
+void bench_user_props(codec_t *, char *, int);
+static GstPadProbeReturn bench_probe(GstPad *, GstPadProbeInfo *, gpointer);
+double cpu_secs();
+void bench_key(char *, int);
+char * bench_fn(char *);
+int bench_save(MainUi *);
+int bench_report(MainUi *);
+int bench_check(MainUi *, int);
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+extern gint query_dialog(GtkWidget *, char *, char *);
+extern void get_session(char*, char**);
+extern int get_user_pref(char *, char **);
+extern void res_to_long(char *, long *, long *);
+extern void swap_fourcc(char *, char *);
+extern codec_t * get_codec_arr(int *);
+extern codec_t * get_codec(char *);
+extern char * app_dir_path();
+extern int gst_view(CamData *, MainUi *);
+extern int view_clear_pipeline(CamData *, MainUi *);
+extern void set_capture_btns(MainUi *, int, int);
+extern GtkWidget* view_file_main(char *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-benchmark.c ";
+static pthread_t bench_tid;
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int bench_status = BN_IDLE;
+static int bench_idx;
+static int bench_count;
+static bench_res_t bench_arr[BENCH_MAX];
+static char bench_fmt[20];
+static long bench_width, bench_height;
+static int bench_fps;
+static guint64 bench_bytes, bench_bufs;
+static double bench_base_cpu;
+
+static const char *bench_var[][2] =	// Alternative encoder settings to try (override preferences)
+    {
+    	{"H264", "speed-preset=1" },			// ultrafast
+    	{"H264", "speed-preset=3" },			// veryfast
+    	{"H264", "speed-preset=1,threads=0,sliced-threads=TRUE" },
+    	{"X264", "speed-preset=1" },
+    	{"X264", "speed-preset=3" },
+    	{"FFV1", "level=3,slices=16" },
+    	{"FFV1", "level=1,slices=0" },
+    	{"THEO", "speed-level=3" },
+    	{"MPG4", "me-method=1" },
+    	{"MPG2", "me-method=1" }
+    };
+
+static const int bench_var_max = 10;
+
+
+/* Set up the benchmark runs and start a thread to do the work */
+
+int bench_control(CamData *cam_data, MainUi *m_ui)
+{
+    int i, j, codec_max, p_err;
+    char *p;
+    char fourcc[20];
+    codec_t *codec;
+
+    /* Ignore if already running */
+    if (bench_status == BN_IN_PROGRESS)
+    	return FALSE;
+
+    /* Session settings to test */
+    get_session(CLRFMT, &p);
+    swap_fourcc(p, fourcc);
+
+    if (gst_video_format_from_string (fourcc) == GST_VIDEO_FORMAT_UNKNOWN)
+	strcpy(bench_fmt, "I420");
+    else
+	strcpy(bench_fmt, fourcc);
+
+    get_session(RESOLUTION, &p);
+    res_to_long(p, &bench_width, &bench_height);
+    get_session(FPS, &p);
+    bench_fps = atoi(p);
+
+    /* Each codec as per user preferences, plus any alternative settings */
+    codec = get_codec_arr(&codec_max);
+    bench_count = 0;
+
+    for(i = 0; i < codec_max && bench_count < BENCH_MAX; i++, codec++)
+    {
+	strcpy(bench_arr[bench_count].fourcc, codec->fourcc);
+	bench_user_props(codec, bench_arr[bench_count].props, BENCH_PROPS_SZ);
+	bench_count++;
+
+	for(j = 0; j < bench_var_max && bench_count < BENCH_MAX; j++)
+	{
+	    if (strcmp(bench_var[j][0], codec->fourcc) != 0)
+	    	continue;
+
+	    strcpy(bench_arr[bench_count].fourcc, codec->fourcc);
+	    bench_user_props(codec, bench_arr[bench_count].props, BENCH_PROPS_SZ);
+
+	    if (*(bench_arr[bench_count].props) != '\0')
+		strcat(bench_arr[bench_count].props, ",");
+
+	    strncat(bench_arr[bench_count].props, bench_var[j][1],
+	    	    BENCH_PROPS_SZ - strlen(bench_arr[bench_count].props) - 1);
+	    bench_count++;
+	}
+    }
+
+    /* Stop the camera while benchmarking */
+    if (view_clear_pipeline(cam_data, m_ui) == FALSE)
+        return FALSE;
+
+    cam_data->mode = CAM_MODE_NONE;
+    bench_idx = 0;
+    bench_status = BN_IN_PROGRESS;
+
+    if ((p_err = pthread_create(&bench_tid, NULL, &bench_main, NULL)) != 0)
+    {
+	sprintf(app_msg_extra, "Error: %s", strerror(p_err));
+	log_msg("SYS9016", NULL, "SYS9016", m_ui->window);
+	bench_status = BN_IDLE;
+	gst_view(cam_data, m_ui);
+	return FALSE;
+    }
+
+    /* Initiate a timer function on the main loop */
+    g_timeout_add (250, bench_main_loop_fn, m_ui);
+    set_capture_btns(m_ui, FALSE, FALSE);
+
+    return TRUE;
+}
+
+
+/* Timeout function on main loop to show progress and finish up */
+
+gboolean bench_main_loop_fn(gpointer user_data)
+{
+    CamData *cam_data;
+    MainUi *m_ui;
+    char s[100];
+    int idx, status;
+
+    /* Get data */
+    m_ui = (MainUi *) user_data;
+    cam_data = (CamData *) g_object_get_data (G_OBJECT(m_ui->window), "cam_data");
+
+    pthread_mutex_lock(&bench_mutex);
+    idx = bench_idx;
+    status = bench_status;
+    pthread_mutex_unlock(&bench_mutex);
+
+    /* Check status */
+    if (status == BN_IN_PROGRESS)
+    {
+	snprintf(s, sizeof(s), "Encoder benchmark %d of %d: %s",
+		 idx + 1, bench_count, bench_arr[idx < bench_count ? idx : bench_count - 1].fourcc);
+	gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
+	return TRUE;
+    }
+
+    pthread_join(bench_tid, NULL);
+
+    if (status == BN_DONE)
+    {
+	bench_save(m_ui);
+	bench_report(m_ui);
+    }
+    else
+    {
+	log_msg("APP0007", "baseline run failed", "APP0007", m_ui->window);
+    }
+
+    bench_status = BN_IDLE;
+
+    /* Restart the camera */
+    set_capture_btns(m_ui, TRUE, FALSE);
+    gst_view(cam_data, m_ui);
+
+    return FALSE;
+}
+
+
+/* Benchmark thread - run each codec in turn */
+
+void * bench_main(void *arg)
+{
+    int i, frames;
+    double base_secs, secs;
+    bench_res_t base;
+
+    /* Enough frames for a few seconds of capture */
+    frames = bench_fps * 3;
+
+    if (frames < BENCH_MIN_FRAMES)
+    	frames = BENCH_MIN_FRAMES;
+
+    /* Baseline - source only */
+    memset(&base, 0, sizeof(bench_res_t));
+    base_secs = 0;
+
+    if (bench_run(&base, frames, &base_secs) == FALSE)
+    {
+	pthread_mutex_lock(&bench_mutex);
+	bench_status = BN_FAIL;
+	pthread_mutex_unlock(&bench_mutex);
+	pthread_exit(NULL);
+    }
+
+    bench_base_cpu = base.cpu;
+
+    /* Each codec */
+    for(i = 0; i < bench_count; i++)
+    {
+	pthread_mutex_lock(&bench_mutex);
+	bench_idx = i;
+	pthread_mutex_unlock(&bench_mutex);
+
+	secs = base_secs;
+
+	if (bench_run(&(bench_arr[i]), frames, &secs) == FALSE)
+	{
+	    bench_arr[i].fps = 0;
+	    bench_arr[i].cpu = 0;
+	    bench_arr[i].bpf = 0;
+	}
+	else
+	{
+	    bench_arr[i].cpu = MAX (bench_arr[i].cpu - base.cpu, 0);
+	}
+    }
+
+    pthread_mutex_lock(&bench_mutex);
+    bench_status = BN_DONE;
+    pthread_mutex_unlock(&bench_mutex);
+
+    pthread_exit(NULL);
+}
+
+
+// Time a pipeline over a number of frames. On entry secs holds the baseline time which is
+// subtracted, on exit it holds the elapsed time. An empty fourcc is the baseline run.
+
+int bench_run(bench_res_t *res, int frames, double *secs)
+{
+    GstElement *pipeline, *sink;
+    GstBus *bus;
+    GstMessage *msg;
+    GstPad *pad;
+    codec_t *codec;
+    gint64 t_start;
+    double cpu_start, elapsed, enc_secs;
+    int r;
+
+    /* Codec (none for baseline) */
+    codec = NULL;
+
+    if (*(res->fourcc) != '\0')
+    {
+	if ((codec = get_codec(res->fourcc)) == NULL)
+	    return FALSE;
+    }
+
+    if ((pipeline = bench_pipeline(codec, res->props, frames, &sink)) == NULL)
+    	return FALSE;
+
+    /* Count the output */
+    bench_bytes = 0;
+    bench_bufs = 0;
+    pad = gst_element_get_static_pad (sink, "sink");
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, bench_probe, NULL, NULL);
+    gst_object_unref (pad);
+
+    /* Run to completion */
+    bus = gst_element_get_bus (pipeline);
+    t_start = g_get_monotonic_time ();
+    cpu_start = cpu_secs();
+
+    gst_element_set_state (pipeline, GST_STATE_PLAYING);
+    msg = gst_bus_timed_pop_filtered (bus, BENCH_TIMEOUT * GST_SECOND, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+    elapsed = (double) (g_get_monotonic_time () - t_start) / G_USEC_PER_SEC;
+    res->cpu = (elapsed > 0) ? (cpu_secs() - cpu_start) / elapsed * 100.0 : 0;
+
+    r = (msg != NULL && GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+
+    if (msg != NULL)
+    	gst_message_unref (msg);
+
+    gst_element_set_state (pipeline, GST_STATE_NULL);
+    gst_object_unref (bus);
+    gst_object_unref (pipeline);
+
+    if (r == FALSE)
+    	return FALSE;
+
+    /* Results */
+    enc_secs = elapsed - *secs;
+
+    if (enc_secs <= 0)
+    	enc_secs = elapsed;
+
+    res->fps = (enc_secs > 0) ? (double) bench_bufs / enc_secs : 0;
+    res->bpf = (bench_bufs > 0) ? (long) (bench_bytes / bench_bufs) : 0;
+    *secs = elapsed;
+
+    return TRUE;
+}
+
+
+/* Build a benchmark pipeline for a codec (or baseline if none) */
+
+GstElement * bench_pipeline(codec_t *codec, char *props, int frames, GstElement **sink)
+{
+    GstElement *pipeline, *src, *filter, *convert, *enc, *muxer;
+    GstCaps *caps;
+    char *fmt;
+    int r;
+
+    pipeline = gst_pipeline_new ("bench");
+    src = gst_element_factory_make ("videotestsrc", NULL);
+    filter = gst_element_factory_make ("capsfilter", NULL);
+    *sink = gst_element_factory_make ("fakesink", NULL);
+    convert = NULL;
+    enc = NULL;
+
+    if (!pipeline || !src || !filter || !*sink)
+    	return NULL;
+
+    /* Noise is closest to a real (astro) image and the hardest to compress */
+    g_object_set (src, "num-buffers", frames, NULL);
+    gst_util_set_object_arg (G_OBJECT (src), "pattern", "snow");
+    g_object_set (*sink, "sync", FALSE, NULL);
+
+    caps = gst_caps_new_simple ("video/x-raw",
+				"format", G_TYPE_STRING, bench_fmt,
+				"framerate", GST_TYPE_FRACTION, bench_fps, 1,
+				"width", G_TYPE_INT, (int) bench_width,
+				"height", G_TYPE_INT, (int) bench_height,
+				NULL);
+    g_object_set (filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+
+    gst_bin_add_many (GST_BIN (pipeline), src, filter, *sink, NULL);
+
+    /* Baseline */
+    if (codec == NULL)
+    {
+	if (gst_element_link_many (src, filter, *sink, NULL) != TRUE)
+	{
+	    gst_object_unref (pipeline);
+	    return NULL;
+	}
+
+	return pipeline;
+    }
+
+    /* Encoder or raw caps */
+    if (*(codec->encoder) != '\0')
+    {
+	enc = gst_element_factory_make (codec->encoder, NULL);
+	convert = gst_element_factory_make ("videoconvert", NULL);
+    }
+    else
+    {
+	if (strcmp(codec->fourcc, NATIVE_FMT) == 0)
+	    fmt = bench_fmt;
+	else
+	    fmt = codec->fourcc;
+
+	enc = gst_element_factory_make ("capsfilter", NULL);
+
+	if (enc)
+	{
+	    caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, fmt, NULL);
+	    g_object_set (enc, "caps", caps, NULL);
+	    gst_caps_unref (caps);
+	}
+
+	if (strcmp(fmt, bench_fmt) != 0)
+	    convert = gst_element_factory_make ("videoconvert", NULL);
+    }
+
+    if (!enc)
+    {
+	gst_object_unref (pipeline);
+	return NULL;
+    }
+
+    if (*(codec->encoder) != '\0')
+	bench_set_props(enc, props);
+
+    /* The container as captured */
+    if ((muxer = gst_element_factory_make (codec->muxer, NULL)) == NULL)
+    {
+	gst_object_unref (enc);
+
+	if (convert)
+	    gst_object_unref (convert);
+
+	gst_object_unref (pipeline);
+	return NULL;
+    }
+
+    /* Link */
+    gst_bin_add_many (GST_BIN (pipeline), enc, muxer, NULL);
+
+    if (convert)
+    {
+	gst_bin_add (GST_BIN (pipeline), convert);
+	r = gst_element_link_many (src, filter, convert, enc, muxer, *sink, NULL);
+    }
+    else
+    {
+	r = gst_element_link_many (src, filter, enc, muxer, *sink, NULL);
+    }
+
+    if (r != TRUE)
+    {
+	gst_object_unref (pipeline);
+	return NULL;
+    }
+
+    return pipeline;
+}
+
+
+/* Set encoder properties from a 'prop=val,prop=val' list */
+
+void bench_set_props(GstElement *enc, char *props)
+{
+    char s[BENCH_PROPS_SZ];
+    char *nm, *nm_val, *sv;
+
+    strcpy(s, props);
+    nm = strtok_r(s, ",", &sv);
+
+    while(nm != NULL)
+    {
+    	if ((nm_val = strchr(nm, '=')) != NULL)
+    	{
+	    *nm_val = '\0';
+	    nm_val++;
+
+	    if (*nm_val != '\0')
+		gst_util_set_object_arg (G_OBJECT (enc), nm, nm_val);
+    	}
+
+	nm = strtok_r(NULL, ",", &sv);
+    }
+
+    return;
+}
+
+
+/* Current encoder settings for a codec from user preferences (plus any fixed settings) */
+
+void bench_user_props(codec_t *codec, char *props, int sz)
+{
+    int i, pref_total;
+    char key[PREF_KEY_SZ];
+    char *p;
+
+    *props = '\0';
+
+    if (*(codec->encoder) == '\0')
+    	return;
+
+    sprintf(key, "%sMAX", codec->encoder);
+    get_user_pref(key, &p);
+
+    if (p == NULL)
+    	pref_total = 0;
+    else
+	pref_total = atoi(p);
+
+    for(i = 0; i < pref_total; i++)
+    {
+	sprintf(key, "%s%02d", codec->encoder, i);
+    	get_user_pref(key, &p);
+
+	if (p == NULL)
+	    continue;
+
+	if (*props != '\0')
+	    strncat(props, ",", sz - strlen(props) - 1);
+
+	strncat(props, p, sz - strlen(props) - 1);
+    }
+
+    if (*(codec->enc_fixed) != '\0')
+    {
+	if (*props != '\0')
+	    strncat(props, ",", sz - strlen(props) - 1);
+
+	strncat(props, codec->enc_fixed, sz - strlen(props) - 1);
+    }
+
+    return;
+}
+
+
+/* Probe - count output buffers and bytes */
+
+static GstPadProbeReturn bench_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    bench_bufs++;
+    bench_bytes += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+/* Process cpu time (user + system) in seconds */
+
+double cpu_secs()
+{
+    struct rusage ru;
+
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+    	return 0;
+
+    return (double) ru.ru_utime.tv_sec + (double) ru.ru_utime.tv_usec / 1000000.0 +
+	   (double) ru.ru_stime.tv_sec + (double) ru.ru_stime.tv_usec / 1000000.0;
+}
+
+
+/* Key for the current session settings eg. 1280x720:YUY2:30 */
+
+void bench_key(char *key, int sz)
+{
+    char *p;
+    char fourcc[20];
+    long width, height;
+
+    get_session(CLRFMT, &p);
+    swap_fourcc(p, fourcc);
+
+    if (gst_video_format_from_string (fourcc) == GST_VIDEO_FORMAT_UNKNOWN)
+	strcpy(fourcc, "I420");
+
+    get_session(RESOLUTION, &p);
+    res_to_long(p, &width, &height);
+    get_session(FPS, &p);
+
+    snprintf(key, sz, "%ldx%ld:%s:%d", width, height, fourcc, atoi(p));
+
+    return;
+}
+
+
+/* Benchmark cache file name - results are per machine */
+
+char * bench_fn(char *fn)
+{
+    char host[100];
+
+    if (gethostname(host, sizeof(host)) != 0)
+    	strcpy(host, "localhost");
+
+    host[sizeof(host) - 1] = '\0';
+    sprintf(fn, "%s/%s%s", app_dir_path(), BENCH_FILE, host);
+
+    return fn;
+}
+
+
+/* Save the results, replacing any previous results for the same session settings */
+
+int bench_save(MainUi *m_ui)
+{
+    FILE *fd, *tfd;
+    char fn[256], tmp_fn[260];
+    char key[50];
+    char buf[400];
+    int i, len;
+
+    bench_fn(fn);
+    sprintf(tmp_fn, "%s~", fn);
+    snprintf(key, sizeof(key), "%ldx%ld:%s:%d", bench_width, bench_height, bench_fmt, bench_fps);
+    len = strlen(key);
+
+    if ((tfd = fopen(tmp_fn, "w")) == (FILE *) NULL)
+    {
+	log_msg("SYS9005", tmp_fn, "SYS9005", m_ui->window);
+	return FALSE;
+    }
+
+    /* Keep other results */
+    if ((fd = fopen(fn, "r")) != (FILE *) NULL)
+    {
+	while((fgets(buf, sizeof(buf), fd)) != NULL)
+	{
+	    if (strncmp(buf, key, len) == 0 && buf[len] == '|')
+	    	continue;
+
+	    fputs(buf, tfd);
+	}
+
+	fclose(fd);
+    }
+
+    /* Key|Codec|Settings|Fps|Cpu|Bytes per frame */
+    for(i = 0; i < bench_count; i++)
+    {
+	fprintf(tfd, "%s|%s|%s|%.1f|%.0f|%ld\n", key, bench_arr[i].fourcc, bench_arr[i].props,
+						  bench_arr[i].fps, bench_arr[i].cpu, bench_arr[i].bpf);
+    }
+
+    fclose(tfd);
+
+    if (rename(tmp_fn, fn) != 0)
+    {
+	log_msg("SYS9021", fn, "SYS9021", m_ui->window);
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Write and show a readable report of the latest run */
+
+int bench_report(MainUi *m_ui)
+{
+    FILE *fd;
+    char fn[256];
+    int i;
+
+    sprintf(fn, "%s/%s", app_dir_path(), BENCH_REPORT);
+
+    if ((fd = fopen(fn, "w")) == (FILE *) NULL)
+    {
+	log_msg("SYS9005", fn, "SYS9005", m_ui->window);
+	return FALSE;
+    }
+
+    fprintf(fd, "Encoder benchmark: %ldx%ld %s at %d fps\n", bench_width, bench_height, bench_fmt, bench_fps);
+    fprintf(fd, "Each run is test source, encoder (or caps) and the codec's muxer to a discarding sink.\n");
+    fprintf(fd, "Cpu%% is process cpu time (all threads, including the rest of the application) over\n"
+    		"the run time, less the baseline run of the test source alone (%.0f%%).\n\n", bench_base_cpu);
+    fprintf(fd, "%-6s %8s %6s %10s  %-4s %s\n", "Codec", "Fps", "Cpu%", "KB/frame", "Ok", "Settings");
+
+    for(i = 0; i < bench_count; i++)
+    {
+	fprintf(fd, "%-6s %8.1f %6.0f %10.1f  %-4s %s\n",
+		bench_arr[i].fourcc, bench_arr[i].fps, bench_arr[i].cpu,
+		(double) bench_arr[i].bpf / 1024.0,
+		(bench_arr[i].fps >= (double) bench_fps) ? "Yes" : "No",
+		(*(bench_arr[i].props) == '\0') ? "(none)" : bench_arr[i].props);
+    }
+
+    fclose(fd);
+    view_file_main(fn);
+
+    return TRUE;
+}
+
+
+// Check the capture codec against any benchmark results for the current session settings.
+// If it could not keep up, warn and suggest settings or a codec that can.
+// When not interactive (control socket) the warning is logged and the capture goes ahead.
+
+int bench_check(MainUi *m_ui, int interactive)
+{
+    FILE *fd;
+    char fn[256];
+    char key[50];
+    char buf[400];
+    char props[BENCH_PROPS_SZ];
+    char best[BENCH_PROPS_SZ + 50];
+    char s[BENCH_PROPS_SZ * 2 + 200];
+    char *p, *f_codec, *f_props, *f_fps, *f_bpf, *sv;
+    double fps, curr_fps;
+    long bpf, best_bpf;
+    int len, best_same, need;
+    codec_t *codec;
+
+    /* Current capture codec and settings */
+    get_user_pref(CAPTURE_FORMAT, &p);
+
+    if (p == NULL || (codec = get_codec(p)) == NULL)
+    	return TRUE;
+
+    bench_user_props(codec, props, BENCH_PROPS_SZ);
+    bench_key(key, sizeof(key));
+    len = strlen(key);
+    get_session(FPS, &p);
+    need = atoi(p);
+
+    if ((fd = fopen(bench_fn(fn), "r")) == (FILE *) NULL)
+    	return TRUE;
+
+    curr_fps = -1;
+    best_bpf = -1;
+    best_same = FALSE;
+    best[0] = '\0';
+
+    while((fgets(buf, sizeof(buf), fd)) != NULL)
+    {
+	if (strncmp(buf, key, len) != 0 || buf[len] != '|')
+	    continue;
+
+	buf[strcspn(buf, "\n")] = '\0';
+	strtok_r(buf, "|", &sv);
+
+	if ((f_codec = strtok_r(NULL, "|", &sv)) == NULL)
+	    continue;
+
+	/* Settings may be empty */
+	f_props = sv;
+
+	if ((sv = strchr(f_props, '|')) == NULL)
+	    continue;
+
+	*sv++ = '\0';
+
+	if ((f_fps = strtok_r(NULL, "|", &sv)) == NULL)
+	    continue;
+
+	strtok_r(NULL, "|", &sv);				// Cpu
+
+	if ((f_bpf = strtok_r(NULL, "|", &sv)) == NULL)
+	    continue;
+
+	fps = atof(f_fps);
+	bpf = atol(f_bpf);
+
+	/* Current settings */
+	if (strcmp(f_codec, codec->fourcc) == 0 && strcmp(f_props, props) == 0)
+	{
+	    curr_fps = fps;
+	    continue;
+	}
+
+	/* Prefer the same codec, then the smallest output */
+	if (fps < (double) need)
+	    continue;
+
+	if (strcmp(f_codec, codec->fourcc) == 0)
+	{
+	    if (best_same == FALSE || bpf < best_bpf)
+	    {
+		best_same = TRUE;
+		best_bpf = bpf;
+		snprintf(best, sizeof(best), "%s (%s)", f_codec, f_props);
+	    }
+	}
+	else if (best_same == FALSE && (best_bpf == -1 || bpf < best_bpf))
+	{
+	    best_bpf = bpf;
+	    snprintf(best, sizeof(best), "%s (%s)", f_codec, (*f_props == '\0') ? "defaults" : f_props);
+	}
+    }
+
+    fclose(fd);
+
+    /* No results or keeps up */
+    if (curr_fps < 0 || curr_fps >= (double) need)
+    	return TRUE;
+
+    if (interactive == FALSE)
+    {
+	snprintf(s, sizeof(s), "capture format %s managed only %.1f fps (%d fps required), capturing anyway. "
+			       "Suggested: %s", codec->short_desc, curr_fps, need,
+			       (best[0] != '\0') ? best : "a lower frame rate or resolution");
+	log_msg("APP0011", s, NULL, NULL);
+	return TRUE;
+    }
+
+    if (best[0] != '\0')
+	snprintf(s, sizeof(s), "Capture format %s managed only %.1f fps in the encoder benchmark (%d fps required).\n"
+			       "Suggested: %s\n\nContinue anyway?", codec->short_desc, curr_fps, need, best);
+    else
+	snprintf(s, sizeof(s), "Capture format %s managed only %.1f fps in the encoder benchmark (%d fps required).\n"
+			       "No tested setting kept up - consider a lower frame rate or resolution.\n\n"
+			       "Continue anyway?", codec->short_desc, curr_fps, need);
+
+    if (query_dialog(m_ui->window, "%s", s) == GTK_RESPONSE_NO)
+    	return FALSE;
+
+    return TRUE;
+}
@@ -26,6 +26,17 @@
 **
 ** History
 **	01-Dec-2013	Initial code
+**	19-Oct-2026	Encoder benchmark
+**	19-Oct-2026	Pipeline statistics
+**	19-Oct-2026	Capture sequence
+**	19-Oct-2026	Camera tiles
+**	19-Oct-2026	Coalesced slider control writes
+**	19-Oct-2026	Control events for the selected camera
+**	19-Oct-2026	Sequence prompts from the menu only
+**	19-Oct-2026	No camera reload while a tile is recording
+**	19-Oct-2026	Frame checks restart when a capture resumes
+**	19-Oct-2026	Capture is interactive (benchmark check)
+**	19-Oct-2026	Control key buffers sized for every control id
 */
 
 
@@ -61,10 +72,14 @@ void OnCamScan(GtkWidget*, gpointer);
 void OnStartCapUi(GtkWidget*, gpointer);
 void OnStartCap(GtkWidget*, gpointer);
 void OnStopCap(GtkWidget*, gpointer);
+void OnCapSeq(GtkWidget*, gpointer);
 void OnSnapUi(GtkWidget*, gpointer);
 void OnSnapShot(GtkWidget*, gpointer);
 void OnPauseCap(GtkWidget*, gpointer);
 void OnPrefs(GtkWidget*, gpointer);
+void OnBenchmark(GtkWidget*, gpointer);
+void OnPipeStats(GtkWidget*, gpointer);
+void OnCamTiles(GtkWidget*, gpointer);
 void OnNightVision(GtkWidget*, gpointer);
 void OnReticule(GtkWidget*, gpointer);
 void OnAbout(GtkWidget*, gpointer);
@@ -90,6 +105,8 @@ void OnPrepReticule (GstElement *, GstCaps *, gpointer);
 void OnDrawReticule (GstElement *, cairo_t *, guint64, guint64, gpointer);
 
 int title_empty(MainUi *);
+gboolean ctrl_pend_write(gpointer);
+void ctrl_pend_flush();
 
 
 extern int gst_view(CamData *, MainUi *);
@@ -105,6 +122,10 @@ extern void free_window_reg();
 extern void close_open_ui();
 extern int is_ui_reg(char *, int);
 extern void save_ctrl(struct v4l2_queryctrl *, char *, long, CamData *, GtkWidget *);
+extern void cam_ctrl_batch(camera_t *);
+extern int cam_ctrl_commit(camera_t *, GtkWidget *);
+extern void cam_ctl_close(camera_t *);
+extern int cam_ctl_watch(camera_t *, GtkWidget *, GtkWidget *);
 extern int cam_ctrl_reset(CamData *, GtkWidget *, char, GtkWidget *);
 extern int cam_defaults(camera_t *, MainUi *, struct v4l2_list *);
 extern int cam_fmt_read(CamData *, struct v4l2_format *, struct v4l2_fmtdesc **, int);
@@ -128,8 +149,9 @@ extern int cam_set_state(CamData *, GstState, GtkWidget *);
 extern int capture_main(GtkWidget *);
 extern int snap_ui_main(GtkWidget *);
 extern int snap_control(CamData *, MainUi *, int, int, int);
+extern int seq_run(char *, CamData *, MainUi *, char *, int, int);
 extern int user_prefs_main(GtkWidget *);
-extern int gst_capture(CamData *, MainUi *, int, int);
+extern int gst_capture(CamData *, MainUi *, int, int, int);
 extern int val_str2numb(char *, int *, char *, GtkWidget *);
 extern int set_eos(MainUi *);
 extern int cancel_snapshot(MainUi *);
@@ -152,9 +174,15 @@ extern int snap_mutex_unlock();
 extern int close_ui(char *);
 extern gint query_dialog(GtkWidget *, char *, char *);
 extern int get_user_pref(char *, char **);
+extern int bench_control(CamData *, MainUi *);
+extern int stats_ui_main(GtkWidget *);
+extern int tiles_ui_main(GtkWidget *);
+extern int tiles_cam_used(char *);
+extern int tiles_close_all(int);
 /*
 extern void lock_imgbuf();
 extern void unlock_imgbuf();
+extern void frame_chk_resume(frame_chk_t *);
 */
 
 
@@ -163,6 +191,16 @@ extern void unlock_imgbuf();
 static const char *debug_hdr = "DEBUG-callbacks.c ";
 extern guintptr video_window_handle;
 
+/* Latest slider value not yet written to the camera */
+static struct
+{
+    struct v4l2_queryctrl *qctrl;
+    long val;
+    CamData *cam_data;
+    GtkWidget *window;
+    guint id;
+} ctrl_pend;
+
 
 /* Callbacks */
 
@@ -187,6 +225,13 @@ void OnCameraSel(GtkWidget *cam_sel, gpointer user_data)
     /* Get current camera and pipeline details */
     cam_data = (CamData *) user_data;
 
+    /* A camera shown in a tile has its own pipeline */
+    if (tiles_cam_used(cam_dev))
+    {
+	log_msg("APP0009", cam_nm, "APP0009", m_ui->window);
+    	return;
+    }
+
     /* Display a message if no change */
     if ((strcmp(cam_data->current_dev, cam_dev)) == 0)
     {
@@ -207,6 +252,12 @@ void OnCameraSel(GtkWidget *cam_sel, gpointer user_data)
     if (view_clear_pipeline(cam_data, m_ui) == FALSE)
         return;
 
+    /* Finish with the old camera controls */
+    ctrl_pend_flush();
+
+    if (cam_data->cam != NULL)
+	cam_ctl_close(cam_data->cam);
+
     /* Set new camera */
     strcpy(cam_data->current_cam, cam_nm);
     strcpy(cam_data->current_dev, cam_dev);
@@ -223,6 +274,7 @@ void OnCameraSel(GtkWidget *cam_sel, gpointer user_data)
     /* New camera selection may require resetting the controls */
     close_ui(OTHER_CTRL_UI); 
     reset_cntl_panel(m_ui, cam_data);
+    cam_ctl_watch(cam, m_ui->cntl_grid, m_ui->window);
 
     /* Rebuild the pipeline */
     gst_view(cam_data, m_ui);
@@ -264,6 +316,7 @@ void OnCamDefault(GtkWidget *def_val_btn, gpointer user_data)
     window = (GtkWidget *) user_data;
     cam_data = g_object_get_data (G_OBJECT(window), "cam_data");
     m_ui = g_object_get_data (G_OBJECT(window), "ui");
+    ctrl_pend_flush();
 
     cam_defaults(cam_data->cam, m_ui, cam_data->cam->ctl_head);
     cam_defaults(cam_data->cam, m_ui, cam_data->cam->pctl_head);
@@ -302,6 +355,8 @@ void OnCamScan(GtkWidget *cam_scan, gpointer user_data)
     MainUi *m_ui;
     CamData *cam_data;
     GtkWidget *window;
+    struct _capt_engine *eng;
+    struct _live_snap *live_snap;
 
     /* Get data */
     window = (GtkWidget *) user_data;
@@ -311,6 +366,15 @@ void OnCamScan(GtkWidget *cam_scan, gpointer user_data)
     /* Close the 'More Settings' ui if open */
     close_ui(OTHER_CTRL_UI); 
 
+    /* Camera tiles refer to the camera list (not while one is recording) */
+    if (tiles_close_all(FALSE) == FALSE)
+    {
+	log_msg("APP0010", NULL, "APP0010", window);
+    	return;
+    }
+
+    ctrl_pend_flush();
+
     /* Remove the current menu items */
     delete_menu_items(m_ui->cam_menu, "cam_");
 
@@ -321,7 +385,13 @@ void OnCamScan(GtkWidget *cam_scan, gpointer user_data)
 	    return;
 
 	clear_camera_list(cam_data);
+
+	/* Keep the engine and snapshot state (threads may refer to it) */
+	eng = cam_data->eng;
+	live_snap = cam_data->live_snap;
 	memset(cam_data, 0, sizeof (CamData));
+	cam_data->eng = eng;
+	cam_data->live_snap = live_snap;
     }
 
     /* Rebuild everything */
@@ -331,6 +401,7 @@ void OnCamScan(GtkWidget *cam_scan, gpointer user_data)
     	return;
 
     reset_cntl_panel(m_ui, cam_data);
+    cam_ctl_watch(cam_data->cam, m_ui->cntl_grid, m_ui->window);
 
     /* Rebuild the pipeline */
     gst_view(cam_data, m_ui);
@@ -396,7 +467,7 @@ void OnStartCap(GtkWidget *capture_btn, gpointer user_data)
     g_free(dur_str);
 
     /* Initiate capture */
-    gst_capture(cam_data, m_ui, duration, 0);
+    gst_capture(cam_data, m_ui, duration, 0, TRUE);
 
     return;
 }  
@@ -425,6 +496,55 @@ void OnStopCap(GtkWidget *capture_btn, gpointer user_data)
 }  
 
 
+/* Callback - Select a capture sequence file and run it */
+
+void OnCapSeq(GtkWidget *menu_item, gpointer user_data)
+{  
+    CamData *cam_data;
+    MainUi *m_ui;
+    GtkWidget *window, *dialog;
+    gchar *fn;
+    gint res;
+    char err[150];
+
+    /* Get data */
+    window = (GtkWidget *) user_data;
+    cam_data = g_object_get_data (G_OBJECT(window), "cam_data");
+    m_ui = g_object_get_data (G_OBJECT(window), "ui");
+
+    /* Check for empty Title */
+    if (title_empty(m_ui) == FALSE)
+    	return;
+
+    /* Selection */
+    dialog = gtk_file_chooser_dialog_new ("Capture Sequence",
+					  GTK_WINDOW (window),
+					  GTK_FILE_CHOOSER_ACTION_OPEN,
+					  "_Cancel", GTK_RESPONSE_CANCEL,
+					  "_Run", GTK_RESPONSE_ACCEPT,
+					  NULL);
+
+    res = gtk_dialog_run (GTK_DIALOG (dialog));
+    fn = NULL;
+
+    if (res == GTK_RESPONSE_ACCEPT)
+	fn = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
+
+    gtk_widget_destroy (dialog);
+
+    if (fn == NULL)
+    	return;
+
+    /* Load and start */
+    if (seq_run(fn, cam_data, m_ui, err, sizeof(err), TRUE) == FALSE)
+	log_msg("APP0008", err, "APP0008", window);
+
+    g_free (fn);
+
+    return;
+}  
+
+
 /* Callback -  Pause video capture */
 
 void OnPauseCap(GtkWidget *capture_btn, gpointer user_data)
@@ -442,6 +562,7 @@ void OnPauseCap(GtkWidget *capture_btn, gpointer user_data)
     /* If camera is playing, pause it, otherwise un-pause it and continue */
     if (cam_data->state == GST_STATE_PAUSED)
     {
+	frame_chk_resume(&(cam_data->u.v_capt.fchk));
 	cam_set_state(cam_data, GST_STATE_PLAYING, window);
 	snprintf(s, sizeof(s), "Camera %s (%s) capturing resumed ", cam_data->current_cam_abbr, cam_data->current_dev_abbr);
 	gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
@@ -537,6 +658,77 @@ void OnPrefs(GtkWidget *menu_item, gpointer user_data)
 }  
 
 
+/* Callback - Run the encoder benchmark */
+
+void OnBenchmark(GtkWidget *menu_item, gpointer user_data)
+{  
+    GtkWidget *window;
+    CamData *cam_data;
+    MainUi *m_ui;
+    gint res;
+
+    /* Get data */
+    window = (GtkWidget *) user_data;
+    cam_data = (CamData *) g_object_get_data (G_OBJECT(window), "cam_data");
+    m_ui = (MainUi *) g_object_get_data (G_OBJECT(window), "ui");
+
+    if (cam_data->mode != CAM_MODE_VIEW)
+    {
+	app_msg("CAM0025", NULL, window);
+    	return;
+    }
+
+    res = query_dialog(window, "The camera will be stopped while each capture format is timed. Continue?", (char *) NULL);
+
+    if (res == GTK_RESPONSE_NO)
+	return;
+
+    bench_control(cam_data, m_ui);
+
+    return;
+}  
+
+
+/* Callback - Show the pipeline statistics */
+
+void OnPipeStats(GtkWidget *menu_item, gpointer user_data)
+{  
+    GtkWidget *window;
+
+    /* Get data */
+    window = (GtkWidget *) user_data;
+
+    /* Check if already open */
+    if (is_ui_reg(STATS_UI, TRUE))
+    	return;
+
+    /* Open */
+    stats_ui_main(window);
+
+    return;
+}  
+
+
+/* Callback - Open the camera tiles window (other cameras alongside the main one) */
+
+void OnCamTiles(GtkWidget *menu_item, gpointer user_data)
+{  
+    GtkWidget *window;
+
+    /* Get data */
+    window = (GtkWidget *) user_data;
+
+    /* Check if already open */
+    if (is_ui_reg(TILES_UI, TRUE))
+    	return;
+
+    /* Open */
+    tiles_ui_main(window);
+
+    return;
+}  
+
+
 /* Callback - Reset Night Vision (only applies when switched on) */
 
 gboolean OnNvExpose(GtkWidget *widget, cairo_t *cr, gpointer user_data)
@@ -669,6 +861,7 @@ void OnSetProfile(GtkWidget *cbox, gpointer user_data)
 
     /* Close 'Other Control' window if open */
     close_ui(OTHER_CTRL_UI); 
+    ctrl_pend_flush();
 
     /* No Profile */
     if (strcmp(cur_profile, PRF_NONE) == 0)
@@ -681,9 +874,11 @@ void OnSetProfile(GtkWidget *cbox, gpointer user_data)
     if (view_clear_pipeline(cam_data, m_ui) == FALSE)
         return;
    
-    /* Load the preset profile and reset the window */
+    /* Load the preset profile and reset the window (the controls are set in one request) */
     load_profile(cur_profile);
+    cam_ctrl_batch(cam_data->cam);
     reset_cntl_panel(m_ui, cam_data);
+    cam_ctrl_commit(cam_data->cam, m_ui->window);
 
     if ((strcmp(cur_profile, LAST_SESSION) == 0) || (strcmp(cur_profile, PRF_NONE) == 0))
     	gtk_widget_set_sensitive (m_ui->save_profile_btn, FALSE);
@@ -931,7 +1126,8 @@ void OnSetCtrl(GtkRange *slider, GtkScrollType scroll, gdouble val, gpointer use
     CamData *cam_data;
     struct v4l2_queryctrl *qctrl;
     long ival;
-    char ctl_key[10];
+    int fps, ms;
+    char *p;
 
     /* Update the slider and get required objects */
     ival = round(val);
@@ -941,9 +1137,22 @@ void OnSetCtrl(GtkRange *slider, GtkScrollType scroll, gdouble val, gpointer use
     window = g_object_get_data (G_OBJECT(slider), "ui_window");
     cam_data = (CamData *) user_data;
 
-    /* Set the control */
-    sprintf(ctl_key, "ctl-%d", qctrl->id - V4L2_CID_BASE);
-    save_ctrl(qctrl, ctl_key, ival, cam_data, window);
+    /* A drag gives many changes, only the latest is written each frame interval */
+    if (ctrl_pend.id != 0 && ctrl_pend.qctrl != qctrl)
+	ctrl_pend_flush();
+
+    ctrl_pend.qctrl = qctrl;
+    ctrl_pend.val = ival;
+    ctrl_pend.cam_data = cam_data;
+    ctrl_pend.window = window;
+
+    if (ctrl_pend.id == 0)
+    {
+	get_session(FPS, &p);
+	fps = (p != NULL) ? atoi(p) : 0;
+	ms = (fps > 0) ? 1000 / fps : 100;
+	ctrl_pend.id = g_timeout_add((ms < 10) ? 10 : ms, ctrl_pend_write, NULL);
+    }
 
     return;
 }  
@@ -957,7 +1166,7 @@ void OnSetCtrlCbox(GtkWidget *cbox, gpointer user_data)
     CamData *cam_data;
     struct v4l2_queryctrl *qctrl;
     long ival;
-    char ctl_key[10];
+    char ctl_key[CTL_KEY_SZ];
 
     /* Get data */
     cam_data = (CamData *) user_data;
@@ -966,7 +1175,7 @@ void OnSetCtrlCbox(GtkWidget *cbox, gpointer user_data)
     ival = gtk_combo_box_get_active (GTK_COMBO_BOX (cbox));
 
     /* Set the control */
-    sprintf(ctl_key, "ctl-%d", qctrl->id - V4L2_CID_BASE);
+    snprintf(ctl_key, sizeof(ctl_key), "ctl-%d", qctrl->id - V4L2_CID_BASE);
     save_ctrl(qctrl, ctl_key, ival, cam_data, window);
 
     return;
@@ -981,7 +1190,7 @@ void OnSetCtrlRadio(GtkToggleButton *radio_btn, gpointer user_data)
     CamData *cam_data;
     struct v4l2_queryctrl *qctrl;
     long ival;
-    char ctl_key[10];
+    char ctl_key[CTL_KEY_SZ];
 
     /* Get data */
     cam_data = (CamData *) user_data;
@@ -994,7 +1203,7 @@ void OnSetCtrlRadio(GtkToggleButton *radio_btn, gpointer user_data)
 
     /* Set the control and check for impact on other controls */
     ival = GPOINTER_TO_INT (g_object_get_data (G_OBJECT(radio_btn), "index"));
-    sprintf(ctl_key, "ctl-%d", qctrl->id - V4L2_CID_BASE);
+    snprintf(ctl_key, sizeof(ctl_key), "ctl-%d", qctrl->id - V4L2_CID_BASE);
     save_ctrl(qctrl, ctl_key, ival, cam_data, window);
     cam_auto_reset(GTK_WIDGET (radio_btn), qctrl, ival, cam_data->cam, window);
 
@@ -1017,7 +1226,7 @@ void OnSetCtrlRadio(GtkToggleButton *radio_btn, gpointer user_data)
     if (tmp != NULL)
     {
 	ival = GPOINTER_TO_INT (g_object_get_data (G_OBJECT(tmp), "index"));
-	sprintf(ctl_key, "ctl-%d", qctrl->id - V4L2_CID_BASE);
+	snprintf(ctl_key, sizeof(ctl_key), "ctl-%d", qctrl->id - V4L2_CID_BASE);
 	save_ctrl(qctrl, ctl_key, ival, cam_data, window);
 	cam_auto_reset(GTK_WIDGET (tmp), qctrl, ival, cam_data->cam, window);
     }
@@ -1037,6 +1246,7 @@ void OnCtrlDefVal(GtkWidget *def_val_btn, gpointer user_data)
     /* Get data */
     cam_data = (CamData *) user_data;
     m_ui = g_object_get_data (G_OBJECT(def_val_btn), "ui");
+    ctrl_pend_flush();
 
     cam_ctrl_reset(cam_data, m_ui->cntl_grid, 'd', m_ui->window);
 
@@ -1054,6 +1264,7 @@ void OnCtrlReset(GtkWidget *reset_btn, gpointer user_data)
     /* Get data */
     cam_data = (CamData *) user_data;
     m_ui = g_object_get_data (G_OBJECT(reset_btn), "ui");
+    ctrl_pend_flush();
 
     cam_ctrl_reset(cam_data, m_ui->cntl_grid, 'l', m_ui->window);
     gtk_widget_set_sensitive (m_ui->save_profile_btn, FALSE);
@@ -1247,6 +1458,10 @@ void OnQuit(GtkWidget *window, gpointer user_data)
     /* Get window and current camera details */
     cam_data = g_object_get_data (G_OBJECT(window), "cam_data");
 
+    /* Camera tiles first (they share the camera list), recordings are finished off */
+    tiles_close_all(TRUE);
+    ctrl_pend_flush();
+
     if (cam_data->camlist != NULL)
     {
 	/* Free resources */
@@ -1284,6 +1499,34 @@ void OnQuit(GtkWidget *window, gpointer user_data)
 /* CALLBACK other functions */
 
 
+/* Write the latest slider value */
+
+gboolean ctrl_pend_write(gpointer user_data)
+{
+    char ctl_key[CTL_KEY_SZ];
+
+    ctrl_pend.id = 0;
+    snprintf(ctl_key, sizeof(ctl_key), "ctl-%d", ctrl_pend.qctrl->id - V4L2_CID_BASE);
+    save_ctrl(ctrl_pend.qctrl, ctl_key, ctrl_pend.val, ctrl_pend.cam_data, ctrl_pend.window);
+
+    return FALSE;
+}
+
+
+/* Write a waiting slider value now */
+
+void ctrl_pend_flush()
+{
+    if (ctrl_pend.id == 0)
+    	return;
+
+    g_source_remove(ctrl_pend.id);
+    ctrl_pend_write(NULL);
+
+    return;
+}
+
+
 /* Check for empty Title, if required */
 
 int title_empty(MainUi *m_ui)
@@ -26,6 +26,23 @@
 **
 ** History
 **	15-Jan-2014	Initial
+**	19-Oct-2026	Capture limit probe counters
+**	19-Oct-2026	Native format passthrough capture
+**	19-Oct-2026	Reduced rate and size display branch during capture
+**	19-Oct-2026	Per element pipeline statistics
+**	19-Oct-2026	Driver frame sequence and timing checks
+**	19-Oct-2026	Per frame timestamp file
+**	19-Oct-2026	Live snapshot probe
+**	19-Oct-2026	Sequence capture file probe
+**	19-Oct-2026	Per camera engine and snapshot state (several cameras)
+**	19-Oct-2026	Frame processing stages
+**	19-Oct-2026	Frame output (shared memory) branch
+**	19-Oct-2026	Network preview branch
+**	19-Oct-2026	Control handle and batched control writes
+**	19-Oct-2026	Control value cache and control events
+**	19-Oct-2026	Control flags that follow the camera state, quiet enumeration
+**	19-Oct-2026	Frame checks restart after a pause
+**	19-Oct-2026	Control key buffers sized for every control id
 **
 */
 
@@ -36,6 +53,9 @@
 #define CAM_HDR
 #endif
 
+#define CTRL_STATE_FLAGS (V4L2_CTRL_FLAG_INACTIVE | V4L2_CTRL_FLAG_GRABBED)	// Not cached (camera state)
+#define CTL_KEY_SZ 20						// Control session key "ctl-<id less base>"
+
 /* Includes */
 
 #include <linux/videodev2.h>
@@ -64,6 +84,17 @@ struct v4l2_list
 };
 
 
+/* Control writes held while a batch is open (see cam_ctrl_batch) */
+
+typedef struct _ctrl_batch
+{
+    int n;
+    int max;
+    struct v4l2_queryctrl **qctrl;
+    long *val;
+} ctrl_batch_t;
+
+
 /* Structure to hold information about and capabilities of a camera */
 
 typedef struct _camera
@@ -79,6 +110,13 @@ typedef struct _camera
     struct v4l2_list *fmt_head;		/* Formats list head */
     struct v4l2_list *fmt_last;		/* Formats list end */
     struct v4l2_buffer vbuf;            /* Video buffer */
+    int ctl_fd;				/* Control handle kept open for the session (-1 none) */
+    struct _ctrl_batch *batch;		/* Held control writes (NULL none) */
+    GHashTable *ctl_vals;		/* Control values by id, kept by control events (NULL none) */
+    guint ctl_watch;			/* Control event source id */
+    struct _GtkWidget *ctl_grid;	/* Sliders to update on control events */
+    struct _frame_times *ftm;		/* Control changes are noted here while capturing */
+    int quiet;				/* Enumerate without messages (background check) */
 } camera_t;
 
 
@@ -102,6 +140,29 @@ typedef struct _cairo_overlay_state
 } CairoOverlayState;
 
 
+/* Driver frame sequence and timing checks (see frame_check) */
+
+typedef struct _frame_chk
+{
+    gint64 last_seq;					// V4L2 sequence (-1 none / unknown)
+    guint64 last_ts;					// Timestamp ns (0 none)
+    guint64 interval;					// Expected frame interval ns (tracked)
+    long frames;
+    long dropped;					// Sequence gaps
+    long duplicated;					// Repeated sequence or timestamp
+    long late;						// In sequence but well past the interval
+    guint64 jitter_max;					// ns
+    guint64 jitter_sum;					// ns
+    long jitter_n;
+    gint resync;					// Restart from the next frame (resumed)
+} frame_chk_t;
+
+
+/* Per frame timestamp file (see frame_times.c) */
+
+struct _frame_times;
+
+
 /* Snapshot capture details */
 
 typedef struct _ImgCapture
@@ -130,6 +191,8 @@ typedef struct _ImgCapture
     char id;						// Preferences
     char tt;						// Preferences
     char ts;						// Preferences
+    frame_chk_t fchk;					// Driver frame checks
+    struct _frame_times *ftm;				// Frame timestamps (if required)
 } snap_capt_t;
 
 
@@ -147,7 +210,16 @@ typedef struct _VideoCapture
     long capt_actl;
     long capt_frames;
     long capt_dropped;
-    char cam_fcc[5];					// Preferences
+    guint64 rt_start;					// Running time of first captured buffer
+    guint64 rt_elapsed;					// Running time captured (incl. last buffer)
+    guint64 rt_posted;					// Running time of last progress message
+    guint64 buf_count;					// Buffers passed to the capture branch
+    int limit_hit;					// Limit reached, EOS sent downstream
+    int seg_hot;					// Sequence - only the capture branch is ended
+    char cam_fcc[20];					// Negotiated (or session) camera format
+    int passthru;					// Camera format captured without conversion
+    frame_chk_t fchk;					// Driver frame checks
+    struct _frame_times *ftm;				// Frame timestamps (if required)
     char *codec;					// Preferences
     char *locn;						// Preferences
     char id;						// Preferences
@@ -165,16 +237,38 @@ typedef struct _app_gst_objects
     GstElement *c_convert;						// Fixed capture
     GstElement *encoder; 						// Encoder capture
     GstElement *c_filter;						// Caps capture
+    GstElement *view_rate, *view_scale, *view_filter;			// Capture display branch
     GstElement *q1; 							// Reticule (insertion) related
+    GstElement *proc, *v_proc;						// Processing stages (all, display only)
+    GstElement *out_tee, *shm_queue, *shm_sink;				// Frame output branches
+    GstElement *net_queue, *net_rate, *net_scale, *net_convert;		// Network preview
+    GstElement *net_filter, *net_enc, *net_pay, *net_sink;
     GstPad *tee_capt_pad, *tee_video_pad;
     GstCaps *v_caps, *c_caps;						
     GstElement *cairo_overlay, *cairo_convert;				// Cairo elements for reticule
     GstPad *blockpad;							// Reticule only
     gulong probe_id;							// Reticule only
+    gulong limit_probe_id;						// Capture limits
+    gulong fchk_probe_id;						// Driver frame checks
+    gulong snap_probe_id;						// Live snapshots
+    gulong seg_probe_id;						// Sequence capture file end
     CairoOverlayState *overlay_state;					// Reticule only
 } app_gst_objects; 
 
 
+/* Per element pipeline statistics (see pipeline_stats.c) */
+
+typedef struct _pipe_stat
+{
+    char nm[20];
+    double fps;							// Buffers / sec (last interval)
+    double mbps;						// MB / sec (last interval)
+    double lat_p50, lat_p95, lat_p99;				// Latency ms (-1 not measured)
+    int level, level_max;					// Queue fill (-1 not a queue)
+    guint64 buffers, bytes;					// Totals
+} pipe_stat_t;
+
+
 /* Structure to contain all our information, so we can pass it around */
 
 typedef struct _CamData
@@ -193,6 +287,10 @@ typedef struct _CamData
     struct camlistNode *camlist;	/* Pointer to head of camera list */
     GdkPixbuf *pixbuf;			/* Snapshot usage */
     int status;				/* General purpose */
+    int inst;				/* 0 = main camera, otherwise a camera tile */
+    GHashTable *sess;			/* Tile format values (main camera uses the session) */
+    struct _capt_engine *eng;		/* Pipeline engine state (see gst_view_capture.c) */
+    struct _live_snap *live_snap;	/* Live snapshot state (see snapshot.c) */
     union
     {
 	video_capt_t v_capt;		/* Video capture details */
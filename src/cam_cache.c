@@ -0,0 +1,475 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Camera capability cache. The controls, menus, formats, frame sizes and frame
+**		rates enumerated for a camera are saved so they need not be queried again
+**		(some cameras take seconds to answer).
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Control state flags not cached, background check reported on the main loop
+**
+*/
+
+/*
+    One file per camera in the application directory, named from a checksum of the bus, driver,
+    driver version and card (so a driver update or a different camera model starts afresh):
+
+    	$HOME/.AstroCTC/CameraCache/<sha1>.caps
+
+    The file is the lists in camera_t written in order, each node's v4l2 structure followed by
+    its sub list. The structure sizes are in the header and a mismatch rejects the file. The
+    control flags that follow the camera state (inactive, grabbed) are left out; they are read
+    from the camera when it is selected (see cam_ctrl_flags).
+
+	"ACTCCAPS", version, 5 structure sizes
+	controls	count, (v4l2_queryctrl, count, v4l2_querymenu ...) ...
+	private		count, v4l2_queryctrl ...
+	formats		count, (v4l2_fmtdesc, count, (v4l2_frmsizeenum, count, v4l2_frmivalenum ...) ...) ...
+
+    A cached camera is enumerated again once per run in a background thread, which does not log
+    (log_msg and app_msg_extra belong to the main loop). The result is compared on the main loop
+    and if anything differs the file is rewritten and used from the next time the camera is
+    selected.
+*/
+
+
+/* Defines */
+
+#define CACHE_MAGIC "ACTCCAPS"
+#define CACHE_VERSION 1
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <linux/videodev2.h>
+#include <libv4l2.h>
+#include <gtk/gtk.h>
+#include <main.h>
+#include <cam.h>
+#include <defs.h>
+
+
+/* Prototypes */
+
+int cam_cache_load(camera_t *);
+void cam_cache_save(camera_t *);
+void cam_cache_check(camera_t *);
+char * cache_path(struct v4l2_capability *, int);
+int cache_write(FILE *, camera_t *);
+int cache_write_list(FILE *, struct v4l2_list *, const guint32 *, int);
+int cache_read_list(FILE *, struct v4l2_list **, struct v4l2_list **, const guint32 *);
+void * cache_check_thread(void *);
+gboolean cache_check_done(gpointer);
+void cache_free(camera_t *);
+int cache_changed(camera_t *);
+char * cache_image(camera_t *, size_t *);
+
+extern int camera_ctrls(camera_t *, GtkWidget *);
+extern int camera_formats(camera_t *, GtkWidget *);
+extern void free_cam_data(struct v4l2_list *);
+extern struct v4l2_list *new_v4l2Node(int);
+extern char * app_dir_path();
+extern int check_dir(char *);
+extern int make_dir(char *);
+extern void log_msg(char*, char*, char*, GtkWidget*);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-cam_cache.c ";
+
+// Structure sizes by list depth (0 ends)
+static const guint32 ctl_sz[] = { sizeof(struct v4l2_queryctrl), sizeof(struct v4l2_querymenu), 0 };
+static const guint32 pctl_sz[] = { sizeof(struct v4l2_queryctrl), 0 };
+static const guint32 fmt_sz[] = { sizeof(struct v4l2_fmtdesc), sizeof(struct v4l2_frmsizeenum),
+				  sizeof(struct v4l2_frmivalenum), 0 };
+
+static GHashTable *checked = NULL;				// Cache files checked this run
+
+
+/* Load the camera details from the cache, if present and valid */
+
+int cam_cache_load(camera_t *cam)
+{
+    FILE *fd;
+    char *path;
+    char magic[8];
+    guint32 hdr[6];
+    int r;
+
+    if ((path = cache_path(&(cam->vcaps), FALSE)) == NULL)
+    	return FALSE;
+
+    fd = fopen(path, "rb");
+    g_free(path);
+
+    if (fd == NULL)
+    	return FALSE;
+
+    /* Header */
+    r = (fread(magic, 1, sizeof(magic), fd) == sizeof(magic) &&
+    	 fread(hdr, sizeof(guint32), 6, fd) == 6 &&
+	 memcmp(magic, CACHE_MAGIC, sizeof(magic)) == 0 &&
+	 hdr[0] == CACHE_VERSION &&
+	 hdr[1] == ctl_sz[0] && hdr[2] == ctl_sz[1] &&
+	 hdr[3] == fmt_sz[0] && hdr[4] == fmt_sz[1] && hdr[5] == fmt_sz[2]);
+
+    /* Lists */
+    if (r == TRUE)
+	r = cache_read_list(fd, &(cam->ctl_head), &(cam->ctl_last), ctl_sz) &&
+	    cache_read_list(fd, &(cam->pctl_head), &(cam->pctl_last), pctl_sz) &&
+	    cache_read_list(fd, &(cam->fmt_head), &(cam->fmt_last), fmt_sz);
+
+    fclose(fd);
+
+    /* A bad file is ignored (it is replaced when the camera is enumerated) */
+    if (r == FALSE)
+    {
+	free_cam_data(cam->ctl_head);
+	free_cam_data(cam->pctl_head);
+	free_cam_data(cam->fmt_head);
+	cam->ctl_head = cam->ctl_last = NULL;
+	cam->pctl_head = cam->pctl_last = NULL;
+	cam->fmt_head = cam->fmt_last = NULL;
+    }
+
+    return r;
+}
+
+
+/* Save the camera details (written to a temporary file and renamed) */
+
+void cam_cache_save(camera_t *cam)
+{
+    FILE *fd;
+    char *path, *tmp;
+    int r;
+
+    if ((path = cache_path(&(cam->vcaps), TRUE)) == NULL)
+    	return;
+
+    tmp = g_strdup_printf ("%s.%d", path, (int) getpid());
+
+    if ((fd = fopen(tmp, "wb")) == NULL)
+    {
+	log_msg("SYS9005", tmp, NULL, NULL);
+	g_free(path);
+	g_free(tmp);
+	return;
+    }
+
+    r = cache_write(fd, cam);
+
+    if (fclose(fd) != 0 || r == FALSE || rename(tmp, path) != 0)
+    {
+	log_msg("SYS9005", tmp, NULL, NULL);
+	unlink(tmp);
+    }
+
+    g_free(path);
+    g_free(tmp);
+
+    return;
+}
+
+
+/* Check a cached camera against the device in the background (once per run) */
+
+void cam_cache_check(camera_t *cam)
+{
+    camera_t *chk;
+    pthread_t tid;
+    char *path;
+
+    if ((path = cache_path(&(cam->vcaps), FALSE)) == NULL)
+    	return;
+
+    if (checked == NULL)
+	checked = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    if (g_hash_table_contains (checked, path))
+    {
+	g_free(path);
+    	return;
+    }
+
+    g_hash_table_add (checked, path);
+
+    /* The thread works on its own copy (the camera list may be cleared meanwhile) */
+    chk = (camera_t *) calloc(1, sizeof(camera_t));
+    chk->ctl_fd = -1;
+    strcpy(chk->video_dev, cam->video_dev);
+    memcpy(&(chk->vcaps), &(cam->vcaps), sizeof(struct v4l2_capability));
+
+    if (pthread_create(&tid, NULL, &cache_check_thread, (void *) chk) != 0)
+    {
+	log_msg("SYS9016", NULL, NULL, NULL);
+	free(chk);
+	return;
+    }
+
+    pthread_detach(tid);
+
+    return;
+}
+
+
+/* Enumerate the camera again (no ui or logging here) and pass it to the main loop */
+
+void * cache_check_thread(void *arg)
+{
+    camera_t *chk;
+    int r;
+
+    chk = (camera_t *) arg;
+    chk->quiet = TRUE;
+    r = FALSE;
+
+    if ((chk->fd = v4l2_open(chk->video_dev, O_RDWR, 0)) != -1)
+    {
+	r = (camera_ctrls(chk, NULL) && camera_formats(chk, NULL));
+	v4l2_close(chk->fd);
+    }
+
+    if (r == TRUE)
+	g_idle_add (cache_check_done, (gpointer) chk);
+    else
+	cache_free(chk);
+
+    pthread_exit(NULL);
+}
+
+
+/* Main loop - replace the cache if anything is different */
+
+gboolean cache_check_done(gpointer user_data)
+{
+    camera_t *chk;
+
+    chk = (camera_t *) user_data;
+
+    if (cache_changed(chk) == TRUE)
+    {
+	cam_cache_save(chk);
+	log_msg("CAM0035", (char *) chk->vcaps.card, NULL, NULL);
+    }
+
+    cache_free(chk);
+
+    return FALSE;
+}
+
+
+/* Free a camera copy and its lists */
+
+void cache_free(camera_t *cam)
+{
+    free_cam_data(cam->ctl_head);
+    free_cam_data(cam->pctl_head);
+    free_cam_data(cam->fmt_head);
+    free(cam);
+
+    return;
+}
+
+
+/* Compare freshly enumerated details with the cache file */
+
+int cache_changed(camera_t *chk)
+{
+    camera_t *old;
+    char *img_new, *img_old;
+    size_t sz_new, sz_old;
+    int r;
+
+    old = (camera_t *) calloc(1, sizeof(camera_t));
+    memcpy(&(old->vcaps), &(chk->vcaps), sizeof(struct v4l2_capability));
+    r = TRUE;
+
+    if (cam_cache_load(old) == TRUE)
+    {
+	img_new = cache_image(chk, &sz_new);
+	img_old = cache_image(old, &sz_old);
+
+	if (img_new != NULL && img_old != NULL && sz_new == sz_old)
+	    r = (memcmp(img_new, img_old, sz_new) != 0);
+
+	free(img_new);
+	free(img_old);
+    }
+
+    cache_free(old);
+
+    return r;
+}
+
+
+/* Cache file contents in memory (for comparison) */
+
+char * cache_image(camera_t *cam, size_t *sz)
+{
+    FILE *fd;
+    char *buf;
+
+    buf = NULL;
+
+    if ((fd = open_memstream(&buf, sz)) == NULL)
+    	return NULL;
+
+    cache_write(fd, cam);
+    fclose(fd);
+
+    return buf;
+}
+
+
+/* Cache file path for a camera, optionally creating the directory */
+
+char * cache_path(struct v4l2_capability *vcaps, int create)
+{
+    char *dir, *key, *sum, *path;
+
+    dir = g_strdup_printf ("%s/%s", app_dir_path(), CAPS_CACHE);
+
+    if (create == TRUE && ! check_dir(dir))
+    {
+	if (! make_dir(dir))
+	{
+	    g_free(dir);
+	    return NULL;
+	}
+    }
+
+    key = g_strdup_printf ("%.32s|%.16s|%u|%.32s", vcaps->bus_info, vcaps->driver, vcaps->version, vcaps->card);
+    sum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+    path = g_strdup_printf ("%s/%s.caps", dir, sum);
+
+    g_free(dir);
+    g_free(key);
+    g_free(sum);
+
+    return path;
+}
+
+
+/* Write the header and lists */
+
+int cache_write(FILE *fd, camera_t *cam)
+{
+    guint32 hdr[6];
+
+    hdr[0] = CACHE_VERSION;
+    hdr[1] = ctl_sz[0];
+    hdr[2] = ctl_sz[1];
+    hdr[3] = fmt_sz[0];
+    hdr[4] = fmt_sz[1];
+    hdr[5] = fmt_sz[2];
+
+    if (fwrite(CACHE_MAGIC, 1, 8, fd) != 8 || fwrite(hdr, sizeof(guint32), 6, fd) != 6)
+    	return FALSE;
+
+    return cache_write_list(fd, cam->ctl_head, ctl_sz, TRUE) &&
+	   cache_write_list(fd, cam->pctl_head, pctl_sz, TRUE) &&
+	   cache_write_list(fd, cam->fmt_head, fmt_sz, FALSE);
+}
+
+
+/* Write a list and its sub lists (controls without their state flags) */
+
+int cache_write_list(FILE *fd, struct v4l2_list *head, const guint32 *sz, int ctl)
+{
+    struct v4l2_list *node;
+    struct v4l2_queryctrl qctrl;
+    void *data;
+    guint32 n;
+
+    for(n = 0, node = head; node != NULL; node = node->next)
+    	n++;
+
+    if (fwrite(&n, sizeof(guint32), 1, fd) != 1)
+    	return FALSE;
+
+    for(node = head; node != NULL; node = node->next)
+    {
+	data = node->v4l2_data;
+
+	if (ctl == TRUE)
+	{
+	    memcpy(&qctrl, data, sizeof(qctrl));
+	    qctrl.flags &= ~CTRL_STATE_FLAGS;
+	    data = &qctrl;
+	}
+
+	if (fwrite(data, sz[0], 1, fd) != 1)
+	    return FALSE;
+
+	if (sz[1] != 0 && ! cache_write_list(fd, node->sub_list_head, sz + 1, FALSE))
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Read a list and its sub lists */
+
+int cache_read_list(FILE *fd, struct v4l2_list **head, struct v4l2_list **last, const guint32 *sz)
+{
+    struct v4l2_list *node;
+    guint32 i, n;
+
+    if (fread(&n, sizeof(guint32), 1, fd) != 1 || n > 100000)
+    	return FALSE;
+
+    for(i = 0; i < n; i++)
+    {
+	node = new_v4l2Node(sz[0]);
+
+	if (*head == NULL)
+	    *head = node;
+	else
+	    (*last)->next = node;
+
+	*last = node;
+
+	if (fread(node->v4l2_data, sz[0], 1, fd) != 1)
+	    return FALSE;
+
+	if (sz[1] != 0 && ! cache_read_list(fd, &(node->sub_list_head), &(node->sub_list_last), sz + 1))
+	    return FALSE;
+    }
+
+    return TRUE;
+}
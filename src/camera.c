@@ -26,6 +26,15 @@
 **
 ** History
 **	15-Dec-2013	Initial code
+**	19-Oct-2026	Set several controls in one request
+**	19-Oct-2026	Persistent control handle and batched control writes
+**	19-Oct-2026	Control value cache kept current by control events
+**	19-Oct-2026	Capability cache (see cam_cache.c)
+**	19-Oct-2026	Probe the video devices in parallel
+**	19-Oct-2026	Single device probe and list removal (camera hotplug)
+**	19-Oct-2026	Control snapshot in the frame timestamps file after the application's own writes
+**	19-Oct-2026	Control state flags refreshed from the camera, quiet enumeration (cache check)
+**	19-Oct-2026	Control key buffers sized for every control id
 **
 */
 
@@ -54,6 +63,22 @@
 
 /* Defines */
 #define MAX_STD_CTRLS 10
+#define PROBE_THREADS 8
+#define PROBE_TIMEOUT 3000000					// us per device
+
+
+/* Structures and Typedefs required */
+
+typedef struct _cam_probe
+{
+    char video_dev[300];
+    struct camlistNode *node;				// Capture device found (else NULL)
+    char *op;						// Failed operation (else NULL)
+    int err;
+    gint64 started;					// Monotonic (us), 0 - queued
+    int done;
+    int refs;						// Freed by the last user
+} cam_probe_t;
 
 
 /* Prototypes */
@@ -61,7 +86,13 @@
 //GList* gst_camera_devices(gchar*);
 struct camlistNode* dev_camera_devices(GtkWidget*);
 struct camlistNode* new_listNode();
+void probe_device(gpointer, gpointer);
+void probe_free(cam_probe_t *);
+gint probe_cmp(gconstpointer, gconstpointer);
 void add_listNode(struct camlistNode*, struct camlistNode**);
+struct camlistNode* dev_camera_node(char *);
+struct camlistNode* find_listNode(CamData *, char *);
+void remove_listNode(CamData *, struct camlistNode *);
 int camera_setup(camera_t*, GtkWidget*);
 int camera_caps(camera_t*, GtkWidget*);
 int camera_ctrls(camera_t*, GtkWidget*);
@@ -76,6 +107,18 @@ struct v4l2_list * get_next_oth_ctrl(struct v4l2_list *, CamData *);
 int find_ctl(camera_t *, char *); 
 int get_cam_ctrl(long, struct v4l2_queryctrl *, camera_t *, GtkWidget *);
 int set_cam_ctrl(camera_t *, struct v4l2_queryctrl *, long, GtkWidget *);
+int set_cam_ctrls(camera_t *, struct v4l2_queryctrl **, long *, int, GtkWidget *);
+int cam_ctrl_write(camera_t *, struct v4l2_queryctrl *, long, GtkWidget *);
+void cam_ctrl_batch(camera_t *);
+int cam_ctrl_commit(camera_t *, GtkWidget *);
+int cam_ctrl_get(camera_t *, struct v4l2_queryctrl *, long *);
+void cam_ctrl_cache(camera_t *, __u32, long);
+int cam_ctl_watch(camera_t *, GtkWidget *, GtkWidget *);
+gboolean OnCtlEvent(GIOChannel *, GIOCondition, gpointer);
+char * cam_ctrl_snapshot(camera_t *);
+void cam_ctrl_flags(camera_t *);
+static struct v4l2_queryctrl * cam_ctrl_find(camera_t *, __u32);
+static void cam_ctrl_note(camera_t *);
 int cam_defaults(camera_t *, MainUi *, struct v4l2_list *); 
 int cam_ctrl_reset(CamData *, GtkWidget *, char, GtkWidget *); 
 void cam_reset_range(GtkWidget *, CamData *, char, GtkWidget *); 
@@ -99,6 +142,8 @@ int get_fps(CamData *, char *);
 int xioctl(int, int, void *);
 void xv4l2_close(camera_t *);
 int cam_open(char *, int, GtkWidget *);
+int cam_ctl_fd(camera_t *, GtkWidget *);
+void cam_ctl_close(camera_t *);
 void session_ctrl_val(struct v4l2_queryctrl *, char *, long *);
 void save_ctrl(struct v4l2_queryctrl *, char *, long, CamData *, GtkWidget *);
 void clear_camera_list(CamData *);
@@ -117,6 +162,11 @@ extern GtkWidget * find_parent(GtkWidget *);
 extern pixelfmt fourcc2pxl(char *);
 extern void res_to_long(char *, long *, long *);
 extern int calc_fps(pixelfmt, pixelfmt);
+extern GtkWidget * find_widget_by_name(GtkWidget *, char *);
+extern void ftm_ctrls(struct _frame_times *, guint64, char *);
+extern int cam_cache_load(camera_t *);
+extern void cam_cache_save(camera_t *);
+extern void cam_cache_check(camera_t *);
 
 
 /* Globals */
@@ -130,6 +180,8 @@ static const char *v4l2_warn = "Function returned 0 results (may not be supporte
 struct camlistNode *head = NULL;
 static struct v4l2_queryctrl *p_std_ctrls[MAX_STD_CTRLS];
 static int current_idx;
+static GMutex probe_mutex;
+static GCond probe_cond;
 
 
 /* Use GST Probe to return a list of WebCams */
@@ -175,18 +227,24 @@ GList* gst_camera_devices(gchar *device_name)
 */
 
 
-/* Use V4L2 ioctl to get WebCam details and return a list (probably more efficient) */
+// Use V4L2 ioctl to get WebCam details and return a list (probably more efficient).
+// The devices are probed at the same time on a small thread pool as opening a sleeping USB
+// camera can take a while. A device that does not answer in time is left out (its probe
+// finishes and frees itself in the background).
 
 struct camlistNode* dev_camera_devices(GtkWidget *window)
 {
     DIR *dp = NULL;
     struct dirent *ep;
     struct stat fileStat;
-    int fd, err, sz_dev, sz_fs;
+    int err, sz_dev, sz_fs, pending;
+    guint i, n, threads;
+    gint64 now, limit;
     char video_dev[300];
     const char *sysfsclass = V4L_SYS_CLASS;
-    struct camlistNode *v_node;
-    unsigned capabilities;
+    cam_probe_t *p;
+    GPtrArray *probes;
+    GThreadPool *pool;
 
     /* Open video directory */
     if((dp = opendir(sysfsclass)) == NULL)
@@ -197,6 +255,7 @@ struct camlistNode* dev_camera_devices(GtkWidget *window)
 
     sz_fs = strlen(sysfsclass);
     sz_dev = sizeof(video_dev);
+    probes = g_ptr_array_new ();
 
     /* Iterate thru the video devices */
     while (ep = readdir(dp))
@@ -207,7 +266,7 @@ struct camlistNode* dev_camera_devices(GtkWidget *window)
 	if ((strlen(ep->d_name) + sz_fs) > sz_dev)
 	{
 	    log_msg("SYS9006", NULL, "SYS9000", window);
-	    return NULL;
+	    break;
 	}
 
 	sprintf(video_dev, "%s/%s", sysfsclass, ep->d_name);
@@ -222,43 +281,190 @@ struct camlistNode* dev_camera_devices(GtkWidget *window)
 	if (! S_ISLNK(fileStat.st_mode))
 	    continue;
 
-	sprintf(video_dev, "%s/%s", DEV_DIR, ep->d_name);
+	p = (cam_probe_t *) calloc(1, sizeof(cam_probe_t));
+	sprintf(p->video_dev, "%s/%s", DEV_DIR, ep->d_name);
+	p->refs = 2;						// This function and the probe
+	g_ptr_array_add (probes, p);
+    }
 
-	/* Open the camera */
-	if ((fd = cam_open(video_dev, O_RDWR, window)) == -1)
-	    return NULL;
+    closedir(dp);
 
-	/* Connect to the camera and get caps */
-	v_node = new_listNode();
+    /* Keep the menu order stable (video2 before video10) */
+    g_ptr_array_sort (probes, probe_cmp);
+    n = probes->len;
 
-	v_node->cam->fd = fd;
-	strcpy(v_node->cam->video_dev, video_dev);
+    if (n > 0)
+    {
+	threads = (n < PROBE_THREADS) ? n : PROBE_THREADS;
+	pool = g_thread_pool_new (probe_device, NULL, threads, FALSE, NULL);
 
-	if (! camera_caps(v_node->cam, window))
-	    return NULL;
-	
-	/* Only add devices capable of capture */
-	capabilities = v_node->cam->vcaps.capabilities;
+	for(i = 0; i < n; i++)
+	    g_thread_pool_push (pool, g_ptr_array_index (probes, i), NULL);
+
+	g_thread_pool_free (pool, FALSE, FALSE);		// Finishes in the background
+    }
+
+    /* Wait for each device to answer or run out of time */
+    limit = g_get_monotonic_time () + PROBE_TIMEOUT * ((n + PROBE_THREADS - 1) / PROBE_THREADS);
+    g_mutex_lock (&probe_mutex);
+
+    while (TRUE)
+    {
+	now = g_get_monotonic_time ();
+	pending = FALSE;
+
+	for(i = 0; i < n; i++)
+	{
+	    p = (cam_probe_t *) g_ptr_array_index (probes, i);
+
+	    if (! p->done && (p->started == 0 || now - p->started < PROBE_TIMEOUT))
+	    	pending = TRUE;
+	}
+
+	if (pending == FALSE || now >= limit)
+	    break;
+
+	g_cond_wait_until (&probe_cond, &probe_mutex, now + 50000);
+    }
 
-	if (capabilities & V4L2_CAP_DEVICE_CAPS) 
-	    capabilities = v_node->cam->vcaps.device_caps;
+    /* Add the capture devices to the list */
+    for(i = 0; i < n; i++)
+    {
+	p = (cam_probe_t *) g_ptr_array_index (probes, i);
 
-	if (! (capabilities & (V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_VIDEO_CAPTURE_MPLANE)))
+	if (p->node != NULL)
+	{
+	    add_listNode(p->node, &head);
+	    p->node = NULL;
+	}
+	else if (! p->done)
 	{
-	    free(v_node-> cam); 
-	    free(v_node); 
+	    log_msg("CAM0036", p->video_dev, NULL, NULL);
+	}
+	else if (p->op != NULL)
+	{
+	    sprintf(app_msg_extra, "%s Error: %d, %s", p->op, p->err, strerror(p->err));
+	    log_msg("CAM0003", p->video_dev, "SYS9000", window);
+	}
+
+	if (--(p->refs) == 0)
+	    probe_free(p);
+    }
+
+    g_mutex_unlock (&probe_mutex);
+    g_ptr_array_free (probes, TRUE);
+
+    return head;
+}
+
+
+/* Probe a device (pool thread) - open and get the capabilities, no ui or logging here */
+
+void probe_device(gpointer data, gpointer user_data)
+{
+    cam_probe_t *p;
+    struct camlistNode *v_node;
+    unsigned capabilities;
+    int fd, err, last;
+    char *op;
+
+    p = (cam_probe_t *) data;
+
+    g_mutex_lock (&probe_mutex);
+    p->started = g_get_monotonic_time ();
+    g_mutex_unlock (&probe_mutex);
+
+    v_node = NULL;
+    op = NULL;
+    err = 0;
+
+    if ((fd = v4l2_open(p->video_dev, O_RDWR, 0)) == -1)
+    {
+	op = "open";
+	err = errno;
+    }
+    else
+    {
+	v_node = new_listNode();
+	v_node->cam->fd = fd;
+	strcpy(v_node->cam->video_dev, p->video_dev);
+
+	if (xioctl(fd, VIDIOC_QUERYCAP, &(v_node->cam->vcaps)) == -1)
+	{
+	    op = "VIDIOC_QUERYCAP";
+	    err = errno;
+	    free(v_node->cam);
+	    free(v_node);
+	    v_node = NULL;
 	}
 	else
 	{
-	    add_listNode(v_node, &head);
+	    /* Only add devices capable of capture */
+	    capabilities = v_node->cam->vcaps.capabilities;
+
+	    if (capabilities & V4L2_CAP_DEVICE_CAPS) 
+		capabilities = v_node->cam->vcaps.device_caps;
+
+	    if (! (capabilities & (V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_VIDEO_CAPTURE_MPLANE)))
+	    {
+		free(v_node->cam); 
+		free(v_node); 
+		v_node = NULL;
+	    }
 	}
-	
+
 	v4l2_close(fd);
     }
 
-    closedir(dp);
+    g_mutex_lock (&probe_mutex);
+    p->node = v_node;
+    p->op = op;
+    p->err = err;
+    p->done = TRUE;
+    last = (--(p->refs) == 0);
+    g_cond_broadcast (&probe_cond);
+    g_mutex_unlock (&probe_mutex);
 
-    return head;
+    /* Too late - nobody is waiting for it */
+    if (last)
+	probe_free(p);
+
+    return;
+}
+
+
+/* Release a device probe */
+
+void probe_free(cam_probe_t *p)
+{
+    if (p->node != NULL)
+    {
+	free(p->node->cam);
+	free(p->node);
+    }
+
+    free(p);
+
+    return;
+}
+
+
+/* Device name order (by length first so video10 follows video9) */
+
+gint probe_cmp(gconstpointer a, gconstpointer b)
+{
+    const cam_probe_t *pa, *pb;
+    size_t la, lb;
+
+    pa = *(const cam_probe_t **) a;
+    pb = *(const cam_probe_t **) b;
+    la = strlen(pa->video_dev);
+    lb = strlen(pb->video_dev);
+
+    if (la != lb)
+    	return (la < lb) ? -1 : 1;
+
+    return strcmp(pa->video_dev, pb->video_dev);
 }
 
 
@@ -270,6 +476,7 @@ struct camlistNode *new_listNode()
     n->cam = (camera_t *) malloc(sizeof(camera_t) + 1);
     n->next = NULL;
     memset(n->cam, 0, sizeof(camera_t));
+    n->cam->ctl_fd = -1;
 
     return n;
 }
@@ -300,6 +507,74 @@ void add_listNode(struct camlistNode *vn, struct camlistNode **headNode)
 }
 
 
+/* Probe a single device (eg. just plugged in) - returns NULL if not a capture device or not accessible yet */
+
+struct camlistNode* dev_camera_node(char *video_dev)
+{
+    cam_probe_t *p;
+    struct camlistNode *node;
+
+    p = (cam_probe_t *) calloc(1, sizeof(cam_probe_t));
+    strcpy(p->video_dev, video_dev);
+    p->refs = 2;
+    probe_device(p, NULL);
+
+    node = p->node;
+    p->node = NULL;
+    probe_free(p);
+
+    return node;
+}
+
+
+/* Find the list entry for a device */
+
+struct camlistNode* find_listNode(CamData *cam_data, char *video_dev)
+{
+    struct camlistNode *tmp;
+
+    for(tmp = cam_data->camlist; tmp != NULL; tmp = tmp->next)
+    {
+    	if (strcmp(tmp->cam->video_dev, video_dev) == 0)
+	    return tmp;
+    }
+
+    return NULL;
+}
+
+
+/* Take a camera out of the list and free its details (as clear_camera_list) */
+
+void remove_listNode(CamData *cam_data, struct camlistNode *node)
+{
+    struct camlistNode **pp;
+    camera_t *cam;
+
+    for(pp = &(cam_data->camlist); *pp != NULL; pp = &((*pp)->next))
+    {
+    	if (*pp == node)
+	{
+	    *pp = node->next;
+	    break;
+	}
+    }
+
+    head = cam_data->camlist;
+
+    cam = node->cam;
+    cam_ctl_close(cam);
+    free_cam_data(cam->ctl_head);
+    free_cam_data(cam->pctl_head);
+    free_cam_data(cam->fmt_head);
+    cam->ctl_head = cam->ctl_last = NULL;
+    cam->pctl_head = cam->pctl_last = NULL;
+    cam->fmt_head = cam->fmt_last = NULL;
+    free(node);
+
+    return;
+}
+
+
 /* Get the camera details and capabilities */
 
 int camera_caps(camera_t *cam, GtkWidget *window)
@@ -322,10 +597,19 @@ int camera_setup(camera_t *cam, GtkWidget *window)
     /* Return if the details are already populated (may need to rebuild controls though) */
     if (cam->ctl_head)
     {
+	cam_ctrl_flags(cam);
 	std_controls(cam);
 	return TRUE;
     }
 
+    /* Use the details saved earlier if possible, they are checked in the background */
+    if (cam_cache_load(cam) == TRUE)
+    {
+	cam_ctrl_flags(cam);
+	cam_cache_check(cam);
+	return TRUE;
+    }
+
     /* Open the camera */
     if ((cam->fd = cam_open(cam->video_dev, O_RDWR, window)) == -1)
 	return FALSE;
@@ -337,6 +621,7 @@ int camera_setup(camera_t *cam, GtkWidget *window)
 	return FALSE;
 
     xv4l2_close(cam);
+    cam_cache_save(cam);
 
     return TRUE;
 }
@@ -360,13 +645,18 @@ int camera_ctrls(camera_t *cam, GtkWidget *window)
 	    	continue;
 	    else
 	    {
-		sprintf(app_msg_extra, "%s Error: %s", v4l2_err, strerror(errno));
-		log_msg("CAM0005", "VIDIOC_QUERYCTRL", "SYS9000", window);
+		if (cam->quiet == FALSE)
+		{
+		    sprintf(app_msg_extra, "%s Error: %s", v4l2_err, strerror(errno));
+		    log_msg("CAM0005", "VIDIOC_QUERYCTRL", "SYS9000", window);
+		}
 		return FALSE;
 	    }
 	}
 
-	if (! (qctrl.flags == 0 || qctrl.flags & V4L2_CTRL_FLAG_SLIDER || qctrl.flags & V4L2_CTRL_FLAG_INACTIVE))
+	/* Grabbed only means in use just now (eg. while streaming) */
+	if (! ((qctrl.flags & ~V4L2_CTRL_FLAG_GRABBED) == 0 || 
+	       qctrl.flags & V4L2_CTRL_FLAG_SLIDER || qctrl.flags & V4L2_CTRL_FLAG_INACTIVE))
 	    continue;
 
 	v_node = new_v4l2Node(sizeof(qctrl));
@@ -398,8 +688,11 @@ int camera_ctrls(camera_t *cam, GtkWidget *window)
 	    	break;
 	    else
 	    {
-		sprintf(app_msg_extra, "%s Error: %s", v4l2_err, strerror(errno));
-		log_msg("CAM0005", "VIDIOC_QUERYCTRL", "SYS9000", window);
+		if (cam->quiet == FALSE)
+		{
+		    sprintf(app_msg_extra, "%s Error: %s", v4l2_err, strerror(errno));
+		    log_msg("CAM0005", "VIDIOC_QUERYCTRL", "SYS9000", window);
+		}
 		return FALSE;
 	    }
 	}
@@ -440,8 +733,11 @@ int camera_ctrl_menu(camera_t *cam,
 		continue;
 	    else
 	    {
-		sprintf(app_msg_extra, "%s Error: %s", v4l2_err, strerror(errno));
-		log_msg("CAM0005", "VIDIOC_QUERYMENU", "SYS9000", window);
+		if (cam->quiet == FALSE)
+		{
+		    sprintf(app_msg_extra, "%s Error: %s", v4l2_err, strerror(errno));
+		    log_msg("CAM0005", "VIDIOC_QUERYMENU", "SYS9000", window);
+		}
 		return FALSE;
 	    }
 	}
@@ -507,8 +803,11 @@ int camera_formats(camera_t *cam, GtkWidget *window)
     /* If none were found, either the function is not supported or its the driver */
     if (cam->fmt_head == NULL)
     {
-	sprintf(app_msg_extra, "VIDIOC_ENUM_FMT %s", v4l2_warn);
-	log_msg("CAM0006", "video formats (VIDIOC_ENUM_FMT)", NULL, NULL);
+	if (cam->quiet == FALSE)
+	{
+	    sprintf(app_msg_extra, "VIDIOC_ENUM_FMT %s", v4l2_warn);
+	    log_msg("CAM0006", "video formats (VIDIOC_ENUM_FMT)", NULL, NULL);
+	}
     }
 
     return TRUE;
@@ -553,8 +852,11 @@ int camera_res(camera_t *cam,
     /* If none were found, either the function is not supported or its the driver */
     if (fmtNode->sub_list_head == NULL)
     {
-	sprintf(app_msg_extra, "VIDIOC_ENUM_FRAMESIZES %s", v4l2_warn);
-	log_msg("CAM0006", "video frame sizes (VIDIOC_ENUM_FRAMESIZES)", NULL, NULL);
+	if (cam->quiet == FALSE)
+	{
+	    sprintf(app_msg_extra, "VIDIOC_ENUM_FRAMESIZES %s", v4l2_warn);
+	    log_msg("CAM0006", "video frame sizes (VIDIOC_ENUM_FRAMESIZES)", NULL, NULL);
+	}
     }
 
     return TRUE;
@@ -666,8 +968,11 @@ int camera_frmival(camera_t *cam,
     /* If none were found, either the function is not supported or its the driver */
     if (frmNode->sub_list_head == NULL)
     {
-	sprintf(app_msg_extra, "VIDIOC_ENUM_FRAMEINTERVALS %s", v4l2_warn);
-	log_msg("CAM0006", "video frame intervals (VIDIOC_ENUM_FRAMEINTERVALS)", NULL, NULL);
+	if (cam->quiet == FALSE)
+	{
+	    sprintf(app_msg_extra, "VIDIOC_ENUM_FRAMEINTERVALS %s", v4l2_warn);
+	    log_msg("CAM0006", "video frame intervals (VIDIOC_ENUM_FRAMEINTERVALS)", NULL, NULL);
+	}
     }
 
     return TRUE;
@@ -838,90 +1143,239 @@ int find_ctl(camera_t *cam, char *key)
 
 int get_cam_ctrl(long id, struct v4l2_queryctrl *qctrl, camera_t *cam, GtkWidget *window)
 {
-    int r = TRUE;
+    int fd;
 
-    if ((cam->fd = cam_open(cam->video_dev, O_RDWR, window)) == -1)
+    if ((fd = cam_ctl_fd(cam, window)) == -1)
 	return FALSE;
 
     memset(qctrl, 0, sizeof(struct v4l2_queryctrl));
     qctrl->id = id;
 
-    if (xioctl(cam->fd, VIDIOC_QUERYCTRL, qctrl) != 0)
+    if (xioctl(fd, VIDIOC_QUERYCTRL, qctrl) != 0)
     {
 	sprintf(app_msg_extra, "%s Error: %s", v4l2_err, strerror(errno));
 	log_msg("CAM0005", "VIDIOC_QUERYCTRL", "CAM0005", window);
-	r = FALSE;
+	return FALSE;
     }
 
-    xv4l2_close(cam);
-
-    return r;
+    return TRUE;
 }
 
 
-/* Set a camera control value */
+/* Set a camera control value (held for the batch if one is open) */
 
 int set_cam_ctrl(camera_t *cam, 
 		 struct v4l2_queryctrl *qctrl, 
 		 long val, 
 		 GtkWidget *window)
 {
-    struct v4l2_control ctrl; 
-    int r = FALSE;
+    ctrl_batch_t *b;
+    int i;
 
-    /* Open the camera */
-    if (! cam->cam_is_open)
+    if ((b = cam->batch) == NULL)
+	return cam_ctrl_write(cam, qctrl, val, window);
+
+    /* A later value for the same control replaces the earlier one */
+    for(i = 0; i < b->n; i++)
     {
-	if ((cam->fd = cam_open(cam->video_dev, O_RDWR, window)) == -1)
-	    return r;
+    	if (b->qctrl[i]->id == qctrl->id)
+	{
+	    b->val[i] = val;
+	    return TRUE;
+	}
     }
 
-    /* Get the current value */
-    memset (&ctrl, 0, sizeof (ctrl));
-    ctrl.id = qctrl->id;
+    if (b->n == b->max)
+    {
+	b->max += 16;
+	b->qctrl = (struct v4l2_queryctrl **) realloc(b->qctrl, b->max * sizeof(struct v4l2_queryctrl *));
+	b->val = (long *) realloc(b->val, b->max * sizeof(long));
+    }
+
+    b->qctrl[b->n] = qctrl;
+    b->val[b->n] = val;
+    b->n++;
 
-    if (xioctl(cam->fd, VIDIOC_G_CTRL, &ctrl) != 0)
+    return TRUE;
+}
+
+
+/* Write a camera control value on the control handle */
+
+int cam_ctrl_write(camera_t *cam, 
+		   struct v4l2_queryctrl *qctrl, 
+		   long val, 
+		   GtkWidget *window)
+{
+    struct v4l2_control ctrl; 
+    long curr_val;
+    int fd;
+
+    if ((fd = cam_ctl_fd(cam, window)) == -1)
+	return FALSE;
+
+    /* Get the current value */
+    if (cam_ctrl_get(cam, qctrl, &curr_val) == FALSE)
     {
 	sprintf(app_msg_extra, "Control %s, Error: (%d) %s", qctrl->name, 
 							     errno, 
 							     strerror(errno)); 
 	log_msg("CAM0011", qctrl->name, "SYS9009", window);
-	xv4l2_close(cam);
-	return r;
+	return FALSE;
     }
 
     /* Set the new value (if req). The driver may clamp the value or return ERANGE, ignored here */
-    if (ctrl.value != val)
+    if (curr_val == val)
+	return -1;
+
+    memset (&ctrl, 0, sizeof (ctrl));
+    ctrl.id = qctrl->id;
+    ctrl.value = val;
+
+    if (xioctl(fd, VIDIOC_S_CTRL, &ctrl) == -1)
     {
-	ctrl.value = val;
+	sprintf(app_msg_extra, "New Value (%ld), Current Value (%ld), Error: (%d) %s", 
+			       val, curr_val, errno, strerror(errno)); 
+	log_msg("CAM0012", qctrl->name, "SYS9009", window);
+	return FALSE;
+    }
+
+    cam_ctrl_cache(cam, qctrl->id, ctrl.value);
+    cam_ctrl_note(cam);
+
+    return TRUE;
+}
+
 
-	if (xioctl(cam->fd, VIDIOC_S_CTRL, &ctrl) == -1)
+/* Current control value, from the cache when control events are being received */
+
+int cam_ctrl_get(camera_t *cam, struct v4l2_queryctrl *qctrl, long *val)
+{
+    struct v4l2_control ctrl; 
+    gpointer v;
+
+    if (cam->ctl_vals != NULL)
+    {
+	if (g_hash_table_lookup_extended (cam->ctl_vals, GUINT_TO_POINTER (qctrl->id), NULL, &v))
 	{
-	    sprintf(app_msg_extra, "New Value (%ld), Current Value (%d), Error: (%d) %s", 
-				   val, ctrl.value, errno, strerror(errno)); 
-	    log_msg("CAM0012", qctrl->name, "SYS9009", window);
-	    xv4l2_close(cam);
-	    return r;
+	    *val = (long) GPOINTER_TO_INT (v);
+	    return TRUE;
 	}
+    }
+
+    memset (&ctrl, 0, sizeof (ctrl));
+    ctrl.id = qctrl->id;
+
+    if (cam->ctl_fd == -1 || xioctl(cam->ctl_fd, VIDIOC_G_CTRL, &ctrl) != 0)
+	return FALSE;
+
+    *val = ctrl.value;
+    cam_ctrl_cache(cam, qctrl->id, ctrl.value);
+
+    return TRUE;
+}
+
+
+/* Note a value written to or reported by the camera */
+
+void cam_ctrl_cache(camera_t *cam, __u32 id, long val)
+{
+    if (cam->ctl_vals == NULL)
+    	return;
+
+    g_hash_table_insert (cam->ctl_vals, GUINT_TO_POINTER (id), GINT_TO_POINTER ((gint) val));
+
+    return;
+}
+
 
-	r = TRUE;
+// Set several camera controls together (eg. between capture sequence steps). A single
+// VIDIOC_S_EXT_CTRLS is tried first, drivers that reject it have the controls set one
+// at a time.
+
+int set_cam_ctrls(camera_t *cam, struct v4l2_queryctrl **qctrl, long *val, int n, GtkWidget *window)
+{
+    struct v4l2_ext_controls ext_ctrls;
+    struct v4l2_ext_control *ctrl;
+    int i, r, fd;
+
+    if (n <= 0)
+    	return TRUE;
+
+    if ((fd = cam_ctl_fd(cam, window)) == -1)
+	return FALSE;
+
+    /* All at once (class 0 allows controls of different classes) */
+    ctrl = (struct v4l2_ext_control *) calloc(n, sizeof(struct v4l2_ext_control));
+
+    for(i = 0; i < n; i++)
+    {
+	ctrl[i].id = qctrl[i]->id;
+	ctrl[i].value = (__s32) val[i];
     }
-    else
+
+    memset (&ext_ctrls, 0, sizeof (ext_ctrls));
+    ext_ctrls.ctrl_class = 0;
+    ext_ctrls.count = n;
+    ext_ctrls.controls = ctrl;
+
+    r = (xioctl(fd, VIDIOC_S_EXT_CTRLS, &ext_ctrls) == 0);
+
+    if (r == TRUE)
     {
-	r = -1;
+	for(i = 0; i < n; i++)
+	    cam_ctrl_cache(cam, ctrl[i].id, ctrl[i].value);
+
+	cam_ctrl_note(cam);
     }
 
-    /* Leave open if it was already open */
-    if (! cam->cam_is_open)
-	xv4l2_close(cam);
+    free(ctrl);
 
-    return r;
+    if (r == TRUE)
+	return TRUE;
 
-    /* Debug
-    xioctl(cam->fd, VIDIOC_G_CTRL, ctrl);
-    printf("%s Control Before - Id %d Value %d\n", debug_hdr, ctrl->id, ctrl->value);
-    printf("%s Control After - Id %d Value %d\n", debug_hdr, ctrl->id, ctrl->value);
-    */
+    /* One at a time */
+    for(i = 0; i < n; i++)
+    {
+    	if (cam_ctrl_write(cam, qctrl[i], val[i], window) == FALSE)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Hold control writes until cam_ctrl_commit (eg. while a profile is applied) */
+
+void cam_ctrl_batch(camera_t *cam)
+{
+    if (cam->batch != NULL)
+    	return;
+
+    cam->batch = (ctrl_batch_t *) calloc(1, sizeof(ctrl_batch_t));
+
+    return;
+}
+
+
+/* Write the held controls in one request */
+
+int cam_ctrl_commit(camera_t *cam, GtkWidget *window)
+{
+    ctrl_batch_t *b;
+    int r;
+
+    if ((b = cam->batch) == NULL)
+    	return TRUE;
+
+    cam->batch = NULL;
+    r = set_cam_ctrls(cam, b->qctrl, b->val, b->n, window);
+
+    free(b->qctrl);
+    free(b->val);
+    free(b);
+
+    return r;
 }
 
 
@@ -930,44 +1384,52 @@ int set_cam_ctrl(camera_t *cam,
 int cam_defaults(camera_t *cam, MainUi *m_ui, struct v4l2_list *head_node) 
 {
     struct v4l2_queryctrl *qctrl; 
+    struct v4l2_queryctrl **chg_qctrl;
     struct v4l2_list *v_node;
-    char s[10];
-    int r;
+    long *chg_val, curr_val;
+    char s[CTL_KEY_SZ];
+    int i, n, r;
 
-    /* Open the camera */
-    cam->cam_is_open = FALSE;
-
-    if ((cam->fd = cam_open(cam->video_dev, O_RDWR, m_ui->window)) == -1)
+    if (cam_ctl_fd(cam, m_ui->window) == -1)
 	return FALSE;
 
-    /* Loop through each control and reset to default if necessary */
-    cam->cam_is_open = TRUE;
-    v_node = head_node;
+    /* Find the controls not at their default */
+    for(n = 0, v_node = head_node; v_node != NULL; v_node = v_node->next)
+    	n++;
 
-    while(v_node != NULL)
+    if (n == 0)
+    	return TRUE;
+
+    chg_qctrl = (struct v4l2_queryctrl **) malloc(n * sizeof(struct v4l2_queryctrl *));
+    chg_val = (long *) malloc(n * sizeof(long));
+    n = 0;
+
+    for(v_node = head_node; v_node != NULL; v_node = v_node->next)
     {
     	qctrl = (struct v4l2_queryctrl *) v_node->v4l2_data;
 
-	/* Check current setting and change if necessary */
-    	r = set_cam_ctrl(cam, qctrl, qctrl->default_value, m_ui->window);
+	if (cam_ctrl_get(cam, qctrl, &curr_val) == FALSE || curr_val == qctrl->default_value)
+	    continue;
 
-    	if (r == TRUE)
-    	{
-	    /* If a related widget exists, set its value */
-	    sprintf(s, "ctl-%d", qctrl->id - V4L2_CID_BASE);
-	    set_scale_val(m_ui->cntl_grid, s, qctrl->default_value);
-	}
-	else if (r == FALSE)
+	chg_qctrl[n] = qctrl;
+	chg_val[n] = qctrl->default_value;
+	n++;
+    }
+
+    /* Reset them together and set any related widgets */
+    if ((r = set_cam_ctrls(cam, chg_qctrl, chg_val, n, m_ui->window)) == TRUE)
+    {
+	for(i = 0; i < n; i++)
 	{
-	    return FALSE;
+	    snprintf(s, sizeof(s), "ctl-%d", chg_qctrl[i]->id - V4L2_CID_BASE);
+	    set_scale_val(m_ui->cntl_grid, s, chg_val[i]);
 	}
-
-    	v_node = v_node->next;
     }
 
-    xv4l2_close(cam);
+    free(chg_qctrl);
+    free(chg_val);
 
-    return TRUE;
+    return r;
 }
 
 
@@ -984,14 +1446,9 @@ int cam_ctrl_reset(CamData *cam_data, GtkWidget *contr, char action, GtkWidget *
     ctl_list = ctrl_widget_list(contr, window);
     ctl_list = g_list_first(ctl_list);
 
-    /* Open the camera */
+    /* Changes are written together at the end */
     cam = cam_data->cam;
-    cam->cam_is_open = FALSE;
-
-    if ((cam->fd = cam_open(cam->video_dev, O_RDWR, window)) == -1)
-	return FALSE;
-
-    cam->cam_is_open = TRUE;
+    cam_ctrl_batch(cam);
 
     while(ctl_list != NULL)
     {
@@ -1018,9 +1475,8 @@ int cam_ctrl_reset(CamData *cam_data, GtkWidget *contr, char action, GtkWidget *
     }
 
     g_list_free(ctl_list);
-    xv4l2_close(cam);
 
-    return TRUE;
+    return cam_ctrl_commit(cam, window);
 }
 
 
@@ -1156,6 +1612,13 @@ void cam_auto_reset(GtkWidget *radio_btn,
     if (qctrl->type != V4L2_CTRL_TYPE_BOOLEAN)
     	return;
 
+    /* The new flags are only known once the held writes are on the camera */
+    if (cam->batch != NULL)
+    {
+	cam_ctrl_commit(cam, window);
+	cam_ctrl_batch(cam);
+    }
+
     /* Find the main parent widget */
     tmp = radio_btn;
 
@@ -1668,13 +2131,279 @@ void xv4l2_close(camera_t *cam)
 }
 
 
+/* Control handle, opened on first use and kept for the session (slider changes, profiles) */
+
+int cam_ctl_fd(camera_t *cam, GtkWidget *window)
+{
+    if (cam->ctl_fd == -1)
+	cam->ctl_fd = cam_open(cam->video_dev, O_RDWR | O_NONBLOCK, window);
+
+    return cam->ctl_fd;
+}
+
+
+// Load the control value cache and subscribe to control change events for all the controls
+// (standard, other and private). Values changed by the driver or another program (eg. auto
+// exposure) then update the cache and the related slider. Events are not sent for changes
+// made on this handle, those are cached as written.
+
+int cam_ctl_watch(camera_t *cam, GtkWidget *grid, GtkWidget *window)
+{
+    struct v4l2_event_subscription sub;
+    struct v4l2_queryctrl *qctrl; 
+    struct v4l2_list *v_node;
+    GIOChannel *chan;
+    long val;
+    int i, n;
+
+    if (cam->ctl_watch != 0)
+    	return TRUE;
+
+    if (cam_ctl_fd(cam, window) == -1)
+	return FALSE;
+
+    cam->ctl_grid = grid;
+    cam->ctl_vals = g_hash_table_new (g_direct_hash, g_direct_equal);
+    n = 0;
+
+    for(i = 0; i < 2; i++)
+    {
+	for(v_node = (i == 0) ? cam->ctl_head : cam->pctl_head; v_node != NULL; v_node = v_node->next)
+	{
+	    qctrl = (struct v4l2_queryctrl *) v_node->v4l2_data;
+
+	    if (cam_ctrl_get(cam, qctrl, &val) == FALSE)		// Eg. write only
+	    	continue;
+
+	    memset (&sub, 0, sizeof (sub));
+	    sub.type = V4L2_EVENT_CTRL;
+	    sub.id = qctrl->id;
+
+	    if (xioctl(cam->ctl_fd, VIDIOC_SUBSCRIBE_EVENT, &sub) == 0)
+	    	n++;
+	}
+    }
+
+    /* No events (older driver) - the cache can not be relied on */
+    if (n == 0)
+    {
+	g_hash_table_destroy (cam->ctl_vals);
+	cam->ctl_vals = NULL;
+	return FALSE;
+    }
+
+    /* Events are signalled as priority data */
+    chan = g_io_channel_unix_new (cam->ctl_fd);
+    cam->ctl_watch = g_io_add_watch (chan, G_IO_PRI | G_IO_ERR | G_IO_HUP, OnCtlEvent, (gpointer) cam);
+    g_io_channel_unref (chan);
+
+    return TRUE;
+}
+
+
+/* Callback - Control change events */
+
+gboolean OnCtlEvent(GIOChannel *chan, GIOCondition cond, gpointer user_data)
+{
+    camera_t *cam;
+    struct v4l2_event ev;
+    struct v4l2_queryctrl *qctrl; 
+    GtkWidget *widget;
+    char key[CTL_KEY_SZ];
+    int chg;
+
+    cam = (camera_t *) user_data;
+
+    /* Device gone */
+    if (cond & (G_IO_ERR | G_IO_HUP))
+    {
+	cam->ctl_watch = 0;
+	g_hash_table_destroy (cam->ctl_vals);
+	cam->ctl_vals = NULL;
+	return FALSE;
+    }
+
+    chg = FALSE;
+
+    while (xioctl(cam->ctl_fd, VIDIOC_DQEVENT, &ev) == 0)
+    {
+	if (ev.type != V4L2_EVENT_CTRL)
+	    continue;
+
+	snprintf(key, sizeof(key), "ctl-%d", ev.id - V4L2_CID_BASE);
+	widget = (cam->ctl_grid != NULL) ? find_widget_by_name(cam->ctl_grid, key) : NULL;
+
+	if (ev.u.ctrl.changes & V4L2_EVENT_CTRL_CH_VALUE)
+	{
+	    cam_ctrl_cache(cam, ev.id, (long) ev.u.ctrl.value);
+	    chg = TRUE;
+
+	    if (widget != NULL && GTK_IS_RANGE(widget))
+		gtk_range_set_value(GTK_RANGE (widget), (gdouble) ev.u.ctrl.value);
+	}
+
+	if (ev.u.ctrl.changes & V4L2_EVENT_CTRL_CH_FLAGS)
+	{
+	    if ((qctrl = cam_ctrl_find(cam, ev.id)) != NULL)
+		qctrl->flags = (qctrl->flags & ~CTRL_STATE_FLAGS) | (ev.u.ctrl.flags & CTRL_STATE_FLAGS);
+
+	    if (widget != NULL)
+		gtk_widget_set_sensitive(widget, ! (ev.u.ctrl.flags & CTRL_STATE_FLAGS));
+	}
+    }
+
+    if (chg == TRUE)
+	cam_ctrl_note(cam);
+
+    return TRUE;
+}
+
+
+// Note the control values in the frame timestamps file if capturing. Events are not sent to
+// the handle that made a change, so the application's own writes are noted as they are made.
+
+static void cam_ctrl_note(camera_t *cam)
+{
+    char *snap;
+
+    if (cam->ftm == NULL)
+    	return;
+
+    snap = cam_ctrl_snapshot(cam);
+    ftm_ctrls(cam->ftm, (guint64) g_get_monotonic_time() * 1000, snap);
+    g_free(snap);
+
+    return;
+}
+
+
+// Refresh the control flags that follow the camera state (inactive, grabbed). They are not kept
+// in the capability cache and may have changed since the controls were enumerated.
+
+void cam_ctrl_flags(camera_t *cam)
+{
+    struct v4l2_queryctrl q, *qctrl; 
+    struct v4l2_list *v_node;
+    int i, fd;
+
+    if ((fd = cam->ctl_fd) == -1)
+    {
+	if ((fd = v4l2_open(cam->video_dev, O_RDWR | O_NONBLOCK, 0)) == -1)
+	    return;
+    }
+
+    for(i = 0; i < 2; i++)
+    {
+	for(v_node = (i == 0) ? cam->ctl_head : cam->pctl_head; v_node != NULL; v_node = v_node->next)
+	{
+	    qctrl = (struct v4l2_queryctrl *) v_node->v4l2_data;
+
+	    memset (&q, 0, sizeof (q));
+	    q.id = qctrl->id;
+
+	    if (xioctl(fd, VIDIOC_QUERYCTRL, &q) == 0)
+		qctrl->flags = (qctrl->flags & ~CTRL_STATE_FLAGS) | (q.flags & CTRL_STATE_FLAGS);
+	}
+    }
+
+    if (fd != cam->ctl_fd)
+	v4l2_close(fd);
+
+    return;
+}
+
+
+/* Find a control by id */
+
+static struct v4l2_queryctrl * cam_ctrl_find(camera_t *cam, __u32 id)
+{
+    struct v4l2_queryctrl *qctrl; 
+    struct v4l2_list *v_node;
+    int i;
+
+    for(i = 0; i < 2; i++)
+    {
+	for(v_node = (i == 0) ? cam->ctl_head : cam->pctl_head; v_node != NULL; v_node = v_node->next)
+	{
+	    qctrl = (struct v4l2_queryctrl *) v_node->v4l2_data;
+
+	    if (qctrl->id == id)
+	    	return qctrl;
+	}
+    }
+
+    return NULL;
+}
+
+
+/* Current control values as text (name=value, ...) */
+
+char * cam_ctrl_snapshot(camera_t *cam)
+{
+    struct v4l2_queryctrl *qctrl; 
+    struct v4l2_list *v_node;
+    GString *str;
+    long val;
+    int i;
+
+    str = g_string_new (NULL);
+
+    for(i = 0; i < 2; i++)
+    {
+	for(v_node = (i == 0) ? cam->ctl_head : cam->pctl_head; v_node != NULL; v_node = v_node->next)
+	{
+	    qctrl = (struct v4l2_queryctrl *) v_node->v4l2_data;
+
+	    if (cam_ctrl_get(cam, qctrl, &val) == FALSE)
+	    	continue;
+
+	    g_string_append_printf (str, "%s%s=%ld", (str->len > 0) ? ", " : "", qctrl->name, val);
+	}
+    }
+
+    return g_string_free (str, FALSE);
+}
+
+
+/* Close the control handle */
+
+void cam_ctl_close(camera_t *cam)
+{
+    if (cam->batch != NULL)
+	cam_ctrl_commit(cam, NULL);
+
+    if (cam->ctl_watch != 0)
+    {
+	g_source_remove (cam->ctl_watch);
+	cam->ctl_watch = 0;
+    }
+
+    if (cam->ctl_vals != NULL)
+    {
+	g_hash_table_destroy (cam->ctl_vals);
+	cam->ctl_vals = NULL;
+    }
+
+    cam->ctl_grid = NULL;
+    cam->ftm = NULL;
+
+    if (cam->ctl_fd != -1)
+    {
+	v4l2_close(cam->ctl_fd);
+	cam->ctl_fd = -1;
+    }
+
+    return;
+}
+
+
 /* Get the last session value, if any, or the default for a control */
 
 void session_ctrl_val(struct v4l2_queryctrl *qctrl, char *key, long *val)
 {
     char *p;
 
-    sprintf(key, "ctl-%d", qctrl->id - V4L2_CID_BASE);
+    snprintf(key, CTL_KEY_SZ, "ctl-%d", qctrl->id - V4L2_CID_BASE);
     get_session(key, &p);
 
     if (p != NULL)
@@ -1699,11 +2428,11 @@ void save_ctrl(struct v4l2_queryctrl *qctrl,
 	       char *ctl_key, long ctl_val, 
 	       CamData *cam_data, GtkWidget *window) 
 {
-    char s[10];
+    char s[25];
 
     if (set_cam_ctrl(cam_data->cam, qctrl, ctl_val, window) != FALSE)
     {
-	sprintf(s, "%ld", ctl_val);
+	snprintf(s, sizeof(s), "%ld", ctl_val);
 	set_session(ctl_key, s);
     }
 	
@@ -1725,6 +2454,7 @@ void clear_camera_list(CamData *cam_data)
     {
 	/* Free the controls, menus, formats, frame sizes and frame rates lists */
 	cam = tmp->cam;
+	cam_ctl_close(cam);
 	free_cam_data(cam->ctl_head);
 	free_cam_data(cam->pctl_head);
 	free_cam_data(cam->fmt_head);
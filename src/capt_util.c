@@ -0,0 +1,250 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+** Description:	Capture utilities with no Gtk dependency (part of the libastroctc engine library
+**		as well as the application) - RAM staging memory and driver frame checks.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code (moved from utility.c)
+**	19-Oct-2026	Frame checks restart after a pause
+**
+*/
+
+
+/* Defines */
+
+#define RAM_HUGE_PAGE (2 * 1024 * 1024)
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <gst/gst.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <cam.h>
+
+
+/* Prototypes */
+
+void * ram_alloc(size_t, int *);
+void ram_free(void *, size_t, int);
+void frame_chk_init(frame_chk_t *, int);
+void frame_check(frame_chk_t *, gint64, guint64);
+void frame_chk_resume(frame_chk_t *);
+void frame_chk_str(frame_chk_t *, char *, int);
+void frame_chk_meta(FILE *, frame_chk_t *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-capt_util.c ";
+
+
+// Allocate a large memory area for RAM staged capture. Huge pages are used if any are
+// reserved (otherwise transparent huge pages are requested) and the area is locked in
+// memory if the limits allow. The size is rounded up to a huge page, ram_free does the same.
+
+void * ram_alloc(size_t sz, int *locked)
+{
+    void *p;
+
+    sz = (sz + RAM_HUGE_PAGE - 1) & ~((size_t) RAM_HUGE_PAGE - 1);
+    *locked = FALSE;
+
+    p = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (p == MAP_FAILED)
+    {
+	p = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (p == MAP_FAILED)
+	    return NULL;
+
+#ifdef MADV_HUGEPAGE
+	madvise(p, sz, MADV_HUGEPAGE);
+#endif
+    }
+
+    if (mlock(p, sz) == 0)
+    	*locked = TRUE;
+
+    return p;
+}
+
+
+/* Release a ram_alloc area */
+
+void ram_free(void *p, size_t sz, int locked)
+{
+    if (p == NULL)
+    	return;
+
+    sz = (sz + RAM_HUGE_PAGE - 1) & ~((size_t) RAM_HUGE_PAGE - 1);
+
+    if (locked == TRUE)
+	munlock(p, sz);
+
+    munmap(p, sz);
+
+    return;
+}
+
+
+/* Reset frame checks - the expected interval starts from the requested frame rate */
+
+void frame_chk_init(frame_chk_t *fc, int fps)
+{
+    memset(fc, 0, sizeof(frame_chk_t));
+    fc->last_seq = -1;
+
+    if (fps > 0)
+	fc->interval = (guint64) 1000000000 / fps;
+
+    return;
+}
+
+
+// Check a frame from the driver against the last one.
+// With a V4L2 sequence number (seq >= 0) gaps are dropped frames and repeats are duplicates.
+// Without one the timestamp gap is measured in frame intervals instead.
+// Frames in sequence that arrive more than 1.5 intervals after the last are counted as late.
+// The expected interval follows the actual camera rate (which may be limited by exposure).
+
+void frame_check(frame_chk_t *fc, gint64 seq, guint64 ts)
+{
+    gint64 gap;
+    guint64 delta, jitter;
+
+    fc->frames++;
+
+    /* After a pause the driver sequence has moved on - start again from this frame */
+    if (g_atomic_int_get (&(fc->resync)) == TRUE)
+    {
+	g_atomic_int_set (&(fc->resync), FALSE);
+	fc->last_seq = -1;
+	fc->last_ts = 0;
+    }
+
+    if (fc->last_ts == 0 || ts <= fc->last_ts)
+    {
+	if (fc->last_ts != 0 && ts == fc->last_ts)
+	    fc->duplicated++;
+
+	fc->last_seq = seq;
+	fc->last_ts = ts;
+	return;
+    }
+
+    delta = ts - fc->last_ts;
+
+    /* Frames between this one and the last */
+    if (seq >= 0 && fc->last_seq >= 0)
+	gap = seq - fc->last_seq;
+    else if (fc->interval > 0)
+	gap = (gint64) ((delta + fc->interval / 2) / fc->interval);
+    else
+    	gap = 1;
+
+    fc->last_seq = seq;
+    fc->last_ts = ts;
+
+    if (gap <= 0)
+    {
+	fc->duplicated++;
+	return;
+    }
+
+    if (gap > 1)
+    {
+	fc->dropped += (long) (gap - 1);
+	return;
+    }
+
+    /* In sequence - timing */
+    if (fc->interval == 0)
+    {
+	fc->interval = delta;
+	return;
+    }
+
+    if (delta * 2 > fc->interval * 3)
+	fc->late++;
+
+    jitter = (delta > fc->interval) ? delta - fc->interval : fc->interval - delta;
+    fc->jitter_sum += jitter;
+    fc->jitter_n++;
+
+    if (jitter > fc->jitter_max)
+    	fc->jitter_max = jitter;
+
+    fc->interval = (fc->interval * 15 + delta) / 16;
+
+    return;
+}
+
+
+/* Capture resumed - the frames not taken while paused are not dropped (any thread) */
+
+void frame_chk_resume(frame_chk_t *fc)
+{
+    g_atomic_int_set (&(fc->resync), TRUE);
+
+    return;
+}
+
+
+/* Short description for the status line (empty if nothing to report) */
+
+void frame_chk_str(frame_chk_t *fc, char *s, int sz)
+{
+    if (fc->dropped == 0 && fc->duplicated == 0 && fc->late == 0)
+    	s[0] = '\0';
+    else
+	snprintf(s, sz, "  [dropped %ld, dup %ld, late %ld]", fc->dropped, fc->duplicated, fc->late);
+
+    return;
+}
+
+
+/* Write the frame check results to the meta data file */
+
+void frame_chk_meta(FILE *mf, frame_chk_t *fc)
+{
+    if (fc->frames == 0)
+    	return;
+
+    fprintf(mf, "Driver frames: %ld (%ld dropped, %ld duplicated, %ld late)\n", 
+    		fc->frames, fc->dropped, fc->duplicated, fc->late);
+
+    if (fc->jitter_n > 0)
+	fprintf(mf, "Frame interval: %.3f ms (jitter mean %.3f ms, max %.3f ms)\n",
+		(double) fc->interval / 1000000.0,
+		(double) fc->jitter_sum / (double) fc->jitter_n / 1000000.0,
+		(double) fc->jitter_max / 1000000.0);
+
+    return;
+}
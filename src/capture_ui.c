@@ -26,6 +26,7 @@
 **
 ** History
 **	8-Aug-2014	Initial code
+**	19-Oct-2026	Capture is interactive (benchmark check)
 **
 */
 
@@ -81,7 +82,7 @@ void OnCaptCancel(GtkWidget *, gpointer);
 extern void app_msg(char*, char *, GtkWidget*);
 extern void register_window(GtkWidget *);
 extern void deregister_window(GtkWidget *);
-extern int gst_capture(CamData *, MainUi *, int, int);
+extern int gst_capture(CamData *, MainUi *, int, int, int);
 extern int val_str2numb(char *, int *, char *, GtkWidget *);
 
 
@@ -398,7 +399,7 @@ void OnCaptOK(GtkWidget *btn, gpointer user_data)
     	ui->no_frames = 0;
     }
 
-    gst_capture(cam_data, m_ui, ui->duration, ui->no_frames);
+    gst_capture(cam_data, m_ui, ui->duration, ui->no_frames, TRUE);
 
     /* Clean up */
     free(ui);
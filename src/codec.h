@@ -26,6 +26,7 @@
 **
 ** History
 **	20-Oct-2014	Initial
+**	19-Oct-2026	Fixed encoder properties (eg. lossless presets)
 **
 */
 
@@ -49,6 +50,7 @@ typedef struct _codec
     char extn[5];
     char encoder[20];
     char muxer[30];
+    char enc_fixed[50];			// Encoder properties always applied (prop=val,prop=val)
 } codec_t;
 
 
@@ -26,6 +26,9 @@
 **
 ** History
 **	20-Oct-2014	Initial code
+**	19-Oct-2026	Native (passthrough) capture format
+**	19-Oct-2026	Lossless codecs (FFV1, HuffYUV, Ut Video, H264 qp=0)
+**	19-Oct-2026	Encoder property and codec counts taken from their tables
 **
 */
 
@@ -181,10 +184,51 @@ static codec_t codec_arr[] =		// The codecs that are supported.
     	.extn = "ogg",
     	.encoder = "theoraenc",
     	.muxer = "oggmux"
+    },
+    {
+    	.fourcc = "FFV1",
+    	.short_desc = "FFV1",
+    	.long_desc = "FFV1 lossless Matroska (slice threaded)",
+    	.extn = "mkv",
+    	.encoder = "avenc_ffv1",
+    	.muxer = "matroskamux"
+    },
+    {
+    	.fourcc = "HFYU",
+    	.short_desc = "HuffYUV",
+    	.long_desc = "HuffYUV lossless",
+    	.extn = "avi",
+    	.encoder = "avenc_huffyuv",
+    	.muxer = "avimux"
+    },
+    {
+    	.fourcc = "ULRG",
+    	.short_desc = "Ut Video",
+    	.long_desc = "Ut Video lossless Matroska",
+    	.extn = "mkv",
+    	.encoder = "avenc_utvideo",
+    	.muxer = "matroskamux"
+    },
+    {
+    	.fourcc = "X264",
+    	.short_desc = "H264 LL",
+    	.long_desc = "H264 lossless (qp=0) Matroska",
+    	.extn = "mkv",
+    	.encoder = "x264enc",
+    	.muxer = "matroskamux",
+    	.enc_fixed = "pass=quant,quantizer=0"
+    },
+    {
+    	.fourcc = NATIVE_FMT,
+    	.short_desc = "Native",
+    	.long_desc = "Camera format as negotiated (no conversion)",
+    	.extn = "mkv",
+    	.encoder = "",
+    	.muxer = "matroskamux"
     }
 };
 
-static const int codec_max = 7;
+static const int codec_max = sizeof(codec_arr) / sizeof(codec_arr[0]);
 
 static encoder_t encoder_arr[] =	// Default values for a range of supported encoder properties
 {
@@ -272,20 +316,46 @@ static encoder_t encoder_arr[] =	// Default values for a range of supported enco
     { .encoder = "theoraenc", .property_nm = "rate-buffer",    .default_val = "0", 	   .type = 0,
       .tooltip = "Range: 0 - 1000" },
     { .encoder = "theoraenc", .property_nm = "multipass-mode", .default_val = "0", 	   .type = 0,
-      .tooltip = "(0): single-pass, (1): first-pass, (2): second-pass" }
+      .tooltip = "(0): single-pass, (1): first-pass, (2): second-pass" },
+
+    { .encoder = "avenc_ffv1", .property_nm = "threads",       .default_val = "0", 	   .type = 3,
+      .tooltip = "Encoding threads. (0): auto" },
+    { .encoder = "avenc_ffv1", .property_nm = "slices",        .default_val = "0", 	   .type = 0,
+      .tooltip = "Slices per frame (needs level 3). 4, 6, 9, 12, 16, 24 ..." },
+    { .encoder = "avenc_ffv1", .property_nm = "level",         .default_val = "-99", 	   .type = 0,
+      .tooltip = "Bitstream version. (1), (3): slice threading" },
+    { .encoder = "avenc_ffv1", .property_nm = "context",       .default_val = "0", 	   .type = 0,
+      .tooltip = "Context model. (0): small, (1): large" },
+    { .encoder = "avenc_ffv1", .property_nm = "coder",         .default_val = "rice", 	   .type = 3,
+      .tooltip = "rice, ac, range_def, range_tab" },
+    { .encoder = "avenc_ffv1", .property_nm = "slicecrc",      .default_val = "-1", 	   .type = 0,
+      .tooltip = "Slice CRC. (-1): auto, (0): off, (1): on" },
+
+    { .encoder = "avenc_huffyuv", .property_nm = "threads",    .default_val = "0", 	   .type = 3,
+      .tooltip = "Encoding threads. (0): auto" },
+    { .encoder = "avenc_huffyuv", .property_nm = "pred",       .default_val = "left", 	   .type = 3,
+      .tooltip = "Prediction method. left, plane, median" },
+
+    { .encoder = "avenc_utvideo", .property_nm = "threads",    .default_val = "0", 	   .type = 3,
+      .tooltip = "Encoding threads. (0): auto" },
+    { .encoder = "avenc_utvideo", .property_nm = "pred",       .default_val = "left", 	   .type = 3,
+      .tooltip = "Prediction method. none, left, gradient, median" }
 };
 
-static const int encoder_max = 40;
+static const int encoder_max = sizeof(encoder_arr) / sizeof(encoder_arr[0]);
 
 static const char *codec_def[][2] =	// Initial settings for some codec properties
     {
     	{"x264enc", "speed-preset=4" },			// (4)faster
     	{"x264enc", "tune=zerolatency" },		
     	{"avenc_mpeg2video", "bitrate=3000000" },
-    	{"avenc_mpeg4", "bitrate=3000000" }
+    	{"avenc_mpeg4", "bitrate=3000000" },
+    	{"avenc_ffv1", "level=3" },			// Required for slices
+    	{"avenc_ffv1", "slices=4" },
+    	{"avenc_ffv1", "threads=0" }
     };
 
-static const int init_pref_max = 3;
+static const int init_pref_max = 7;
 
 static const char *mpg2_fps_arr[][2] =	// Possible framerate values for mpeg2 codec
     {
@@ -0,0 +1,970 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Local control API - JSON lines over a Unix domain socket
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Capture sequence command
+**	19-Oct-2026	Check the subscribe argument type
+**	19-Oct-2026	Socket captures are not interactive (benchmark check)
+**	19-Oct-2026	Control key buffers sized for every control id
+**
+*/
+
+/*
+    The socket is created in the application directory (astroctc.sock) and accepts any number
+    of local clients. Each request is one JSON object per line and gets one reply line. The
+    'id' member, if present, is returned in the reply.
+
+	{"id":1,"cmd":"set_control","name":"Exposure","value":120}
+	{"id":1,"ok":true}
+	{"id":2,"cmd":"start_capture","frames":500}
+	{"id":2,"ok":false,"error":"Camera is busy (capture)"}
+
+    Commands:
+	list_cameras
+	get_controls
+	set_control	"control" (V4L2 control id) or "name", "value"
+	set_format	"format" (fourcc), "res" (WxH), "fps" - any or all
+	start_capture	"secs" or "frames" (neither is unlimited), "title"
+	stop_capture
+	sequence	"file" - capture sequence file to run (stop_capture ends it, darks and flats need noprompt)
+	snapshot	"count", "delay" (secs), "group" (frames per delay)
+	cancel_snapshot
+	status
+	subscribe	"events" (true / false) - mode changes as they happen, status once a second
+
+    Everything runs on the main loop and maps onto the same functions the user interface uses,
+    so the screen stays in step. A client that stops reading is disconnected rather than
+    allowed to hold up the main loop. For testing:
+
+	socat - UNIX-CONNECT:$HOME/.AstroCTC/astroctc.sock
+*/
+
+
+
+/* Includes */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+#include <json-glib/json-glib.h>
+#include <gst/gst.h>
+#include <main.h>
+#include <cam.h>
+#include <defs.h>
+#include <session.h>
+
+
+/* Defines */
+
+#define CTL_SOCK_NM "astroctc.sock"
+#define CTL_TICK 250						// ms
+#define CTL_STATUS_TICKS 4
+#define CTL_ERR_SZ 200
+
+
+/* Structures and Typedefs required */
+
+typedef struct _ctl_client
+{
+    GSocketConnection *conn;
+    GDataInputStream *in;
+    GOutputStream *out;
+    int events;
+    int closed;
+} ctl_client_t;
+
+typedef struct _ctl_cmd
+{
+    char *cmd;
+    int (*fn)(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+} ctl_cmd_t;
+
+
+/* Prototypes */
+
+int ctl_socket_init(CamData *, MainUi *);
+void ctl_socket_close();
+static gboolean ctl_incoming(GSocketService *, GSocketConnection *, GObject *, gpointer);
+static void ctl_read_cb(GObject *, GAsyncResult *, gpointer);
+void ctl_request(ctl_client_t *, char *);
+int ctl_send(ctl_client_t *, JsonBuilder *);
+void ctl_client_free(ctl_client_t *);
+gboolean ctl_events(gpointer);
+int ctl_list_cameras(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_get_controls(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_set_control(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_set_format(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_start_capture(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_stop_capture(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_sequence(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_snapshot(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_cancel_snapshot(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_status(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+int ctl_subscribe(JsonObject *, JsonBuilder *, ctl_client_t *, char *);
+void ctl_ctrl_list(struct v4l2_list *, JsonBuilder *);
+int ctl_mode_check(char *);
+char * ctl_mode_nm(int);
+gint64 ctl_int(JsonObject *, char *, gint64);
+const gchar * ctl_str(JsonObject *, char *);
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+extern char * app_dir_path();
+extern void get_session(char*, char**);
+extern int set_session(char*, char*);
+extern void session_ctrl_val(struct v4l2_queryctrl *, char *, long *);
+extern int set_cam_ctrl(camera_t *, struct v4l2_queryctrl *, long, GtkWidget *);
+extern void set_scale_val(GtkWidget *, char *, long);
+extern int cam_fmt_update(CamData *, char *);
+extern int cam_fps_update(CamData *, char *);
+extern void res_to_long(char *, long *, long *);
+extern void update_main_ui_res(MainUi *, CamData *);
+extern void update_main_ui_video(long, long, MainUi *);
+extern int update_main_ui_clrfmt(char *, MainUi *);
+extern int view_clear_pipeline(CamData *, MainUi *);
+extern int gst_view(CamData *, MainUi *);
+extern int gst_capture(CamData *, MainUi *, int, int, int);
+extern int set_eos(MainUi *);
+extern int seq_run(char *, CamData *, MainUi *, char *, int, int);
+extern int snap_control(CamData *, MainUi *, int, int, int);
+extern void cancel_snapshot(MainUi *);
+extern int stats_get(int, pipe_stat_t *);
+extern int stats_active();
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-ctl_socket.c ";
+static GSocketService *ctl_service = NULL;
+static char *ctl_path = NULL;
+static GList *ctl_clients = NULL;
+static CamData *ctl_cam_data;
+static MainUi *ctl_m_ui;
+static guint ctl_timer_id = 0;
+static int ctl_last_mode = -1;
+static int ctl_ticks = 0;
+
+static ctl_cmd_t ctl_cmds[] =
+{
+    { "list_cameras", ctl_list_cameras },
+    { "get_controls", ctl_get_controls },
+    { "set_control", ctl_set_control },
+    { "set_format", ctl_set_format },
+    { "start_capture", ctl_start_capture },
+    { "stop_capture", ctl_stop_capture },
+    { "sequence", ctl_sequence },
+    { "snapshot", ctl_snapshot },
+    { "cancel_snapshot", ctl_cancel_snapshot },
+    { "status", ctl_status },
+    { "subscribe", ctl_subscribe },
+    { NULL, NULL }
+};
+
+
+/* Create the socket and listen (on the main loop) */
+
+int ctl_socket_init(CamData *cam_data, MainUi *m_ui)
+{
+    GSocketAddress *addr;
+    GError *err = NULL;
+
+    ctl_cam_data = cam_data;
+    ctl_m_ui = m_ui;
+
+    /* A socket left by a previous run is removed */
+    ctl_path = g_build_filename (app_dir_path(), CTL_SOCK_NM, NULL);
+    unlink(ctl_path);
+
+    addr = g_unix_socket_address_new (ctl_path);
+    ctl_service = g_socket_service_new ();
+
+    if (! g_socket_listener_add_address (G_SOCKET_LISTENER (ctl_service), addr,
+					 G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+					 NULL, NULL, &err))
+    {
+	sprintf(app_msg_extra, "%s", err->message);
+	log_msg("SYS9005", ctl_path, NULL, NULL);
+	g_clear_error (&err);
+	g_object_unref (addr);
+	g_object_unref (ctl_service);
+	ctl_service = NULL;
+	return FALSE;
+    }
+
+    g_object_unref (addr);
+    chmod(ctl_path, 0600);
+
+    g_signal_connect (ctl_service, "incoming", G_CALLBACK (ctl_incoming), NULL);
+    g_socket_service_start (ctl_service);
+
+    ctl_timer_id = g_timeout_add (CTL_TICK, ctl_events, NULL);
+
+    return TRUE;
+}
+
+
+/* Stop listening, disconnect any clients and remove the socket */
+
+void ctl_socket_close()
+{
+    GList *l;
+
+    if (ctl_service == NULL)
+    	return;
+
+    g_source_remove (ctl_timer_id);
+    g_socket_service_stop (ctl_service);
+    g_socket_listener_close (G_SOCKET_LISTENER (ctl_service));
+    g_object_unref (ctl_service);
+    ctl_service = NULL;
+
+    for(l = ctl_clients; l != NULL; l = l->next)
+    {
+	((ctl_client_t *) l->data)->closed = TRUE;
+	g_io_stream_close (G_IO_STREAM (((ctl_client_t *) l->data)->conn), NULL, NULL);
+    }
+
+    unlink(ctl_path);
+    g_free (ctl_path);
+    ctl_path = NULL;
+
+    return;
+}
+
+
+/* New client - start reading requests */
+
+static gboolean ctl_incoming(GSocketService *service, GSocketConnection *conn, GObject *source, gpointer user_data)
+{
+    ctl_client_t *client;
+
+    client = (ctl_client_t *) malloc(sizeof(ctl_client_t));
+    memset(client, 0, sizeof(ctl_client_t));
+
+    client->conn = g_object_ref (conn);
+    client->in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (conn)));
+    client->out = g_io_stream_get_output_stream (G_IO_STREAM (conn));
+    ctl_clients = g_list_append (ctl_clients, client);
+
+    g_data_input_stream_read_line_async (client->in, G_PRIORITY_DEFAULT, NULL, ctl_read_cb, client);
+
+    return TRUE;
+}
+
+
+/* A request line (or end of the connection) */
+
+static void ctl_read_cb(GObject *source, GAsyncResult *res, gpointer user_data)
+{
+    ctl_client_t *client;
+    char *line;
+    gsize len;
+
+    client = (ctl_client_t *) user_data;
+    line = g_data_input_stream_read_line_finish (G_DATA_INPUT_STREAM (source), res, &len, NULL);
+
+    if (line == NULL || client->closed == TRUE)
+    {
+	g_free (line);
+	ctl_client_free(client);
+	return;
+    }
+
+    if (len > 0)
+	ctl_request(client, line);
+
+    g_free (line);
+
+    g_data_input_stream_read_line_async (client->in, G_PRIORITY_DEFAULT, NULL, ctl_read_cb, client);
+
+    return;
+}
+
+
+/* Parse a request, run the command and reply */
+
+void ctl_request(ctl_client_t *client, char *line)
+{
+    JsonParser *parser;
+    JsonNode *root;
+    JsonObject *req;
+    JsonBuilder *b;
+    GError *err = NULL;
+    const gchar *cmd;
+    char err_str[CTL_ERR_SZ];
+    int i, ok;
+
+    parser = json_parser_new ();
+    b = json_builder_new ();
+    json_builder_begin_object (b);
+    req = NULL;
+    err_str[0] = '\0';
+    ok = FALSE;
+
+    if (! json_parser_load_from_data (parser, line, -1, &err))
+    {
+	snprintf(err_str, sizeof(err_str), "Invalid JSON: %s", err->message);
+	g_clear_error (&err);
+    }
+    else if ((root = json_parser_get_root (parser)) == NULL || ! JSON_NODE_HOLDS_OBJECT (root))
+    {
+	snprintf(err_str, sizeof(err_str), "Request must be an object");
+    }
+    else
+    {
+	req = json_node_get_object (root);
+
+	if (json_object_has_member (req, "id"))
+	{
+	    json_builder_set_member_name (b, "id");
+	    json_builder_add_value (b, json_node_copy (json_object_get_member (req, "id")));
+	}
+
+	if ((cmd = ctl_str(req, "cmd")) == NULL)
+	{
+	    snprintf(err_str, sizeof(err_str), "No command");
+	}
+	else
+	{
+	    for(i = 0; ctl_cmds[i].cmd != NULL; i++)
+	    {
+		if (strcmp(cmd, ctl_cmds[i].cmd) == 0)
+		    break;
+	    }
+
+	    if (ctl_cmds[i].cmd == NULL)
+		snprintf(err_str, sizeof(err_str), "Unknown command: %s", cmd);
+	    else
+		ok = (*ctl_cmds[i].fn)(req, b, client, err_str);
+	}
+    }
+
+    json_builder_set_member_name (b, "ok");
+    json_builder_add_boolean_value (b, ok);
+
+    if (ok == FALSE)
+    {
+	json_builder_set_member_name (b, "error");
+	json_builder_add_string_value (b, err_str);
+    }
+
+    json_builder_end_object (b);
+    ctl_send(client, b);
+
+    g_object_unref (b);
+    g_object_unref (parser);
+
+    return;
+}
+
+
+// Write a line without waiting. A client whose socket is full is not reading, so it is
+// closed (the pending read then fails and frees it).
+
+int ctl_send(ctl_client_t *client, JsonBuilder *b)
+{
+    JsonGenerator *gen;
+    JsonNode *root;
+    gchar *data, *line;
+    gssize n;
+    gsize len;
+
+    if (client->closed == TRUE)
+    	return FALSE;
+
+    gen = json_generator_new ();
+    root = json_builder_get_root (b);
+    json_generator_set_root (gen, root);
+    data = json_generator_to_data (gen, &len);
+    line = g_strconcat (data, "\n", NULL);
+    len++;
+
+    n = g_pollable_output_stream_write_nonblocking (G_POLLABLE_OUTPUT_STREAM (client->out), line, len, NULL, NULL);
+
+    g_free (line);
+    g_free (data);
+    json_node_unref (root);
+    g_object_unref (gen);
+
+    if (n != (gssize) len)
+    {
+	client->closed = TRUE;
+	g_io_stream_close (G_IO_STREAM (client->conn), NULL, NULL);
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Release a client */
+
+void ctl_client_free(ctl_client_t *client)
+{
+    ctl_clients = g_list_remove (ctl_clients, client);
+
+    if (client->closed == FALSE)
+	g_io_stream_close (G_IO_STREAM (client->conn), NULL, NULL);
+
+    g_object_unref (client->in);
+    g_object_unref (client->conn);
+    free(client);
+
+    return;
+}
+
+
+/* Timer - mode changes straight away and status once a second to subscribed clients */
+
+gboolean ctl_events(gpointer user_data)
+{
+    GList *l;
+    ctl_client_t *client;
+    JsonBuilder *b;
+    char err_str[CTL_ERR_SZ];
+    int mode_chg;
+
+    mode_chg = (ctl_cam_data->mode != ctl_last_mode);
+    ctl_last_mode = ctl_cam_data->mode;
+    ctl_ticks++;
+
+    if (mode_chg == FALSE && ctl_ticks < CTL_STATUS_TICKS)
+    	return TRUE;
+
+    ctl_ticks = 0;
+
+    for(l = ctl_clients; l != NULL; l = l->next)
+    {
+	client = (ctl_client_t *) l->data;
+
+	if (client->events == FALSE || client->closed == TRUE)
+	    continue;
+
+	b = json_builder_new ();
+	json_builder_begin_object (b);
+	json_builder_set_member_name (b, "event");
+	json_builder_add_string_value (b, (mode_chg == TRUE) ? "mode" : "status");
+	ctl_status(NULL, b, client, err_str);
+	json_builder_end_object (b);
+	ctl_send(client, b);
+	g_object_unref (b);
+    }
+
+    return TRUE;
+}
+
+
+/* Cameras found at startup (or the last scan) */
+
+int ctl_list_cameras(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    struct camlistNode *node;
+
+    json_builder_set_member_name (b, "cameras");
+    json_builder_begin_array (b);
+
+    for(node = ctl_cam_data->camlist; node != NULL; node = node->next)
+    {
+	json_builder_begin_object (b);
+	json_builder_set_member_name (b, "device");
+	json_builder_add_string_value (b, node->cam->video_dev);
+	json_builder_set_member_name (b, "name");
+	json_builder_add_string_value (b, (char *) node->cam->vcaps.card);
+	json_builder_set_member_name (b, "current");
+	json_builder_add_boolean_value (b, (strcmp(node->cam->video_dev, ctl_cam_data->current_dev) == 0));
+	json_builder_end_object (b);
+    }
+
+    json_builder_end_array (b);
+
+    return TRUE;
+}
+
+
+/* Controls for the current camera with their ranges and values */
+
+int ctl_get_controls(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    if (ctl_cam_data->cam == NULL)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "No camera");
+	return FALSE;
+    }
+
+    json_builder_set_member_name (b, "controls");
+    json_builder_begin_array (b);
+    ctl_ctrl_list(ctl_cam_data->cam->ctl_head, b);
+    ctl_ctrl_list(ctl_cam_data->cam->pctl_head, b);
+    json_builder_end_array (b);
+
+    return TRUE;
+}
+
+
+/* Set a control by id or name (within range) */
+
+int ctl_set_control(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    struct v4l2_list *p;
+    struct v4l2_queryctrl *qctrl;
+    const gchar *nm;
+    gint64 id;
+    long val;
+    int i;
+    char ctl_key[CTL_KEY_SZ], s[25];
+
+    if (ctl_cam_data->cam == NULL)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "No camera");
+	return FALSE;
+    }
+
+    id = ctl_int(req, "control", -1);
+    nm = ctl_str(req, "name");
+
+    if (! json_object_has_member (req, "value") || (id < 0 && nm == NULL))
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Control (\"control\" or \"name\") and \"value\" required");
+	return FALSE;
+    }
+
+    val = (long) ctl_int(req, "value", 0);
+
+    /* Find the control */
+    qctrl = NULL;
+
+    for(i = 0; i < 2 && qctrl == NULL; i++)
+    {
+	for(p = (i == 0) ? ctl_cam_data->cam->ctl_head : ctl_cam_data->cam->pctl_head; p != NULL; p = p->next)
+	{
+	    qctrl = (struct v4l2_queryctrl *) p->v4l2_data;
+
+	    if ((id >= 0 && qctrl->id == (__u32) id) ||
+		(id < 0 && g_ascii_strcasecmp(nm, (char *) qctrl->name) == 0))
+		break;
+
+	    qctrl = NULL;
+	}
+    }
+
+    if (qctrl == NULL)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Control not found");
+	return FALSE;
+    }
+
+    if (val < qctrl->minimum || val > qctrl->maximum)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Value out of range (%d to %d)", qctrl->minimum, qctrl->maximum);
+	return FALSE;
+    }
+
+    /* Set, keep for the session and show on the control panel */
+    if (set_cam_ctrl(ctl_cam_data->cam, qctrl, val, NULL) == FALSE)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Control could not be set (see log)");
+	return FALSE;
+    }
+
+    snprintf(ctl_key, sizeof(ctl_key), "ctl-%d", qctrl->id - V4L2_CID_BASE);
+    snprintf(s, sizeof(s), "%ld", val);
+    set_session(ctl_key, s);
+    set_scale_val(ctl_m_ui->cntl_grid, ctl_key, val);
+
+    return TRUE;
+}
+
+
+// Set the camera format, frame size and / or rate. As for the control panel the view
+// pipeline is cleared, the camera updated, the lists reset and the pipeline rebuilt.
+
+int ctl_set_format(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    const gchar *fmt, *res_req;
+    char *p;
+    char res[30], fps[20], old_fmt[10];
+    gint64 fps_req;
+    long width, height;
+    int r;
+
+    if (ctl_mode_check(err_str) == FALSE)
+    	return FALSE;
+
+    fmt = ctl_str(req, "format");
+    res_req = ctl_str(req, "res");
+    fps_req = ctl_int(req, "fps", 0);
+
+    /* Current settings for anything not given */
+    get_session(RESOLUTION, &p);
+    snprintf(res, sizeof(res), "%s", (res_req != NULL) ? res_req : p);
+    get_session(CLRFMT, &p);
+    snprintf(old_fmt, sizeof(old_fmt), "%s", p);
+
+    if (view_clear_pipeline(ctl_cam_data, ctl_m_ui) == FALSE)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Pipeline could not be stopped");
+	return FALSE;
+    }
+
+    r = TRUE;
+
+    if (fmt != NULL && update_main_ui_clrfmt((char *) fmt, ctl_m_ui) == FALSE)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Format %s is not supported by the camera", fmt);
+	r = FALSE;
+    }
+
+    if (r == TRUE && cam_fmt_update(ctl_cam_data, res) == FALSE)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Format could not be set (see log)");
+	set_session(CLRFMT, old_fmt);
+	update_main_ui_clrfmt(old_fmt, ctl_m_ui);
+	r = FALSE;
+    }
+
+    if (r == TRUE)
+    {
+	set_session(RESOLUTION, res);
+
+	if (fps_req > 0)
+	{
+	    snprintf(fps, sizeof(fps), "%" G_GINT64_FORMAT, fps_req);
+
+	    if (cam_fps_update(ctl_cam_data, fps) == TRUE)
+	    {
+		set_session(FPS, fps);
+	    }
+	    else
+	    {
+		snprintf(err_str, CTL_ERR_SZ, "Frame rate could not be set (see log)");
+		r = FALSE;
+	    }
+	}
+
+	res_to_long(res, &width, &height);
+	update_main_ui_res(ctl_m_ui, ctl_cam_data);
+	update_main_ui_video(width, height, ctl_m_ui);
+    }
+
+    /* Rebuild the pipeline */
+    gst_view(ctl_cam_data, ctl_m_ui);
+
+    return r;
+}
+
+
+/* Start a capture - seconds, frames or unlimited (until stop_capture) */
+
+int ctl_start_capture(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    const gchar *title;
+
+    if (ctl_mode_check(err_str) == FALSE)
+    	return FALSE;
+
+    if ((title = ctl_str(req, "title")) != NULL)
+	gtk_entry_set_text (GTK_ENTRY (ctl_m_ui->obj_title), title);
+
+    if (gst_capture(ctl_cam_data, ctl_m_ui, (int) ctl_int(req, "secs", 0), (int) ctl_int(req, "frames", 0), FALSE) == FALSE)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Capture could not be started (see log)");
+	return FALSE;
+    }
+
+    json_builder_set_member_name (b, "file");
+    json_builder_add_string_value (b, ctl_cam_data->u.v_capt.out_name);
+
+    return TRUE;
+}
+
+
+/* Stop the current capture (the file is finished by the bus watch) */
+
+int ctl_stop_capture(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    if (ctl_cam_data->mode != CAM_MODE_CAPT)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Not capturing");
+	return FALSE;
+    }
+
+    set_eos(ctl_m_ui);
+
+    return TRUE;
+}
+
+
+/* Run a capture sequence file (see sequence.c) */
+
+int ctl_sequence(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    const gchar *fn;
+
+    if ((fn = ctl_str(req, "file")) == NULL)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "\"file\" required");
+	return FALSE;
+    }
+
+    if (ctl_mode_check(err_str) == FALSE)
+    	return FALSE;
+
+    if (seq_run((char *) fn, ctl_cam_data, ctl_m_ui, err_str, CTL_ERR_SZ, FALSE) == FALSE)
+    	return FALSE;
+
+    json_builder_set_member_name (b, "file");
+    json_builder_add_string_value (b, ctl_cam_data->u.v_capt.out_name);
+
+    return TRUE;
+}
+
+
+/* Take a snapshot sequence */
+
+int ctl_snapshot(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    if (snap_control(ctl_cam_data, ctl_m_ui, (int) ctl_int(req, "count", 1), (int) ctl_int(req, "delay", -1),
+		     (int) ctl_int(req, "group", 0)) == FALSE)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Snapshot could not be started (see log)");
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Cancel a snapshot sequence */
+
+int ctl_cancel_snapshot(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    cancel_snapshot(ctl_m_ui);
+
+    return TRUE;
+}
+
+
+/* Current camera, format, mode and status line (plus pipeline statistics while capturing) */
+
+int ctl_status(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    pipe_stat_t ps;
+    char *p;
+    int i;
+
+    json_builder_set_member_name (b, "mode");
+    json_builder_add_string_value (b, ctl_mode_nm(ctl_cam_data->mode));
+    json_builder_set_member_name (b, "camera");
+    json_builder_add_string_value (b, ctl_cam_data->current_cam);
+    json_builder_set_member_name (b, "device");
+    json_builder_add_string_value (b, ctl_cam_data->current_dev);
+
+    get_session(CLRFMT, &p);
+    json_builder_set_member_name (b, "format");
+    json_builder_add_string_value (b, (p != NULL) ? p : "");
+    get_session(RESOLUTION, &p);
+    json_builder_set_member_name (b, "res");
+    json_builder_add_string_value (b, (p != NULL) ? p : "");
+    get_session(FPS, &p);
+    json_builder_set_member_name (b, "fps");
+    json_builder_add_int_value (b, (p != NULL) ? atoi(p) : 0);
+
+    json_builder_set_member_name (b, "status");
+    json_builder_add_string_value (b, gtk_label_get_text (GTK_LABEL (ctl_m_ui->status_info)));
+
+    if (ctl_cam_data->mode == CAM_MODE_CAPT)
+    {
+	json_builder_set_member_name (b, "file");
+	json_builder_add_string_value (b, ctl_cam_data->u.v_capt.out_name);
+	json_builder_set_member_name (b, "frames");
+	json_builder_add_int_value (b, (gint64) ctl_cam_data->u.v_capt.buf_count);
+    }
+
+    if (stats_active() == TRUE)
+    {
+	json_builder_set_member_name (b, "stats");
+	json_builder_begin_array (b);
+
+	for(i = 0; stats_get(i, &ps) == TRUE; i++)
+	{
+	    json_builder_begin_object (b);
+	    json_builder_set_member_name (b, "element");
+	    json_builder_add_string_value (b, ps.nm);
+	    json_builder_set_member_name (b, "fps");
+	    json_builder_add_double_value (b, ps.fps);
+	    json_builder_set_member_name (b, "p95_ms");
+	    json_builder_add_double_value (b, ps.lat_p95);
+	    json_builder_set_member_name (b, "level");
+	    json_builder_add_int_value (b, ps.level);
+	    json_builder_set_member_name (b, "mbps");
+	    json_builder_add_double_value (b, ps.mbps);
+	    json_builder_end_object (b);
+	}
+
+	json_builder_end_array (b);
+    }
+
+    return TRUE;
+}
+
+
+/* Turn status events on or off for this client */
+
+int ctl_subscribe(JsonObject *req, JsonBuilder *b, ctl_client_t *client, char *err_str)
+{
+    JsonNode *node;
+
+    if (! json_object_has_member (req, "events"))
+    {
+	client->events = TRUE;
+	return TRUE;
+    }
+
+    node = json_object_get_member (req, "events");
+
+    if (! JSON_NODE_HOLDS_VALUE (node) || json_node_get_value_type (node) != G_TYPE_BOOLEAN)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "\"events\" must be true or false");
+	return FALSE;
+    }
+
+    client->events = json_node_get_boolean (node);
+
+    return TRUE;
+}
+
+
+/* Add a list of controls to an array */
+
+void ctl_ctrl_list(struct v4l2_list *p, JsonBuilder *b)
+{
+    struct v4l2_queryctrl *qctrl;
+    char ctl_key[CTL_KEY_SZ];
+    long val;
+
+    for(; p != NULL; p = p->next)
+    {
+	qctrl = (struct v4l2_queryctrl *) p->v4l2_data;
+
+	if (qctrl->flags & V4L2_CTRL_FLAG_DISABLED)
+	    continue;
+
+	session_ctrl_val(qctrl, ctl_key, &val);
+
+	json_builder_begin_object (b);
+	json_builder_set_member_name (b, "control");
+	json_builder_add_int_value (b, qctrl->id);
+	json_builder_set_member_name (b, "name");
+	json_builder_add_string_value (b, (char *) qctrl->name);
+	json_builder_set_member_name (b, "min");
+	json_builder_add_int_value (b, qctrl->minimum);
+	json_builder_set_member_name (b, "max");
+	json_builder_add_int_value (b, qctrl->maximum);
+	json_builder_set_member_name (b, "step");
+	json_builder_add_int_value (b, qctrl->step);
+	json_builder_set_member_name (b, "default");
+	json_builder_add_int_value (b, qctrl->default_value);
+	json_builder_set_member_name (b, "value");
+	json_builder_add_int_value (b, val);
+	json_builder_end_object (b);
+    }
+
+    return;
+}
+
+
+/* Format changes and captures are only allowed while just viewing */
+
+int ctl_mode_check(char *err_str)
+{
+    if (ctl_cam_data->pipeline == NULL || ctl_cam_data->mode != CAM_MODE_VIEW)
+    {
+	snprintf(err_str, CTL_ERR_SZ, "Camera is busy (%s)", ctl_mode_nm(ctl_cam_data->mode));
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Mode as text */
+
+char * ctl_mode_nm(int mode)
+{
+    switch(mode)
+    {
+	case CAM_MODE_VIEW:
+	    return "view";
+
+	case CAM_MODE_CAPT:
+	    return "capture";
+
+	case CAM_MODE_SNAP:
+	    return "snapshot";
+
+	default:
+	    return "none";
+    }
+}
+
+
+/* Optional integer member */
+
+gint64 ctl_int(JsonObject *req, char *nm, gint64 dflt)
+{
+    JsonNode *node;
+
+    if (req == NULL || (node = json_object_get_member (req, nm)) == NULL)
+    	return dflt;
+
+    if (! JSON_NODE_HOLDS_VALUE (node) ||
+	(json_node_get_value_type (node) != G_TYPE_INT64 && json_node_get_value_type (node) != G_TYPE_DOUBLE))
+    	return dflt;
+
+    return json_node_get_int (node);
+}
+
+
+/* Optional string member */
+
+const gchar * ctl_str(JsonObject *req, char *nm)
+{
+    JsonNode *node;
+
+    if (req == NULL || (node = json_object_get_member (req, nm)) == NULL)
+    	return NULL;
+
+    if (! JSON_NODE_HOLDS_VALUE (node) || json_node_get_value_type (node) != G_TYPE_STRING)
+    	return NULL;
+
+    return json_node_get_string (node);
+}
@@ -26,6 +26,10 @@
 **
 ** History
 **	06-Dec-2013	Initial
+**	19-Oct-2026	Native capture format code
+**	19-Oct-2026	Pipeline statistics window title
+**	19-Oct-2026	Camera tiles window title
+**	19-Oct-2026	Camera capability cache directory
 **
 */
 
@@ -79,10 +83,12 @@ extern const GdkRGBA NIGHT;
 #ifndef TITLE
 #define TITLE "AstroCTC"
 #define PROFILES "Profiles"
+#define CAPS_CACHE "CameraCache"
 #define LAST_SESSION "Last_Session"
 #define USER_PREFS "user_preferences"
 #define PRF_NONE "None"
 #define MPEG2 "MPG2"
+#define NATIVE_FMT "NATV"
 #define DEV_DIR "/dev"
 #define V4L_SYS_CLASS "/sys/class/video4linux"
 #define PACKAGE_DATA_DIR "/usr/share"			// Release only
@@ -121,6 +127,8 @@ extern const GdkRGBA NIGHT;
 #define SNAP_UI "Snapshot Options"
 #define ABOUT_UI "About"
 #define OTHER_CTRL_UI "More Controls"
+#define STATS_UI "Pipeline Statistics"
+#define TILES_UI "Camera Tiles"
 #endif
 
 
@@ -0,0 +1,857 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Capture file sink - preallocated, direct i/o, double buffered
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	RAM staging - ring of blocks sized by a memory budget
+**
+*/
+
+/*
+    A replacement for filesink for long, high bit rate captures. Data is gathered into large
+    aligned blocks and written with O_DIRECT by a writer thread while the next block fills, so
+    the page cache (and its writeback) is not involved. The file is preallocated ahead of the
+    writes with fallocate in large extents.
+
+    Muxers seek back at the end to finish their headers. When that happens the partly filled
+    block is written (padded) and all further writes go through a normal buffered descriptor.
+    The file is truncated to its real length when closed. If the file system does not support
+    O_DIRECT (eg. tmpfs) the same scheme is used with normal writes.
+
+    With a RAM budget the two blocks become a ring of as many blocks as the budget allows
+    (locked in memory, huge pages if possible). Bursts faster than the disk are staged in the
+    ring and drained in the background; at end of stream the ring is emptied before the EOS
+    is passed on, so the capture is only complete once it is all on disk.
+
+    Read only properties give the bytes written, the write rate (MB/s over the last second),
+    the number of times the pipeline had to wait for the disk and the ring headroom.
+*/
+
+
+/* Defines */
+
+#define _GNU_SOURCE
+
+#define DS_ALIGN 4096
+#define DS_BLOCK (4 * 1024 * 1024)
+#define DS_EXTENT (256 * 1024 * 1024)
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
+
+
+/* Structures and Typedefs required */
+
+typedef struct _DirectSink
+{
+    GstBaseSink parent;
+
+    gchar *location;						// Properties
+    guint block_sz;
+    guint64 extent;
+    gboolean direct;
+    guint64 ram_budget;
+
+    int fd;							// Appends (O_DIRECT if possible)
+    int fd_b;							// Buffered (header rewrites)
+    gboolean is_direct;
+    guchar *ring;						// Blocks (2 or the RAM budget)
+    gsize ring_sz;
+    int ring_locked;
+    guint n_blocks;
+    guint64 *blk_off;
+    guint *blk_len;
+    guint head;							// Block being filled
+    guint fill;							// Bytes in the current block
+    guint64 base;						// File offset of the current block
+    guint64 pos;						// Next write position
+    guint64 end;						// Highest offset written
+    gboolean rewrite;						// Seeked - buffered writes only
+
+    GThread *thread;						// Writer
+    GMutex lock;
+    GCond cond;
+    guint tail;							// Next block to write
+    guint queued;						// Blocks waiting or being written
+    gboolean wr_stop;
+    int wr_err;
+    guint64 alloc_end;						// Preallocated to (writer only)
+
+    guint64 written;						// Statistics (lock)
+    guint stalls;
+    gdouble rate;
+    gint64 rate_t;
+    guint64 rate_bytes;
+} DirectSink;
+
+typedef struct _DirectSinkClass
+{
+    GstBaseSinkClass parent_class;
+} DirectSinkClass;
+
+enum { PROP_0, PROP_LOCATION, PROP_BLOCK_SIZE, PROP_EXTENT, PROP_DIRECT, PROP_RAM_BUDGET,
+       PROP_BYTES_WRITTEN, PROP_WRITE_RATE, PROP_STALLS, PROP_DIRECT_ACTIVE, PROP_HEADROOM };
+
+
+/* Prototypes */
+
+GType direct_sink_get_type(void);
+int direct_sink_register();
+static void direct_sink_class_init(DirectSinkClass *);
+static void direct_sink_init(DirectSink *);
+static void ds_set_property(GObject *, guint, const GValue *, GParamSpec *);
+static void ds_get_property(GObject *, guint, GValue *, GParamSpec *);
+static void ds_finalize(GObject *);
+static gboolean ds_start(GstBaseSink *);
+static gboolean ds_stop(GstBaseSink *);
+static GstFlowReturn ds_render(GstBaseSink *, GstBuffer *);
+static gboolean ds_event(GstBaseSink *, GstEvent *);
+static gboolean ds_query(GstBaseSink *, GstQuery *);
+static int ds_append(DirectSink *, const guchar *, gsize);
+static int ds_submit(DirectSink *, guint);
+static int ds_flush_tail(DirectSink *);
+static int ds_wait_idle(DirectSink *);
+static int ds_pwrite(int, const guchar *, gsize, guint64);
+static gpointer ds_writer(gpointer);
+static void ds_free_ring(DirectSink *);
+
+extern void * ram_alloc(size_t, int *);
+extern void ram_free(void *, size_t, int);
+
+#define DIRECT_TYPE_SINK (direct_sink_get_type())
+#define DIRECT_SINK(obj) ((DirectSink *) (obj))
+
+G_DEFINE_TYPE (DirectSink, direct_sink, GST_TYPE_BASE_SINK);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-direct_sink.c ";
+
+static GstStaticPadTemplate ds_sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+								      GST_PAD_SINK,
+								      GST_PAD_ALWAYS,
+								      GST_STATIC_CAPS_ANY);
+
+
+/* Make the sink available to the application (not a plugin) */
+
+int direct_sink_register()
+{
+    return gst_element_register (NULL, "astrodirectsink", GST_RANK_NONE, DIRECT_TYPE_SINK);
+}
+
+
+/* Class setup - properties and virtual functions */
+
+static void direct_sink_class_init(DirectSinkClass *klass)
+{
+    GObjectClass *gobject_class;
+    GstElementClass *element_class;
+    GstBaseSinkClass *basesink_class;
+
+    gobject_class = G_OBJECT_CLASS (klass);
+    element_class = GST_ELEMENT_CLASS (klass);
+    basesink_class = GST_BASE_SINK_CLASS (klass);
+
+    gobject_class->set_property = ds_set_property;
+    gobject_class->get_property = ds_get_property;
+    gobject_class->finalize = ds_finalize;
+
+    g_object_class_install_property (gobject_class, PROP_LOCATION,
+	g_param_spec_string ("location", "File Location", "Location of the file to write",
+			     NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_BLOCK_SIZE,
+	g_param_spec_uint ("block-size", "Block size", "Size of each write (multiple of 4096)",
+			   DS_ALIGN, 256 * 1024 * 1024, DS_BLOCK, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_EXTENT,
+	g_param_spec_uint64 ("extent", "Preallocation extent", "Bytes preallocated ahead of the writes (0 = none)",
+			     0, G_MAXUINT64, DS_EXTENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_DIRECT,
+	g_param_spec_boolean ("direct", "Direct i/o", "Use O_DIRECT if the file system supports it",
+			      TRUE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_RAM_BUDGET,
+	g_param_spec_uint64 ("ram-budget", "RAM budget", "Bytes of memory to stage writes in (0 = double buffer only)",
+			     0, G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_BYTES_WRITTEN,
+	g_param_spec_uint64 ("bytes-written", "Bytes written", "Bytes written to disk",
+			     0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_WRITE_RATE,
+	g_param_spec_double ("write-rate", "Write rate", "MB per second written (last second)",
+			     0, G_MAXDOUBLE, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_STALLS,
+	g_param_spec_uint ("stalls", "Stalls", "Times the pipeline waited for the disk",
+			   0, G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_DIRECT_ACTIVE,
+	g_param_spec_boolean ("direct-active", "Direct i/o active", "O_DIRECT is in use",
+			      FALSE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property (gobject_class, PROP_HEADROOM,
+	g_param_spec_int ("headroom", "Headroom", "Percentage of the staging blocks free",
+			  0, 100, 100, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+    gst_element_class_set_static_metadata (element_class, "AstroCTC direct file sink", "Sink/File",
+					   "Preallocated, direct i/o capture file writer", "Anthony Buckley");
+    gst_element_class_add_static_pad_template (element_class, &ds_sink_template);
+
+    basesink_class->start = GST_DEBUG_FUNCPTR (ds_start);
+    basesink_class->stop = GST_DEBUG_FUNCPTR (ds_stop);
+    basesink_class->render = GST_DEBUG_FUNCPTR (ds_render);
+    basesink_class->event = GST_DEBUG_FUNCPTR (ds_event);
+    basesink_class->query = GST_DEBUG_FUNCPTR (ds_query);
+
+    return;
+}
+
+
+/* Instance defaults */
+
+static void direct_sink_init(DirectSink *ds)
+{
+    ds->location = NULL;
+    ds->block_sz = DS_BLOCK;
+    ds->extent = DS_EXTENT;
+    ds->direct = TRUE;
+    ds->fd = ds->fd_b = -1;
+    g_mutex_init (&(ds->lock));
+    g_cond_init (&(ds->cond));
+
+    gst_base_sink_set_sync (GST_BASE_SINK (ds), FALSE);
+
+    return;
+}
+
+
+/* Property set */
+
+static void ds_set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    DirectSink *ds;
+
+    ds = DIRECT_SINK (object);
+
+    switch (prop_id)
+    {
+	case PROP_LOCATION:
+	    g_free (ds->location);
+	    ds->location = g_value_dup_string (value);
+	    break;
+
+	case PROP_BLOCK_SIZE:
+	    ds->block_sz = g_value_get_uint (value) & ~(DS_ALIGN - 1);
+	    break;
+
+	case PROP_EXTENT:
+	    ds->extent = g_value_get_uint64 (value);
+	    break;
+
+	case PROP_DIRECT:
+	    ds->direct = g_value_get_boolean (value);
+	    break;
+
+	case PROP_RAM_BUDGET:
+	    ds->ram_budget = g_value_get_uint64 (value);
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+
+    return;
+}
+
+
+/* Property get */
+
+static void ds_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    DirectSink *ds;
+
+    ds = DIRECT_SINK (object);
+
+    switch (prop_id)
+    {
+	case PROP_LOCATION:
+	    g_value_set_string (value, ds->location);
+	    break;
+
+	case PROP_BLOCK_SIZE:
+	    g_value_set_uint (value, ds->block_sz);
+	    break;
+
+	case PROP_EXTENT:
+	    g_value_set_uint64 (value, ds->extent);
+	    break;
+
+	case PROP_DIRECT:
+	    g_value_set_boolean (value, ds->direct);
+	    break;
+
+	case PROP_RAM_BUDGET:
+	    g_value_set_uint64 (value, ds->ram_budget);
+	    break;
+
+	case PROP_BYTES_WRITTEN:
+	    g_mutex_lock (&(ds->lock));
+	    g_value_set_uint64 (value, ds->written);
+	    g_mutex_unlock (&(ds->lock));
+	    break;
+
+	case PROP_WRITE_RATE:
+	    g_mutex_lock (&(ds->lock));
+	    g_value_set_double (value, ds->rate);
+	    g_mutex_unlock (&(ds->lock));
+	    break;
+
+	case PROP_STALLS:
+	    g_mutex_lock (&(ds->lock));
+	    g_value_set_uint (value, ds->stalls);
+	    g_mutex_unlock (&(ds->lock));
+	    break;
+
+	case PROP_DIRECT_ACTIVE:
+	    g_value_set_boolean (value, ds->is_direct);
+	    break;
+
+	case PROP_HEADROOM:
+	    g_mutex_lock (&(ds->lock));
+
+	    if (ds->n_blocks > 1)
+		g_value_set_int (value, (int) (100 * (ds->n_blocks - 1 - MIN (ds->queued, ds->n_blocks - 1)) /
+					       (ds->n_blocks - 1)));
+	    else
+		g_value_set_int (value, 100);
+
+	    g_mutex_unlock (&(ds->lock));
+	    break;
+
+	default:
+	    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+
+    return;
+}
+
+
+/* Free */
+
+static void ds_finalize(GObject *object)
+{
+    DirectSink *ds;
+
+    ds = DIRECT_SINK (object);
+    g_free (ds->location);
+    g_mutex_clear (&(ds->lock));
+    g_cond_clear (&(ds->cond));
+
+    G_OBJECT_CLASS (direct_sink_parent_class)->finalize (object);
+}
+
+
+/* Open the file (direct if possible), set up the ring of blocks and start the writer */
+
+static gboolean ds_start(GstBaseSink *sink)
+{
+    DirectSink *ds;
+    int flags;
+
+    ds = DIRECT_SINK (sink);
+
+    if (ds->location == NULL)
+    {
+	GST_ELEMENT_ERROR (ds, RESOURCE, NOT_FOUND, ("No file name specified for writing."), (NULL));
+	return FALSE;
+    }
+
+    flags = O_WRONLY | O_CREAT | O_TRUNC;
+    ds->is_direct = FALSE;
+
+    if (ds->direct == TRUE)
+    {
+	if ((ds->fd = open(ds->location, flags | O_DIRECT, 0644)) >= 0)
+	    ds->is_direct = TRUE;
+    }
+
+    if (ds->is_direct == FALSE)
+	ds->fd = open(ds->location, flags, 0644);
+
+    if (ds->fd < 0 || (ds->fd_b = open(ds->location, O_WRONLY)) < 0)
+    {
+	GST_ELEMENT_ERROR (ds, RESOURCE, OPEN_WRITE, ("Could not open file \"%s\" for writing.", ds->location),
+			   GST_ERROR_SYSTEM);
+
+	if (ds->fd >= 0)
+	    close(ds->fd);
+
+	ds->fd = -1;
+	return FALSE;
+    }
+
+    /* Aligned blocks - at least one filling and one being written, more for a RAM budget */
+    if (ds->block_sz < DS_ALIGN)
+    	ds->block_sz = DS_BLOCK;
+
+    ds->n_blocks = (guint) MAX (2, MIN (ds->ram_budget / ds->block_sz, G_MAXINT));
+    ds->ring_sz = (gsize) ds->n_blocks * ds->block_sz;
+    ds->ring = (guchar *) ram_alloc(ds->ring_sz, &(ds->ring_locked));
+    ds->blk_off = (guint64 *) malloc(ds->n_blocks * sizeof(guint64));
+    ds->blk_len = (guint *) malloc(ds->n_blocks * sizeof(guint));
+
+    if (ds->ring == NULL || ds->blk_off == NULL || ds->blk_len == NULL)
+    {
+	GST_ELEMENT_ERROR (ds, RESOURCE, NO_SPACE_LEFT, ("Could not allocate %" G_GSIZE_FORMAT " MB of write buffers.",
+			   ds->ring_sz / (1024 * 1024)), (NULL));
+	ds_free_ring(ds);
+	close(ds->fd);
+	close(ds->fd_b);
+	ds->fd = ds->fd_b = -1;
+	return FALSE;
+    }
+
+    ds->head = ds->tail = ds->queued = 0;
+    ds->fill = 0;
+    ds->base = ds->pos = ds->end = 0;
+    ds->rewrite = FALSE;
+    ds->wr_stop = FALSE;
+    ds->wr_err = 0;
+    ds->alloc_end = 0;
+    ds->written = ds->rate_bytes = 0;
+    ds->stalls = 0;
+    ds->rate = 0;
+    ds->rate_t = g_get_monotonic_time ();
+
+    ds->thread = g_thread_new ("ds_writer", ds_writer, ds);
+
+    return TRUE;
+}
+
+
+/* Write anything outstanding, stop the writer and trim the file to its real length */
+
+static gboolean ds_stop(GstBaseSink *sink)
+{
+    DirectSink *ds;
+    int err;
+
+    ds = DIRECT_SINK (sink);
+    err = 0;
+
+    if (ds->thread != NULL)
+    {
+	if (ds->rewrite == FALSE)
+	    err = ds_flush_tail(ds);
+
+	g_mutex_lock (&(ds->lock));
+	ds->wr_stop = TRUE;
+	g_cond_broadcast (&(ds->cond));
+	g_mutex_unlock (&(ds->lock));
+
+	g_thread_join (ds->thread);
+	ds->thread = NULL;
+    }
+
+    if (ds->fd_b >= 0)
+    {
+	if (ftruncate(ds->fd_b, (off_t) ds->end) != 0 && err == 0)
+	    err = errno;
+
+	close(ds->fd_b);
+	ds->fd_b = -1;
+    }
+
+    if (ds->fd >= 0)
+    {
+	close(ds->fd);
+	ds->fd = -1;
+    }
+
+    ds_free_ring(ds);
+
+    if (err != 0)
+    {
+	GST_ELEMENT_ERROR (ds, RESOURCE, CLOSE, ("Error closing file \"%s\": %s", ds->location, strerror(err)),
+			   (NULL));
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Write a buffer - appended to the current block, or written directly once seeking has started */
+
+static GstFlowReturn ds_render(GstBaseSink *sink, GstBuffer *buffer)
+{
+    DirectSink *ds;
+    GstMapInfo map;
+    int err;
+
+    ds = DIRECT_SINK (sink);
+
+    if (! gst_buffer_map (buffer, &map, GST_MAP_READ))
+    	return GST_FLOW_ERROR;
+
+    if (ds->rewrite == FALSE)
+    {
+	err = ds_append(ds, map.data, map.size);
+    }
+    else
+    {
+	err = ds_pwrite(ds->fd_b, map.data, map.size, ds->pos);
+	ds->pos += map.size;
+
+	if (ds->pos > ds->end)
+	    ds->end = ds->pos;
+    }
+
+    gst_buffer_unmap (buffer, &map);
+
+    if (err != 0)
+    {
+	GST_ELEMENT_ERROR (ds, RESOURCE, WRITE, ("Error while writing to file \"%s\": %s", ds->location,
+			   strerror(err)), (NULL));
+	return GST_FLOW_ERROR;
+    }
+
+    return GST_FLOW_OK;
+}
+
+
+/* Byte segments are seeks from the muxer (header updates) */
+
+static gboolean ds_event(GstBaseSink *sink, GstEvent *event)
+{
+    DirectSink *ds;
+    GstSegment segment;
+    int err;
+
+    ds = DIRECT_SINK (sink);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT)
+    {
+	gst_event_copy_segment (event, &segment);
+
+	if (segment.format == GST_FORMAT_BYTES && (guint64) segment.start != ds->pos)
+	{
+	    if (ds->rewrite == FALSE)
+	    {
+		if ((err = ds_flush_tail(ds)) != 0)
+		{
+		    GST_ELEMENT_ERROR (ds, RESOURCE, WRITE, ("Error while writing to file \"%s\": %s",
+				       ds->location, strerror(err)), (NULL));
+		    gst_event_unref (event);
+		    return FALSE;
+		}
+
+		ds->rewrite = TRUE;
+	    }
+
+	    ds->pos = (guint64) segment.start;
+	}
+    }
+
+    /* Empty the ring before the end of stream is reported */
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS && ds->rewrite == FALSE && ds->thread != NULL)
+    {
+	if ((err = ds_flush_tail(ds)) != 0)
+	{
+	    GST_ELEMENT_ERROR (ds, RESOURCE, WRITE, ("Error while writing to file \"%s\": %s",
+			       ds->location, strerror(err)), (NULL));
+	    gst_event_unref (event);
+	    return FALSE;
+	}
+
+	ds->rewrite = TRUE;
+    }
+
+    return GST_BASE_SINK_CLASS (direct_sink_parent_class)->event (sink, event);
+}
+
+
+/* Muxers check the sink can seek before relying on header rewrites */
+
+static gboolean ds_query(GstBaseSink *sink, GstQuery *query)
+{
+    DirectSink *ds;
+    GstFormat fmt;
+
+    ds = DIRECT_SINK (sink);
+
+    switch (GST_QUERY_TYPE (query))
+    {
+	case GST_QUERY_SEEKING:
+	    gst_query_parse_seeking (query, &fmt, NULL, NULL, NULL);
+
+	    if (fmt == GST_FORMAT_BYTES)
+		gst_query_set_seeking (query, GST_FORMAT_BYTES, TRUE, 0, -1);
+	    else
+		gst_query_set_seeking (query, fmt, FALSE, 0, -1);
+
+	    return TRUE;
+
+	case GST_QUERY_POSITION:
+	    gst_query_parse_position (query, &fmt, NULL);
+
+	    if (fmt != GST_FORMAT_BYTES)
+	    	break;
+
+	    gst_query_set_position (query, GST_FORMAT_BYTES, (gint64) ds->pos);
+	    return TRUE;
+
+	case GST_QUERY_FORMATS:
+	    gst_query_set_formats (query, 2, GST_FORMAT_DEFAULT, GST_FORMAT_BYTES);
+	    return TRUE;
+
+	default:
+	    break;
+    }
+
+    return GST_BASE_SINK_CLASS (direct_sink_parent_class)->query (sink, query);
+}
+
+
+/* Copy into the current block, handing each full block to the writer */
+
+static int ds_append(DirectSink *ds, const guchar *data, gsize sz)
+{
+    guint n;
+    int err;
+
+    while(sz > 0)
+    {
+	n = ds->block_sz - ds->fill;
+
+	if (n > sz)
+	    n = (guint) sz;
+
+	memcpy(ds->ring + ((gsize) ds->head * ds->block_sz) + ds->fill, data, n);
+	ds->fill += n;
+	ds->pos += n;
+	ds->end = ds->pos;
+	data += n;
+	sz -= n;
+
+	if (ds->fill == ds->block_sz)
+	{
+	    if ((err = ds_submit(ds, ds->block_sz)) != 0)
+		return err;
+
+	    ds->base += ds->block_sz;
+	    ds->head = (ds->head + 1) % ds->n_blocks;
+	    ds->fill = 0;
+	}
+    }
+
+    return 0;
+}
+
+
+// Queue the current block for the writer. If every other block is still waiting to be
+// written (the disk is behind and the ring is full) wait for one to be freed.
+
+static int ds_submit(DirectSink *ds, guint len)
+{
+    int err;
+
+    g_mutex_lock (&(ds->lock));
+
+    if (ds->queued >= ds->n_blocks - 1)
+    {
+	ds->stalls++;
+
+	while(ds->queued >= ds->n_blocks - 1 && ds->wr_err == 0)
+	    g_cond_wait (&(ds->cond), &(ds->lock));
+    }
+
+    if ((err = ds->wr_err) == 0)
+    {
+	ds->blk_off[ds->head] = ds->base;
+	ds->blk_len[ds->head] = len;
+	ds->queued++;
+	g_cond_broadcast (&(ds->cond));
+    }
+
+    g_mutex_unlock (&(ds->lock));
+
+    return err;
+}
+
+
+/* Write the partly filled block (padded to the alignment) and wait for it */
+
+static int ds_flush_tail(DirectSink *ds)
+{
+    guint len;
+    int err;
+
+    if (ds->fill > 0)
+    {
+	len = (ds->fill + DS_ALIGN - 1) & ~(DS_ALIGN - 1);
+	memset(ds->ring + ((gsize) ds->head * ds->block_sz) + ds->fill, 0, len - ds->fill);
+
+	if ((err = ds_submit(ds, len)) != 0)
+	    return err;
+    }
+
+    return ds_wait_idle(ds);
+}
+
+
+/* Wait for the writer to empty the ring */
+
+static int ds_wait_idle(DirectSink *ds)
+{
+    int err;
+
+    g_mutex_lock (&(ds->lock));
+
+    while(ds->queued > 0 && ds->wr_err == 0)
+	g_cond_wait (&(ds->cond), &(ds->lock));
+
+    err = ds->wr_err;
+    g_mutex_unlock (&(ds->lock));
+
+    return err;
+}
+
+
+/* Write all of a buffer at an offset */
+
+static int ds_pwrite(int fd, const guchar *data, gsize sz, guint64 off)
+{
+    ssize_t n;
+
+    while(sz > 0)
+    {
+	n = pwrite(fd, data, sz, (off_t) off);
+
+	if (n < 0)
+	{
+	    if (errno == EINTR)
+	    	continue;
+
+	    return errno;
+	}
+
+	data += n;
+	sz -= n;
+	off += n;
+    }
+
+    return 0;
+}
+
+
+/* Writer thread - preallocate ahead, write each queued block in turn and keep the statistics */
+
+static gpointer ds_writer(gpointer arg)
+{
+    DirectSink *ds;
+    guchar *buf;
+    guint len;
+    guint64 off;
+    gint64 now;
+    int err;
+
+    ds = (DirectSink *) arg;
+
+    while(1)
+    {
+	g_mutex_lock (&(ds->lock));
+
+	while(ds->queued == 0 && ds->wr_stop == FALSE)
+	    g_cond_wait (&(ds->cond), &(ds->lock));
+
+	if (ds->queued == 0 || ds->wr_err != 0)
+	{
+	    g_mutex_unlock (&(ds->lock));
+	    break;
+	}
+
+	buf = ds->ring + ((gsize) ds->tail * ds->block_sz);
+	len = ds->blk_len[ds->tail];
+	off = ds->blk_off[ds->tail];
+	g_mutex_unlock (&(ds->lock));
+
+	/* Preallocate the next extent (not supported everywhere, carry on regardless) */
+	if (ds->extent > 0 && off + len > ds->alloc_end)
+	{
+	    if (fallocate(ds->fd, FALLOC_FL_KEEP_SIZE, (off_t) ds->alloc_end,
+			  (off_t) (off + len + ds->extent - ds->alloc_end)) == 0)
+		ds->alloc_end = off + len + ds->extent;
+	    else
+		ds->extent = 0;
+	}
+
+	err = ds_pwrite(ds->fd, buf, len, off);
+
+	/* Done */
+	g_mutex_lock (&(ds->lock));
+	ds->wr_err = err;
+	ds->tail = (ds->tail + 1) % ds->n_blocks;
+	ds->queued--;
+	ds->written += len;
+	now = g_get_monotonic_time ();
+
+	if (now - ds->rate_t >= G_USEC_PER_SEC)
+	{
+	    ds->rate = (gdouble) (ds->written - ds->rate_bytes) / (gdouble) (now - ds->rate_t);
+	    ds->rate_t = now;
+	    ds->rate_bytes = ds->written;
+	}
+
+	g_cond_broadcast (&(ds->cond));
+	g_mutex_unlock (&(ds->lock));
+    }
+
+    return NULL;
+}
+
+
+/* Release the ring of blocks */
+
+static void ds_free_ring(DirectSink *ds)
+{
+    ram_free(ds->ring, ds->ring_sz, ds->ring_locked);
+    free(ds->blk_off);
+    free(ds->blk_len);
+    ds->ring = NULL;
+    ds->blk_off = NULL;
+    ds->blk_len = NULL;
+
+    return;
+}
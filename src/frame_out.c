@@ -0,0 +1,474 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Frame output branches - camera frames for other programs while viewing and capturing
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code (shared memory)
+**	19-Oct-2026	Network preview branch
+**	19-Oct-2026	Network preview height set (even) as well as the width
+**
+*/
+
+/*
+    The output branches hang off their own tee straight after the camera caps filter, so they
+    see the raw camera frames (before any processing stages) in view and capture mode alike and
+    are kept when the capture elements come and go.
+
+  | Caps   |  | Out |  | (Processing) |  | Queue |
+  | Filter |->| tee |->| (stages)     |->| (blk) |-> view / capture as before
+                     \
+                      \  | Queue    |  | Shm  |
+                       |->| (leaky)  |->| sink |-> <app dir>/shm-video0
+                       |
+                       \  | Queue   |  | Video |  | Video |  | Video   |  | Caps   |  | Encoder |  | Pay / |  | Net  |
+                        ->| (leaky) |->| rate  |->| scale |->| convert |->| filter |->|         |->| mux   |->| sink |-> LAN
+
+    Each branch starts with a leaky queue of a couple of frames, so a slow or stuck reader loses
+    frames on its own branch and never holds up the view or capture.
+
+    Shared memory: shmsink places each frame in a shared memory area once; any number of local
+    readers (shmsrc) map the same area and read the frames in place. The caps (shmsrc has none
+    of its own) are written alongside the socket as <socket>.caps whenever they are negotiated, eg.
+
+	gst-launch-1.0 shmsrc socket-path=$HOME/.AstroCTC/shm-video0 is-live=true ! \
+		$(cat $HOME/.AstroCTC/shm-video0.caps) ! videoconvert ! autovideosink
+
+    The socket is closed and made again when the camera is restarted or the format changed,
+    so a reader has to reconnect.
+
+    Network preview (main camera only): a reduced size and rate copy of the camera for watching
+    from another computer. The size, rate and bit rate are its own (the caps filter), whatever
+    is being captured. H264 is encoded for low latency (x264enc tune=zerolatency, ultrafast,
+    a key frame every second); MJPEG needs less CPU but more bandwidth (the bit rate does not
+    apply). It is either sent as RTP over UDP to one host, or served over TCP (MPEG-TS or
+    multipart JPEG) to any number of clients, eg.
+
+	gst-launch-1.0 udpsrc port=5000 caps="application/x-rtp,media=video,encoding-name=H264,payload=96,clock-rate=90000" ! \
+		rtpjitterbuffer latency=50 ! rtph264depay ! avdec_h264 ! videoconvert ! autovideosink sync=false
+	gst-launch-1.0 udpsrc port=5000 caps="application/x-rtp,media=video,encoding-name=JPEG,payload=26,clock-rate=90000" ! \
+		rtpjitterbuffer latency=50 ! rtpjpegdepay ! jpegdec ! videoconvert ! autovideosink sync=false
+	gst-launch-1.0 tcpclientsrc host=scope port=5000 ! tsdemux ! h264parse ! avdec_h264 ! videoconvert ! autovideosink sync=false
+	gst-launch-1.0 tcpclientsrc host=scope port=5000 ! multipartdemux ! jpegdec ! videoconvert ! autovideosink sync=false
+*/
+
+
+/* Defines */
+
+#define OUT_QUEUE_BUFS 2
+#define SHM_FRAMES 8
+#define NET_ELEMENTS 8
+
+
+/* Includes */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <cam.h>
+#include <defs.h>
+#include <preferences.h>
+
+
+/* Prototypes */
+
+int out_elements(CamData *, MainUi *);
+int out_link(CamData *, GstElement **, MainUi *);
+static int out_shm_elements(CamData *, MainUi *);
+static int out_net_elements(CamData *, MainUi *);
+static int out_pref_int(char *, int);
+static int out_make(GstElement **, char *, char *, char *, MainUi *);
+static void out_queue_props(GstElement *);
+static void out_shm_caps(GObject *, GParamSpec *, gpointer);
+char * out_shm_path(CamData *);
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+extern int get_user_pref(char *, char **);
+extern void res_to_long(char *, long *, long *);
+extern void cam_session(CamData *, char*, char**);
+extern char * app_dir_path();
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-frame_out.c ";
+
+
+/* Create the output tee and any branches the user has turned on */
+
+int out_elements(CamData *cam_data, MainUi *m_ui)
+{
+    app_gst_objects *gst_objs;
+    char *p;
+
+    /* Convenience pointer */
+    gst_objs = &(cam_data->gst_objs);
+
+    /* Branches */
+    get_user_pref(SHM_OUT, &p);
+
+    if (p != NULL && atoi(p) == 1)
+	out_shm_elements(cam_data, m_ui);
+
+    get_user_pref(NET_OUT, &p);
+
+    if (p != NULL && atoi(p) == 1 && cam_data->inst == 0)
+	out_net_elements(cam_data, m_ui);
+
+    if (gst_objs->shm_sink == NULL && gst_objs->net_sink == NULL)
+    	return TRUE;
+
+    /* Tee */
+    if (out_make(&(gst_objs->out_tee), "tee", "out_tee", "Frame output", m_ui) == FALSE)
+    	return FALSE;
+
+    gst_bin_add (GST_BIN (cam_data->pipeline), gst_objs->out_tee);
+
+    return TRUE;
+}
+
+
+/* Link the output tee after 'head' and its branches - head becomes the tee */
+
+int out_link(CamData *cam_data, GstElement **head, MainUi *m_ui)
+{
+    app_gst_objects *gst_objs;
+
+    /* Convenience pointer */
+    gst_objs = &(cam_data->gst_objs);
+
+    if (gst_objs->out_tee == NULL)
+    	return TRUE;
+
+    if (gst_element_link (*head, gst_objs->out_tee) != TRUE)
+    {
+	sprintf(app_msg_extra, " - %s:out_tee", GST_ELEMENT_NAME (*head));
+	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
+	return FALSE;
+    }
+
+    *head = gst_objs->out_tee;
+
+    /* Shared memory */
+    if (gst_objs->shm_sink != NULL)
+    {
+	if (gst_element_link_many (gst_objs->out_tee, gst_objs->shm_queue, gst_objs->shm_sink, NULL) != TRUE)
+	{
+	    sprintf(app_msg_extra, " - out_tee:shm_queue:shm_sink");
+	    log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
+	    return FALSE;
+	}
+    }
+
+    /* Network preview */
+    if (gst_objs->net_sink != NULL)
+    {
+	if (gst_element_link_many (gst_objs->out_tee, gst_objs->net_queue, gst_objs->net_rate, gst_objs->net_scale,
+				   gst_objs->net_convert, gst_objs->net_filter, gst_objs->net_enc,
+				   gst_objs->net_pay, gst_objs->net_sink, NULL) != TRUE)
+	{
+	    sprintf(app_msg_extra, " - out_tee:net_queue:rate:scale:convert:filter:encoder:pay:net_sink");
+	    log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
+	    return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+
+/* Shared memory branch - the area holds several frames at the session resolution */
+
+static int out_shm_elements(CamData *cam_data, MainUi *m_ui)
+{
+    app_gst_objects *gst_objs;
+    GstPad *pad;
+    long width, height;
+    char *p, *path;
+
+    /* Convenience pointer */
+    gst_objs = &(cam_data->gst_objs);
+
+    if (out_make(&(gst_objs->shm_queue), "queue", "shm_queue", "Shared memory", m_ui) == FALSE)
+    	return FALSE;
+
+    if (out_make(&(gst_objs->shm_sink), "shmsink", "shm_sink", "Shared memory", m_ui) == FALSE)
+    {
+	gst_object_unref (gst_objs->shm_queue);
+	gst_objs->shm_queue = NULL;
+    	return FALSE;
+    }
+
+    cam_session(cam_data, RESOLUTION, &p);
+    res_to_long(p, &width, &height);
+    path = out_shm_path(cam_data);
+    unlink(path);						// Left from a previous run
+
+    out_queue_props(gst_objs->shm_queue);
+    g_object_set (gst_objs->shm_sink, "socket-path", path,
+    				      "shm-size", (guint) (width * height * 4 * SHM_FRAMES),
+    				      "wait-for-connection", FALSE,
+    				      "sync", FALSE,
+    				      "async", FALSE,
+    				      NULL);
+
+    /* Readers need the caps */
+    pad = gst_element_get_static_pad (gst_objs->shm_sink, "sink");
+    g_signal_connect (pad, "notify::caps", G_CALLBACK (out_shm_caps), NULL);
+    gst_object_unref (pad);
+
+    gst_bin_add_many (GST_BIN (cam_data->pipeline), gst_objs->shm_queue, gst_objs->shm_sink, NULL);
+    g_free (path);
+
+    return TRUE;
+}
+
+
+/* Network preview branch - its own size, rate and bit rate (no larger or faster than the camera) */
+
+static int out_net_elements(CamData *cam_data, MainUi *m_ui)
+{
+    app_gst_objects *gst_objs;
+    GstElement **el[NET_ELEMENTS];
+    char *fac[NET_ELEMENTS];
+    char *nm[NET_ELEMENTS] = { "net_queue", "net_rate", "net_scale", "net_convert", "net_filter",
+    			       "net_enc", "net_pay", "net_sink" };
+    GstCaps *caps;
+    long cam_w, cam_h;
+    int i, j, mjpeg, tcp, width, height, fps, kbps, port, cam_fps;
+    char *p, *host;
+
+    /* Convenience pointer */
+    gst_objs = &(cam_data->gst_objs);
+
+    /* Settings */
+    mjpeg = out_pref_int(NET_MJPEG, 0);
+    tcp = out_pref_int(NET_TCP, 0);
+    port = out_pref_int(NET_PORT, 5000);
+    width = out_pref_int(NET_WIDTH, 640);
+    fps = out_pref_int(NET_FPS, 10);
+    kbps = out_pref_int(NET_KBPS, 1000);
+    get_user_pref(NET_HOST, &host);
+
+    cam_session(cam_data, RESOLUTION, &p);
+    res_to_long(p, &cam_w, &cam_h);
+    cam_session(cam_data, FPS, &p);
+    cam_fps = atoi(p);
+
+    if (width <= 0 || width > cam_w)
+    	width = cam_w;
+
+    if (fps <= 0 || (cam_fps > 0 && fps > cam_fps))
+    	fps = cam_fps;
+
+    /* Keep the camera shape, both sizes even for I420 and the encoders */
+    height = (cam_w > 0) ? (int) ((long) width * cam_h / cam_w) : (int) cam_h;
+
+    width &= ~1;
+    height &= ~1;
+
+    /* Elements */
+    el[0] = &(gst_objs->net_queue);
+    el[1] = &(gst_objs->net_rate);
+    el[2] = &(gst_objs->net_scale);
+    el[3] = &(gst_objs->net_convert);
+    el[4] = &(gst_objs->net_filter);
+    el[5] = &(gst_objs->net_enc);
+    el[6] = &(gst_objs->net_pay);
+    el[7] = &(gst_objs->net_sink);
+
+    fac[0] = "queue";
+    fac[1] = "videorate";
+    fac[2] = "videoscale";
+    fac[3] = "videoconvert";
+    fac[4] = "capsfilter";
+    fac[5] = mjpeg ? "jpegenc" : "x264enc";
+
+    if (tcp)
+	fac[6] = mjpeg ? "multipartmux" : "mpegtsmux";
+    else
+	fac[6] = mjpeg ? "rtpjpegpay" : "rtph264pay";
+
+    fac[7] = tcp ? "tcpserversink" : "udpsink";
+
+    for(i = 0; i < NET_ELEMENTS; i++)
+    {
+	if (out_make(el[i], fac[i], nm[i], "Network preview", m_ui) == FALSE)
+	{
+	    for(j = 0; j < i; j++)
+	    {
+		gst_object_unref (*(el[j]));
+		*(el[j]) = NULL;
+	    }
+
+	    return FALSE;
+	}
+    }
+
+    /* Properties */
+    out_queue_props(gst_objs->net_queue);
+    g_object_set (gst_objs->net_rate, "drop-only", TRUE, NULL);
+
+    caps = gst_caps_new_simple ("video/x-raw",
+				"format", G_TYPE_STRING, "I420",
+				"width", G_TYPE_INT, width,
+				"height", G_TYPE_INT, height,
+				"pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+				"framerate", GST_TYPE_FRACTION, fps, 1,
+				NULL);
+    g_object_set (gst_objs->net_filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+
+    if (mjpeg)
+    {
+	g_object_set (gst_objs->net_enc, "quality", 60, NULL);
+    }
+    else
+    {
+	gst_util_set_object_arg (G_OBJECT (gst_objs->net_enc), "tune", "zerolatency");
+	gst_util_set_object_arg (G_OBJECT (gst_objs->net_enc), "speed-preset", "ultrafast");
+	g_object_set (gst_objs->net_enc, "bitrate", (guint) kbps, "key-int-max", (guint) fps, NULL);
+    }
+
+    if (tcp)
+    {
+	g_object_set (gst_objs->net_sink, "host", "0.0.0.0", "port", port, NULL);
+	gst_util_set_object_arg (G_OBJECT (gst_objs->net_sink), "recover-policy", "keyframe");
+	gst_util_set_object_arg (G_OBJECT (gst_objs->net_sink), "sync-method", "latest-keyframe");
+    }
+    else
+    {
+	if (! mjpeg)
+	    g_object_set (gst_objs->net_pay, "config-interval", 1, "pt", 96, NULL);
+
+	g_object_set (gst_objs->net_sink, "host", (host != NULL && *host != '\0') ? host : "127.0.0.1",
+					  "port", port, NULL);
+    }
+
+    g_object_set (gst_objs->net_sink, "sync", FALSE, "async", FALSE, NULL);
+
+    gst_bin_add_many (GST_BIN (cam_data->pipeline), gst_objs->net_queue, gst_objs->net_rate, gst_objs->net_scale,
+    						    gst_objs->net_convert, gst_objs->net_filter, gst_objs->net_enc,
+    						    gst_objs->net_pay, gst_objs->net_sink, NULL);
+
+    return TRUE;
+}
+
+
+/* Numeric preference (default if not set) */
+
+static int out_pref_int(char *key, int dflt)
+{
+    char *p;
+
+    get_user_pref(key, &p);
+
+    if (p == NULL || *p == '\0')
+    	return dflt;
+
+    return atoi(p);
+}
+
+
+/* Make an element for an optional branch - a missing plugin is reported and the branch left out */
+
+static int out_make(GstElement **element, char *factory_nm, char *nm, char *desc, MainUi *m_ui)
+{
+    *element = gst_element_factory_make ((const gchar *) factory_nm, (const gchar *) nm);
+
+    if (*element == NULL)
+    {
+	sprintf(app_msg_extra, " - %s", factory_nm);
+	log_msg("CAM0034", desc, "CAM0034", m_ui->window);
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* A branch never holds up the camera - old frames are dropped */
+
+static void out_queue_props(GstElement *queue)
+{
+    g_object_set (queue, "leaky", 2,
+    			 "max-size-buffers", OUT_QUEUE_BUFS,
+    			 "max-size-bytes", 0,
+    			 "max-size-time", (guint64) 0,
+    			 NULL);
+
+    return;
+}
+
+
+/* Negotiated caps for shared memory readers (streaming thread) */
+
+static void out_shm_caps(GObject *obj, GParamSpec *pspec, gpointer user_data)
+{
+    GstPad *pad;
+    GstCaps *caps;
+    FILE *fd;
+    gchar *path, *fn, *s;
+
+    pad = GST_PAD (obj);
+
+    if ((caps = gst_pad_get_current_caps (pad)) == NULL)
+    	return;
+
+    g_object_get (GST_PAD_PARENT (pad), "socket-path", &path, NULL);
+    fn = g_strdup_printf ("%s.caps", path);
+    s = gst_caps_to_string (caps);
+
+    if ((fd = fopen(fn, "w")) != NULL)
+    {
+	fprintf(fd, "%s\n", s);
+	fclose(fd);
+    }
+
+    g_free (s);
+    g_free (fn);
+    g_free (path);
+    gst_caps_unref (caps);
+
+    return;
+}
+
+
+/* Socket for a camera - application directory, named after the device (g_free) */
+
+char * out_shm_path(CamData *cam_data)
+{
+    char nm[300];
+    char dev[256];
+
+    strcpy(dev, cam_data->current_dev);
+    sprintf(nm, "shm-%s", basename(dev));
+
+    return g_build_filename (app_dir_path(), nm, NULL);
+}
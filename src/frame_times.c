@@ -0,0 +1,354 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Per frame timestamp file (for occultation and other timing work)
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Camera control snapshots
+**
+*/
+
+/*
+    Frame timestamps (CLOCK_MONOTONIC, as supplied by the driver) are added by the capture
+    thread to a fixed size ring with no locking or i/o. A writer thread drains the ring to a
+    CSV file alongside the capture. The offset to CLOCK_REALTIME is taken once when the file
+    is opened so that later clock adjustments (NTP) do not disturb the sequence.
+
+	# comment lines (clock, offset, source)
+	frame,monotonic_ns,utc,delta_ms
+
+    Camera control values (at the start and on each change) are written as comment lines
+    ahead of the first frame taken after them.
+
+	# Controls from frame N: Brightness=0, Gain=12, ...
+*/
+
+
+/* Defines */
+
+#define FTM_RING 8192
+#define FTM_WAKE 100						// ms
+#define FTM_BUF_SZ 65536
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <gtk/gtk.h>
+
+
+/* Structures and Typedefs required */
+
+typedef struct _ftm_rec
+{
+    guint64 frame;
+    guint64 mono_ns;
+} ftm_rec_t;
+
+typedef struct _ftm_ctl
+{
+    guint64 mono_ns;
+    char *txt;
+} ftm_ctl_t;
+
+typedef struct _frame_times
+{
+    FILE *fd;
+    char *buf;
+    ftm_rec_t ring[FTM_RING];
+    gint head;							// Next to fill (capture thread)
+    gint tail;							// Next to write (writer thread)
+    gint stop;
+    guint64 lost;
+    gint64 rt_offset;						// Realtime - monotonic (ns)
+    guint64 last_ns;
+    GQueue *ctl_q;						// Control snapshots (ftm_ctl_t)
+    pthread_mutex_t ctl_mutex;
+    pthread_t tid;
+} frame_times_t;
+
+
+/* Prototypes */
+
+frame_times_t * ftm_open(char *, char *);
+void ftm_add(frame_times_t *, guint64, guint64);
+void ftm_close(frame_times_t *);
+void * ftm_writer(void *);
+void ftm_drain(frame_times_t *);
+void ftm_utc(gint64, char *, int);
+void ftm_ctrls(frame_times_t *, guint64, char *);
+void ftm_ctl_drain(frame_times_t *, ftm_rec_t *);
+void ftm_free(frame_times_t *);
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-frame_times.c ";
+
+
+/* Create the timestamp file and start the writer */
+
+frame_times_t * ftm_open(char *path, char *source)
+{
+    frame_times_t *ftm;
+    struct timespec mono, real;
+    char s[60];
+
+    ftm = (frame_times_t *) malloc(sizeof(frame_times_t));
+    memset(ftm, 0, sizeof(frame_times_t));
+    ftm->ctl_q = g_queue_new ();
+    pthread_mutex_init(&(ftm->ctl_mutex), NULL);
+
+    if ((ftm->fd = fopen(path, "w")) == NULL)
+    {
+	log_msg("SYS9005", path, "SYS9005", NULL);
+	ftm_free(ftm);
+	return NULL;
+    }
+
+    /* Large stdio buffer - the writer thread does the actual i/o */
+    ftm->buf = (char *) malloc(FTM_BUF_SZ);
+    setvbuf(ftm->fd, ftm->buf, _IOFBF, FTM_BUF_SZ);
+
+    /* Clock mapping */
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    clock_gettime(CLOCK_REALTIME, &real);
+    ftm->rt_offset = ((gint64) real.tv_sec - (gint64) mono.tv_sec) * 1000000000 +
+		     ((gint64) real.tv_nsec - (gint64) mono.tv_nsec);
+
+    ftm_utc((gint64) mono.tv_sec * 1000000000 + mono.tv_nsec + ftm->rt_offset, s, sizeof(s));
+    fprintf(ftm->fd, "# Frame timestamps: %s\n", source);
+    fprintf(ftm->fd, "# Clock: CLOCK_MONOTONIC mapped to CLOCK_REALTIME at %s (offset %" G_GINT64_FORMAT " ns)\n",
+		     s, ftm->rt_offset);
+    fprintf(ftm->fd, "frame,monotonic_ns,utc,delta_ms\n");
+
+    if (pthread_create(&(ftm->tid), NULL, &ftm_writer, (void *) ftm) != 0)
+    {
+	log_msg("SYS9016", NULL, "SYS9016", NULL);
+	fclose(ftm->fd);
+	ftm_free(ftm);
+	return NULL;
+    }
+
+    return ftm;
+}
+
+
+/* Add a frame (capture thread) - never blocks, a full ring counts the frame as lost */
+
+void ftm_add(frame_times_t *ftm, guint64 frame, guint64 mono_ns)
+{
+    gint head, next;
+
+    if (ftm == NULL)
+    	return;
+
+    head = g_atomic_int_get (&(ftm->head));
+    next = (head + 1) % FTM_RING;
+
+    if (next == g_atomic_int_get (&(ftm->tail)))
+    {
+	ftm->lost++;
+	return;
+    }
+
+    ftm->ring[head].frame = frame;
+    ftm->ring[head].mono_ns = mono_ns;
+    g_atomic_int_set (&(ftm->head), next);
+
+    return;
+}
+
+
+/* Stop the writer, write anything outstanding and close */
+
+void ftm_close(frame_times_t *ftm)
+{
+    if (ftm == NULL)
+    	return;
+
+    g_atomic_int_set (&(ftm->stop), TRUE);
+    pthread_join(ftm->tid, NULL);
+
+    ftm_drain(ftm);
+    ftm_ctl_drain(ftm, NULL);
+
+    if (ftm->lost > 0)
+	fprintf(ftm->fd, "# %" G_GUINT64_FORMAT " frame timestamps not recorded (writer could not keep up)\n",
+			 ftm->lost);
+
+    fclose(ftm->fd);
+    ftm_free(ftm);
+
+    return;
+}
+
+
+/* Release the file details */
+
+void ftm_free(frame_times_t *ftm)
+{
+    ftm_ctl_t *ctl;
+
+    while ((ctl = (ftm_ctl_t *) g_queue_pop_head (ftm->ctl_q)) != NULL)
+    {
+	free(ctl->txt);
+	free(ctl);
+    }
+
+    g_queue_free (ftm->ctl_q);
+    pthread_mutex_destroy(&(ftm->ctl_mutex));
+    free(ftm->buf);
+    free(ftm);
+
+    return;
+}
+
+
+/* Add a camera control snapshot taken at a monotonic time (main thread) */
+
+void ftm_ctrls(frame_times_t *ftm, guint64 mono_ns, char *txt)
+{
+    ftm_ctl_t *ctl;
+
+    if (ftm == NULL || txt == NULL)
+    	return;
+
+    ctl = (ftm_ctl_t *) malloc(sizeof(ftm_ctl_t));
+    ctl->mono_ns = mono_ns;
+    ctl->txt = strdup(txt);
+
+    pthread_mutex_lock(&(ftm->ctl_mutex));
+    g_queue_push_tail (ftm->ctl_q, ctl);
+    pthread_mutex_unlock(&(ftm->ctl_mutex));
+
+    return;
+}
+
+
+/* Write the control snapshots taken before a frame (all remaining if no frame) */
+
+void ftm_ctl_drain(frame_times_t *ftm, ftm_rec_t *rec)
+{
+    ftm_ctl_t *ctl;
+
+    pthread_mutex_lock(&(ftm->ctl_mutex));
+
+    while ((ctl = (ftm_ctl_t *) g_queue_peek_head (ftm->ctl_q)) != NULL)
+    {
+	if (rec != NULL && ctl->mono_ns > rec->mono_ns)
+	    break;
+
+	g_queue_pop_head (ftm->ctl_q);
+
+	if (rec != NULL)
+	    fprintf(ftm->fd, "# Controls from frame %" G_GUINT64_FORMAT ": %s\n", rec->frame, ctl->txt);
+	else
+	    fprintf(ftm->fd, "# Controls after the last frame: %s\n", ctl->txt);
+
+	free(ctl->txt);
+	free(ctl);
+    }
+
+    pthread_mutex_unlock(&(ftm->ctl_mutex));
+
+    return;
+}
+
+
+/* Writer thread */
+
+void * ftm_writer(void *arg)
+{
+    frame_times_t *ftm;
+
+    ftm = (frame_times_t *) arg;
+
+    while (g_atomic_int_get (&(ftm->stop)) == FALSE)
+    {
+	ftm_drain(ftm);
+	g_usleep (FTM_WAKE * 1000);
+    }
+
+    pthread_exit(NULL);
+}
+
+
+/* Write out the ring contents */
+
+void ftm_drain(frame_times_t *ftm)
+{
+    gint tail, head;
+    ftm_rec_t *rec;
+    char s[60];
+    double delta;
+
+    tail = g_atomic_int_get (&(ftm->tail));
+    head = g_atomic_int_get (&(ftm->head));
+
+    while (tail != head)
+    {
+	rec = &(ftm->ring[tail]);
+	ftm_ctl_drain(ftm, rec);
+	ftm_utc((gint64) rec->mono_ns + ftm->rt_offset, s, sizeof(s));
+	delta = (ftm->last_ns == 0) ? 0.0 : (double) ((gint64) rec->mono_ns - (gint64) ftm->last_ns) / 1000000.0;
+
+	fprintf(ftm->fd, "%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%s,%.3f\n",
+			 rec->frame, rec->mono_ns, s, delta);
+
+	ftm->last_ns = rec->mono_ns;
+	tail = (tail + 1) % FTM_RING;
+	g_atomic_int_set (&(ftm->tail), tail);
+    }
+
+    fflush(ftm->fd);
+
+    return;
+}
+
+
+/* UTC date and time to the microsecond (ISO 8601) */
+
+void ftm_utc(gint64 ns, char *s, int sz)
+{
+    time_t secs;
+    struct tm tm;
+    char dt[30];
+
+    secs = (time_t) (ns / 1000000000);
+    gmtime_r(&secs, &tm);
+    strftime(dt, sizeof(dt), "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(s, sz, "%s.%06ldZ", dt, (long) ((ns % 1000000000) / 1000));
+
+    return;
+}
@@ -26,6 +26,28 @@
 **
 ** History
 **	24-Jan-2015	Initial code
+**	19-Oct-2026	Capture limits enforced by a probe on the capture queue
+**	19-Oct-2026	Raw capture without conversion when the camera format matches
+**	19-Oct-2026	Apply fixed codec encoder properties (lossless presets)
+**	19-Oct-2026	Warn if the encoder benchmark shows the codec cannot keep up
+**	19-Oct-2026	Reduced rate and size display branch while capturing
+**	19-Oct-2026	Per element statistics probes during capture
+**	19-Oct-2026	Driver frame drop detection from buffer offsets and timestamps
+**	19-Oct-2026	Per frame timestamps file
+**	19-Oct-2026	Snapshots taken from the running pipeline (view or capture)
+**	19-Oct-2026	Capture elements and caps kept between recordings (per codec cache)
+**	19-Oct-2026	Direct i/o capture file sink (optional) and its write rate
+**	19-Oct-2026	RAM staged capture (direct sink ring sized by a memory budget)
+**	19-Oct-2026	Next capture file without stopping the camera (sequences)
+**	19-Oct-2026	Per camera engine state (several cameras at once)
+**	19-Oct-2026	Optional frame processing stages before the tee and on the display
+**	19-Oct-2026	Frame output branches (shared memory, network preview) after the caps filter
+**	19-Oct-2026	Camera control snapshots in the frame timestamps file
+**	19-Oct-2026	Engine state kept until the EOS thread has finished
+**	19-Oct-2026	Capture branch file sink and linking from libastroctc (actc_engine.c)
+**	19-Oct-2026	Capture ended by an unplugged camera does not restart the view
+**	19-Oct-2026	One capture link function for the encoder and caps filter pipelines
+**	19-Oct-2026	No benchmark prompt when not interactive
 */
 
 /*
@@ -36,20 +58,43 @@
   | Camera  |  | Video |  | Caps   |  | Queue |  | Video   |  | Video |
   | v4l2src |->| Rate  |->| Filter |->| (blk) |->| convert |->| sink  |-> Screen
 
+ Processing stages (user preferences, see astro_filters.c) may be added in two places. The 'all'
+ stages go between the caps filter and the 'blk' queue, so they are recorded as well as shown. The
+ 'display' stages go just before the display video convert (in view and in the capture display
+ branch). Each is a bin made from a gst-launch style description, eg. 'astrostack frames=4'.
+
+ Frame output branches for other programs (see frame_out.c) have their own tee directly after the
+ caps filter, ahead of any processing stages.
+
 
  ** CAPTURE 1 (encoder based) ** (note 2 x 'Videoconvert' convenience)
 
-                                                            | Video |  | Video   |  | Video |
-                                                         /->| queue |->| convert |->| sink  |-> Screen
+                                                            | Video |  | View |  | View  |  | View   |  | Video   |  | Video |
+                                                         /->| queue |->| rate |->| scale |->| filter |->| convert |->| sink  |-> Screen
   | Camera  |  | Video |  | Caps   |  | Queue |  | Tee |/
   | v4l2src |->| Rate  |->| Filter |->| (blk) |->|     |\   | Capture |  | Video   |  | Encoder |  | Muxer |  | File |
                                                          \->| queue   |->| convert |->|         |->|       |->| sink |-> Video file
                                                                          
+ Note the view rate, scale and filter only throttle the display; the capture branch receives every
+ frame. The view scale and filter are only present if the display is to be scaled to the window.
+
+ The file sink is either the standard filesink or the application's own direct i/o sink (see
+ direct_sink.c) depending on the user preference. The application sink is also used when a capture
+ RAM buffer is set - the data is staged in memory and written out in the background, so bursts
+ faster than the disk do not stall the pipeline.
+
+ The capture branch, from the capture queue to the file sink, is the one libastroctc records
+ with (see astroctc.h). The sink choice and the linking are done by the library functions; the
+ elements themselves are created and kept here.
+
+ The capture elements are not destroyed when a capture ends. They are removed from the pipeline
+ (which resets them) and kept for the next recording - the fixed elements once only and the codec
+ elements per codec. Encoder properties are only applied again if the codec preferences change.
                                                                        
  ** CAPTURE 2 (requires a 2nd caps filter) ** 
 
-                                                            | Video |  | Video   |  | Video |
-                                                         /->| queue |->| convert |->| sink  |-> Screen
+                                                            | Video |  | View |  | View  |  | View   |  | Video   |  | Video |
+                                                         /->| queue |->| rate |->| scale |->| filter |->| convert |->| sink  |-> Screen
   | Camera  |  | Video |  | Caps   |  | Queue |  | Tee |/
   | v4l2src |->| Rate  |->| Filter |->| (blk) |->|     |\   | Capture |  | Video   |  | Caps   |  | Muxer |  | File |
                                                          \->| queue   |->| convert |->| filter |->|       |->| sink |-> Video file
@@ -62,15 +107,21 @@
 
                                                                          
  ** SNAPSHOT ** 
-  NOTE snapshots do not use gstreamer and instead use the various Video4linux utilities directly.
-  This is done for a number of (mostly good) reasons.
+  Snapshots are taken from the running pipeline (view or capture) by a probe on the caps filter
+  source pad. The probe only copies the requested frames; conversion and the image files are done
+  on a separate thread (see snapshot.c) so the display and any recording are not interrupted.
+  If there is no running pipeline the Video4linux utilities are used directly as before.
 
 */
 
 
 /* Defines */
 
+#define _GNU_SOURCE
+
 #define GST_VIEW_CAPT
+#define CAPT_CACHE_MAX 20
+#define EOS_JOIN_TRIES 100					// 10ms each
 
 
 /* Includes */
@@ -93,6 +144,39 @@
 #include <cam.h>
 #include <defs.h>
 #include <preferences.h>
+#include <astroctc.h>
+
+
+/* Types */
+
+typedef struct _capt_fixed
+{
+    GstElement *tee, *video_queue, *capt_queue, *c_convert, *file_sink, *direct_sink;
+    GstElement *view_rate, *view_scale, *view_filter;
+} capt_fixed_t;
+
+typedef struct _capt_cache
+{
+    char codec[10];					// Key
+    GstElement *encoder, *c_filter, *muxer;
+    char enc_sig[512];					// Encoder preferences as applied
+    GstCaps *c_caps;
+    char caps_key[60];					// Format, size and rate of the caps
+} capt_cache_t;
+
+typedef struct _capt_engine
+{
+    MainUi *m_ui;					// Window the pipeline reports to
+    guintptr win_handle;				// Video window (0 = main window)
+    pthread_mutex_t lock_mutex;
+    pthread_cond_t eos_cv;
+    pthread_t eos_tid;
+    int ret_eos;
+    char info_txt[150];
+    capt_fixed_t fixed;
+    capt_cache_t cache[CAPT_CACHE_MAX];
+    int cache_n;
+} capt_engine_t;
 
 
 /* Prototypes */
@@ -100,37 +184,66 @@
 int gst_view(CamData *, MainUi *);
 int gst_view_elements(CamData *, MainUi *);
 int link_view_pipeline(CamData *, MainUi *);
+int proc_element(GstElement **, char *, char *, char *, MainUi *);
+GstElement * view_head(app_gst_objects *);
 int start_view_pipeline(CamData *, MainUi *, int);
-int gst_capture(CamData *, MainUi *, int, int);
+int gst_capture(CamData *, MainUi *, int, int, int);
 int gst_capture_init(CamData *, MainUi *, int, int);
+static void capt_limits_init(video_capt_t *, MainUi *, int, int);
+static void capt_file_name(video_capt_t *, MainUi *);
 int gst_capture_elements(CamData *, MainUi *);
-int link_enc_pipeline(CamData *, MainUi *);
-int link_caps_pipeline(CamData *, MainUi *);
+int link_capt_pipeline(CamData *, MainUi *);
+static void capt_branch(CamData *, actc_branch_t *);
+int view_branch_elements(CamData *, MainUi *);
+int view_branch_size(CamData *, MainUi *, long *, long *);
+int link_view_branch(app_gst_objects *, MainUi *);
 int start_capt_pipeline(CamData *, MainUi *);
+static void capt_info(CamData *, MainUi *);
+int capt_seg_hot(CamData *);
+void capt_close_file(CamData *);
+int capt_next_file(CamData *, MainUi *, int, int);
 void view_prepare_capt(CamData *, MainUi *);
 void capt_prepare_view(CamData *, MainUi *);
 int view_clear_pipeline(CamData *, MainUi *);
+int view_unplugged(CamData *, MainUi *);
 int cam_set_state(CamData *, GstState, GtkWidget *);
 int create_element(GstElement **, char *, char *, CamData *, MainUi *);
 void check_unref(GstElement **, char *, int);
 void init_video_capt(video_capt_t *);
 void set_capture_btns(MainUi *, int, int);
 void swap_fourcc(char *, char *);
-void capture_limits(app_gst_objects *, MainUi *);
+void get_negotiated_fmt(CamData *, char *, size_t);
+char * capt_format(video_capt_t *);
+void capture_limits(CamData *, MainUi *);
+static GstPadProbeReturn capt_limit_probe(GstPad *, GstPadProbeInfo *, gpointer);
+static void capt_branch_eos(GstPad *, video_capt_t *);
+static GstPadProbeReturn capt_seg_probe(GstPad *, GstPadProbeInfo *, gpointer);
+static void post_capt_msg(GstPad *, video_capt_t *, char *);
+static GstPadProbeReturn frame_chk_probe(GstPad *, GstPadProbeInfo *, gpointer);
+void capt_progress(GstMessage *, CamData *, MainUi *);
+void capt_frame_times(CamData *);
+int cache_element(GstElement **, GstElement **, char *, char *, MainUi *);
+capt_cache_t * capt_cache_entry(capt_engine_t *, char *);
+int capt_codec_elements(CamData *, capt_cache_t *, MainUi *);
+void enc_prefs_sig(video_capt_t *, char *, int);
 void set_encoder_props(video_capt_t *, GstElement **, MainUi *); 
-static void load_prefs(video_capt_t *);
+void set_encoder_prop(GstElement *, char *, char *, char *, MainUi *); 
+static void load_prefs(video_capt_t *, CamData *);
 void set_reticule(MainUi *, CamData *);
 int prepare_reticule(MainUi *, CamData *);
 int remove_reticule(MainUi *, CamData *);
-int init_thread(MainUi *, void *(*start_routine)(void*));
-void * monitor_unltd(void *);
-void * monitor_duration(void *);
-void * monitor_frames(void *);
 void * send_EOS(void *);
 int set_eos(MainUi *);
+int cam_set_eos(CamData *, MainUi *);
 void setup_meta(CamData *);
 void capture_cleanup();
-void check_video_scroll(char *, char *, MainUi *);
+static capt_engine_t * capt_eng(CamData *);
+void capt_set_window(CamData *, guintptr);
+static void capt_engine_free(CamData *);
+static int capt_eos_join(capt_engine_t *);
+void cam_engine_close(CamData *, MainUi *);
+void btn_sens(GtkWidget *, int);
+void check_video_scroll(char *, char *, CamData *, MainUi *);
 GstBusSyncReply bus_sync_handler (GstBus*, GstMessage*, gpointer);
 gboolean bus_message_watch (GstBus *, GstMessage *, gpointer);
 void debug_state(GstElement *, char *,  CamData *);
@@ -146,7 +259,7 @@ static gboolean print_field(GQuark, const GValue *, gpointer);
 
 extern void log_msg(char*, char*, char*, GtkWidget*);
 extern void res_to_long(char *, long *, long *);
-extern void get_session(char*, char**);
+extern void cam_session(CamData *, char*, char**);
 extern void dttm_stamp(char *, size_t);
 extern void get_file_name(char *, int, char *, char *, char *, char, char, char);
 extern codec_t * get_codec(char *);
@@ -158,16 +271,32 @@ extern void OnDrawReticule (GstElement *, cairo_t *, guint64, guint64, gpointer)
 extern int check_dir(char *);
 extern int write_meta_file(char, CamData *, char *);
 extern int update_main_ui_clrfmt(char *, MainUi *);
+extern int bench_check(MainUi *, int);
+extern void stats_attach(CamData *);
+extern void stats_detach(CamData *);
+extern void frame_chk_init(frame_chk_t *, int);
+extern void frame_check(frame_chk_t *, gint64, guint64);
+extern void frame_chk_str(frame_chk_t *, char *, int);
+extern struct _frame_times * ftm_open(char *, char *);
+extern void ftm_add(struct _frame_times *, guint64, guint64);
+extern void ftm_close(struct _frame_times *);
+extern void ftm_ctrls(struct _frame_times *, guint64, char *);
+extern char * cam_ctrl_snapshot(camera_t *);
+extern void live_snap_attach(CamData *);
+extern void live_snap_free(CamData *);
+extern int seq_step_end(CamData *, MainUi *);
+extern void seq_next_step(CamData *, MainUi *);
+extern void seq_capture_end(CamData *, MainUi *);
+extern char * seq_info();
+extern int out_elements(CamData *, MainUi *);
+extern int out_link(CamData *, GstElement **, MainUi *);
 
 
 /* Globals */
 
 static const char *debug_hdr = "DEBUG-gst_view_capture.c ";
-static int capt_seq_no = 0;
-static int ret_mon, ret_eos;
-static pthread_t mon_tid, eos_tid;
-static pthread_mutex_t capt_lock_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t capt_eos_cv = PTHREAD_COND_INITIALIZER;
+static gint capt_seq_no = 0;
+static GList *capt_engines = NULL;
 
 extern guintptr video_window_handle;
 
@@ -189,9 +318,12 @@ int gst_view(CamData *cam_data, MainUi *m_ui)
 	return FALSE;
 
     /* May need to include reticule */
-    if (gtk_check_menu_item_get_active (GTK_CHECK_MENU_ITEM (m_ui->opt_ret)) == TRUE)
+    if (m_ui->opt_ret != NULL && gtk_check_menu_item_get_active (GTK_CHECK_MENU_ITEM (m_ui->opt_ret)) == TRUE)
 	prepare_reticule(m_ui, cam_data);
 
+    /* Snapshots from the running pipeline */
+    live_snap_attach(cam_data);
+
     /* Start viewing */
     if (start_view_pipeline(cam_data, m_ui, TRUE) == FALSE)
 	return FALSE;
@@ -249,6 +381,10 @@ int gst_view_elements(CamData *cam_data, MainUi *m_ui)
     if (! create_element(&(cam_data->gst_objs.q1), "queue", "block", cam_data, m_ui))
     	return FALSE;
 
+    /* Optional processing stages */
+    proc_element(&(cam_data->gst_objs.proc), PROC_STAGES, "proc", "Recorded", m_ui);
+    proc_element(&(cam_data->gst_objs.v_proc), VIEW_STAGES, "v_proc", "Display", m_ui);
+
     /* Create the pipeline */
     cam_data->pipeline = gst_pipeline_new ("cam_video");
 
@@ -265,9 +401,9 @@ int gst_view_elements(CamData *cam_data, MainUi *m_ui)
     swap_fourcc(p, fourcc);
     */
 
-    get_session(RESOLUTION, &p);
+    cam_session(cam_data, RESOLUTION, &p);
     res_to_long(p, &width, &height);
-    get_session(FPS, &p);
+    cam_session(cam_data, FPS, &p);
     fps = atoi(p);
 
     cam_data->gst_objs.v_caps = gst_caps_new_simple ("video/x-raw",
@@ -295,6 +431,16 @@ int gst_view_elements(CamData *cam_data, MainUi *m_ui)
     				cam_data->gst_objs.q1, 
     				NULL);
 
+    if (cam_data->gst_objs.proc != NULL)
+	gst_bin_add (GST_BIN (cam_data->pipeline), cam_data->gst_objs.proc);
+
+    if (cam_data->gst_objs.v_proc != NULL)
+	gst_bin_add (GST_BIN (cam_data->pipeline), cam_data->gst_objs.v_proc);
+
+    /* Frame output for other programs */
+    if (out_elements(cam_data, m_ui) == FALSE)
+    	return FALSE;
+
     return TRUE;
 }
 
@@ -304,6 +450,8 @@ int gst_view_elements(CamData *cam_data, MainUi *m_ui)
 int link_view_pipeline(CamData *cam_data, MainUi *m_ui)
 {
     app_gst_objects *gst_objs;
+    GstElement *head;
+    int ret;
 
     /* Convenience pointer */
     gst_objs = &(cam_data->gst_objs);
@@ -312,12 +460,32 @@ int link_view_pipeline(CamData *cam_data, MainUi *m_ui)
     if (gst_element_link_many (gst_objs->v4l2_src, 
 			       gst_objs->vid_rate, 
 			       gst_objs->v_filter,
-			       gst_objs->q1,
-			       gst_objs->v_convert,
-			       gst_objs->v_sink,
 			       NULL) != TRUE)
     {
-	sprintf(app_msg_extra, " - v4l2_src:vid_rate:v_filter (vcaps):convert:sink");
+	sprintf(app_msg_extra, " - v4l2_src:vid_rate:v_filter (vcaps)");
+	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
+	return FALSE;
+    }
+
+    /* Frame output tee (if any) */
+    head = gst_objs->v_filter;
+
+    if (out_link(cam_data, &head, m_ui) == FALSE)
+    	return FALSE;
+
+    /* Processing stages (if any) either side of the block queue */
+    if (gst_objs->proc != NULL)
+	ret = gst_element_link_many (head, gst_objs->proc, gst_objs->q1, NULL);
+    else
+	ret = gst_element_link (head, gst_objs->q1);
+
+    if (ret == TRUE && gst_objs->v_proc != NULL)
+	ret = gst_element_link (gst_objs->v_proc, gst_objs->v_convert);
+
+    if (ret != TRUE || gst_element_link (gst_objs->q1, view_head(gst_objs)) != TRUE
+    		    || gst_element_link (gst_objs->v_convert, gst_objs->v_sink) != TRUE)
+    {
+	sprintf(app_msg_extra, " - v_filter:proc:block:v_proc:convert:sink");
 	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
 	return FALSE;
     }
@@ -336,11 +504,14 @@ int start_view_pipeline(CamData *cam_data, MainUi *m_ui, int init)
     guint source_id;
     char s[100];
 
+    /* Messages for this camera are reported to this window */
+    capt_eng(cam_data)->m_ui = m_ui;
+
     if (init == TRUE)
     {
 	/* Set up sync handler for setting the xid once the pipeline is started */
 	bus = gst_pipeline_get_bus (GST_PIPELINE (cam_data->pipeline));
-	gst_bus_set_sync_handler (bus, (GstBusSyncHandler) bus_sync_handler, NULL, NULL);
+	gst_bus_set_sync_handler (bus, (GstBusSyncHandler) bus_sync_handler, cam_data, NULL);
     }
 
     if (cam_set_state(cam_data, GST_STATE_PLAYING, m_ui->window) == FALSE)
@@ -354,7 +525,7 @@ int start_view_pipeline(CamData *cam_data, MainUi *m_ui, int init)
     if (init == TRUE)
     {
 	/* Add a bus watch for messages */
-	source_id = gst_bus_add_watch (bus, (GstBusFunc) bus_message_watch, m_ui);
+	source_id = gst_bus_add_watch (bus, (GstBusFunc) bus_message_watch, cam_data);
 	gst_object_unref (bus);
     }
 
@@ -366,10 +537,14 @@ int start_view_pipeline(CamData *cam_data, MainUi *m_ui, int init)
 }
 
 
-/* Gst camera view and capture video */
+/* Gst camera view and capture video (not interactive - no prompts, eg. control socket) */
 
-int gst_capture(CamData *cam_data, MainUi *m_ui, int duration, int no_frames)
+int gst_capture(CamData *cam_data, MainUi *m_ui, int duration, int no_frames, int interactive)
 {
+    /* Check the codec can keep up (if benchmarked - main camera) */
+    if (cam_data->inst == 0 && bench_check(m_ui, interactive) == FALSE)
+    	return FALSE;
+
     /* Initial */
     if (gst_capture_init(cam_data, m_ui, duration, no_frames) == FALSE)
     	return FALSE;
@@ -381,19 +556,18 @@ int gst_capture(CamData *cam_data, MainUi *m_ui, int duration, int no_frames)
     	return FALSE;
 
     /* Capture limits */
-    capture_limits(&(cam_data->gst_objs), m_ui);
+    capture_limits(cam_data, m_ui);
 
     /* Capture pipeline element links */
-    if (cam_data->pipeline_type == ENC_PIPELINE)
-    {
-	if (link_enc_pipeline(cam_data, m_ui) == FALSE)
-	    return FALSE;
-    }
-    else
-    {
-	if (link_caps_pipeline(cam_data, m_ui) == FALSE)
-	    return FALSE;
-    }
+    if (link_capt_pipeline(cam_data, m_ui) == FALSE)
+	return FALSE;
+
+    /* Per element statistics (main camera) */
+    if (cam_data->inst == 0)
+	stats_attach(cam_data);
+
+    /* Frame timestamps file */
+    capt_frame_times(cam_data);
 
     /* Start view and capture */
     if (start_capt_pipeline(cam_data, m_ui) == FALSE)
@@ -408,28 +582,20 @@ int gst_capture(CamData *cam_data, MainUi *m_ui, int duration, int no_frames)
 int gst_capture_init(CamData *cam_data, MainUi *m_ui, int duration, int no_frames)
 {
     video_capt_t *capt;
-    char seq_no_s[10];
 
     /* Set up convenience pointer */
     init_video_capt(&(cam_data->u.v_capt));
     capt = &(cam_data->u.v_capt);
 
-    /* Preferences */
-    load_prefs(capt);
+    /* Preferences and the format actually coming from the camera */
+    load_prefs(capt, cam_data);
+    get_negotiated_fmt(cam_data, capt->cam_fcc, sizeof(capt->cam_fcc));
 
     /* Capture limits */
-    m_ui->duration = duration;	
-    m_ui->no_of_frames = no_frames;
+    capt_limits_init(capt, m_ui, duration, no_frames);
 
     /* Initial */
     m_ui->thread_init = FALSE;
-    sprintf(seq_no_s, "%03d", capt_seq_no);
-
-    /* Object title for file name */
-    capt->obj_title = gtk_entry_get_text( GTK_ENTRY (m_ui->obj_title));
-
-    /* Timestamp */
-    dttm_stamp(capt->tm_stmp, sizeof(capt->tm_stmp));
 
     /* Capture location */
     if (check_dir(capt->locn) == FALSE)
@@ -445,77 +611,137 @@ int gst_capture_init(CamData *cam_data, MainUi *m_ui, int duration, int no_frame
     	return FALSE;
     }
 
-    get_file_name(capt->fn, (int) sizeof(capt->fn), 
-    		  seq_no_s, 
-		  (char *) capt->obj_title,
-		  capt->tm_stmp, capt->id, capt->tt, capt->ts);
-    sprintf(capt->out_name, "%s/%s.%s", capt->locn, capt->fn, capt->codec_data->extn);
+    capt_file_name(capt, m_ui);
 
     if (*(capt->codec_data->encoder) == '\0')		
 	cam_data->pipeline_type = CAPS_PIPELINE;		// Requires a 2nd caps filter
     else
 	cam_data->pipeline_type = ENC_PIPELINE;
 
-    /* Capture sequence is incremented each time a capture is performed */
-    capt_seq_no++;
+    /* Raw capture of the camera format needs no conversion */
+    if (cam_data->pipeline_type == CAPS_PIPELINE)
+	capt->passthru = (strcmp(capt_format(capt), capt->cam_fcc) == 0 && cam_data->gst_objs.proc == NULL);
+    else
+	capt->passthru = FALSE;
 
     return TRUE;
 }
 
 
+/* Capture limit (seconds, frames or unlimited) */
+
+static void capt_limits_init(video_capt_t *capt, MainUi *m_ui, int duration, int no_frames)
+{
+    m_ui->duration = duration;	
+    m_ui->no_of_frames = no_frames;
+
+    if (duration > 0)
+    {
+	capt->capt_opt = 1;				// Capture number of seconds
+	capt->capt_reqd = duration;
+    }
+    else if (no_frames > 0)
+    {
+	capt->capt_opt = 2;				// Capture number of frames
+	capt->capt_reqd = no_frames;
+    }
+    else
+    {
+	capt->capt_opt = 3;				// Capture unlimited seconds
+	capt->capt_reqd = -1;
+    }
+
+    return;
+}
+
+
+/* Output file name from the title, timestamp and capture sequence */
+
+static void capt_file_name(video_capt_t *capt, MainUi *m_ui)
+{
+    char seq_no_s[10];
+
+    /* Capture sequence is incremented each time a capture is performed (any camera) */
+    sprintf(seq_no_s, "%03d", g_atomic_int_add (&capt_seq_no, 1));
+
+    /* Object title for file name */
+    capt->obj_title = gtk_entry_get_text( GTK_ENTRY (m_ui->obj_title));
+
+    /* Timestamp */
+    dttm_stamp(capt->tm_stmp, sizeof(capt->tm_stmp));
+
+    get_file_name(capt->fn, (int) sizeof(capt->fn), 
+    		  seq_no_s, 
+		  (char *) capt->obj_title,
+		  capt->tm_stmp, capt->id, capt->tt, capt->ts);
+    sprintf(capt->out_name, "%s/%s.%s", capt->locn, capt->fn, capt->codec_data->extn);
+
+    return;
+}
+
+
 /* Create capture elements and add to pipeline */
 
 int gst_capture_elements(CamData *cam_data, MainUi *m_ui)
 {
-    long width, height;
-    int fps;
-    char *p;
     video_capt_t *capt;
+    capt_cache_t *cache;
+    capt_engine_t *eng;
+    const char *sink_nm;
+    guint64 ram_budget;
+    char *p;
+    int dio, ram_mb;
 
-    /* Convenience pointer */
+    /* Convenience pointers */
     capt = &(cam_data->u.v_capt);
+    eng = capt_eng(cam_data);
 
-    /* Fixed elements */
-    if (! create_element(&(cam_data->gst_objs.tee), "tee", "split", NULL, m_ui))
+    /* Fixed elements (kept between recordings) */
+    if (! cache_element(&(cam_data->gst_objs.tee), &(eng->fixed.tee), "tee", "split", m_ui))
     	return FALSE;
 
-    if (! create_element(&(cam_data->gst_objs.video_queue), "queue", "v_queue", NULL, m_ui))
+    if (! cache_element(&(cam_data->gst_objs.video_queue), &(eng->fixed.video_queue), "queue", "v_queue", m_ui))
     	return FALSE;
 
-    if (! create_element(&(cam_data->gst_objs.capt_queue), "queue", "c_queue", NULL, m_ui))
+    if (! cache_element(&(cam_data->gst_objs.capt_queue), &(eng->fixed.capt_queue), "queue", "c_queue", m_ui))
     	return FALSE;
 
-    if (! create_element(&(cam_data->gst_objs.muxer), capt->codec_data->muxer, "muxer", NULL, m_ui))
+    if (! view_branch_elements(cam_data, m_ui))
     	return FALSE;
 
-    if (! create_element(&(cam_data->gst_objs.file_sink), "filesink", "file_sink", NULL, m_ui))
-    	return FALSE;
-    
-    if (! create_element(&(cam_data->gst_objs.c_convert), "videoconvert", "c_convert", NULL, m_ui))
-    	return FALSE;
+    get_user_pref(DIRECT_IO, &p);
+    dio = (p != NULL && *p == '1');
+
+    get_user_pref(RAM_BUDGET, &p);
+    ram_mb = (p != NULL) ? atoi(p) : 0;
+
+    ram_budget = (guint64) MAX (ram_mb, 0) * 1024 * 1024;
+    sink_nm = actc_sink_factory(dio, ram_budget);
+
+    if (! cache_element(&(cam_data->gst_objs.file_sink),
+    			(strcmp(sink_nm, "filesink") == 0) ? &(eng->fixed.file_sink) : &(eng->fixed.direct_sink),
+    			(char *) sink_nm, "file_sink", m_ui))
+	return FALSE;
+
+    actc_sink_props(cam_data->gst_objs.file_sink, dio, ram_budget);
     
-    /* Different elements will created or set depending on the output format */
-    if (cam_data->pipeline_type == CAPS_PIPELINE)		// Requires a 2nd caps filter
+    if (capt->passthru == FALSE)
     {
-	cam_data->gst_objs.c_filter = gst_element_factory_make ("capsfilter", "c_filter");
-
-    	if (!cam_data->gst_objs.c_filter)
-    	{
-	    log_msg("CAM0020", NULL, "CAM0020", m_ui->window);
+	if (! cache_element(&(cam_data->gst_objs.c_convert), &(eng->fixed.c_convert), "videoconvert", "c_convert", m_ui))
 	    return FALSE;
-    	}
     }
-    else						// Normal encoding
+    
+    /* Different elements will created or set depending on the output format (kept per codec) */
+    if ((cache = capt_cache_entry(capt_eng(cam_data), capt->codec)) == NULL)
     {
-	cam_data->gst_objs.encoder = gst_element_factory_make (capt->codec_data->encoder, "encoder");
-
-    	if (!cam_data->gst_objs.encoder)
-    	{
-	    log_msg("CAM0020", NULL, "CAM0020", m_ui->window);
-	    return FALSE;
-    	}
+	sprintf(app_msg_extra, " - too many codecs cached");
+	log_msg("CAM0020", NULL, "CAM0020", m_ui->window);
+	return FALSE;
     }
 
+    if (capt_codec_elements(cam_data, cache, m_ui) == FALSE)
+    	return FALSE;
+
     /* Just a check, shouldn't be a problem but ... */
     if (!cam_data->pipeline ||
     	!cam_data->gst_objs.v4l2_src || !cam_data->gst_objs.v_filter || !cam_data->gst_objs.v_convert || 
@@ -525,262 +751,470 @@ int gst_capture_elements(CamData *cam_data, MainUi *m_ui)
         return FALSE;
     }
 
-    /* The queue needs to be allowed to leak and the video sink should not sync */
-    g_object_set (cam_data->gst_objs.video_queue, "leaky", TRUE, NULL);
+    /* The queue needs to be allowed to leak (oldest first, before any display work) */
+    /* and the video sink should not sync */
+    g_object_set (cam_data->gst_objs.video_queue, "leaky", 2,
+    						  "max-size-buffers", 2,
+    						  "max-size-bytes", 0,
+    						  "max-size-time", (guint64) 0, NULL);
     g_object_set (cam_data->gst_objs.v_sink, "sync", FALSE, NULL);
 
-    /* Encoder properties */
-    set_encoder_props(capt, &(cam_data->gst_objs.encoder), m_ui);
-
     /* Capture file */
     g_object_set (cam_data->gst_objs.file_sink, "location", capt->out_name, NULL);
 
     /* Build the pipeline - add all the elements (note some elements are already present from viewing) */
     gst_bin_add_many (GST_BIN (cam_data->pipeline),
 		      cam_data->gst_objs.tee, cam_data->gst_objs.video_queue, cam_data->gst_objs.capt_queue,
-    		      cam_data->gst_objs.muxer, cam_data->gst_objs.file_sink, cam_data->gst_objs.c_convert, NULL);
+    		      cam_data->gst_objs.muxer, cam_data->gst_objs.file_sink, NULL);
+
+    if (capt->passthru == FALSE)
+	gst_bin_add (GST_BIN (cam_data->pipeline), cam_data->gst_objs.c_convert);
+
+    gst_bin_add (GST_BIN (cam_data->pipeline), cam_data->gst_objs.view_rate);
+
+    if (cam_data->gst_objs.view_scale != NULL)
+	gst_bin_add_many (GST_BIN (cam_data->pipeline), cam_data->gst_objs.view_scale,
+							cam_data->gst_objs.view_filter, NULL);
 
     if (cam_data->pipeline_type == ENC_PIPELINE)
-    {
 	gst_bin_add_many (GST_BIN (cam_data->pipeline), cam_data->gst_objs.encoder, NULL);
-    }
     else
-    {
 	gst_bin_add_many (GST_BIN (cam_data->pipeline), cam_data->gst_objs.c_filter, NULL);
 
-	/* Specify what kind of video is wanted from the camera */
-	get_session(RESOLUTION, &p);
-	res_to_long(p, &width, &height);
-	get_session(FPS, &p);
-	fps = atoi(p);
-
-	/* Video (capture) caps filter */
-	cam_data->gst_objs.c_caps = gst_caps_new_simple ("video/x-raw",
-							   "format", G_TYPE_STRING, capt->codec_data->fourcc,
-							   "framerate", GST_TYPE_FRACTION, fps, 1,
-							   "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
-							   "width", G_TYPE_INT, width,
-							   "height", G_TYPE_INT, height,
-							   NULL);
-    }
-
     return TRUE;
 }
 
 
-/* Set the required properties for the encoder */
+// Return a capture element, creating it the first time only. The cache holds its own reference
+// so the element survives being removed from the pipeline at the end of a capture.
 
-void set_encoder_props(video_capt_t *capt, GstElement **encoder, MainUi *m_ui) 
+int cache_element(GstElement **element, GstElement **cached, char *factory_nm, char *nm, MainUi *m_ui)
 {
-    int i, idx, pref_total, len, pr_type, i_val;
-    double f_val;
-    char key[PREF_KEY_SZ];
-    char s[51];
-    char *p, *nm, *nm_val;
-
-    /* Total user default setting for the encoder */
-    sprintf(key, "%sMAX", capt->codec_data->encoder);
-    idx = get_user_pref(key, &p);
-
-    if (p == NULL)
-    	return;
-
-    pref_total = atoi(p);
-    
-    /* Set the encoder object property for each setting */
-    for(i = 0; i < pref_total; i++)
+    if (*cached == NULL)
     {
-    	/* Check preference setting */
-	sprintf(key, "%s%02d", capt->codec_data->encoder, i);
-    	get_user_pref(key, &p);
-
-	if (p == NULL)
-	{
-	    sprintf(app_msg_extra, "The User Preferences file may be corrupt.");
-	    sprintf(s, "Encoder Preference (%s)", key);
-	    log_msg("CAM0006", s, "CAM0006", m_ui->window);
-	    continue;
-	}
+	*cached = gst_element_factory_make ((const gchar *) factory_nm, (const gchar *) nm);
 
-    	if ((nm_val = strchr(p , '=')) == NULL)
+	if (*cached == NULL)
 	{
-	    sprintf(app_msg_extra, "The User Preferences file may be corrupt.");
-	    sprintf(s, "Encoder Property Value (%s)", key);
-	    log_msg("CAM0006", s, "CAM0006", m_ui->window);
-	    continue;
+	    log_msg("CAM0020", NULL, "CAM0020", m_ui->window);
+	    return FALSE;
 	}
 
-	/* Get the property name and value */
-    	nm_val++;
-    	len = nm_val - p;
-    	nm = (char *) malloc(len);
-    	strncpy(nm, p, len - 1);
-    	nm[len - 1] = '\0';
-
-    	/* Convert value to correct type and set */
-    	pr_type = codec_property_type(capt->codec_data->encoder, nm);
+	gst_object_ref_sink (*cached);
+    }
 
-    	switch(pr_type)
-    	{
-	    case 0:						// Integer
-		i_val = atoi(nm_val);
-		g_object_set (G_OBJECT (*encoder), nm, i_val, NULL);
-		break;
+    *element = *cached;
 
-	    case 1:						// Float
-		f_val = atof(nm_val);
-		g_object_set (G_OBJECT (*encoder), nm, f_val, NULL);
-		break;
+    return TRUE;
+}
 
-	    case 2:						// Boolean
-		if (*nm_val == 'T')
-		    i_val = TRUE;
-		else
-		    i_val = FALSE;
 
-		g_object_set (G_OBJECT (*encoder), nm, i_val, NULL);
-		break;
+/* Find (or add) the cache entry for a codec */
 
-	    case 3:						// Object
-		if (*nm_val != '\0')
-		    gst_util_set_object_arg (G_OBJECT (*encoder), nm, nm_val);
+capt_cache_t * capt_cache_entry(capt_engine_t *eng, char *codec)
+{
+    int i;
 
-		break;
+    for(i = 0; i < eng->cache_n; i++)
+    {
+    	if (strcmp(eng->cache[i].codec, codec) == 0)
+	    return &(eng->cache[i]);
+    }
 
-	    default:						// Unknown 
-		log_msg("CAM0006", "Property data type", "CAM0006", m_ui->window);
-    	};
+    if (eng->cache_n >= CAPT_CACHE_MAX)
+    	return NULL;
 
-    	free(nm);
-    };
+    memset(&(eng->cache[i]), 0, sizeof(capt_cache_t));
+    snprintf(eng->cache[i].codec, sizeof(eng->cache[i].codec), "%s", codec);
+    eng->cache_n++;
 
-    return;
+    return &(eng->cache[i]);
 }
 
 
-/* Link the capture elements for a pileine that uses an encoder */
+// Codec specific elements: muxer and either an encoder or a 2nd caps filter (with caps).
+// The encoder properties are applied when it is created and again only if the preferences
+// have changed since (a new encoder is made so any property no longer set reverts).
 
-int link_enc_pipeline(CamData *cam_data, MainUi *m_ui)
+int capt_codec_elements(CamData *cam_data, capt_cache_t *cache, MainUi *m_ui)
 {
-    GstPadTemplate *tee_src_pad_template;
-    GstPad *queue_capt_pad, *queue_video_pad;
-    app_gst_objects *gst_objs;
+    long width, height;
+    int fps;
+    char *p;
+    char key[60];
+    char sig[512];
+    video_capt_t *capt;
 
     /* Convenience pointer */
-    gst_objs = &(cam_data->gst_objs);
+    capt = &(cam_data->u.v_capt);
 
-    /* Video thread (note that some view elements are already linked) */
-    if (gst_element_link_many (gst_objs->q1, gst_objs->tee, NULL) != TRUE)
-    {
-	sprintf(app_msg_extra, " - q1:tee");
-	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
-        return FALSE;
-    }
+    if (! cache_element(&(cam_data->gst_objs.muxer), &(cache->muxer), capt->codec_data->muxer, "muxer", m_ui))
+    	return FALSE;
 
-    if (gst_element_link_many (gst_objs->video_queue, gst_objs->v_convert, NULL) != TRUE)
+    if (cam_data->pipeline_type == ENC_PIPELINE)		// Normal encoding
     {
-	sprintf(app_msg_extra, " - video queue:video convert");
-	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
-	return FALSE;
-    }
+	enc_prefs_sig(capt, sig, sizeof(sig));
 
-    /* Capture thread - (use an Encoder instead of second caps filter) */
-    if (gst_element_link_many (gst_objs->capt_queue, gst_objs->c_convert, gst_objs->encoder, 
-			       gst_objs->muxer, gst_objs->file_sink, NULL) != TRUE)
-    {
-	sprintf(app_msg_extra, " - capture queue:video convert:encoder:muxer:filesink");
-	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
-	return FALSE;
-    }
+	if (cache->encoder != NULL && strcmp(sig, cache->enc_sig) != 0)
+	{
+	    gst_object_unref (cache->encoder);
+	    cache->encoder = NULL;
+	}
 
-    /* Build the pipeline - linking the elements with Request pads */
-    tee_src_pad_template = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (gst_objs->tee), "src_%u");
+	if (cache->encoder == NULL)
+	{
+	    if (! cache_element(&(cam_data->gst_objs.encoder), &(cache->encoder), 
+	    			capt->codec_data->encoder, "encoder", m_ui))
+		return FALSE;
 
-    gst_objs->tee_video_pad = gst_element_request_pad (gst_objs->tee, tee_src_pad_template, NULL, NULL);
-    queue_video_pad = gst_element_get_static_pad (gst_objs->video_queue, "sink");
+	    set_encoder_props(capt, &(cache->encoder), m_ui);
+	    strcpy(cache->enc_sig, sig);
+	}
 
-    gst_objs->tee_capt_pad = gst_element_request_pad (gst_objs->tee, tee_src_pad_template, NULL, NULL);
-    queue_capt_pad = gst_element_get_static_pad (gst_objs->capt_queue, "sink");
+	cam_data->gst_objs.encoder = cache->encoder;
 
-    if (gst_pad_link (gst_objs->tee_video_pad, queue_video_pad) != GST_PAD_LINK_OK)
-    {
-	sprintf(app_msg_extra, " - Cannot link Tee to Video pad");
-	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
-	gst_object_unref (cam_data->pipeline);
-        return FALSE;
+	return TRUE;
     }
 
-    if (gst_pad_link (gst_objs->tee_capt_pad, queue_capt_pad) != GST_PAD_LINK_OK)
+    /* Requires a 2nd caps filter */
+    if (! cache_element(&(cam_data->gst_objs.c_filter), &(cache->c_filter), "capsfilter", "c_filter", m_ui))
+    	return FALSE;
+
+    /* Specify what kind of video is wanted from the camera */
+    cam_session(cam_data, RESOLUTION, &p);
+    res_to_long(p, &width, &height);
+    cam_session(cam_data, FPS, &p);
+    fps = atoi(p);
+
+    /* Video (capture) caps filter - only rebuilt if the format, size or rate change */
+    snprintf(key, sizeof(key), "%s %ldx%ld %d", capt_format(capt), width, height, fps);
+
+    if (cache->c_caps == NULL || strcmp(key, cache->caps_key) != 0)
     {
-	sprintf(app_msg_extra, " - Cannot link Tee to Capture pad");
-	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
-	gst_object_unref (cam_data->pipeline);
-        return FALSE;
+	if (cache->c_caps != NULL)
+	    gst_caps_unref (cache->c_caps);
+
+	cache->c_caps = gst_caps_new_simple ("video/x-raw",
+					     "format", G_TYPE_STRING, capt_format(capt),
+					     "framerate", GST_TYPE_FRACTION, fps, 1,
+					     "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+					     "width", G_TYPE_INT, width,
+					     "height", G_TYPE_INT, height,
+					     NULL);
+	strcpy(cache->caps_key, key);
+	g_object_set (cache->c_filter, "caps", cache->c_caps, NULL);
     }
 
-    /* Free resources */
-    gst_object_unref (queue_video_pad);
-    gst_object_unref (queue_capt_pad);
+    cam_data->gst_objs.c_caps = cache->c_caps;
 
     return TRUE;
 }
 
 
-// Link the capture elements for a pileine that requires a second caps filter */
-// (Certain formats require a second caps filter for capture)
+/* Encoder preferences (and fixed settings) as a single string for comparison */
 
-int link_caps_pipeline(CamData *cam_data, MainUi *m_ui)
+void enc_prefs_sig(video_capt_t *capt, char *sig, int sz)
 {
-    GstPadTemplate *tee_src_pad_template;
-    GstPad *queue_capt_pad, *queue_video_pad;
-    app_gst_objects *gst_objs;
-    long width, height;
-    int fps;
+    int i, pref_total, len;
+    char key[PREF_KEY_SZ];
     char *p;
 
-    /* Convenience pointer */
-    gst_objs = &(cam_data->gst_objs);
+    sprintf(key, "%sMAX", capt->codec_data->encoder);
+    get_user_pref(key, &p);
+    pref_total = (p == NULL) ? 0 : atoi(p);
 
-    /* Specify what kind of video is wanted from the camera */
-    get_session(RESOLUTION, &p);
-    res_to_long(p, &width, &height);
-    get_session(FPS, &p);
-    fps = atoi(p);
+    len = snprintf(sig, sz, "%s", capt->codec_data->enc_fixed);
 
-    /* Video thread (note that some view elements are already linked) */
-    if (gst_element_link_many (gst_objs->q1, gst_objs->tee, NULL) != TRUE)
+    for(i = 0; i < pref_total && len < sz; i++)
     {
-	sprintf(app_msg_extra, " - q1:tee");
-	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
-        return FALSE;
+	sprintf(key, "%s%02d", capt->codec_data->encoder, i);
+    	get_user_pref(key, &p);
+	len += snprintf(sig + len, sz - len, ";%s", (p == NULL) ? "" : p);
     }
 
-    if (gst_element_link_many (gst_objs->video_queue, gst_objs->v_convert, NULL) != TRUE)
+    return;
+}
+
+
+/* The capture branch elements in use (see actc_branch_link) */
+
+static void capt_branch(CamData *cam_data, actc_branch_t *br)
+{
+    app_gst_objects *gst_objs;
+
+    gst_objs = &(cam_data->gst_objs);
+
+    br->queue = gst_objs->capt_queue;
+    br->convert = (cam_data->u.v_capt.passthru == TRUE) ? NULL : gst_objs->c_convert;
+    br->encoder = (cam_data->pipeline_type == ENC_PIPELINE) ? gst_objs->encoder : gst_objs->c_filter;
+    br->muxer = gst_objs->muxer;
+    br->file_sink = gst_objs->file_sink;
+
+    return;
+}
+
+
+/* Create the display branch elements used while capturing (rate limit and optional scale) */
+
+int view_branch_elements(CamData *cam_data, MainUi *m_ui)
+{
+    int fps;
+    long width, height;
+    char *p;
+    GstCaps *caps;
+    capt_engine_t *eng;
+
+    eng = capt_eng(cam_data);
+
+    /* Rate - only drops frames, never duplicates */
+    if (! cache_element(&(cam_data->gst_objs.view_rate), &(eng->fixed.view_rate), "videorate", "view_rate", m_ui))
+    	return FALSE;
+
+    get_user_pref(VIEW_CAPT_FPS, &p);
+    fps = (p == NULL) ? 0 : atoi(p);
+
+    g_object_set (cam_data->gst_objs.view_rate, "drop-only", TRUE,
+    						 "max-rate", (fps > 0) ? fps : G_MAXINT, NULL);
+
+    /* Scale - only required if the window is smaller than the capture resolution */
+    get_user_pref(VIEW_CAPT_SCALE, &p);
+
+    if ((p != NULL && atoi(p) == 0) || view_branch_size(cam_data, m_ui, &width, &height) == FALSE)
+    	return TRUE;
+
+    if (! cache_element(&(cam_data->gst_objs.view_scale), &(eng->fixed.view_scale), "videoscale", "view_scale", m_ui))
+    	return FALSE;
+
+    if (! cache_element(&(cam_data->gst_objs.view_filter), &(eng->fixed.view_filter), "capsfilter", "view_filter", m_ui))
+    	return FALSE;
+
+    caps = gst_caps_new_simple ("video/x-raw",
+				"width", G_TYPE_INT, (int) width,
+				"height", G_TYPE_INT, (int) height,
+				"pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+				NULL);
+    g_object_set (cam_data->gst_objs.view_filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+
+    return TRUE;
+}
+
+
+/* Fit the capture resolution to the visible video window, keeping the aspect ratio */
+
+int view_branch_size(CamData *cam_data, MainUi *m_ui, long *width, long *height)
+{
+    long res_w, res_h, win_w, win_h;
+    char *p;
+
+    cam_session(cam_data, RESOLUTION, &p);
+    res_to_long(p, &res_w, &res_h);
+
+    win_w = (long) gtk_widget_get_allocated_width (m_ui->scrollwin);
+    win_h = (long) gtk_widget_get_allocated_height (m_ui->scrollwin);
+
+    /* Downscale only */
+    if (res_w <= 0 || res_h <= 0 || win_w <= 1 || win_h <= 1)
+    	return FALSE;
+
+    if (res_w <= win_w && res_h <= win_h)
+    	return FALSE;
+
+    if (res_w * win_h > res_h * win_w)
     {
-	sprintf(app_msg_extra, " - video queue:video convert");
-	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
-        return FALSE;
+	*width = win_w;
+	*height = (res_h * win_w) / res_w;
     }
+    else
+    {
+	*height = win_h;
+	*width = (res_w * win_h) / res_h;
+    }
+
+    /* Most raw formats need even dimensions */
+    *width &= ~1L;
+    *height &= ~1L;
+
+    if (*width < 2 || *height < 2)
+    	return FALSE;
+
+    return TRUE;
+}
+
+
+/* Link the display branch while capturing: video queue to video convert */
 
-    /* Capture queue to capture convert */
-    if (gst_element_link_many (gst_objs->capt_queue, gst_objs->c_convert, NULL) != TRUE)
+int link_view_branch(app_gst_objects *gst_objs, MainUi *m_ui)
+{
+    int ret;
+
+    if (gst_objs->view_scale != NULL)
+	ret = gst_element_link_many (gst_objs->video_queue, gst_objs->view_rate, gst_objs->view_scale,
+				     gst_objs->view_filter, view_head(gst_objs), NULL);
+    else
+	ret = gst_element_link_many (gst_objs->video_queue, gst_objs->view_rate, view_head(gst_objs), NULL);
+
+    if (ret != TRUE)
     {
-	sprintf(app_msg_extra, " - capture queue:video convert");
+	sprintf(app_msg_extra, " - video queue:view rate:view scale:video convert");
 	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
 	return FALSE;
     }
 
-    /* Build the pipeline - linking the elements with Always pads */
-    if (gst_element_link_filtered (gst_objs->c_convert, gst_objs->c_filter, gst_objs->c_caps) != TRUE)
+    return TRUE;
+}
+
+
+/* Set the required properties for the encoder */
+
+void set_encoder_props(video_capt_t *capt, GstElement **encoder, MainUi *m_ui) 
+{
+    int i, idx, pref_total, len;
+    char key[PREF_KEY_SZ];
+    char s[51];
+    char *p, *nm, *nm_val;
+
+    /* Total user default setting for the encoder */
+    sprintf(key, "%sMAX", capt->codec_data->encoder);
+    idx = get_user_pref(key, &p);
+
+    if (p == NULL)
+    	pref_total = 0;
+    else
+	pref_total = atoi(p);
+    
+    /* Set the encoder object property for each setting */
+    for(i = 0; i < pref_total; i++)
+    {
+    	/* Check preference setting */
+	sprintf(key, "%s%02d", capt->codec_data->encoder, i);
+    	get_user_pref(key, &p);
+
+	if (p == NULL)
+	{
+	    sprintf(app_msg_extra, "The User Preferences file may be corrupt.");
+	    sprintf(s, "Encoder Preference (%s)", key);
+	    log_msg("CAM0006", s, "CAM0006", m_ui->window);
+	    continue;
+	}
+
+    	if ((nm_val = strchr(p , '=')) == NULL)
+	{
+	    sprintf(app_msg_extra, "The User Preferences file may be corrupt.");
+	    sprintf(s, "Encoder Property Value (%s)", key);
+	    log_msg("CAM0006", s, "CAM0006", m_ui->window);
+	    continue;
+	}
+
+	/* Get the property name and value */
+    	nm_val++;
+    	len = nm_val - p;
+    	nm = (char *) malloc(len);
+    	strncpy(nm, p, len - 1);
+    	nm[len - 1] = '\0';
+
+    	/* Convert value to correct type and set */
+	set_encoder_prop(*encoder, capt->codec_data->encoder, nm, nm_val, m_ui);
+    	free(nm);
+    };
+
+    /* Some codecs (eg. lossless presets) require fixed settings regardless of preferences */
+    if (*(capt->codec_data->enc_fixed) == '\0')
+    	return;
+
+    strcpy(s, capt->codec_data->enc_fixed);
+    nm = strtok(s, ",");
+
+    while(nm != NULL)
+    {
+    	if ((nm_val = strchr(nm, '=')) != NULL)
+    	{
+	    *nm_val = '\0';
+	    nm_val++;
+	    gst_util_set_object_arg (G_OBJECT (*encoder), nm, nm_val);
+    	}
+
+	nm = strtok(NULL, ",");
+    }
+
+    return;
+}
+
+
+/* Convert an encoder property value to the correct type and set */
+
+void set_encoder_prop(GstElement *encoder, char *enc_nm, char *nm, char *nm_val, MainUi *m_ui) 
+{
+    int pr_type, i_val;
+    double f_val;
+
+    pr_type = codec_property_type(enc_nm, nm);
+
+    switch(pr_type)
     {
-	sprintf(app_msg_extra, " - video convert:filter (c_caps)");
+	case 0:						// Integer
+	    i_val = atoi(nm_val);
+	    g_object_set (G_OBJECT (encoder), nm, i_val, NULL);
+	    break;
+
+	case 1:						// Float
+	    f_val = atof(nm_val);
+	    g_object_set (G_OBJECT (encoder), nm, f_val, NULL);
+	    break;
+
+	case 2:						// Boolean
+	    if (*nm_val == 'T')
+		i_val = TRUE;
+	    else
+		i_val = FALSE;
+
+	    g_object_set (G_OBJECT (encoder), nm, i_val, NULL);
+	    break;
+
+	case 3:						// Object
+	    if (*nm_val != '\0')
+		gst_util_set_object_arg (G_OBJECT (encoder), nm, nm_val);
+
+	    break;
+
+	default:					// Unknown 
+	    log_msg("CAM0006", "Property data type", "CAM0006", m_ui->window);
+    };
+
+    return;
+}
+
+
+// Link the capture elements. The capture branch has an encoder or, for certain formats, a
+// second caps filter (see capt_branch); the rest is the same for both.
+
+int link_capt_pipeline(CamData *cam_data, MainUi *m_ui)
+{
+    GstPadTemplate *tee_src_pad_template;
+    GstPad *queue_capt_pad, *queue_video_pad;
+    app_gst_objects *gst_objs;
+    actc_branch_t br;
+
+    /* Convenience pointer */
+    gst_objs = &(cam_data->gst_objs);
+
+    /* Video thread (note that some view elements are already linked) */
+    if (gst_element_link_many (gst_objs->q1, gst_objs->tee, NULL) != TRUE)
+    {
+	sprintf(app_msg_extra, " - q1:tee");
 	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
-	return FALSE;
+        return FALSE;
     }
 
-    if (gst_element_link_many (gst_objs->c_filter, gst_objs->muxer, gst_objs->file_sink, NULL) != TRUE)
+    if (link_view_branch(gst_objs, m_ui) == FALSE)
+	return FALSE;
+
+    /* Capture thread (the camera format may be recorded as is - no video convert) */
+    capt_branch(cam_data, &br);
+
+    if (actc_branch_link(&br) != TRUE)
     {
-	sprintf(app_msg_extra, " - capture filter:muxer:filesink");
+	sprintf(app_msg_extra, " - capture queue:video convert:encoder (or c_caps):muxer:filesink");
 	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
 	return FALSE;
     }
@@ -813,7 +1247,6 @@ int link_caps_pipeline(CamData *cam_data, MainUi *m_ui)
     /* Free resources */
     gst_object_unref (queue_video_pad);
     gst_object_unref (queue_capt_pad);
-    gst_caps_unref(gst_objs->c_caps);
 
     return TRUE;
 }
@@ -838,10 +1271,27 @@ int start_capt_pipeline(CamData *cam_data, MainUi *m_ui)
     cam_data->mode = CAM_MODE_CAPT;
     set_capture_btns(m_ui, FALSE, TRUE);
 
+    /* Stills may still be taken (from the running pipeline) */
+    btn_sens (m_ui->snap_ui, TRUE); 
+    btn_sens (GTK_WIDGET (m_ui->snap_tb), TRUE);
+
     /* Add a bus watch for messages */
-    //source_id = gst_bus_add_watch (bus, (GstBusFunc) bus_message_watch, m_ui);	xxxx IS THIS NEEDED ?
+    //source_id = gst_bus_add_watch (bus, (GstBusFunc) bus_message_watch, cam_data);	xxxx IS THIS NEEDED ?
 
     /* Inforamtion status line */
+    capt_info(cam_data, m_ui);
+    gst_object_unref (bus);
+
+    return TRUE;
+}
+
+
+/* Capture information status line (progress is added to this) */
+
+static void capt_info(CamData *cam_data, MainUi *m_ui)
+{
+    char *s;
+
     s = (char *) malloc(strlen(cam_data->current_cam) + strlen(cam_data->current_dev) + 50);
     sprintf(s, "Camera %.30s (%.30s) is capturing", cam_data->current_cam, cam_data->current_dev);
 
@@ -853,9 +1303,106 @@ int start_capt_pipeline(CamData *cam_data, MainUi *m_ui)
 	sprintf(s, "%s: unlimited", s);
 
     gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
-    gst_object_unref (bus);
+    snprintf(capt_eng(cam_data)->info_txt, sizeof(capt_eng(cam_data)->info_txt), "%s%s", s,
+	     (cam_data->inst == 0) ? seq_info() : "");
     free(s);
 
+    return;
+}
+
+
+// Keep the camera running between capture files (sequences). The limit probe ends the capture
+// branch only and a probe on the file sink reports when the file is complete.
+
+int capt_seg_hot(CamData *cam_data)
+{
+    GstPad *pad;
+
+    if (cam_data->mode != CAM_MODE_CAPT || cam_data->gst_objs.file_sink == NULL)
+    	return FALSE;
+
+    pad = gst_element_get_static_pad (cam_data->gst_objs.file_sink, "sink");
+    cam_data->gst_objs.seg_probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, 
+							 capt_seg_probe, cam_data, NULL); 
+    gst_object_unref (pad);
+    cam_data->u.v_capt.seg_hot = TRUE;
+
+    return TRUE;
+}
+
+
+/* Sequence - meta data and frame times for a capture file that is complete */
+
+void capt_close_file(CamData *cam_data)
+{
+    setup_meta(cam_data);
+    cam_data->cam->ftm = NULL;
+    ftm_close(cam_data->u.v_capt.ftm);
+    cam_data->u.v_capt.ftm = NULL;
+
+    return;
+}
+
+
+// Start the next capture file while the camera keeps streaming (see capt_close_file).
+// The capture branch has already received EOS (the queue itself has not), so the elements
+// after the capture queue are reset, given the new file and relinked. The queue resends
+// its caps and segment on the new link. Buffers are dropped by the limit probe until done.
+
+int capt_next_file(CamData *cam_data, MainUi *m_ui, int duration, int no_frames)
+{
+    app_gst_objects *gst_objs;
+    video_capt_t *capt;
+    GstElement *branch[ACTC_BRANCH_MAX];
+    actc_branch_t br;
+    int i, n;
+
+    /* Convenience pointers */
+    gst_objs = &(cam_data->gst_objs);
+    capt = &(cam_data->u.v_capt);
+
+    if (cam_data->mode != CAM_MODE_CAPT || capt->seg_hot == FALSE)
+    	return FALSE;
+
+    /* Branch elements (upstream first) */
+    capt_branch(cam_data, &br);
+    n = actc_branch_list(&br, branch);
+
+    gst_element_unlink (gst_objs->capt_queue, branch[0]);
+
+    for(i = 0; i < n; i++)
+	gst_element_set_state (branch[i], GST_STATE_NULL);
+
+    /* New limits, counts and file */
+    capt_limits_init(capt, m_ui, duration, no_frames);
+    capt->capt_actl = capt->capt_frames = capt->capt_dropped = 0;
+    capt->rt_start = capt->rt_elapsed = capt->rt_posted = capt->buf_count = 0;
+    capt_file_name(capt, m_ui);
+    capt_frame_times(cam_data);
+    g_object_set (gst_objs->file_sink, "location", capt->out_name, NULL);
+
+    /* Restart (downstream first) and relink */
+    for(i = n - 1; i >= 0; i--)
+    {
+	if (gst_element_sync_state_with_parent (branch[i]) == FALSE)
+	{
+	    log_msg("CAM0028", GST_ELEMENT_NAME (branch[i]), "CAM0028", m_ui->window);
+	    return FALSE;
+	}
+    }
+
+    if (gst_element_link (gst_objs->capt_queue, branch[0]) != TRUE)
+    {
+	sprintf(app_msg_extra, " - capture queue:%s", GST_ELEMENT_NAME (branch[0]));
+	log_msg("CAM0021", NULL, "CAM0021", m_ui->window);
+	return FALSE;
+    }
+
+    capt_info(cam_data, m_ui);
+
+    /* Let buffers through again */
+    g_atomic_int_set (&(capt->limit_hit), 0);
+
     return TRUE;
 }
 
@@ -961,79 +1508,446 @@ void swap_fourcc(char *fcc_in, char *fcc_out)
 }
 
 
+// Get the colour format negotiated between the camera and the view pipeline
+// (the session format is retained if the pipeline has not negotiated yet)
+
+void get_negotiated_fmt(CamData *cam_data, char *fcc, size_t sz)
+{
+    GstPad *pad;
+    GstCaps *caps;
+    GstStructure *st;
+    const gchar *fmt;
+
+    if (! GST_IS_ELEMENT(cam_data->gst_objs.v_filter))
+    	return;
+
+    pad = gst_element_get_static_pad (cam_data->gst_objs.v_filter, "src");
+    caps = gst_pad_get_current_caps (pad);
+    gst_object_unref (pad);
+
+    if (caps == NULL)
+    	return;
+
+    st = gst_caps_get_structure (caps, 0);
+
+    if ((fmt = gst_structure_get_string (st, CLR_FORMAT_FLD)) != NULL)
+	snprintf(fcc, sz, "%s", fmt);
+
+    gst_caps_unref (caps);
+
+    return;
+}
+
+
+/* Return the raw format required for capture ('Native' uses the camera format) */
+
+char * capt_format(video_capt_t *capt)
+{
+    if (strcmp(capt->codec_data->fourcc, NATIVE_FMT) == 0)
+    	return capt->cam_fcc;
+
+    return capt->codec_data->fourcc;
+}
+
+
 /* Load user preferences for video capture and filenames */
 
-static void load_prefs(video_capt_t *capt)
+static void load_prefs(video_capt_t *capt, CamData *cam_data)
+{
+    char *p;
+
+    cam_session(cam_data, CLRFMT, &p);
+    swap_fourcc(p, capt->cam_fcc);
+
+    get_user_pref(CAPTURE_FORMAT, &p);
+    capt->codec = p;
+
+    get_user_pref(CAPTURE_LOCATION, &p);
+    capt->locn = p;
+
+    get_user_pref(FN_ID, &p);
+    capt->id = *p;
+
+    get_user_pref(FN_TITLE, &p);
+    capt->tt = *p;
+
+    get_user_pref(FN_TIMESTAMP, &p);
+    capt->ts = *p;
+
+    return;
+}
+
+
+/* Enable or disable capture buttons as appropriate */
+
+void set_capture_btns (MainUi *m_ui, int start_sens, int stop_sens)
+{
+    /* Start items on menu and toolbar */
+    btn_sens (m_ui->cap_ui, start_sens);
+    btn_sens (m_ui->cap_seq, start_sens);
+    btn_sens (GTK_WIDGET (m_ui->cap_start_tb), start_sens);
+
+    /* Snapshot items on menu and toolbar */
+    btn_sens (m_ui->snap_ui, start_sens); 
+    btn_sens (GTK_WIDGET (m_ui->snap_tb), start_sens);
+
+    /* Stop items on menu and toolbar */
+    btn_sens (m_ui->cap_stop, stop_sens);
+    btn_sens (GTK_WIDGET (m_ui->cap_stop_tb), stop_sens);
+
+    /* Pause is a special case */
+    btn_sens (m_ui->cap_pause, stop_sens);
+    btn_sens (GTK_WIDGET (m_ui->cap_pause_tb), stop_sens);
+
+    /* Controls (always same as start) */
+    //gtk_widget_set_sensitive (m_ui->cbox_clrfmt, start_sens);		// Only use negotiated now 
+    btn_sens (m_ui->cbox_res, start_sens); 
+    btn_sens (m_ui->cbox_fps, start_sens); 
+    btn_sens (m_ui->oth_ctrls_btn, start_sens); 
+    btn_sens (m_ui->def_val_btn, start_sens); 
+
+    /* Menu items, Toolbar items (always same as start) */
+    btn_sens (m_ui->cam_hdr, start_sens); 
+    btn_sens (m_ui->cbox_profile, start_sens); 
+
+    return;
+}
+
+
+/* Set a widget sensitive or not (a camera tile window only has some of the buttons) */
+
+void btn_sens(GtkWidget *w, int sens)
+{
+    if (w != NULL)
+	gtk_widget_set_sensitive (w, sens);
+
+    return;
+}
+
+
+// Set any capture limits and the driver frame checks
+// The limits are enforced in the streaming thread by a probe on the capture queue so that
+// only the capture branch is counted and the file ends on the exact frame
+
+void capture_limits(CamData *cam_data, MainUi *m_ui)
 {
+    GstPad *pad;
     char *p;
 
-    get_session(CLRFMT, &p);
-    swap_fourcc(p, capt->cam_fcc);
+    if (m_ui->no_of_frames > 0)
+	g_object_set (cam_data->gst_objs.vid_rate, "drop-only", TRUE, NULL);
+
+    pad = gst_element_get_static_pad (cam_data->gst_objs.capt_queue, "src");
+    cam_data->gst_objs.limit_probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, 
+							   capt_limit_probe, cam_data, NULL); 
+    gst_object_unref (pad);
+
+    /* Driver frame checks straight off the camera (before any rate adjustment) */
+    cam_session(cam_data, FPS, &p);
+    frame_chk_init(&(cam_data->u.v_capt.fchk), atoi(p));
+
+    pad = gst_element_get_static_pad (cam_data->gst_objs.v4l2_src, "src");
+    cam_data->gst_objs.fchk_probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, 
+							  frame_chk_probe, cam_data, NULL); 
+    gst_object_unref (pad);
+
+    return;
+}
+
+
+// Probe - v4l2src sets the buffer offset to the V4L2 sequence number and the PTS from the
+// driver timestamp, so gaps and timing problems before the pipeline can be counted.
+
+static GstPadProbeReturn frame_chk_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    CamData *cam_data;
+    GstBuffer *buf;
+    gint64 seq;
+
+    cam_data = (CamData *) user_data;
+    buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    if (! GST_BUFFER_PTS_IS_VALID (buf))
+    	return GST_PAD_PROBE_OK;
+
+    seq = (GST_BUFFER_OFFSET_IS_VALID (buf)) ? (gint64) GST_BUFFER_OFFSET (buf) : -1;
+    frame_check(&(cam_data->u.v_capt.fchk), seq, GST_BUFFER_PTS (buf));
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+// Probe - count buffers and running time on the capture branch.
+// The last buffer within the limit is passed and a 'capt-limit' message is posted (the bus watch
+// then stops the pipeline). Anything after that is dropped and EOS is pushed down the branch.
+
+static GstPadProbeReturn capt_limit_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    CamData *cam_data;
+    video_capt_t *capt;
+    GstBuffer *buf;
+    GstEvent *seg_ev;
+    const GstSegment *segment;
+    GstClockTime rt, dur, limit;
+    int last;
+
+    /* Get data */
+    cam_data = (CamData *) user_data;
+    capt = &(cam_data->u.v_capt);
+
+    /* Past the limit - make sure the branch is ended and drop */
+    if (capt->limit_hit != 0)
+    {
+    	if (capt->limit_hit == 1)
+    	{
+	    capt->limit_hit = 2;
+	    capt_branch_eos(pad, capt);
+    	}
+
+	return GST_PAD_PROBE_DROP;
+    }
+
+    /* Running time of the buffer (paused periods are excluded by the pipeline) */
+    buf = GST_PAD_PROBE_INFO_BUFFER (info);
+    rt = GST_BUFFER_PTS (buf);
+    dur = GST_BUFFER_DURATION (buf);
+
+    if ((seg_ev = gst_pad_get_sticky_event (pad, GST_EVENT_SEGMENT, 0)) != NULL)
+    {
+	gst_event_parse_segment (seg_ev, &segment);
+	rt = gst_segment_to_running_time (segment, GST_FORMAT_TIME, rt);
+	gst_event_unref (seg_ev);
+    }
+
+    if (! GST_CLOCK_TIME_IS_VALID (rt))
+	rt = capt->rt_start + capt->rt_elapsed;
+
+    if (! GST_CLOCK_TIME_IS_VALID (dur))
+    	dur = 0;
+
+    if (capt->buf_count == 0)
+    {
+	capt->rt_start = rt;
+	capt->rt_posted = 0;
+    }
+
+    /* Check the limits */
+    last = FALSE;
+
+    if (capt->capt_opt == 1)
+    {
+	limit = (GstClockTime) capt->capt_reqd * GST_SECOND;
+
+	if (rt - capt->rt_start >= limit)
+	{
+	    capt->limit_hit = 2;
+	    capt_branch_eos(pad, capt);
+	    post_capt_msg(pad, capt, "capt-limit");
+	    return GST_PAD_PROBE_DROP;
+	}
+
+	if (rt - capt->rt_start + dur >= limit)
+	    last = TRUE;
+    }
+    else if (capt->capt_opt == 2)
+    {
+	if (capt->buf_count + 1 >= (guint64) capt->capt_reqd)
+	    last = TRUE;
+    }
+
+    /* Count the buffer */
+    capt->buf_count++;
+    capt->rt_elapsed = rt - capt->rt_start + dur;
+
+    /* Frame time (pipeline clock is monotonic, as are the driver timestamps) */
+    if (capt->ftm != NULL)
+	ftm_add(capt->ftm, capt->buf_count, rt + gst_element_get_base_time (cam_data->pipeline));
+
+    if (last == TRUE)
+    {
+	capt->limit_hit = 1;
+	post_capt_msg(pad, capt, "capt-limit");
+    }
+    else if (capt->rt_elapsed - capt->rt_posted >= GST_SECOND / 4)
+    {
+	capt->rt_posted = capt->rt_elapsed;
+	post_capt_msg(pad, capt, "capt-progress");
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+// End the capture branch. Between sequence files the EOS is given to the next element only,
+// so the queue pad does not go EOS and can feed the next file.
+
+static void capt_branch_eos(GstPad *pad, video_capt_t *capt)
+{
+    GstPad *peer;
+
+    if (capt->seg_hot == FALSE)
+    {
+	gst_pad_push_event (pad, gst_event_new_eos ());
+	return;
+    }
+
+    if ((peer = gst_pad_get_peer (pad)) == NULL)
+    	return;
+
+    gst_pad_send_event (peer, gst_event_new_eos ());
+    gst_object_unref (peer);
+
+    return;
+}
+
+
+/* Probe - the capture file is complete when EOS reaches the file sink (sequences only) */
+
+static GstPadProbeReturn capt_seg_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    CamData *cam_data;
+
+    cam_data = (CamData *) user_data;
+
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_EOS)
+	post_capt_msg(pad, &(cam_data->u.v_capt), "capt-seg-done");
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+/* Open the frame timestamps file if required */
+
+void capt_frame_times(CamData *cam_data)
+{
+    video_capt_t *capt;
+    char *p, *fn;
+
+    capt = &(cam_data->u.v_capt);
+    capt->ftm = NULL;
+    get_user_pref(FRAME_TIMES, &p);
+
+    if (p == NULL || *p != '1')
+    	return;
+
+    fn = (char *) malloc(strlen(capt->locn) + strlen(capt->fn) + 20);
+    sprintf(fn, "%s/%s.times.csv", capt->locn, capt->fn);
+    capt->ftm = ftm_open(fn, capt->out_name);
+    free(fn);
+
+    /* Camera controls at the start, then as they change (main camera only) */
+    if (capt->ftm != NULL && cam_data->inst == 0)
+    {
+	p = cam_ctrl_snapshot(cam_data->cam);
+	ftm_ctrls(capt->ftm, 0, p);
+	g_free(p);
+	cam_data->cam->ftm = capt->ftm;
+    }
+
+    return;
+}
 
-    get_user_pref(CAPTURE_FORMAT, &p);
-    capt->codec = p;
 
-    get_user_pref(CAPTURE_LOCATION, &p);
-    capt->locn = p;
+/* Post a capture progress message on the bus (called from the streaming thread) */
 
-    get_user_pref(FN_ID, &p);
-    capt->id = *p;
+static void post_capt_msg(GstPad *pad, video_capt_t *capt, char *nm)
+{
+    GstObject *parent;
+    GstStructure *st;
 
-    get_user_pref(FN_TITLE, &p);
-    capt->tt = *p;
+    if ((parent = gst_pad_get_parent (pad)) == NULL)
+    	return;
 
-    get_user_pref(FN_TIMESTAMP, &p);
-    capt->ts = *p;
+    st = gst_structure_new (nm, 
+			    "frames", G_TYPE_UINT64, capt->buf_count,
+			    "running-time", G_TYPE_UINT64, capt->rt_elapsed,
+			    NULL);
+    gst_element_post_message (GST_ELEMENT (parent), gst_message_new_application (parent, st));
+    gst_object_unref (parent);
 
     return;
 }
 
 
-/* Enable or disable capture buttons as appropriate */
+/* Show capture progress on the status line and stop the capture if the limit was reached */
 
-void set_capture_btns (MainUi *m_ui, int start_sens, int stop_sens)
+void capt_progress(GstMessage *msg, CamData *cam_data, MainUi *m_ui)
 {
-    int ctrl_sens;
+    const GstStructure *st;
+    guint64 frames, rt;
+    char new_status[250];
+    char fchk[80];
+    gdouble rate;
+    guint stalls;
+    guint64 budget;
+    gint headroom;
+    capt_engine_t *eng;
+
+    eng = capt_eng(cam_data);
+    st = gst_message_get_structure (msg);
+
+    if (! gst_structure_get_uint64 (st, "frames", &frames))
+    	return;
 
-    /* Start items on menu and toolbar */
-    gtk_widget_set_sensitive (m_ui->cap_ui, start_sens);
-    gtk_widget_set_sensitive (GTK_WIDGET (m_ui->cap_start_tb), start_sens);
+    if (! gst_structure_get_uint64 (st, "running-time", &rt))
+    	return;
 
-    /* Snapshot items on menu and toolbar */
-    gtk_widget_set_sensitive (m_ui->snap_ui, start_sens); 
-    gtk_widget_set_sensitive (GTK_WIDGET (m_ui->snap_tb), start_sens);
+    switch(cam_data->u.v_capt.capt_opt)
+    {
+	case 1:						// Seconds
+	    cam_data->u.v_capt.capt_actl = (long) (rt / GST_SECOND);
+	    snprintf(new_status, sizeof(new_status), "%s    (%ld of %d)", 
+	    	     eng->info_txt, cam_data->u.v_capt.capt_actl, m_ui->duration);
+	    break;
 
-    /* Stop items on menu and toolbar */
-    gtk_widget_set_sensitive (m_ui->cap_stop, stop_sens);
-    gtk_widget_set_sensitive (GTK_WIDGET (m_ui->cap_stop_tb), stop_sens);
+	case 2:						// Frames
+	    cam_data->u.v_capt.capt_actl = (long) frames;
+	    snprintf(new_status, sizeof(new_status), "%s    (%ld of %d)", 
+	    	     eng->info_txt, cam_data->u.v_capt.capt_actl, m_ui->no_of_frames);
+	    break;
 
-    /* Pause is a special case */
-    gtk_widget_set_sensitive (m_ui->cap_pause, stop_sens);
-    gtk_widget_set_sensitive (GTK_WIDGET (m_ui->cap_pause_tb), stop_sens);
+	default:					// Unlimited
+	    cam_data->u.v_capt.capt_actl = (long) (rt / GST_SECOND);
+	    snprintf(new_status, sizeof(new_status), "%s    %ld seconds", 
+	    	     eng->info_txt, cam_data->u.v_capt.capt_actl);
+    }
 
-    /* Controls (always same as start) */
-    //gtk_widget_set_sensitive (m_ui->cbox_clrfmt, start_sens);		// Only use negotiated now 
-    gtk_widget_set_sensitive (m_ui->cbox_res, start_sens); 
-    gtk_widget_set_sensitive (m_ui->cbox_fps, start_sens); 
-    gtk_widget_set_sensitive (m_ui->oth_ctrls_btn, start_sens); 
-    gtk_widget_set_sensitive (m_ui->def_val_btn, start_sens); 
+    /* Driver drops etc. if any */
+    frame_chk_str(&(cam_data->u.v_capt.fchk), fchk, sizeof(fchk));
 
-    /* Menu items, Toolbar items (always same as start) */
-    gtk_widget_set_sensitive (m_ui->cam_hdr, start_sens); 
-    gtk_widget_set_sensitive (m_ui->cbox_profile, start_sens); 
+    if (fchk[0] != '\0')
+	strncat(new_status, fchk, sizeof(new_status) - strlen(new_status) - 1);
 
-    return;
-}
+    /* Disk write rate (direct i/o sink only) */
+    if (cam_data->gst_objs.file_sink != NULL && cam_data->gst_objs.file_sink == eng->fixed.direct_sink)
+    {
+	g_object_get (cam_data->gst_objs.file_sink, "write-rate", &rate, "stalls", &stalls, NULL);
+	snprintf(fchk, sizeof(fchk), "  Disk %.1f MB/s", rate);
+	strncat(new_status, fchk, sizeof(new_status) - strlen(new_status) - 1);
 
+	if (stalls > 0)
+	{
+	    snprintf(fchk, sizeof(fchk), " (%u waits)", stalls);
+	    strncat(new_status, fchk, sizeof(new_status) - strlen(new_status) - 1);
+	}
 
-/* Set any capture limits */
+	/* Staging headroom if there is a RAM buffer */
+	g_object_get (cam_data->gst_objs.file_sink, "ram-budget", &budget, "headroom", &headroom, NULL);
 
-void capture_limits(app_gst_objects *gst_objs, MainUi *m_ui)
-{
-    if (m_ui->no_of_frames > 0)
+	if (budget > 0)
+	{
+	    snprintf(fchk, sizeof(fchk), "  RAM %d%% free", headroom);
+	    strncat(new_status, fchk, sizeof(new_status) - strlen(new_status) - 1);
+	}
+    }
+
+    gtk_label_set_text (GTK_LABEL (m_ui->status_info), new_status);
+
+    /* Limit reached - next sequence step, or stop capture and resume normal playback */
+    if (gst_message_has_name (msg, "capt-limit"))
     {
-	g_object_set (gst_objs->vid_rate, "drop-only", TRUE, NULL);
-	g_object_set (gst_objs->v4l2_src, "num-buffers", m_ui->no_of_frames, NULL);
+	if (seq_step_end(cam_data, m_ui) == FALSE)
+	    cam_set_eos(cam_data, m_ui);
     }
 
     return;
@@ -1062,15 +1976,15 @@ void view_prepare_capt(CamData *cam_data, MainUi *m_ui)
     if (cam_set_state(cam_data, GST_STATE_NULL, m_ui->window) == FALSE)
     	return;
 
-    gst_element_unlink (cam_data->gst_objs.q1, cam_data->gst_objs.v_convert);
+    gst_element_unlink (cam_data->gst_objs.q1, view_head(&(cam_data->gst_objs)));
     
     if (cam_data->pipeline_type == ENC_PIPELINE)
     {
 	if (strcmp(cam_data->u.v_capt.codec, MPEG2) == 0)
 	{
-	    get_session(CLRFMT, &p);
+	    cam_session(cam_data, CLRFMT, &p);
 	    swap_fourcc(p, fourcc);
-	    get_session(RESOLUTION, &p);
+	    cam_session(cam_data, RESOLUTION, &p);
 	    res_to_long(p, &width, &height);
 	    get_user_pref(MPG2_FRAMERATE, &p);
 	    fps = atoi(p);
@@ -1119,21 +2033,65 @@ void capt_prepare_view(CamData *cam_data, MainUi *m_ui)
     /* Convenience pointer */
     gst_objs = &(cam_data->gst_objs);
 
+    /* Remove the capture limits probe */
+    if (gst_objs->limit_probe_id != 0)
+    {
+	GstPad *pad = gst_element_get_static_pad (gst_objs->capt_queue, "src");
+	gst_pad_remove_probe (pad, gst_objs->limit_probe_id);
+	gst_object_unref (pad);
+	gst_objs->limit_probe_id = 0;
+    }
+
+    /* Remove the sequence file end probe */
+    if (gst_objs->seg_probe_id != 0)
+    {
+	GstPad *pad = gst_element_get_static_pad (gst_objs->file_sink, "sink");
+	gst_pad_remove_probe (pad, gst_objs->seg_probe_id);
+	gst_object_unref (pad);
+	gst_objs->seg_probe_id = 0;
+    }
+
+    cam_data->u.v_capt.seg_hot = FALSE;
+
+    /* Close the frame timestamps file */
+    cam_data->cam->ftm = NULL;
+    ftm_close(cam_data->u.v_capt.ftm);
+    cam_data->u.v_capt.ftm = NULL;
+
+    /* Remove the driver frame checks probe */
+    if (gst_objs->fchk_probe_id != 0)
+    {
+	GstPad *pad = gst_element_get_static_pad (gst_objs->v4l2_src, "src");
+	gst_pad_remove_probe (pad, gst_objs->fchk_probe_id);
+	gst_object_unref (pad);
+	gst_objs->fchk_probe_id = 0;
+    }
+
+    /* Remove the statistics probes (the totals are kept) */
+    if (cam_data->inst == 0)
+	stats_detach(cam_data);
+
     /* Release the request pads from the Tee, and unref them */
     gst_element_release_request_pad (gst_objs->tee, gst_objs->tee_capt_pad);
     gst_element_release_request_pad (gst_objs->tee, gst_objs->tee_video_pad);
     gst_object_unref (gst_objs->tee_capt_pad);
     gst_object_unref (gst_objs->tee_video_pad);
 
-    /* Remove or unlink capture elements */
+    /* Remove or unlink capture elements (they are reset and kept for the next recording) */
     gst_bin_remove_many (GST_BIN (cam_data->pipeline), gst_objs->file_sink,
     						       gst_objs->muxer,
     						       gst_objs->tee,
     						       gst_objs->video_queue,
     						       gst_objs->capt_queue,
-    						       gst_objs->c_convert,
+    						       gst_objs->view_rate,
     						       NULL);
 
+    if (gst_objs->view_scale != NULL)
+	gst_bin_remove_many (GST_BIN (cam_data->pipeline), gst_objs->view_scale, gst_objs->view_filter, NULL);
+
+    if (gst_objs->c_convert != NULL)
+	gst_bin_remove (GST_BIN (cam_data->pipeline), gst_objs->c_convert);
+
     if (cam_data->pipeline_type == ENC_PIPELINE)
     {
 	gst_bin_remove (GST_BIN (cam_data->pipeline), gst_objs->encoder);
@@ -1153,14 +2111,14 @@ void capt_prepare_view(CamData *cam_data, MainUi *m_ui)
         }
 
 	gst_caps_unref(tmp_caps);
-	get_session(FPS, &p);
+	cam_session(cam_data, FPS, &p);
 	fps = atoi(p);
 
 	if (num != fps)
 	{
-	    get_session(CLRFMT, &p);
+	    cam_session(cam_data, CLRFMT, &p);
 	    swap_fourcc(p, fourcc);
-	    get_session(RESOLUTION, &p);
+	    cam_session(cam_data, RESOLUTION, &p);
 	    res_to_long(p, &width, &height);
 
 	    gst_objs->v_caps = gst_caps_make_writable (gst_objs->v_caps);
@@ -1180,7 +2138,7 @@ void capt_prepare_view(CamData *cam_data, MainUi *m_ui)
 	gst_bin_remove_many (GST_BIN (cam_data->pipeline), gst_objs->c_filter, NULL);
     }
 
-    gst_element_link (gst_objs->q1, gst_objs->v_convert);
+    gst_element_link (gst_objs->q1, view_head(gst_objs));
 
     /* Reset */
     gst_objs->file_sink = NULL;
@@ -1191,6 +2149,9 @@ void capt_prepare_view(CamData *cam_data, MainUi *m_ui)
     gst_objs->c_convert = NULL;
     gst_objs->c_filter = NULL;
     gst_objs->encoder = NULL;
+    gst_objs->view_rate = NULL;
+    gst_objs->view_scale = NULL;
+    gst_objs->view_filter = NULL;
 
     return;
 }
@@ -1218,6 +2179,21 @@ int view_clear_pipeline(CamData *cam_data, MainUi *m_ui)
 }
 
 
+// The camera has been unplugged (see hotplug.c) - stop and free any view pipeline and leave
+// capture off until the camera is back. Returns TRUE if there was a pipeline to restart.
+
+int view_unplugged(CamData *cam_data, MainUi *m_ui)
+{
+    cam_data->mode = CAM_MODE_VIEW;
+    set_capture_btns(m_ui, FALSE, FALSE);
+
+    if (cam_data->pipeline == NULL)
+    	return FALSE;
+
+    return view_clear_pipeline(cam_data, m_ui);
+}
+
+
 /* Check the ref count of the element and set up if required */
 
 int create_element(GstElement **element, char *factory_nm, char *nm, CamData *cam_data, MainUi *m_ui)
@@ -1245,6 +2221,49 @@ int create_element(GstElement **element, char *factory_nm, char *nm, CamData *ca
 }
 
 
+/* Processing stages from a preference (gst-launch syntax) - none if not set or in error */
+
+int proc_element(GstElement **element, char *pref, char *nm, char *desc, MainUi *m_ui)
+{
+    GError *err = NULL;
+    char *p;
+
+    *element = NULL;
+    get_user_pref(pref, &p);
+
+    if (p == NULL || *p == '\0')
+    	return TRUE;
+
+    *element = gst_parse_bin_from_description (p, TRUE, &err);
+
+    if (*element == NULL || err != NULL)
+    {
+	sprintf(app_msg_extra, " - %.200s", (err != NULL) ? err->message : p);
+	log_msg("CAM0033", desc, "CAM0033", m_ui->window);
+
+	if (*element != NULL)
+	    gst_object_unref (*element);
+
+	*element = NULL;
+	g_clear_error (&err);
+
+	return FALSE;
+    }
+
+    gst_object_set_name (GST_OBJECT (*element), nm);
+
+    return TRUE;
+}
+
+
+/* First element of the display - the display stages if present */
+
+GstElement * view_head(app_gst_objects *gst_objs)
+{
+    return (gst_objs->v_proc != NULL) ? gst_objs->v_proc : gst_objs->v_convert;
+}
+
+
 /* Check the ref count of the element and unref if specified */
 
 void check_unref(GstElement **element, char *desc, int unref_indi)
@@ -1287,6 +2306,12 @@ void init_video_capt(video_capt_t *v_capt)
     memset(v_capt->cam_fcc, '\0', sizeof(v_capt->cam_fcc));
 
     v_capt->capt_opt = v_capt->capt_reqd = v_capt->capt_actl = v_capt->capt_frames = v_capt->capt_dropped = 0;
+    v_capt->rt_start = v_capt->rt_elapsed = v_capt->rt_posted = v_capt->buf_count = 0;
+    v_capt->limit_hit = 0;
+    v_capt->seg_hot = FALSE;
+    v_capt->passthru = FALSE;
+    frame_chk_init(&(v_capt->fchk), 0);
+    v_capt->ftm = NULL;
     v_capt->id = v_capt->tt = v_capt->ts = '\0';
     v_capt->codec = v_capt->locn = NULL;
     v_capt->codec_data = NULL;
@@ -1299,18 +2324,26 @@ void init_video_capt(video_capt_t *v_capt)
 
 GstBusSyncReply bus_sync_handler (GstBus * bus, GstMessage * message, gpointer user_data)
 {
+    guintptr handle;
+
     // Ignore anything but 'prepare-window-handle' element messages
     if (!gst_is_video_overlay_prepare_window_handle_message (message))
         return GST_BUS_PASS;
 
-    if (video_window_handle != 0)
+    // Each camera may have its own window, the main camera uses the main window
+    handle = capt_eng((CamData *) user_data)->win_handle;
+
+    if (handle == 0)
+    	handle = video_window_handle;
+
+    if (handle != 0)
     {
         //g_print("%s sync reply\n", debug_hdr);
         GstVideoOverlay *overlay;
 
         // GST_MESSAGE_SRC (message) will be the video sink element
         overlay = GST_VIDEO_OVERLAY (GST_MESSAGE_SRC (message));
-        gst_video_overlay_set_window_handle (overlay, video_window_handle);
+        gst_video_overlay_set_window_handle (overlay, handle);
     }
     else
     {
@@ -1332,10 +2365,12 @@ gboolean bus_message_watch (GstBus *bus, GstMessage *msg, gpointer user_data)
     GError *err = NULL;
     gchar *msg_str = NULL;
     app_gst_objects *gst_objs;
+    capt_engine_t *eng;
 
     /* Get data */
-    m_ui = (MainUi *) user_data;
-    cam_data = g_object_get_data (G_OBJECT(m_ui->window), "cam_data");
+    cam_data = (CamData *) user_data;
+    eng = capt_eng(cam_data);
+    m_ui = eng->m_ui;
 
     /* Mainly interested in EOS, but need to be playing first */
     switch GST_MESSAGE_TYPE (msg)
@@ -1375,7 +2410,7 @@ gboolean bus_message_watch (GstBus *bus, GstMessage *msg, gpointer user_data)
 
 	case GST_MESSAGE_ASYNC_DONE:
 	    /* Check need to set vidow window scrollbars */
-	    check_video_scroll(GST_MESSAGE_SRC_NAME(msg), "v_sink", m_ui);
+	    check_video_scroll(GST_MESSAGE_SRC_NAME(msg), "v_sink", cam_data, m_ui);
 
 	    /* Action for capture only */
 	    if (cam_data->mode != CAM_MODE_CAPT)
@@ -1389,36 +2424,8 @@ gboolean bus_message_watch (GstBus *bus, GstMessage *msg, gpointer user_data)
 	    if (GST_MESSAGE_SRC (msg) != GST_OBJECT (cam_data->pipeline))
 	    	break;
 
-	    GstState curr_state, pend_state;
-	    GstStateChangeReturn ret;
-	    ret = gst_element_get_state (cam_data->pipeline, &curr_state, &pend_state, GST_CLOCK_TIME_NONE);
-
-	    /* If not already started, start thread to monitor or time the capture */
-	    if (m_ui->thread_init == FALSE)
-	    {
-		if (curr_state)
-		{
-		    if (ret == GST_STATE_CHANGE_SUCCESS && curr_state == GST_STATE_PLAYING)
-		    {
-		    	if (m_ui->duration > 0) 		// Timed capture
-		    	{
-			    if (init_thread(m_ui, &monitor_duration) == FALSE)
-			    	break;
-            		}
-		    	else if (m_ui->no_of_frames > 0) 	// Number of buffers capture
-		    	{
-			    if (init_thread(m_ui, &monitor_frames) == FALSE)
-			    	break;
-            		}
-            		else					// Unlimited
-		    	{
-			    if (init_thread(m_ui, &monitor_unltd) == FALSE)
-			    	break;
-            		}
-		    }
-		}
-	    }
-
+	    /* Capture progress and limits are handled by the capture queue probe */
+	    m_ui->thread_init = TRUE;
 	    break;
 
 	    /* Debug
@@ -1453,7 +2460,7 @@ gboolean bus_message_watch (GstBus *bus, GstMessage *msg, gpointer user_data)
 	    	break;
 
 	    /* Lock this section of code */
-	    pthread_mutex_lock(&capt_lock_mutex);
+	    pthread_mutex_lock(&(eng->lock_mutex));
 
 	    /* Check the meta data file */
 	    setup_meta(cam_data);
@@ -1464,11 +2471,17 @@ gboolean bus_message_watch (GstBus *bus, GstMessage *msg, gpointer user_data)
 	    /* Release the mutex and set capture as done */
 	    m_ui->thread_init = FALSE;
 	    cam_data->mode = CAM_MODE_NONE;
-	    pthread_cond_signal(&capt_eos_cv);
-	    pthread_mutex_unlock(&capt_lock_mutex);
+	    pthread_cond_signal(&(eng->eos_cv));
+	    pthread_mutex_unlock(&(eng->lock_mutex));
+
+	    /* Start viewing (not while the camera is unplugged, see hotplug.c) */
+	    if (cam_data->cam != NULL && cam_data->cam->video_dev[0] == '\0')
+		view_unplugged(cam_data, m_ui);
+	    else
+		start_view_pipeline(cam_data, m_ui, FALSE);
 
-	    /* Start viewing */
-	    start_view_pipeline(cam_data, m_ui, FALSE);
+	    /* Any capture sequence is over */
+	    seq_capture_end(cam_data, m_ui);
 	    break;
 
 	    /* Debug
@@ -1476,6 +2489,18 @@ gboolean bus_message_watch (GstBus *bus, GstMessage *msg, gpointer user_data)
 	    fflush(stdout);
 	    */
 
+	case GST_MESSAGE_APPLICATION:
+	    /* Capture progress from the capture queue probe */
+	    if (cam_data->mode != CAM_MODE_CAPT)
+	    	break;
+
+	    /* Sequence capture file complete */
+	    if (gst_message_has_name (msg, "capt-seg-done"))
+		seq_next_step(cam_data, m_ui);
+	    else
+		capt_progress(msg, cam_data, m_ui);
+	    break;
+
 	default:
 	    /*
 	    printf("%s Unknown message name %s type %d\n", debug_hdr, 
@@ -1494,301 +2519,256 @@ gboolean bus_message_watch (GstBus *bus, GstMessage *msg, gpointer user_data)
 /* Thread functions */
 
 
-/* Start the nominated capture thread */
+/* Set off an end-of-stream message (main camera) */
+
+int set_eos(MainUi *m_ui)
+{
+    CamData *cam_data;
+
+    cam_data = g_object_get_data (G_OBJECT (m_ui->window), "cam_data");
+
+    return cam_set_eos(cam_data, m_ui);
+}
+
+
+/* Set off an end-of-stream message for a camera */
 
-int init_thread(MainUi *m_ui, void *(*start_routine)(void*))
+int cam_set_eos(CamData *cam_data, MainUi *m_ui)
 {
     int p_err;
 
-    /* Start thread */
-    if ((p_err = pthread_create(&mon_tid, NULL, start_routine, (void *) m_ui)) != 0)
+    if ((p_err = pthread_create(&(capt_eng(cam_data)->eos_tid), NULL, &send_EOS, (void *) cam_data)) != 0)
     {
 	sprintf(app_msg_extra, "Error: %s", strerror(p_err));
 	log_msg("SYS9016", NULL, "SYS9016", m_ui->window);
-	return FALSE;
+	capt_eng(cam_data)->eos_tid = 0;
     }
 
-    m_ui->thread_init = TRUE;
-
-    return TRUE;
+    return p_err;
 }
 
 
-/* Monitor and time the specified for capture duration */
+/* Send an EOS event allowing for exclusivity (mutex) */
 
-void * monitor_duration(void *arg)
+void * send_EOS(void *arg)
 {
     MainUi *m_ui;
     CamData *cam_data;
-    const gchar *s;
-    char *info_txt;
-    char new_status[150];
-    time_t start_time;
-    double tmp_pause, total_pause;
-    
-    /* Base information text */
-    ret_mon = TRUE;
-    m_ui = (MainUi *) arg;
-    cam_data = g_object_get_data (G_OBJECT (m_ui->window), "cam_data");
-    s = gtk_label_get_text (GTK_LABEL (m_ui->status_info));
-    info_txt = (char *) malloc(strlen(s) + 1);
-    strcpy(info_txt, (char *) s);
-    cam_data->u.v_capt.capt_opt = 1;			// Capture number of seconds
-    cam_data->u.v_capt.capt_reqd = m_ui->duration;
-
-    /* Monitor the current time against the start time */
-    cam_data->u.v_capt.capt_actl = 0;
-    start_time = time(NULL);
-    tmp_pause = 0;
-    total_pause = 0;
-    
-    while(cam_data->u.v_capt.capt_actl < m_ui->duration)
-    {
-    	usleep(500000);
+    capt_engine_t *eng;
 
-    	/* Test if capture has been ended manually */
-	if (! G_IS_OBJECT(cam_data->gst_objs.tee_capt_pad))
-	    break;
+    /* Base information text */
+    cam_data = (CamData *) arg;
+    eng = capt_eng(cam_data);
+    eng->eos_tid = pthread_self();
+    eng->ret_eos = TRUE;
+    m_ui = eng->m_ui;
 
-	/* If the pipeline has been paused, maintain how long for, otherwise continue */
-	if (cam_data->state == GST_STATE_PAUSED)
-	{
-	    tmp_pause = difftime(time(NULL), start_time) - total_pause - (double) cam_data->u.v_capt.capt_actl;
-	    sprintf(new_status, "Capture paused at %ld of %d seconds\n", cam_data->u.v_capt.capt_actl, m_ui->duration);
-	}
-	else
-	{
-	    if (tmp_pause != 0)
-	    {
-	    	total_pause += tmp_pause;
-	    	tmp_pause = 0;
-	    }
+    /* Ignore if capture has already stopped */
+    if (! G_IS_OBJECT(cam_data->gst_objs.tee_capt_pad))
+	pthread_exit(&(eng->ret_eos));
 
-	    cam_data->u.v_capt.capt_actl = (long) (difftime(time(NULL), start_time) - total_pause);
-	    snprintf(new_status, (int) sizeof(new_status), "%s    (%ld of %d)\n", 
-	    	    					   info_txt, cam_data->u.v_capt.capt_actl, m_ui->duration);
-	}
+    /* Initiate capture stop and wait for completion */
+    pthread_mutex_lock (&(eng->lock_mutex));
 
-	gtk_label_set_text (GTK_LABEL (m_ui->status_info), new_status);
-    };
+    gst_element_send_event(cam_data->pipeline, gst_event_new_eos());
 
-    free(info_txt);
+    /* If pipeline is paused, restart it */
+    if (cam_data->state == GST_STATE_PAUSED)
+    	cam_set_state(cam_data, GST_STATE_PLAYING, m_ui->window);
 
-    /* Time is up - stop capture and resume normal playback */
-    set_eos(m_ui);
+    /* Should be immediate, but wait for eos processing to complete */
+    pthread_cond_wait(&(eng->eos_cv), &(eng->lock_mutex));
+    pthread_mutex_unlock (&(eng->lock_mutex));
 
-    pthread_exit(&ret_mon);
+    pthread_exit(&(eng->ret_eos));
 }
 
 
-/* Monitor and control the specified capture frame count */
+/* Create the meta data file if necessary */
 
-void * monitor_frames(void *arg)
+void setup_meta(CamData *cam_data)
 {
-    MainUi *m_ui;
-    CamData *cam_data;
-    guint64 frames;
-    const gchar *s;
-    char *info_txt;
-    char new_status[150];
-    
-    /* Base information text */
-    ret_mon = TRUE;
-    m_ui = (MainUi *) arg;
-    cam_data = g_object_get_data (G_OBJECT (m_ui->window), "cam_data");
-    s = gtk_label_get_text (GTK_LABEL (m_ui->status_info));
-    info_txt = (char *) malloc(strlen(s) + 1);
-    strcpy(info_txt, (char *) s);
-    cam_data->u.v_capt.capt_opt = 2;			// Capture number of frames
-    cam_data->u.v_capt.capt_reqd = m_ui->no_of_frames;
+    guint64 dropped;
+    char *p;
 
-    /* Display a rolling frame count - EOS will be set when the set limit has been reached */
-    while (frames <= m_ui->no_of_frames)
-    {
-    	usleep(500000);
+    get_user_pref(META_DATA, &p);
 
-    	/* Test if capture has been ended manually */
-	if (! G_IS_OBJECT(cam_data->gst_objs.tee_capt_pad))
-	    break;
+    if (*p != '1')
+    	return;
 
-    	/* Check if buffer limit has been reached */
-	if (! G_IS_OBJECT(cam_data->gst_objs.vid_rate))
-	    break;
+    /* Frame total and running time as counted on the capture branch */
+    cam_data->u.v_capt.capt_frames = (long) cam_data->u.v_capt.buf_count;
+
+    if (cam_data->u.v_capt.capt_opt == 2)
+	cam_data->u.v_capt.capt_actl = (long) cam_data->u.v_capt.buf_count;
+    else
+	cam_data->u.v_capt.capt_actl = (long) (cam_data->u.v_capt.rt_elapsed / GST_SECOND);
+
+    /* Frames dropped if available (should be) */
+    if (G_IS_OBJECT(cam_data->gst_objs.vid_rate))
+    {
+	g_object_get(cam_data->gst_objs.vid_rate, "drop", &dropped, NULL);
+	cam_data->u.v_capt.capt_dropped = (long) dropped;
+    }
+    else
+    {
+	cam_data->u.v_capt.capt_dropped = 0;
+    }
+
+    write_meta_file('v', cam_data, NULL);
 
-	/* If the pipeline has been paused, suspend counter, otherwise continue */
-	g_object_get(cam_data->gst_objs.vid_rate, "out", &frames, NULL);
-	cam_data->u.v_capt.capt_actl = (long) frames;
+    return;
+}
 
-	if (cam_data->state == GST_STATE_PAUSED)
-	    sprintf(new_status, "Capture paused at %d of %d frames\n", (int) frames, m_ui->no_of_frames);
-	else
-	    sprintf(new_status, "%s    (%d of %d)\n", info_txt, (int) frames, m_ui->no_of_frames);
 
-    	gtk_label_set_text (GTK_LABEL (m_ui->status_info), new_status);
-    };
+/* Destroy the mutexes and conditions (for completeness only here) */
 
-    free(info_txt);
+void capture_cleanup()
+{
+    capt_engine_t *eng;
+    GList *l;
 
-    /* Time is up - stop capture and resume normal playback */
-    cam_data = g_object_get_data (G_OBJECT(m_ui->window), "cam_data");
+    for(l = capt_engines; l != NULL; l = l->next)
+    {
+	eng = (capt_engine_t *) l->data;
+	pthread_mutex_destroy(&(eng->lock_mutex));
+	pthread_cond_destroy(&(eng->eos_cv));
+    }
 
-    pthread_exit(&ret_mon);
+    return;
 }
 
 
-/* Monitor the time amount of capture duration */
+// Engine state for a camera (created on first use). Every camera has its own pipeline, EOS
+// thread, mutex and element cache so several cameras can be viewed and captured at once.
 
-void * monitor_unltd(void *arg)
+static capt_engine_t * capt_eng(CamData *cam_data)
 {
-    MainUi *m_ui;
-    CamData *cam_data;
-    const gchar *s;
-    char *info_txt;
-    char new_status[150];
-    time_t start_time;
-    double tmp_pause, total_pause;
-    
-    /* Base information text */
-    ret_mon = TRUE;
-    m_ui = (MainUi *) arg;
-    cam_data = g_object_get_data (G_OBJECT (m_ui->window), "cam_data");
-    s = gtk_label_get_text (GTK_LABEL (m_ui->status_info));
-    info_txt = (char *) malloc(strlen(s) + 1);
-    strcpy(info_txt, (char *) s);
-    cam_data->u.v_capt.capt_opt = 3;			// Capture unlimited seconds 
-    cam_data->u.v_capt.capt_reqd = -1;
-
-    /* Monitor the current time against the start time */
-    cam_data->u.v_capt.capt_actl = 0;
-    start_time = time(NULL);
-    tmp_pause = 0;
-    total_pause = 0;
-    
-    while(1)
-    {
-    	usleep(500000);
+    capt_engine_t *eng;
 
-    	/* Test if capture has ended manually */
-	if (! G_IS_OBJECT(cam_data->gst_objs.tee_capt_pad))
-	    break;
+    if (cam_data->eng != NULL)
+    	return cam_data->eng;
 
-	/* If the pipeline has been paused, maintain how long for, otherwise continue */
-	if (cam_data->state == GST_STATE_PAUSED)
-	{
-	    tmp_pause = difftime(time(NULL), start_time) - total_pause - (double) cam_data->u.v_capt.capt_actl;
-	    sprintf(new_status, "Capture paused at %ld seconds\n", cam_data->u.v_capt.capt_actl);
-	}
-	else
-	{
-	    if (tmp_pause != 0)
-	    {
-	    	total_pause += tmp_pause;
-	    	tmp_pause = 0;
-	    }
+    eng = (capt_engine_t *) calloc(1, sizeof(capt_engine_t));
+    pthread_mutex_init(&(eng->lock_mutex), NULL);
+    pthread_cond_init(&(eng->eos_cv), NULL);
+    capt_engines = g_list_prepend(capt_engines, eng);
+    cam_data->eng = eng;
 
-	    cam_data->u.v_capt.capt_actl = (long) (difftime(time(NULL), start_time) - total_pause);
-	    sprintf(new_status, "%s    %ld seconds\n", info_txt, cam_data->u.v_capt.capt_actl);
-	}
+    return eng;
+}
 
-    	gtk_label_set_text (GTK_LABEL (m_ui->status_info), new_status);
-    };
 
-    free(info_txt);
-    pthread_exit(&ret_mon);
+/* Show a camera in a window other than the main one (set before the pipeline starts) */
+
+void capt_set_window(CamData *cam_data, guintptr handle)
+{
+    capt_eng(cam_data)->win_handle = handle;
+
+    return;
 }
 
 
-/* Set off an end-of-stream message */
+// Stop a camera that is no longer shown (camera tile) and release its pipeline, live snapshot
+// and engine state. Any recording is abandoned; if one was being stopped the engine is kept
+// as its EOS thread may still be waiting.
 
-int set_eos(MainUi *m_ui)
+void cam_engine_close(CamData *cam_data, MainUi *m_ui)
 {
-    int p_err;
+    GstBus *bus;
 
-    if ((p_err = pthread_create(&eos_tid, NULL, &send_EOS, (void *) m_ui)) != 0)
+    if (cam_data->pipeline != NULL)
     {
-	sprintf(app_msg_extra, "Error: %s", strerror(p_err));
-	log_msg("SYS9016", NULL, "SYS9016", m_ui->window);
+	cam_set_state(cam_data, GST_STATE_NULL, m_ui->window);
+
+	bus = gst_pipeline_get_bus (GST_PIPELINE (cam_data->pipeline));
+	gst_bus_remove_watch (bus);
+	gst_bus_set_sync_handler (bus, NULL, NULL, NULL);
+	gst_object_unref (bus);
+
+	check_unref(&(cam_data->pipeline), "cam_video", TRUE);
     }
 
-    return p_err;
-}
+    live_snap_free(cam_data);
 
+    if (cam_data->mode != CAM_MODE_CAPT && capt_eos_join(cam_data->eng) == TRUE)
+	capt_engine_free(cam_data);
 
-/* Send an EOS event allowing for exclusivity (mutex) */
+    cam_data->mode = CAM_MODE_NONE;
 
-void * send_EOS(void *arg)
-{
-    MainUi *m_ui;
-    CamData *cam_data;
+    return;
+}
 
-    /* Base information text */
-    eos_tid = pthread_self();
-    ret_eos = TRUE;
-    m_ui = (MainUi *) arg;
-    cam_data = g_object_get_data (G_OBJECT (m_ui->window), "cam_data");
 
-    /* Ignore if capture has already stopped */
-    if (! G_IS_OBJECT(cam_data->gst_objs.tee_capt_pad))
-	pthread_exit(&ret_eos);
+// Wait for the last EOS thread to finish with the engine state. It is released as the bus
+// watch ends the capture so should be immediate; if not the engine state is kept (not freed).
 
-    /* Initiate capture stop and wait for completion */
-    pthread_mutex_lock (&capt_lock_mutex);
+static int capt_eos_join(capt_engine_t *eng)
+{
+    int i;
 
-    gst_element_send_event(cam_data->pipeline, gst_event_new_eos());
+    if (eng == NULL || eng->eos_tid == 0)
+    	return TRUE;
 
-    /* If pipeline is paused, restart it */
-    if (cam_data->state == GST_STATE_PAUSED)
-    	cam_set_state(cam_data, GST_STATE_PLAYING, m_ui->window);
+    for(i = 0; i < EOS_JOIN_TRIES; i++)
+    {
+    	if (pthread_tryjoin_np(eng->eos_tid, NULL) == 0)
+	{
+	    eng->eos_tid = 0;
+	    return TRUE;
+	}
 
-    /* Should be immediate, but wait for eos processing to complete */
-    pthread_cond_wait(&capt_eos_cv, &capt_lock_mutex);
-    pthread_mutex_unlock (&capt_lock_mutex);
+	g_usleep(10000);
+    }
 
-    pthread_exit(&ret_eos);
+    return FALSE;
 }
 
 
-/* Create the meta data file if necessary */
+/* Release the engine state of a camera no longer in use (the pipeline must be cleared) */
 
-void setup_meta(CamData *cam_data)
+static void capt_engine_free(CamData *cam_data)
 {
-    guint64 frames, dropped;
-    char *p;
-
-    get_user_pref(META_DATA, &p);
+    capt_engine_t *eng;
+    GstElement **el;
+    capt_cache_t *cache;
+    int i, n;
 
-    if (*p != '1')
+    if ((eng = cam_data->eng) == NULL)
     	return;
 
-    /* Get the frame total if available (should be) */
-    frames = 0;
+    /* Cached elements */
+    el = (GstElement **) &(eng->fixed);
+    n = sizeof(capt_fixed_t) / sizeof(GstElement *);
 
-    if (G_IS_OBJECT(cam_data->gst_objs.vid_rate))
+    for(i = 0; i < n; i++)
     {
-	g_object_get(cam_data->gst_objs.vid_rate, "out", &frames, NULL);
-	cam_data->u.v_capt.capt_frames = (long) frames;
-
-	g_object_get(cam_data->gst_objs.vid_rate, "drop", &dropped, NULL);
-	cam_data->u.v_capt.capt_dropped = (long) dropped;
+	if (el[i] != NULL)
+	    gst_object_unref (el[i]);
     }
-    else
+
+    for(i = 0; i < eng->cache_n; i++)
     {
-	cam_data->u.v_capt.capt_frames = 0;
-	cam_data->u.v_capt.capt_dropped = 0;
-    }
+	cache = &(eng->cache[i]);
 
-    write_meta_file('v', cam_data, NULL);
+	if (cache->encoder != NULL)
+	    gst_object_unref (cache->encoder);
 
-    return;
-}
+	if (cache->c_filter != NULL)
+	    gst_object_unref (cache->c_filter);
 
+	if (cache->muxer != NULL)
+	    gst_object_unref (cache->muxer);
 
-/* Destroy the mutex and condition (for completeness only here) */
+	if (cache->c_caps != NULL)
+	    gst_caps_unref (cache->c_caps);
+    }
 
-void capture_cleanup()
-{
-    pthread_mutex_destroy(&capt_lock_mutex);
-    pthread_cond_destroy(&capt_eos_cv);
+    pthread_mutex_destroy(&(eng->lock_mutex));
+    pthread_cond_destroy(&(eng->eos_cv));
+    capt_engines = g_list_remove(capt_engines, eng);
+    free(eng);
+    cam_data->eng = NULL;
 
     return;
 }
@@ -1910,7 +2890,7 @@ int remove_reticule(MainUi *m_ui, CamData *cam_data)
 
 /* Check need to adjust video window scrollbars when resolution changes */
 
-void check_video_scroll(char *nm, char *match_nm, MainUi *m_ui)
+void check_video_scroll(char *nm, char *match_nm, CamData *cam_data, MainUi *m_ui)
 {
     GtkAdjustment *h_adj, *v_adj;
     gdouble h_pgsz, v_pgsz, h_val, v_val, h_lwr, h_upr, v_upr;
@@ -1928,7 +2908,7 @@ void check_video_scroll(char *nm, char *match_nm, MainUi *m_ui)
 
     h_upr = gtk_adjustment_get_upper(h_adj);
     v_upr = gtk_adjustment_get_upper(v_adj);
-    get_session(RESOLUTION, &p);
+    cam_session(cam_data, RESOLUTION, &p);
     res_to_long(p, &width, &height);
 
     /* Ignore if its not at the latest selecect resolution */
@@ -0,0 +1,539 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Headless (command line) video capture - no display or Gtk main loop required
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Capture pipeline moved to the engine library (actc_engine.c)
+**	19-Oct-2026	Check the camera format option
+**	19-Oct-2026	MJPEG camera format
+**
+*/
+
+/*
+    astroctc --headless [--camera /dev/video0] [--res 1280x960] [--fps 30] [--format YUY2]
+    		        [--codec H264] [--frames n | --secs n] [--out dir] [--title name]
+
+    Gtk is never initialised so no X server is needed. The capture is a libastroctc session
+    (see astroctc.h and actc_engine.c for the pipeline); this is a consumer of the library.
+
+    Anything not given on the command line comes from the user preferences (codec, location,
+    file name template, direct i/o, RAM buffer, frame timestamps) or the last session (size and
+    rate). Ctrl-C sends an end of stream so the file is always finalised, a second one gives up.
+    Progress is written to stdout once a second.
+*/
+
+
+
+/* Includes */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib-unix.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <main.h>
+#include <cam.h>
+#include <defs.h>
+#include <preferences.h>
+#include <session.h>
+#include <astroctc.h>
+
+
+/* Defines */
+
+#define HL_DEVICE "/dev/video0"
+#define HL_QUEUE_BUFS 200
+
+
+/* Structures and Typedefs required */
+
+typedef struct _hl_opts
+{
+    gchar *camera;
+    gchar *res;
+    gint fps;
+    gchar *format;
+    gchar *codec;
+    gint frames;
+    gint secs;
+    gchar *out;
+    gchar *title;
+    gboolean headless;
+} hl_opts_t;
+
+typedef struct _headless
+{
+    hl_opts_t opt;
+    video_capt_t capt;
+    MainUi m_ui;						// No widgets (shared functions only)
+    actc_session_t *sess;
+    GMainLoop *loop;
+    int rc;
+} headless_t;
+
+
+/* Prototypes */
+
+int headless_opt(int, char *[]);
+int headless_main(int, char *[]);
+int hl_parse(headless_t *, int *, char ***);
+int hl_capt_init(headless_t *);
+void hl_config(headless_t *, actc_config_t *);
+void hl_element(actc_session_t *, const char *, GstElement *, gpointer);
+void hl_frame(actc_session_t *, guint64, gint64, guint64, gpointer);
+void hl_status(actc_session_t *, const actc_status_t *, gpointer);
+void hl_finished(actc_session_t *, int, gpointer);
+void hl_engine_msg(actc_session_t *, const char *, const char *, const char *, gpointer);
+gboolean hl_signal(gpointer);
+void hl_msg(char *, char *);
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+extern void get_msg(char*, char*, char*);
+extern int get_user_pref(char *, char **);
+extern void get_session(char*, char**);
+extern void res_to_long(char *, long *, long *);
+extern void dttm_stamp(char *, size_t);
+extern int check_dir(char *);
+extern void get_file_name(char *, int, char *, char *, char *, char, char, char);
+extern codec_t * get_codec_arr(int *);
+extern void set_encoder_props(video_capt_t *, GstElement **, MainUi *);
+extern struct _frame_times * ftm_open(char *, char *);
+extern void ftm_add(struct _frame_times *, guint64, guint64);
+extern void ftm_close(struct _frame_times *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-headless.c ";
+
+
+/* Check for the headless option (before Gtk sees the command line) */
+
+int headless_opt(int argc, char *argv[])
+{
+    int i;
+
+    for(i = 1; i < argc; i++)
+    {
+    	if (strcmp(argv[i], "--headless") == 0)
+	    return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+/* Headless capture control - returns the exit code */
+
+int headless_main(int argc, char *argv[])
+{
+    headless_t hl;
+    actc_config_t cfg;
+    actc_callbacks_t cb;
+    actc_status_t st;
+
+    /* Initial */
+    memset(&hl, 0, sizeof(headless_t));
+    hl.rc = EXIT_SUCCESS;
+
+    if (hl_parse(&hl, &argc, &argv) == FALSE)
+    	return EXIT_FAILURE;
+
+    if (hl_capt_init(&hl) == FALSE)
+    	return EXIT_FAILURE;
+
+    /* Engine session (builds the pipeline) */
+    actc_init();
+    hl_config(&hl, &cfg);
+
+    memset(&cb, 0, sizeof(actc_callbacks_t));
+    cb.message = hl_engine_msg;
+    cb.element = hl_element;
+    cb.frame = hl_frame;
+    cb.status = hl_status;
+    cb.finished = hl_finished;
+
+    if ((hl.sess = actc_session_new(&cfg, &cb, &hl)) == NULL)
+    {
+	ftm_close(hl.capt.ftm);
+    	return EXIT_FAILURE;
+    }
+
+    /* Signals and the session on a plain main loop */
+    hl.loop = g_main_loop_new (NULL, FALSE);
+    g_unix_signal_add (SIGINT, hl_signal, &hl);
+    g_unix_signal_add (SIGTERM, hl_signal, &hl);
+
+    /* Go */
+    if (actc_start(hl.sess) == TRUE)
+    {
+	printf("Capturing to %s\n", hl.capt.out_name);
+	fflush(stdout);
+	g_main_loop_run (hl.loop);
+    }
+
+    /* Finish (the pipeline is stopped before the timestamps file is closed) */
+    g_main_loop_unref (hl.loop);
+    actc_get_status(hl.sess, &st);
+    actc_session_free(hl.sess);
+
+    ftm_close(hl.capt.ftm);
+    hl.capt.ftm = NULL;
+
+    printf("%s: %" G_GUINT64_FORMAT " frames%s\n", (hl.rc == EXIT_SUCCESS) ? "Done" : "Failed",
+    	   st.frames, st.checks);
+
+    return hl.rc;
+}
+
+
+/* Command line options */
+
+int hl_parse(headless_t *hl, int *argc, char ***argv)
+{
+    GOptionContext *ctx;
+    GError *err = NULL;
+    hl_opts_t *opt;
+    gchar *help;
+
+    opt = &(hl->opt);
+
+    GOptionEntry entries[] =
+    {
+	{ "headless", 0, 0, G_OPTION_ARG_NONE, &(opt->headless), "Capture without a display", NULL },
+	{ "camera", 0, 0, G_OPTION_ARG_STRING, &(opt->camera), "Video device (default " HL_DEVICE ")", "DEV" },
+	{ "res", 0, 0, G_OPTION_ARG_STRING, &(opt->res), "Resolution (default last session)", "WxH" },
+	{ "fps", 0, 0, G_OPTION_ARG_INT, &(opt->fps), "Frame rate (default last session)", "N" },
+	{ "format", 0, 0, G_OPTION_ARG_STRING, &(opt->format), "Camera format (eg. YUY2, GRAY8, MJPG)", "FMT" },
+	{ "codec", 0, 0, G_OPTION_ARG_STRING, &(opt->codec), "Codec fourcc or name (default preference)", "CODEC" },
+	{ "frames", 0, 0, G_OPTION_ARG_INT, &(opt->frames), "Number of frames to capture", "N" },
+	{ "secs", 0, 0, G_OPTION_ARG_INT, &(opt->secs), "Number of seconds to capture", "N" },
+	{ "out", 0, 0, G_OPTION_ARG_FILENAME, &(opt->out), "Capture directory (default preference)", "DIR" },
+	{ "title", 0, 0, G_OPTION_ARG_STRING, &(opt->title), "Object title for the file name", "NAME" },
+	{ NULL }
+    };
+
+    ctx = g_option_context_new ("- headless video capture");
+    g_option_context_add_main_entries (ctx, entries, NULL);
+    g_option_context_add_group (ctx, gst_init_get_option_group ());
+
+    if (! g_option_context_parse (ctx, argc, argv, &err))
+    {
+	fprintf(stderr, "astroctc: %s\n", err->message);
+	g_clear_error (&err);
+	g_option_context_free (ctx);
+	return FALSE;
+    }
+
+    if (opt->frames > 0 && opt->secs > 0)
+    {
+	fprintf(stderr, "astroctc: use either --frames or --secs, not both\n");
+	g_option_context_free (ctx);
+	return FALSE;
+    }
+
+    /* Camera format must be one GStreamer knows (eg. YUY2, GRAY8, RGB) or MJPEG */
+    if (opt->format != NULL && gst_video_format_from_string (opt->format) == GST_VIDEO_FORMAT_UNKNOWN &&
+	strcmp(opt->format, "MJPG") != 0 && strcmp(opt->format, "JPEG") != 0)
+    {
+	help = g_option_context_get_help (ctx, TRUE, NULL);
+	fprintf(stderr, "astroctc: unknown --format %s\n\n%s", opt->format, help);
+	g_free (help);
+	g_option_context_free (ctx);
+	return FALSE;
+    }
+
+    g_option_context_free (ctx);
+
+    return TRUE;
+}
+
+
+/* Capture details from the options, preferences and last session */
+
+int hl_capt_init(headless_t *hl)
+{
+    video_capt_t *capt;
+    codec_t *codecs;
+    char *p;
+    int i, max;
+
+    capt = &(hl->capt);
+
+    /* Codec by fourcc or name */
+    if (hl->opt.codec == NULL)
+	get_user_pref(CAPTURE_FORMAT, &(hl->opt.codec));
+
+    codecs = get_codec_arr(&max);
+
+    for(i = 0; i < max && hl->opt.codec != NULL; i++)
+    {
+    	if (g_ascii_strcasecmp(hl->opt.codec, codecs[i].fourcc) == 0 ||
+	    g_ascii_strcasecmp(hl->opt.codec, codecs[i].short_desc) == 0)
+	{
+	    capt->codec_data = &(codecs[i]);
+	    break;
+	}
+    }
+
+    if (capt->codec_data == NULL)
+    {
+	hl_msg("CAM0024", (hl->opt.codec != NULL) ? hl->opt.codec : "(none)");
+    	return FALSE;
+    }
+
+    capt->codec = capt->codec_data->fourcc;
+
+    /* Location and file name */
+    if (hl->opt.out != NULL)
+	capt->locn = hl->opt.out;
+    else
+	get_user_pref(CAPTURE_LOCATION, &(capt->locn));
+
+    if (check_dir(capt->locn) == FALSE)
+    {
+	hl_msg("APP0006", capt->locn);
+    	return FALSE;
+    }
+
+    get_user_pref(FN_ID, &p);
+    capt->id = *p;
+    get_user_pref(FN_TITLE, &p);
+    capt->tt = *p;
+    get_user_pref(FN_TIMESTAMP, &p);
+    capt->ts = *p;
+
+    capt->obj_title = (hl->opt.title != NULL) ? hl->opt.title : "";
+    dttm_stamp(capt->tm_stmp, sizeof(capt->tm_stmp));
+    get_file_name(capt->fn, (int) sizeof(capt->fn), "000", (char *) capt->obj_title,
+		  capt->tm_stmp, capt->id, capt->tt, capt->ts);
+    sprintf(capt->out_name, "%s/%s.%s", capt->locn, capt->fn, capt->codec_data->extn);
+
+    /* Camera */
+    if (hl->opt.camera == NULL)
+	hl->opt.camera = HL_DEVICE;
+
+    if (hl->opt.res == NULL)
+	get_session(RESOLUTION, &(hl->opt.res));
+
+    if (hl->opt.fps <= 0)
+    {
+	get_session(FPS, &p);
+	hl->opt.fps = (p != NULL) ? atoi(p) : 0;
+    }
+
+    /* Limits */
+    if (hl->opt.secs > 0)
+    {
+	capt->capt_opt = 1;
+	capt->capt_reqd = hl->opt.secs;
+    }
+    else if (hl->opt.frames > 0)
+    {
+	capt->capt_opt = 2;
+	capt->capt_reqd = hl->opt.frames;
+    }
+    else
+    {
+	capt->capt_opt = 3;
+	capt->capt_reqd = -1;
+    }
+
+    /* Frame timestamps file */
+    get_user_pref(FRAME_TIMES, &p);
+
+    if (p != NULL && *p == '1')
+    {
+	p = (char *) malloc(strlen(capt->locn) + strlen(capt->fn) + 20);
+	sprintf(p, "%s/%s.times.csv", capt->locn, capt->fn);
+	capt->ftm = ftm_open(p, capt->out_name);
+	free(p);
+    }
+
+    return TRUE;
+}
+
+
+/* Engine session details from the options, preferences and last session */
+
+void hl_config(headless_t *hl, actc_config_t *cfg)
+{
+    long width, height;
+    int ram_mb;
+    char *p;
+
+    memset(cfg, 0, sizeof(actc_config_t));
+
+    cfg->device = hl->opt.camera;
+    cfg->fps = hl->opt.fps;
+    cfg->format = hl->opt.format;
+
+    if (hl->opt.res != NULL)
+    {
+	res_to_long(hl->opt.res, &width, &height);
+	cfg->width = (int) width;
+	cfg->height = (int) height;
+    }
+
+    /* Encoder or raw format (native - captured as is) */
+    if (strcmp(hl->capt.codec_data->fourcc, NATIVE_FMT) != 0)
+    {
+	if (*(hl->capt.codec_data->encoder) != '\0')
+	    cfg->encoder = hl->capt.codec_data->encoder;
+	else
+	    cfg->raw_format = hl->capt.codec_data->fourcc;
+    }
+
+    cfg->muxer = hl->capt.codec_data->muxer;
+    cfg->location = hl->capt.out_name;
+
+    /* File sink as per the preferences */
+    get_user_pref(DIRECT_IO, &p);
+    cfg->direct = (p != NULL && *p == '1');
+    get_user_pref(RAM_BUDGET, &p);
+    ram_mb = (p != NULL) ? atoi(p) : 0;
+    cfg->ram_budget = (guint64) MAX (ram_mb, 0) * 1024 * 1024;
+
+    /* Limits */
+    cfg->frames = hl->opt.frames;
+    cfg->secs = hl->opt.secs;
+    cfg->queue_bufs = HL_QUEUE_BUFS;
+
+    return;
+}
+
+
+/* Engine callback - encoder properties from the preferences */
+
+void hl_element(actc_session_t *sess, const char *role, GstElement *element, gpointer user_data)
+{
+    headless_t *hl;
+
+    hl = (headless_t *) user_data;
+
+    if (strcmp(role, "encoder") == 0)
+	set_encoder_props(&(hl->capt), &element, &(hl->m_ui));
+
+    return;
+}
+
+
+/* Engine callback (streaming thread) - frame timestamps file */
+
+void hl_frame(actc_session_t *sess, guint64 count, gint64 seq, guint64 ts, gpointer user_data)
+{
+    headless_t *hl;
+
+    hl = (headless_t *) user_data;
+
+    if (hl->capt.ftm != NULL)
+	ftm_add(hl->capt.ftm, count, ts + actc_base_time(sess));
+
+    return;
+}
+
+
+/* Engine callback - progress once a second */
+
+void hl_status(actc_session_t *sess, const actc_status_t *st, gpointer user_data)
+{
+    printf("%.0fs  %" G_GUINT64_FORMAT " frames  %" G_GUINT64_FORMAT " fps%s",
+    	   st->secs, st->frames, st->fps, st->checks);
+
+    if (st->direct == TRUE)
+	printf("  Disk %.1f MB/s", st->disk_rate);
+
+    printf("\n");
+    fflush(stdout);
+
+    return;
+}
+
+
+/* Engine callback - the file is finished (or the capture failed) */
+
+void hl_finished(actc_session_t *sess, int ok, gpointer user_data)
+{
+    headless_t *hl;
+
+    hl = (headless_t *) user_data;
+
+    if (ok == FALSE)
+	hl->rc = EXIT_FAILURE;
+
+    g_main_loop_quit (hl->loop);
+
+    return;
+}
+
+
+/* Engine callback - messages go to stderr and the log */
+
+void hl_engine_msg(actc_session_t *sess, const char *msg_id, const char *opt, const char *detail, gpointer user_data)
+{
+    snprintf(app_msg_extra, sizeof(app_msg_extra), "%s", detail);
+    hl_msg((char *) msg_id, (char *) opt);
+
+    return;
+}
+
+
+/* Ctrl-C or terminate - finish the file, a second signal gives up */
+
+gboolean hl_signal(gpointer user_data)
+{
+    headless_t *hl;
+
+    hl = (headless_t *) user_data;
+
+    if (actc_stopping(hl->sess) == TRUE)
+	actc_abort(hl->sess);
+    else
+	actc_stop(hl->sess);
+
+    return TRUE;
+}
+
+
+/* Errors go to stderr as well as the log (there is no window to show them in) */
+
+void hl_msg(char *msg_id, char *opt_str)
+{
+    char msg[512];
+
+    get_msg(msg, msg_id, opt_str);
+    fprintf(stderr, "astroctc: %s\n", msg);
+
+    if (app_msg_extra[0] != '\0')
+	fprintf(stderr, "\t%s\n", app_msg_extra);
+
+    log_msg(msg_id, opt_str, NULL, NULL);
+
+    return;
+}
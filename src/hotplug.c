@@ -0,0 +1,449 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Camera hotplug - follow video devices appearing and disappearing in /dev
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Capture in progress finished, lost camera's menu item greyed
+**
+*/
+
+/*
+    An inotify watch on /dev is read on the main loop. Events for 'video*' names are collected
+    and acted on once things settle (udev creates the node and then sets its permissions), so
+    a camera is probed once rather than per event.
+
+    - A new capture device is added to the camera list and the Camera menu (a full reload if
+      there were no cameras before).
+    - A device that goes away is removed from the list and the menu, unless it is shown in a
+      camera tile (the tile looks after itself).
+    - If the current camera goes away its view is stopped and its entry kept (greyed). A
+      capture in progress is ended so the file is finalised. When a device with the same card
+      and bus comes back, on any node, the controls are set again from the session and the
+      view restarts.
+*/
+
+
+
+/* Includes */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/inotify.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <linux/videodev2.h>
+#include <main.h>
+#include <cam.h>
+#include <defs.h>
+
+
+/* Defines */
+
+#define HP_SETTLE 250						// ms after the last event
+#define HP_BUF_SZ 4096
+
+
+/* Prototypes */
+
+int hotplug_init(CamData *, MainUi *);
+void hotplug_close();
+gboolean OnHotplugEvent(GIOChannel *, GIOCondition, gpointer);
+gboolean hotplug_settle(gpointer);
+void hotplug_added(char *);
+void hotplug_removed(char *);
+void hotplug_restore(struct camlistNode *);
+int hotplug_listed(camera_t *);
+void hotplug_menu_remove(camera_t *);
+GtkWidget * hotplug_menu_item(camera_t *);
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+extern struct camlistNode* dev_camera_node(char *);
+extern struct camlistNode* find_listNode(CamData *, char *);
+extern void remove_listNode(CamData *, struct camlistNode *);
+extern void add_listNode(struct camlistNode*, struct camlistNode**);
+extern GtkWidget * camera_menu_item(GtkWidget *, camera_t *, char *, MainUi *, CamData *);
+extern int view_unplugged(CamData *, MainUi *);
+extern int cam_set_eos(CamData *, MainUi *);
+extern int gst_view(CamData *, MainUi *);
+extern int reset_cntl_panel(MainUi *, CamData *);
+extern void cam_ctl_close(camera_t *);
+extern int cam_ctl_watch(camera_t *, GtkWidget *, GtkWidget *);
+extern void cam_ctrl_batch(camera_t *);
+extern int cam_ctrl_commit(camera_t *, GtkWidget *);
+extern void ctrl_pend_flush();
+extern int tiles_cam_used(char *);
+extern void OnCamScan(GtkWidget*, gpointer);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-hotplug.c ";
+static int hp_fd = -1;
+static guint hp_watch = 0;
+static guint hp_timer = 0;
+static GHashTable *hp_names = NULL;				// Device names with events pending
+static camera_t *hp_lost = NULL;				// Current camera while unplugged
+static int hp_restart = FALSE;					// Its view was stopped here
+static CamData *hp_cam_data;
+static MainUi *hp_m_ui;
+
+
+/* Watch /dev for video devices (on the main loop) */
+
+int hotplug_init(CamData *cam_data, MainUi *m_ui)
+{
+    GIOChannel *chan;
+
+    hp_cam_data = cam_data;
+    hp_m_ui = m_ui;
+
+    if ((hp_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+    {
+	sprintf(app_msg_extra, "Error: %s", strerror(errno));
+	log_msg("CAM0037", DEV_DIR, NULL, NULL);
+    	return FALSE;
+    }
+
+    if (inotify_add_watch(hp_fd, DEV_DIR, IN_CREATE | IN_DELETE | IN_ATTRIB) < 0)
+    {
+	sprintf(app_msg_extra, "Error: %s", strerror(errno));
+	log_msg("CAM0037", DEV_DIR, NULL, NULL);
+	close(hp_fd);
+	hp_fd = -1;
+    	return FALSE;
+    }
+
+    hp_names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    chan = g_io_channel_unix_new (hp_fd);
+    hp_watch = g_io_add_watch (chan, G_IO_IN | G_IO_ERR | G_IO_HUP, OnHotplugEvent, NULL);
+    g_io_channel_unref (chan);
+
+    return TRUE;
+}
+
+
+/* Stop watching */
+
+void hotplug_close()
+{
+    if (hp_fd < 0)
+    	return;
+
+    if (hp_timer != 0)
+	g_source_remove (hp_timer);
+
+    if (hp_watch != 0)
+	g_source_remove (hp_watch);
+
+    close(hp_fd);
+    g_hash_table_destroy (hp_names);
+
+    hp_fd = -1;
+    hp_timer = 0;
+    hp_watch = 0;
+    hp_names = NULL;
+    hp_lost = NULL;
+
+    return;
+}
+
+
+/* Callback - /dev changed, note the video names and (re)start the settle timer */
+
+gboolean OnHotplugEvent(GIOChannel *chan, GIOCondition cond, gpointer user_data)
+{
+    char buf[HP_BUF_SZ] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    struct inotify_event *ev;
+    ssize_t len;
+    char *p;
+
+    if (cond & (G_IO_ERR | G_IO_HUP))
+    {
+	hp_watch = 0;
+    	return FALSE;
+    }
+
+    while ((len = read(hp_fd, buf, sizeof(buf))) > 0)
+    {
+	for(p = buf; p < buf + len; p += sizeof(struct inotify_event) + ev->len)
+	{
+	    ev = (struct inotify_event *) p;
+
+	    if (ev->len > 0 && strncmp(ev->name, "video", 5) == 0)
+		g_hash_table_add (hp_names, g_strdup_printf ("%s/%s", DEV_DIR, ev->name));
+	}
+    }
+
+    if (g_hash_table_size (hp_names) > 0)
+    {
+	if (hp_timer != 0)
+	    g_source_remove (hp_timer);
+
+	hp_timer = g_timeout_add (HP_SETTLE, hotplug_settle, NULL);
+    }
+
+    return TRUE;
+}
+
+
+/* Act on the devices that changed */
+
+gboolean hotplug_settle(gpointer user_data)
+{
+    GHashTableIter iter;
+    gpointer key;
+    GList *l, *devs;
+
+    hp_timer = 0;
+    devs = NULL;
+
+    g_hash_table_iter_init (&iter, hp_names);
+
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+	devs = g_list_prepend (devs, key);
+	g_hash_table_iter_steal (&iter);
+    }
+
+    for(l = devs; l != NULL; l = l->next)
+    {
+    	if (access((char *) l->data, F_OK) == 0)
+	    hotplug_added((char *) l->data);
+	else
+	    hotplug_removed((char *) l->data);
+    }
+
+    g_list_free_full (devs, g_free);
+
+    return FALSE;
+}
+
+
+/* A device appeared (or its permissions changed) */
+
+void hotplug_added(char *video_dev)
+{
+    struct camlistNode *node;
+    camera_t *cam;
+    char s[310];
+
+    /* A reload may have replaced the unplugged camera */
+    if (hp_lost != NULL && ! hotplug_listed(hp_lost))
+    	hp_lost = NULL;
+
+    /* Already listed */
+    if (find_listNode(hp_cam_data, video_dev) != NULL)
+    	return;
+
+    /* Not a capture device or not open to us yet (a later attribute change will retry) */
+    if ((node = dev_camera_node(video_dev)) == NULL)
+    	return;
+
+    cam = node->cam;
+
+    /* The current camera back again */
+    if (hp_lost != NULL &&
+	strcmp((char *) cam->vcaps.card, (char *) hp_lost->vcaps.card) == 0 &&
+	strcmp((char *) cam->vcaps.bus_info, (char *) hp_lost->vcaps.bus_info) == 0)
+    {
+	hotplug_restore(node);
+    	return;
+    }
+
+    /* First camera - set everything up as a reload does */
+    if (hp_cam_data->camlist == NULL)
+    {
+	free(node->cam);
+	free(node);
+	OnCamScan(NULL, hp_m_ui->window);
+    	return;
+    }
+
+    add_listNode(node, &(hp_cam_data->camlist));
+
+    sprintf(s, "cam_%s", video_dev + strlen(DEV_DIR) + 1);
+    camera_menu_item(hp_m_ui->cam_menu, cam, s, hp_m_ui, hp_cam_data);
+
+    log_msg("CAM0038", (char *) cam->vcaps.card, NULL, NULL);
+
+    return;
+}
+
+
+/* A device went away */
+
+void hotplug_removed(char *video_dev)
+{
+    struct camlistNode *node;
+    camera_t *cam;
+    GtkWidget *item;
+
+    if ((node = find_listNode(hp_cam_data, video_dev)) == NULL)
+    	return;
+
+    cam = node->cam;
+
+    /* Keep the current camera and wait for it (its node name may be reused by another camera) */
+    if (cam == hp_cam_data->cam)
+    {
+	hp_lost = cam;
+	cam->video_dev[0] = '\0';
+	ctrl_pend_flush();
+	cam_ctl_close(cam);
+
+	/* Nothing to select until it is back */
+	if ((item = hotplug_menu_item(cam)) != NULL)
+	    gtk_widget_set_sensitive (item, FALSE);
+
+	/* Finish a capture (the EOS handler then stops the view) or stop the view */
+	if (hp_cam_data->mode == CAM_MODE_CAPT)
+	{
+	    hp_restart = TRUE;
+	    cam_set_eos(hp_cam_data, hp_m_ui);
+	}
+	else if (hp_cam_data->mode != CAM_MODE_SNAP && hp_cam_data->pipeline != NULL)
+	{
+	    hp_restart = view_unplugged(hp_cam_data, hp_m_ui);
+	}
+
+	log_msg("CAM0039", (char *) cam->vcaps.card, NULL, NULL);
+    	return;
+    }
+
+    /* A tile owns it */
+    if (tiles_cam_used(video_dev))
+    	return;
+
+    log_msg("CAM0042", (char *) cam->vcaps.card, NULL, NULL);
+    hotplug_menu_remove(cam);
+    remove_listNode(hp_cam_data, node);
+
+    return;
+}
+
+
+/* The current camera is back - use the new device node, apply the session settings and view */
+
+void hotplug_restore(struct camlistNode *node)
+{
+    camera_t *cam;
+    GtkWidget *item;
+
+    cam = hp_lost;
+    hp_lost = NULL;
+
+    strcpy(cam->video_dev, node->cam->video_dev);
+    free(node->cam);
+    free(node);
+
+    strcpy(hp_cam_data->current_dev, cam->video_dev);
+    memcpy(hp_cam_data->current_dev_abbr, hp_cam_data->current_dev, CAM_ABBR_SZ);
+    hp_cam_data->current_dev_abbr[CAM_ABBR_SZ] = '\0';
+
+    log_msg("CAM0041", (char *) cam->vcaps.card, NULL, NULL);
+
+    if ((item = hotplug_menu_item(cam)) != NULL)
+	gtk_widget_set_sensitive (item, TRUE);
+
+    /* Another camera may have been selected meanwhile */
+    if (cam != hp_cam_data->cam)
+    {
+	hp_restart = FALSE;
+    	return;
+    }
+
+    cam_ctrl_batch(cam);
+    reset_cntl_panel(hp_m_ui, hp_cam_data);
+    cam_ctrl_commit(cam, hp_m_ui->window);
+    cam_ctl_watch(cam, hp_m_ui->cntl_grid, hp_m_ui->window);
+
+    if (hp_restart == TRUE)
+    {
+	hp_restart = FALSE;
+	gst_view(hp_cam_data, hp_m_ui);
+    }
+
+    return;
+}
+
+
+/* Check a camera is still in the list (a reload replaces them all) */
+
+int hotplug_listed(camera_t *cam)
+{
+    struct camlistNode *tmp;
+
+    for(tmp = hp_cam_data->camlist; tmp != NULL; tmp = tmp->next)
+    {
+    	if (tmp->cam == cam)
+	    return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+/* Remove the Camera menu item for a camera */
+
+void hotplug_menu_remove(camera_t *cam)
+{
+    GtkWidget *item;
+
+    if ((item = hotplug_menu_item(cam)) != NULL)
+	gtk_widget_destroy (item);
+
+    return;
+}
+
+
+/* Find the Camera menu item for a camera */
+
+GtkWidget * hotplug_menu_item(camera_t *cam)
+{
+    GList *l, *items;
+    GtkWidget *item;
+
+    items = gtk_container_get_children (GTK_CONTAINER (hp_m_ui->cam_menu));
+    item = NULL;
+
+    for(l = items; l != NULL; l = l->next)
+    {
+    	if (g_object_get_data (G_OBJECT (l->data), "camera") == cam)
+	{
+	    item = GTK_WIDGET (l->data);
+	    break;
+	}
+    }
+
+    g_list_free (items);
+
+    return item;
+}
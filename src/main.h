@@ -26,6 +26,7 @@
 **
 ** History
 **	08-Sep-2014	Initial
+**	19-Oct-2026	Capture sequence menu item
 **
 */
 
@@ -59,6 +60,7 @@ typedef struct _main_ui
     GtkWidget *cbox_seq;
     GtkWidget *obj_title;
     GtkWidget *cap_ui;
+    GtkWidget *cap_seq;
     GtkToolItem *cap_start_tb;
     GtkWidget *cap_stop;
     GtkToolItem *cap_stop_tb;
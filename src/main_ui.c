@@ -27,6 +27,13 @@
 ** History
 **	27-Dec-2013	Initial code
 **	20-Nov-2020	Changes to move to css
+**	19-Oct-2026	Encoder benchmark menu option
+**	19-Oct-2026	Pipeline statistics menu option
+**	19-Oct-2026	Capture sequence menu option
+**	19-Oct-2026	Camera tiles menu option
+**	19-Oct-2026	Sliders follow camera control events
+**	19-Oct-2026	Camera menu item creation shared with hotplug
+**	19-Oct-2026	Control key buffers sized for every control id
 **
 */
 
@@ -64,6 +71,7 @@ void exposure_settings(int*, CamData *, MainUi *);
 void create_panel_btn(GtkWidget **, char *, char *, int, int, MainUi *);
 GtkWidget* create_menu(MainUi *, CamData *);
 void add_camera_list(GtkWidget**, MainUi *, CamData *);
+GtkWidget * camera_menu_item(GtkWidget *, camera_t *, char *, MainUi *, CamData *);
 void colour_fmt(int **, CamData *, MainUi *);
 void clrfmt_res(int **, CamData *, MainUi *);
 void clrfmt_res_list(MainUi *, CamData *);
@@ -97,6 +105,7 @@ GtkWidget * debug_cntr(GtkWidget *);
 extern void get_session(char*, char**);
 extern int set_session(char*, char*);
 extern int camera_setup(camera_t *, GtkWidget *);
+extern int cam_ctl_watch(camera_t *, GtkWidget *, GtkWidget *);
 extern char* get_profile_name(int);
 extern struct v4l2_queryctrl * get_next_ctrl(int);
 extern int std_controls(camera_t *);
@@ -133,6 +142,7 @@ extern void OnSetCtrlRadio(GtkToggleButton *, gpointer);
 extern void OnSetCamMenu(GtkWidget*, gpointer);
 extern void OnStartCapUi(GtkWidget*, gpointer);
 extern void OnStartCap(GtkWidget*, gpointer);
+extern void OnCapSeq(GtkWidget*, gpointer);
 extern void OnStopCap(GtkWidget*, gpointer);
 extern void OnSnapShot(GtkWidget*, gpointer);
 extern void OnPauseCap(GtkWidget*, gpointer);
@@ -142,7 +152,10 @@ extern void OnCamDetail(GtkWidget*, gpointer);
 extern void OnCamDefault(GtkWidget*, gpointer);
 extern void OnCamRestart(GtkWidget*, gpointer);
 extern void OnCamScan(GtkWidget*, gpointer);
+extern void OnCamTiles(GtkWidget*, gpointer);
 extern void OnPrefs(GtkWidget*, gpointer);
+extern void OnBenchmark(GtkWidget*, gpointer);
+extern void OnPipeStats(GtkWidget*, gpointer);
 extern void OnNightVision(GtkWidget*, gpointer);
 extern void OnReticule(GtkWidget*, gpointer);
 extern void OnAbout(GtkWidget*, gpointer);
@@ -261,8 +274,8 @@ GtkWidget* create_menu(MainUi *m_ui, CamData *cam_data)
     GtkWidget *file_menu, *cap_menu, *opt_menu, *help_menu;
     GtkWidget *file_hdr, *cap_hdr, *opt_hdr, *help_hdr;
     GtkWidget *file_exit;
-    GtkWidget *cam_detail, *cam_default, *cam_restart, *cam_rescan;
-    GtkWidget *opt_prefs, *opt_night;
+    GtkWidget *cam_detail, *cam_default, *cam_restart, *cam_rescan, *cam_tiles;
+    GtkWidget *opt_prefs, *opt_bench, *opt_stats, *opt_night;
     GtkWidget *help_about, *view_log;
     GtkWidget *sep, *sep2;
     GtkAccelGroup *accel_group = NULL;
@@ -297,6 +310,7 @@ GtkWidget* create_menu(MainUi *m_ui, CamData *cam_data)
     cam_default = gtk_menu_item_new_with_label ("Set All Defaults");
     cam_restart = gtk_menu_item_new_with_label ("Restart Video");
     cam_rescan = gtk_menu_item_new_with_label ("Reload Cameras");
+    cam_tiles = gtk_menu_item_new_with_label ("Camera Tiles...");
 
     /* Add to menu */
     gtk_menu_shell_append (GTK_MENU_SHELL (m_ui->cam_menu), cam_detail);
@@ -304,6 +318,7 @@ GtkWidget* create_menu(MainUi *m_ui, CamData *cam_data)
     gtk_menu_shell_append (GTK_MENU_SHELL (m_ui->cam_menu), cam_default);
     gtk_menu_shell_append (GTK_MENU_SHELL (m_ui->cam_menu), cam_restart);
     gtk_menu_shell_append (GTK_MENU_SHELL (m_ui->cam_menu), cam_rescan);
+    gtk_menu_shell_append (GTK_MENU_SHELL (m_ui->cam_menu), cam_tiles);
     gtk_menu_shell_append (GTK_MENU_SHELL (m_ui->cam_menu), sep2);
 
     /* Show menu items */
@@ -311,12 +326,14 @@ GtkWidget* create_menu(MainUi *m_ui, CamData *cam_data)
     gtk_widget_show (cam_default);
     gtk_widget_show (cam_restart);
     gtk_widget_show (cam_rescan);
+    gtk_widget_show (cam_tiles);
 
     /* Callbacks */
     g_signal_connect (cam_detail, "activate", G_CALLBACK (OnCamDetail), (gpointer) cam_data);
     g_signal_connect (cam_default, "activate", G_CALLBACK (OnCamDefault), m_ui->window);
     g_signal_connect (cam_restart, "activate", G_CALLBACK (OnCamRestart), m_ui->window);
     g_signal_connect (cam_rescan, "activate", G_CALLBACK (OnCamScan), m_ui->window);
+    g_signal_connect (cam_tiles, "activate", G_CALLBACK (OnCamTiles), m_ui->window);
 
     /* Camera menu items - build a list of available cameras */
     add_camera_list(&(m_ui->cam_menu), m_ui, cam_data);
@@ -329,24 +346,28 @@ GtkWidget* create_menu(MainUi *m_ui, CamData *cam_data)
     cap_menu = gtk_menu_new();
 
     m_ui->cap_ui = gtk_menu_item_new_with_mnemonic ("_Start...");
+    m_ui->cap_seq = gtk_menu_item_new_with_label ("Sequence...");
     m_ui->cap_stop = gtk_menu_item_new_with_mnemonic ("S_top");
     m_ui->cap_pause = gtk_menu_item_new_with_label ("Pause");
     m_ui->snap_ui = gtk_menu_item_new_with_label ("Snapshot...");
 
     /* Add to menu */
     gtk_menu_shell_append (GTK_MENU_SHELL (cap_menu), m_ui->cap_ui);
+    gtk_menu_shell_append (GTK_MENU_SHELL (cap_menu), m_ui->cap_seq);
     gtk_menu_shell_append (GTK_MENU_SHELL (cap_menu), m_ui->cap_stop);
     gtk_menu_shell_append (GTK_MENU_SHELL (cap_menu), m_ui->cap_pause);
     gtk_menu_shell_append (GTK_MENU_SHELL (cap_menu), m_ui->snap_ui);
 
     /* Callbacks */
     g_signal_connect (m_ui->cap_ui, "activate", G_CALLBACK (OnStartCapUi), m_ui->window);
+    g_signal_connect (m_ui->cap_seq, "activate", G_CALLBACK (OnCapSeq), m_ui->window);
     g_signal_connect (m_ui->cap_stop, "activate", G_CALLBACK (OnStopCap), m_ui->window);
     g_signal_connect (m_ui->cap_pause, "activate", G_CALLBACK (OnPauseCap), m_ui->window);
     g_signal_connect (m_ui->snap_ui, "activate", G_CALLBACK (OnSnapUi), m_ui->window);
 
     /* Show menu items */
     gtk_widget_show (m_ui->cap_ui);
+    gtk_widget_show (m_ui->cap_seq);
     gtk_widget_show (m_ui->cap_stop);
     gtk_widget_show (m_ui->cap_pause);
     gtk_widget_show (m_ui->snap_ui);
@@ -360,23 +381,31 @@ GtkWidget* create_menu(MainUi *m_ui, CamData *cam_data)
 
     /* Option menu items */
     opt_prefs = gtk_menu_item_new_with_mnemonic ("_Preferences...");
+    opt_bench = gtk_menu_item_new_with_label ("Encoder Benchmark...");
+    opt_stats = gtk_menu_item_new_with_label ("Pipeline Statistics...");
     sep = gtk_separator_menu_item_new();
     opt_night = gtk_check_menu_item_new_with_label ("Night Vision");
     m_ui->opt_ret = gtk_check_menu_item_new_with_label ("Reticule");
 
     /* Add to menu */
     gtk_menu_shell_append (GTK_MENU_SHELL (opt_menu), opt_prefs);
+    gtk_menu_shell_append (GTK_MENU_SHELL (opt_menu), opt_bench);
+    gtk_menu_shell_append (GTK_MENU_SHELL (opt_menu), opt_stats);
     gtk_menu_shell_append (GTK_MENU_SHELL (opt_menu), sep);
     gtk_menu_shell_append (GTK_MENU_SHELL (opt_menu), opt_night);
     gtk_menu_shell_append (GTK_MENU_SHELL (opt_menu), m_ui->opt_ret);
 
     /* Callbacks */
     g_signal_connect (opt_prefs, "activate", G_CALLBACK (OnPrefs), m_ui->window);
+    g_signal_connect (opt_bench, "activate", G_CALLBACK (OnBenchmark), m_ui->window);
+    g_signal_connect (opt_stats, "activate", G_CALLBACK (OnPipeStats), m_ui->window);
     g_signal_connect (opt_night, "toggled", G_CALLBACK (OnNightVision), m_ui);
     g_signal_connect (m_ui->opt_ret, "activate", G_CALLBACK (OnReticule), m_ui);
 
     /* Show menu items */
     gtk_widget_show (opt_prefs);
+    gtk_widget_show (opt_bench);
+    gtk_widget_show (opt_stats);
     gtk_widget_show (opt_night);
     gtk_widget_show (m_ui->opt_ret);
 
@@ -487,21 +516,9 @@ void add_camera_list(GtkWidget **cam_menu, MainUi *m_ui, CamData *cam_data)
     {
 	cam_nm = tmp->cam->vcaps.card;
 	cam_dev = tmp->cam->video_dev;
-	cam_sel = gtk_menu_item_new_with_label (cam_nm);
 
 	sprintf(s, "cam_%d", i++);
-	gtk_widget_set_name (cam_sel, s);
-
-	/* Add to menu */
-	gtk_menu_shell_append (GTK_MENU_SHELL (*cam_menu), cam_sel);
-
-	/* Callbacks */
-	g_signal_connect (cam_sel, "activate", G_CALLBACK (OnCameraSel), (gpointer) cam_data);
-	g_object_set_data (G_OBJECT (cam_sel), "ui", m_ui);
-	g_object_set_data (G_OBJECT (cam_sel), "camera", tmp->cam);
-
-	/* Show menu item */
-	gtk_widget_show (cam_sel);
+	camera_menu_item(*cam_menu, tmp->cam, s, m_ui, cam_data);
 	
 	if ((strlen(cam_data->current_cam) == 0) || (strcmp(cam_nm, prev_nm) == 0))
 	{
@@ -530,6 +547,30 @@ void add_camera_list(GtkWidget **cam_menu, MainUi *m_ui, CamData *cam_data)
 }  
 
 
+/* Add a camera selection to the Camera menu */
+
+GtkWidget * camera_menu_item(GtkWidget *cam_menu, camera_t *cam, char *nm, MainUi *m_ui, CamData *cam_data)
+{
+    GtkWidget *cam_sel;
+
+    cam_sel = gtk_menu_item_new_with_label ((const gchar *) cam->vcaps.card);
+    gtk_widget_set_name (cam_sel, nm);
+
+    /* Add to menu */
+    gtk_menu_shell_append (GTK_MENU_SHELL (cam_menu), cam_sel);
+
+    /* Callbacks */
+    g_signal_connect (cam_sel, "activate", G_CALLBACK (OnCameraSel), (gpointer) cam_data);
+    g_object_set_data (G_OBJECT (cam_sel), "ui", m_ui);
+    g_object_set_data (G_OBJECT (cam_sel), "camera", cam);
+
+    /* Show menu item */
+    gtk_widget_show (cam_sel);
+
+    return cam_sel;
+}
+
+
 /* Create a quick access toolbar with callbacks */
 
 GtkWidget* create_toolbar(MainUi *m_ui, CamData *cam_data)
@@ -793,6 +834,9 @@ GtkWidget* create_cntl_panel(MainUi *m_ui, CamData *cam_data)
     /* Image exposure settings sub-panel */
     exposure_settings(&row, cam_data, m_ui);
 
+    /* Keep the sliders current with changes made by the camera */
+    cam_ctl_watch(cam_data->cam, m_ui->cntl_grid, m_ui->window);
+
     /* Keep a reference to the control panel */
     g_object_set_data (G_OBJECT (m_ui->window), "cntl_grid", m_ui->cntl_grid);
 
@@ -1266,7 +1310,7 @@ void scale_cam_ctrl(struct v4l2_queryctrl *qctrl,
 		    CamData *cam_data)
 {
     long ctl_val;
-    char ctl_key[10];
+    char ctl_key[CTL_KEY_SZ];
     GtkWidget *exp_scale;  
 
     /* Get last session value if any or the default */
@@ -1329,7 +1373,7 @@ void menu_list_ctrl(struct v4l2_list *ctlNode,
 		    CamData *cam_data)
 {
     long ctl_val;
-    char ctl_key[10], s[100];
+    char ctl_key[CTL_KEY_SZ], s[100];
     GtkWidget *cam_ctrl_cbox;  
     struct v4l2_queryctrl *qctrl;
     struct v4l2_querymenu *qmenu;
@@ -1381,7 +1425,7 @@ void radio_cam_ctrl(struct v4l2_list *ctlNode,
 {
     int i;
     long ctl_val;
-    char ctl_key[10];
+    char ctl_key[CTL_KEY_SZ];
     GtkWidget *radio_grp, *vbox, *label, *frame;
     struct v4l2_queryctrl *qctrl;
     struct v4l2_list *tmp;
@@ -0,0 +1,573 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Per element pipeline statistics during capture
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Periodic statistics log, lock free probe counters
+**
+*/
+
+/*
+    Buffer probes are placed on the capture pipeline elements when a capture starts:
+
+	camera (src), tee (sink), video & capture queues (sink + src), encoder or
+	convert (sink + src), muxer (src) and file sink (sink)
+
+    Each probe only counts buffers and bytes and, where an element has both an input and
+    an output probe, matches the buffer timestamp (PTS) to time the element. Latencies go
+    into a fixed 0.1ms histogram so percentiles need no sorting or allocation. Queue fill
+    levels and the per interval rates are sampled on the main loop.
+
+    The probes take no locks. Each point has its own counters, updated atomically (a buffer
+    may be seen on the streaming threads either side of a queue); the main loop only reads
+    them. An in flight buffer is claimed from the ring by swapping its timestamp out.
+
+    With the meta data file on, the samples are also written to <capture>.stats.csv once a
+    second while capturing, one line per point:
+
+	secs,point,fps,MB/s,p50 ms,p95 ms,p99 ms,queue level
+*/
+
+
+/* Defines */
+
+#define STATS_MAX 8
+#define STATS_RING 128
+#define STATS_BUCKETS 2000					// 0.1 ms each (200 ms)
+#define STATS_INTERVAL 500					// ms
+#define STATS_LOG_EVERY 2					// Samples per log line
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <main.h>
+#include <cam.h>
+#include <defs.h>
+#include <preferences.h>
+
+
+/* Structures and Typedefs required */
+
+typedef struct _stat_point
+{
+    char nm[20];
+    GstElement *el;
+    GstPad *in_pad, *out_pad;
+    gulong in_id, out_id;
+    int is_queue;
+    guint64 buffers, bytes;					// Counted on the output (or only) pad
+    guint64 prev_buffers, prev_bytes;
+    gint64 t_first, t_last;
+    guint64 ring_pts[STATS_RING];				// Buffers in flight (input probe)
+    gint64 ring_tm[STATS_RING];
+    gint ring_idx;
+    guint32 hist[STATS_BUCKETS + 1];
+    guint64 lat_count;
+    double fps, mbps;
+    int level, level_max;
+} stat_point_t;
+
+
+/* Prototypes */
+
+void stats_attach(CamData *);
+void stats_detach(CamData *);
+void stats_add_point(char *, GstElement *, char *, char *, int);
+static GstPadProbeReturn stats_in_probe(GstPad *, GstPadProbeInfo *, gpointer);
+static GstPadProbeReturn stats_out_probe(GstPad *, GstPadProbeInfo *, gpointer);
+static guint64 stats_buf_pts(GstPadProbeInfo *, guint *, gsize *);
+gboolean stats_sample(gpointer);
+double stats_pctl(stat_point_t *, double);
+int stats_get(int, pipe_stat_t *);
+int stats_active();
+void stats_meta(FILE *);
+static void stats_log_open(CamData *);
+static void stats_log(double);
+static void stats_count_buf(stat_point_t *, guint, gsize, gint64);
+
+extern int get_user_pref(char *, char **);
+extern void log_msg(char*, char*, char*, GtkWidget*);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-pipeline_stats.c ";
+static stat_point_t stats[STATS_MAX];
+static int stats_count = 0;
+static int stats_on = FALSE;
+static gint64 stats_tm = 0;
+static guint stats_src = 0;
+static FILE *stats_fd = NULL;					// Statistics log (NULL none)
+static gint64 stats_start = 0;
+static int stats_samples = 0;
+
+
+/* Place probes on the capture elements and reset the counts */
+
+void stats_attach(CamData *cam_data)
+{
+    app_gst_objects *gst_objs;
+
+    /* Initial */
+    gst_objs = &(cam_data->gst_objs);
+    stats_detach(cam_data);
+    stats_count = 0;
+
+    stats_add_point("camera", gst_objs->v4l2_src, NULL, "src", FALSE);
+    stats_add_point("tee", gst_objs->tee, "sink", NULL, FALSE);
+    stats_add_point("view queue", gst_objs->video_queue, "sink", "src", TRUE);
+    stats_add_point("capt queue", gst_objs->capt_queue, "sink", "src", TRUE);
+
+    if (cam_data->pipeline_type == ENC_PIPELINE)
+	stats_add_point("encoder", gst_objs->encoder, "sink", "src", FALSE);
+    else if (gst_objs->c_convert != NULL)
+	stats_add_point("convert", gst_objs->c_convert, "sink", "src", FALSE);
+
+    stats_add_point("muxer", gst_objs->muxer, NULL, "src", FALSE);
+    stats_add_point("file sink", gst_objs->file_sink, "sink", NULL, FALSE);
+
+    /* Rates and queue levels */
+    stats_tm = g_get_monotonic_time();
+    stats_start = stats_tm;
+    stats_samples = 0;
+    stats_log_open(cam_data);
+    stats_on = TRUE;
+    stats_src = g_timeout_add (STATS_INTERVAL, stats_sample, NULL);
+
+    return;
+}
+
+
+/* Remove the probes (pipeline should be stopped), the counts are kept for the meta data */
+
+void stats_detach(CamData *cam_data)
+{
+    int i;
+    stat_point_t *sp;
+
+    stats_on = FALSE;
+
+    if (stats_src != 0)
+    {
+	g_source_remove (stats_src);
+	stats_src = 0;
+    }
+
+    if (stats_fd != NULL)
+    {
+	fclose(stats_fd);
+	stats_fd = NULL;
+    }
+
+    for(i = 0, sp = stats; i < stats_count; i++, sp++)
+    {
+	if (sp->in_pad != NULL)
+	{
+	    gst_pad_remove_probe (sp->in_pad, sp->in_id);
+	    gst_object_unref (sp->in_pad);
+	    sp->in_pad = NULL;
+	}
+
+	if (sp->out_pad != NULL)
+	{
+	    gst_pad_remove_probe (sp->out_pad, sp->out_id);
+	    gst_object_unref (sp->out_pad);
+	    sp->out_pad = NULL;
+	}
+
+	sp->el = NULL;
+    }
+
+    return;
+}
+
+
+/* Set up a statistics point on an element's input and / or output pads */
+
+void stats_add_point(char *nm, GstElement *el, char *in_nm, char *out_nm, int is_queue)
+{
+    int i;
+    stat_point_t *sp;
+
+    if (el == NULL || stats_count >= STATS_MAX)
+    	return;
+
+    /* Reset */
+    sp = &(stats[stats_count]);
+    memset(sp, 0, sizeof(stat_point_t));
+    stats_count++;
+
+    snprintf(sp->nm, sizeof(sp->nm), "%s", nm);
+    sp->el = el;
+    sp->is_queue = is_queue;
+    sp->level = (is_queue) ? 0 : -1;
+    sp->level_max = sp->level;
+
+    for(i = 0; i < STATS_RING; i++)
+    	sp->ring_pts[i] = GST_CLOCK_TIME_NONE;
+
+    if (in_nm != NULL)
+    {
+	sp->in_pad = gst_element_get_static_pad (el, in_nm);
+
+	if (sp->in_pad != NULL)
+	    sp->in_id = gst_pad_add_probe (sp->in_pad,
+	    				   GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+					   stats_in_probe, sp, NULL);
+    }
+
+    if (out_nm != NULL)
+    {
+	sp->out_pad = gst_element_get_static_pad (el, out_nm);
+
+	if (sp->out_pad != NULL)
+	    sp->out_id = gst_pad_add_probe (sp->out_pad,
+	    				    GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+					    stats_out_probe, sp, NULL);
+    }
+
+    return;
+}
+
+
+/* Input probe - note the buffer arrival, or count it if there is no output probe */
+
+static GstPadProbeReturn stats_in_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    stat_point_t *sp;
+    guint64 pts;
+    guint n;
+    gsize sz;
+    gint64 now;
+    int idx;
+
+    sp = (stat_point_t *) user_data;
+    pts = stats_buf_pts(info, &n, &sz);
+    now = g_get_monotonic_time();
+
+    if (sp->out_pad == NULL)
+    {
+	stats_count_buf(sp, n, sz, now);
+    }
+    else if (pts != GST_CLOCK_TIME_NONE)
+    {
+	/* Only this thread writes the ring, the output probe reads it */
+	idx = g_atomic_int_get (&(sp->ring_idx));
+	__atomic_store_n (&(sp->ring_tm[idx]), now, __ATOMIC_RELAXED);
+	__atomic_store_n (&(sp->ring_pts[idx]), pts, __ATOMIC_RELEASE);
+	g_atomic_int_set (&(sp->ring_idx), (idx + 1) % STATS_RING);
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+/* Output probe - count the buffer and time it from its input if possible */
+
+static GstPadProbeReturn stats_out_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    stat_point_t *sp;
+    guint64 pts;
+    guint n;
+    gsize sz;
+    guint64 want;
+    gint64 now, lat;
+    int i, idx, last;
+
+    sp = (stat_point_t *) user_data;
+    pts = stats_buf_pts(info, &n, &sz);
+    now = g_get_monotonic_time();
+
+    stats_count_buf(sp, n, sz, now);
+
+    /* Match the timestamp against the buffers in flight, newest first (claimed by the swap) */
+    if (sp->in_pad != NULL && pts != GST_CLOCK_TIME_NONE)
+    {
+	last = g_atomic_int_get (&(sp->ring_idx));
+
+	for(i = 1; i <= STATS_RING; i++)
+	{
+	    idx = (last - i + STATS_RING) % STATS_RING;
+	    want = pts;
+
+	    if (__atomic_compare_exchange_n (&(sp->ring_pts[idx]), &want, GST_CLOCK_TIME_NONE,
+	    				     FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+	    {
+		lat = (now - __atomic_load_n (&(sp->ring_tm[idx]), __ATOMIC_RELAXED)) / 100;
+		__atomic_fetch_add (&(sp->hist[(lat < STATS_BUCKETS) ? lat : STATS_BUCKETS]), 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add (&(sp->lat_count), 1, __ATOMIC_RELAXED);
+		break;
+	    }
+	}
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+/* Buffer (or first buffer in a list) timestamp, count and size */
+
+static guint64 stats_buf_pts(GstPadProbeInfo *info, guint *n, gsize *sz)
+{
+    GstBuffer *buf;
+    GstBufferList *list;
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    {
+	list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+	*n = gst_buffer_list_length (list);
+	*sz = gst_buffer_list_calculate_size (list);
+
+	if (*n == 0)
+	    return GST_CLOCK_TIME_NONE;
+
+	buf = gst_buffer_list_get (list, 0);
+    }
+    else
+    {
+	buf = GST_PAD_PROBE_INFO_BUFFER (info);
+	*n = 1;
+	*sz = gst_buffer_get_size (buf);
+    }
+
+    return GST_BUFFER_PTS (buf);
+}
+
+
+/* Count buffers and bytes on a point (either probe, any streaming thread) */
+
+static void stats_count_buf(stat_point_t *sp, guint n, gsize sz, gint64 now)
+{
+    gint64 zero;
+
+    zero = 0;
+    __atomic_compare_exchange_n (&(sp->t_first), &zero, now, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&(sp->bytes), (guint64) sz, __ATOMIC_RELAXED);
+    __atomic_fetch_add (&(sp->buffers), (guint64) n, __ATOMIC_RELAXED);
+    __atomic_store_n (&(sp->t_last), now, __ATOMIC_RELAXED);
+
+    return;
+}
+
+
+/* Main loop timer - interval rates and queue levels */
+
+gboolean stats_sample(gpointer user_data)
+{
+    int i;
+    guint lvl;
+    guint64 buffers, bytes;
+    gint64 now;
+    double secs;
+    stat_point_t *sp;
+
+    if (stats_on == FALSE)
+    {
+	stats_src = 0;
+    	return FALSE;
+    }
+
+    now = g_get_monotonic_time();
+    secs = (double) (now - stats_tm) / G_USEC_PER_SEC;
+    stats_tm = now;
+
+    if (secs <= 0)
+    	return TRUE;
+
+    for(i = 0, sp = stats; i < stats_count; i++, sp++)
+    {
+	buffers = __atomic_load_n (&(sp->buffers), __ATOMIC_RELAXED);
+	bytes = __atomic_load_n (&(sp->bytes), __ATOMIC_RELAXED);
+	sp->fps = (double) (buffers - sp->prev_buffers) / secs;
+	sp->mbps = (double) (bytes - sp->prev_bytes) / secs / 1048576.0;
+	sp->prev_buffers = buffers;
+	sp->prev_bytes = bytes;
+
+	if (sp->is_queue && sp->el != NULL)
+	{
+	    g_object_get (sp->el, "current-level-buffers", &lvl, NULL);
+	    sp->level = (int) lvl;
+
+	    if (sp->level > sp->level_max)
+		sp->level_max = sp->level;
+	}
+    }
+
+    if (stats_fd != NULL && ++stats_samples % STATS_LOG_EVERY == 0)
+	stats_log((double) (now - stats_start) / G_USEC_PER_SEC);
+
+    return TRUE;
+}
+
+
+/* Start the statistics log beside the capture file (if meta data is wanted) */
+
+static void stats_log_open(CamData *cam_data)
+{
+    video_capt_t *capt;
+    char *p, *fn;
+
+    get_user_pref(META_DATA, &p);
+
+    if (p == NULL || *p != '1')
+    	return;
+
+    capt = &(cam_data->u.v_capt);
+    fn = g_strdup_printf ("%s/%s.stats.csv", capt->locn, capt->fn);
+
+    if ((stats_fd = fopen(fn, "w")) == NULL)
+	log_msg("SYS9005", fn, NULL, NULL);
+    else
+	fputs("secs,point,fps,mbps,lat_p50,lat_p95,lat_p99,level\n", stats_fd);
+
+    g_free(fn);
+
+    return;
+}
+
+
+/* Write the latest sample for each point */
+
+static void stats_log(double secs)
+{
+    int i;
+    pipe_stat_t ps;
+
+    for(i = 0; stats_get(i, &ps) == TRUE; i++)
+	fprintf(stats_fd, "%.1f,%s,%.2f,%.2f,%.1f,%.1f,%.1f,%d\n",
+		secs, ps.nm, ps.fps, ps.mbps, ps.lat_p50, ps.lat_p95, ps.lat_p99, ps.level);
+
+    fflush(stats_fd);
+
+    return;
+}
+
+
+/* Latency percentile (ms) from the histogram, -1 if none */
+
+double stats_pctl(stat_point_t *sp, double pct)
+{
+    int i;
+    guint64 target, cum, count;
+
+    if ((count = __atomic_load_n (&(sp->lat_count), __ATOMIC_RELAXED)) == 0)
+    	return -1.0;
+
+    target = (guint64) (pct / 100.0 * (double) count);
+
+    if (target < 1)
+    	target = 1;
+
+    for(i = 0, cum = 0; i <= STATS_BUCKETS; i++)
+    {
+	cum += __atomic_load_n (&(sp->hist[i]), __ATOMIC_RELAXED);
+
+	if (cum >= target)
+	    break;
+    }
+
+    return (double) i / 10.0;
+}
+
+
+/* Copy out the details for a statistics point */
+
+int stats_get(int idx, pipe_stat_t *ps)
+{
+    stat_point_t *sp;
+
+    if (idx < 0 || idx >= stats_count)
+    	return FALSE;
+
+    sp = &(stats[idx]);
+
+    strcpy(ps->nm, sp->nm);
+    ps->fps = sp->fps;
+    ps->mbps = sp->mbps;
+    ps->lat_p50 = stats_pctl(sp, 50.0);
+    ps->lat_p95 = stats_pctl(sp, 95.0);
+    ps->lat_p99 = stats_pctl(sp, 99.0);
+    ps->level = sp->level;
+    ps->level_max = sp->level_max;
+    ps->buffers = __atomic_load_n (&(sp->buffers), __ATOMIC_RELAXED);
+    ps->bytes = __atomic_load_n (&(sp->bytes), __ATOMIC_RELAXED);
+
+    return TRUE;
+}
+
+
+/* Probes are in place */
+
+int stats_active()
+{
+    return stats_on;
+}
+
+
+/* Write a summary (whole capture averages) to the meta data file */
+
+void stats_meta(FILE *mf)
+{
+    int i;
+    double secs, fps, mbps;
+    char lat[60], lvl[20];
+    pipe_stat_t ps;
+    stat_point_t *sp;
+
+    if (stats_count == 0)
+    	return;
+
+    fputs("Pipeline statistics (avg fps, latency p50/p95/p99 ms, max queue, MB/s):\n", mf);
+
+    for(i = 0, sp = stats; i < stats_count; i++, sp++)
+    {
+	stats_get(i, &ps);
+	secs = (double) (sp->t_last - sp->t_first) / G_USEC_PER_SEC;
+	fps = (secs > 0 && ps.buffers > 1) ? (double) (ps.buffers - 1) / secs : 0.0;
+	mbps = (secs > 0) ? (double) ps.bytes / secs / 1048576.0 : 0.0;
+
+	if (ps.lat_p50 >= 0)
+	    snprintf(lat, sizeof(lat), "%.1f/%.1f/%.1f", ps.lat_p50, ps.lat_p95, ps.lat_p99);
+	else
+	    strcpy(lat, "-");
+
+	if (sp->is_queue)
+	    snprintf(lvl, sizeof(lvl), "%d", sp->level_max);
+	else
+	    strcpy(lvl, "-");
+
+	fprintf(mf, "  %-10s %7.2f fps  %-17s  %4s  %8.2f MB/s  (%" G_GUINT64_FORMAT " buffers)\n",
+		sp->nm, fps, lat, lvl, mbps, ps.buffers);
+    }
+
+    return;
+}
@@ -26,6 +26,11 @@
 **
 ** History
 **	8-Aug-2014	Initial
+**	19-Oct-2026	Display rate and scaling while capturing
+**	19-Oct-2026	Frame timestamps file
+**	19-Oct-2026	Frame processing stages
+**	19-Oct-2026	Shared memory frame output
+**	19-Oct-2026	Network preview
 **
 */
 
@@ -65,5 +70,21 @@ typedef struct _UserPrefData
 #define AUDIO_MUTE "AUDIO"
 #define WARN_EMPTY_TITLE "NO_TITLE"
 #define META_DATA "META_DATA"
+#define VIEW_CAPT_FPS "VIEW_CAPT_FPS"
+#define VIEW_CAPT_SCALE "VIEW_SCALE"
+#define FRAME_TIMES "FRAME_TIMES"
+#define DIRECT_IO "DIRECT_IO"
+#define RAM_BUDGET "RAM_BUDGET"
+#define PROC_STAGES "PROC_STAGES"
+#define VIEW_STAGES "VIEW_STAGES"
+#define SHM_OUT "SHM_OUT"
+#define NET_OUT "NET_OUT"
+#define NET_MJPEG "NET_MJPEG"
+#define NET_TCP "NET_TCP"
+#define NET_HOST "NET_HOST"
+#define NET_PORT "NET_PORT"
+#define NET_WIDTH "NET_WIDTH"
+#define NET_FPS "NET_FPS"
+#define NET_KBPS "NET_KBPS"
 
 #endif
@@ -27,6 +27,12 @@
 ** History
 **	8-Aug-2014	Initial code
 **      20-Nov-2020     Changes to move to css
+**	19-Oct-2026	Display rate and scaling while capturing
+**	19-Oct-2026	Frame timestamps file
+**	19-Oct-2026	Direct disk writes and capture RAM buffer
+**	19-Oct-2026	Frame processing stages
+**	19-Oct-2026	Shared memory frame output
+**	19-Oct-2026	Network preview
 **
 */
 
@@ -68,12 +74,28 @@ typedef struct _prefs_ui
     GtkWidget *cbox_codec;
     GtkWidget *capt_duration;
     GtkWidget *capt_frames;
+    GtkWidget *view_fps;
+    GtkWidget *vscale_hbox;
+    GtkWidget *dio_hbox;
+    GtkWidget *ram_budget;
+    GtkWidget *proc_stages;
+    GtkWidget *view_stages;
+    GtkWidget *shm_hbox;
+    GtkWidget *net_hbox;
+    GtkWidget *net_codec_hbox;
+    GtkWidget *net_tcp_hbox;
+    GtkWidget *net_host;
+    GtkWidget *net_port;
+    GtkWidget *net_width;
+    GtkWidget *net_fps;
+    GtkWidget *net_kbps;
     GtkWidget *fn_grid;
     GtkWidget *fn_tmpl;
     GtkWidget *capt_dir;
     GtkWidget *audio_hbox;
     GtkWidget *title_hbox;
     GtkWidget *meta_hbox;
+    GtkWidget *ftm_hbox;
     int close_handler;
     int fn_err, qual_alloc_width;
     GList *hide_list;
@@ -94,6 +116,7 @@ void file_location(PrefUi *);
 void audio_mute(PrefUi *);
 void empty_title(PrefUi *);
 void meta_data_file(PrefUi *);
+void frame_times_file(PrefUi *);
 void pref_label_1(char *, GtkWidget **, GtkAlign, int);
 void pref_label_2(char *, GtkWidget **, GtkAlign, int, int);
 void pref_label_3(char *, GtkWidget *, int *);
@@ -120,6 +143,14 @@ void init_profile_prefs();
 void init_audio_prefs();
 void init_title_prefs();
 void init_metadata_prefs();
+void init_view_capt_prefs();
+void init_frame_times_prefs();
+void init_direct_io_prefs();
+void init_ram_budget_prefs();
+void init_proc_stages_prefs();
+void init_shm_out_prefs();
+void init_net_out_prefs();
+void net_entry(GtkWidget **, char *, char *, int, GtkWidget *);
 void set_user_prefs(PrefUi *);
 int get_user_pref(char *, char **);
 void get_user_pref_idx(int, char *, char **);
@@ -318,6 +349,7 @@ void pref_control(PrefUi *p_ui)
     audio_mute(p_ui);
     empty_title(p_ui);
     meta_data_file(p_ui);
+    frame_times_file(p_ui);
 
     return;
 }
@@ -506,6 +538,178 @@ void video_capture(PrefUi *p_ui)
 
     gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), h_box, FALSE, FALSE, 0);
 
+    /* Display rate while capturing (0 is every frame) */
+    h_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Display fps while capturing (0 = all)", &h_box, GTK_ALIGN_END, 20, 0);
+
+    p_ui->view_fps = gtk_entry_new();
+    gtk_widget_set_name(p_ui->view_fps, "view_fps");
+    gtk_widget_set_halign(GTK_WIDGET (p_ui->view_fps), GTK_ALIGN_START);
+    gtk_entry_set_max_length(GTK_ENTRY (p_ui->view_fps), 3);
+    gtk_entry_set_width_chars(GTK_ENTRY (p_ui->view_fps), 4);
+    gtk_box_pack_start (GTK_BOX (h_box), p_ui->view_fps, FALSE, FALSE, 3);
+
+    get_user_pref(VIEW_CAPT_FPS, &p);
+    gtk_entry_set_text(GTK_ENTRY (p_ui->view_fps), (p != NULL) ? p : "10");
+
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), h_box, FALSE, FALSE, 0);
+
+    /* Scale display to the window while capturing */
+    p_ui->vscale_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Scale display to window while capturing", &p_ui->vscale_hbox, GTK_ALIGN_END, 20, 0);
+    get_user_pref(VIEW_CAPT_SCALE, &p);
+
+    i = TRUE;
+
+    if (p != NULL)
+    	if (atoi(p) == 0)
+	    i = FALSE;
+
+    pref_boolean("Off", "On", i, &p_ui->vscale_hbox);
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), p_ui->vscale_hbox, FALSE, FALSE, 0);
+
+    /* Capture file written directly to disk (preallocated, bypassing the page cache) */
+    p_ui->dio_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Direct disk writes for capture files", &p_ui->dio_hbox, GTK_ALIGN_END, 20, 0);
+    get_user_pref(DIRECT_IO, &p);
+
+    i = TRUE;
+
+    if (p != NULL)
+    	if (atoi(p) == 0)
+	    i = FALSE;
+
+    pref_boolean("Off", "On", i, &p_ui->dio_hbox);
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), p_ui->dio_hbox, FALSE, FALSE, 0);
+
+    /* Memory to stage capture data in ahead of the disk (0 is none) */
+    h_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Capture RAM buffer (MB, 0 = none)", &h_box, GTK_ALIGN_END, 20, 0);
+
+    p_ui->ram_budget = gtk_entry_new();
+    gtk_widget_set_name(p_ui->ram_budget, "ram_budget");
+    gtk_widget_set_halign(GTK_WIDGET (p_ui->ram_budget), GTK_ALIGN_START);
+    gtk_entry_set_max_length(GTK_ENTRY (p_ui->ram_budget), 5);
+    gtk_entry_set_width_chars(GTK_ENTRY (p_ui->ram_budget), 5);
+    gtk_widget_set_tooltip_text (p_ui->ram_budget, "Bursts faster than the disk are held in memory "
+    						   "and written out in the background");
+    gtk_box_pack_start (GTK_BOX (h_box), p_ui->ram_budget, FALSE, FALSE, 3);
+
+    get_user_pref(RAM_BUDGET, &p);
+    gtk_entry_set_text(GTK_ENTRY (p_ui->ram_budget), (p != NULL) ? p : "0");
+
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), h_box, FALSE, FALSE, 0);
+
+    /* Processing stages - recorded and shown, or display only (gst-launch syntax) */
+    h_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Processing stages (recorded)", &h_box, GTK_ALIGN_END, 20, 0);
+
+    p_ui->proc_stages = gtk_entry_new();
+    gtk_widget_set_name(p_ui->proc_stages, "proc_stages");
+    gtk_widget_set_halign(GTK_WIDGET (p_ui->proc_stages), GTK_ALIGN_START);
+    gtk_entry_set_max_length(GTK_ENTRY (p_ui->proc_stages), 200);
+    gtk_entry_set_width_chars(GTK_ENTRY (p_ui->proc_stages), 30);
+    gtk_widget_set_tooltip_text (p_ui->proc_stages, "Elements before the capture split, eg. "
+    						    "'videoconvert ! video/x-raw,format=GRAY8 ! astrocalib location=dark.raw'. "
+    						    "Applies when the camera is next started");
+    gtk_box_pack_start (GTK_BOX (h_box), p_ui->proc_stages, FALSE, FALSE, 3);
+
+    get_user_pref(PROC_STAGES, &p);
+    gtk_entry_set_text(GTK_ENTRY (p_ui->proc_stages), (p != NULL) ? p : "");
+
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), h_box, FALSE, FALSE, 0);
+
+    h_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Processing stages (display only)", &h_box, GTK_ALIGN_END, 20, 0);
+
+    p_ui->view_stages = gtk_entry_new();
+    gtk_widget_set_name(p_ui->view_stages, "view_stages");
+    gtk_widget_set_halign(GTK_WIDGET (p_ui->view_stages), GTK_ALIGN_START);
+    gtk_entry_set_max_length(GTK_ENTRY (p_ui->view_stages), 200);
+    gtk_entry_set_width_chars(GTK_ENTRY (p_ui->view_stages), 30);
+    gtk_widget_set_tooltip_text (p_ui->view_stages, "Elements on the display only, eg. "
+    						    "'videoconvert ! astrostack frames=8 ! astrostretch auto=true'. "
+    						    "Applies when the camera is next started");
+    gtk_box_pack_start (GTK_BOX (h_box), p_ui->view_stages, FALSE, FALSE, 3);
+
+    get_user_pref(VIEW_STAGES, &p);
+    gtk_entry_set_text(GTK_ENTRY (p_ui->view_stages), (p != NULL) ? p : "");
+
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), h_box, FALSE, FALSE, 0);
+
+    /* Camera frames shared with other local programs (shmsink) */
+    p_ui->shm_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Share frames with local programs", &p_ui->shm_hbox, GTK_ALIGN_END, 20, 0);
+    get_user_pref(SHM_OUT, &p);
+
+    i = FALSE;
+
+    if (p != NULL)
+    	if (atoi(p) == 1)
+	    i = TRUE;
+
+    pref_boolean("Off", "On", i, &p_ui->shm_hbox);
+    gtk_widget_set_tooltip_text (p_ui->shm_hbox, "Raw camera frames over shared memory (shm-<device> in the "
+    						 "application directory). Applies when the camera is next started");
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), p_ui->shm_hbox, FALSE, FALSE, 0);
+
+    /* Network preview - on or off, encoding and transport */
+    p_ui->net_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Network preview", &p_ui->net_hbox, GTK_ALIGN_END, 20, 0);
+    get_user_pref(NET_OUT, &p);
+    pref_boolean("Off", "On", (p != NULL && atoi(p) == 1), &p_ui->net_hbox);
+    gtk_widget_set_tooltip_text (p_ui->net_hbox, "Reduced size and rate stream of the main camera for "
+    						 "watching remotely. Applies when the camera is next started");
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), p_ui->net_hbox, FALSE, FALSE, 0);
+
+    p_ui->net_codec_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Network preview encoding", &p_ui->net_codec_hbox, GTK_ALIGN_END, 20, 0);
+    get_user_pref(NET_MJPEG, &p);
+    pref_boolean("H264", "MJPEG", (p != NULL && atoi(p) == 1), &p_ui->net_codec_hbox);
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), p_ui->net_codec_hbox, FALSE, FALSE, 0);
+
+    p_ui->net_tcp_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Network preview transport", &p_ui->net_tcp_hbox, GTK_ALIGN_END, 20, 0);
+    get_user_pref(NET_TCP, &p);
+    pref_boolean("RTP to host", "TCP server", (p != NULL && atoi(p) == 1), &p_ui->net_tcp_hbox);
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), p_ui->net_tcp_hbox, FALSE, FALSE, 0);
+
+    /* Destination and stream size */
+    h_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Preview host / port", &h_box, GTK_ALIGN_END, 20, 0);
+    net_entry(&p_ui->net_host, "net_host", NET_HOST, 40, h_box);
+    gtk_entry_set_width_chars(GTK_ENTRY (p_ui->net_host), 15);
+    gtk_widget_set_tooltip_text (p_ui->net_host, "RTP is sent to this host (TCP listens on all addresses)");
+    net_entry(&p_ui->net_port, "net_port", NET_PORT, 5, h_box);
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), h_box, FALSE, FALSE, 0);
+
+    h_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+    pref_label_2("Preview width / fps / kbit/s", &h_box, GTK_ALIGN_END, 20, 0);
+    net_entry(&p_ui->net_width, "net_width", NET_WIDTH, 4, h_box);
+    net_entry(&p_ui->net_fps, "net_fps", NET_FPS, 3, h_box);
+    net_entry(&p_ui->net_kbps, "net_kbps", NET_KBPS, 5, h_box);
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), h_box, FALSE, FALSE, 0);
+
+    return;
+}
+
+
+/* Network preview entry field */
+
+void net_entry(GtkWidget **entry, char *nm, char *key, int len, GtkWidget *h_box)
+{
+    char *p;
+
+    *entry = gtk_entry_new();
+    gtk_widget_set_name(*entry, nm);
+    gtk_widget_set_halign(GTK_WIDGET (*entry), GTK_ALIGN_START);
+    gtk_entry_set_max_length(GTK_ENTRY (*entry), len);
+    gtk_entry_set_width_chars(GTK_ENTRY (*entry), len);
+    gtk_box_pack_start (GTK_BOX (h_box), *entry, FALSE, FALSE, 3);
+
+    get_user_pref(key, &p);
+    gtk_entry_set_text(GTK_ENTRY (*entry), (p != NULL) ? p : "");
+
     return;
 }
 
@@ -689,6 +893,35 @@ void meta_data_file(PrefUi *p_ui)
 }
 
 
+/* Write a per frame timestamps file for capture and snapshot */
+
+void frame_times_file(PrefUi *p_ui)
+{  
+    int i;
+    char *p;
+
+    /* Put in horizontal box */
+    p_ui->ftm_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
+
+    /* Label */
+    pref_label_2("Write a Frame Timestamps file", &p_ui->ftm_hbox, GTK_ALIGN_END, 20, 0);
+
+    /* Set up current preference */
+    get_user_pref(FRAME_TIMES, &p);
+
+    i = FALSE;
+
+    if (p != NULL)
+    	if (atoi(p) == 1)
+	    i = TRUE;
+
+    pref_boolean("Off", "On", i, &p_ui->ftm_hbox);
+    gtk_box_pack_start (GTK_BOX (p_ui->pref_cntr), p_ui->ftm_hbox, FALSE, FALSE, 0);
+
+    return;
+}
+
+
 /* Create a label */
 
 void pref_label_1(char *title, GtkWidget **cntr, GtkAlign align, int top)
@@ -1294,6 +1527,48 @@ void set_default_prefs()
     if (p == NULL)
 	init_metadata_prefs();
 
+    /* Display while capturing */
+    get_user_pref(VIEW_CAPT_FPS, &p);
+
+    if (p == NULL)
+	init_view_capt_prefs();
+
+    /* Frame timestamps */
+    get_user_pref(FRAME_TIMES, &p);
+
+    if (p == NULL)
+	init_frame_times_prefs();
+
+    /* Direct disk writes */
+    get_user_pref(DIRECT_IO, &p);
+
+    if (p == NULL)
+	init_direct_io_prefs();
+
+    /* Capture RAM buffer */
+    get_user_pref(RAM_BUDGET, &p);
+
+    if (p == NULL)
+	init_ram_budget_prefs();
+
+    /* Processing stages */
+    get_user_pref(PROC_STAGES, &p);
+
+    if (p == NULL)
+	init_proc_stages_prefs();
+
+    /* Shared memory frame output */
+    get_user_pref(SHM_OUT, &p);
+
+    if (p == NULL)
+	init_shm_out_prefs();
+
+    /* Network preview */
+    get_user_pref(NET_OUT, &p);
+
+    if (p == NULL)
+	init_net_out_prefs();
+
     /* Initial codec property defaults */
     init_codec_prop_prefs();
 
@@ -1404,6 +1679,85 @@ void init_metadata_prefs()
 }
 
 
+/* Default display while capturing - 10 fps, scaled to the window */
+
+void init_view_capt_prefs()
+{
+    add_user_pref(VIEW_CAPT_FPS, "10");
+    add_user_pref(VIEW_CAPT_SCALE, "1");
+
+    return;
+}
+
+
+/* Default frame timestamps file - off */
+
+void init_frame_times_prefs()
+{
+    add_user_pref(FRAME_TIMES, "0");
+
+    return;
+}
+
+
+/* Default direct disk writes for capture files - on */
+
+void init_direct_io_prefs()
+{
+    add_user_pref(DIRECT_IO, "1");
+
+    return;
+}
+
+
+/* Default capture RAM buffer - none */
+
+void init_ram_budget_prefs()
+{
+    add_user_pref(RAM_BUDGET, "0");
+
+    return;
+}
+
+
+/* Default processing stages - none */
+
+void init_proc_stages_prefs()
+{
+    add_user_pref(PROC_STAGES, "");
+    add_user_pref(VIEW_STAGES, "");
+
+    return;
+}
+
+
+/* Default shared memory frame output - off */
+
+void init_shm_out_prefs()
+{
+    add_user_pref(SHM_OUT, "0");
+
+    return;
+}
+
+
+/* Default network preview - off, H264 RTP to this computer, 640 wide at 10 fps */
+
+void init_net_out_prefs()
+{
+    add_user_pref(NET_OUT, "0");
+    add_user_pref(NET_MJPEG, "0");
+    add_user_pref(NET_TCP, "0");
+    add_user_pref(NET_HOST, "127.0.0.1");
+    add_user_pref(NET_PORT, "5000");
+    add_user_pref(NET_WIDTH, "640");
+    add_user_pref(NET_FPS, "10");
+    add_user_pref(NET_KBPS, "1000");
+
+    return;
+}
+
+
 /* Update all user preferences */
 
 void set_user_prefs(PrefUi *p_ui)
@@ -1486,6 +1840,61 @@ void set_user_prefs(PrefUi *p_ui)
     s[1] = '\0';
     set_user_pref(META_DATA, s);
 
+    /* Display while capturing */
+    set_user_pref(VIEW_CAPT_FPS, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->view_fps)));
+
+    cc = find_active_by_parent(p_ui->vscale_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    set_user_pref(VIEW_CAPT_SCALE, s);
+
+    /* Frame timestamps */
+    cc = find_active_by_parent(p_ui->ftm_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    set_user_pref(FRAME_TIMES, s);
+
+    /* Direct disk writes */
+    cc = find_active_by_parent(p_ui->dio_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    set_user_pref(DIRECT_IO, s);
+
+    /* Capture RAM buffer */
+    set_user_pref(RAM_BUDGET, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->ram_budget)));
+
+    /* Processing stages */
+    set_user_pref(PROC_STAGES, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->proc_stages)));
+    set_user_pref(VIEW_STAGES, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->view_stages)));
+
+    /* Shared memory frame output */
+    cc = find_active_by_parent(p_ui->shm_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    set_user_pref(SHM_OUT, s);
+
+    /* Network preview */
+    cc = find_active_by_parent(p_ui->net_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    set_user_pref(NET_OUT, s);
+
+    cc = find_active_by_parent(p_ui->net_codec_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    set_user_pref(NET_MJPEG, s);
+
+    cc = find_active_by_parent(p_ui->net_tcp_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    set_user_pref(NET_TCP, s);
+
+    set_user_pref(NET_HOST, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_host)));
+    set_user_pref(NET_PORT, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_port)));
+    set_user_pref(NET_WIDTH, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_width)));
+    set_user_pref(NET_FPS, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_fps)));
+    set_user_pref(NET_KBPS, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_kbps)));
+
     return;
 }
 
@@ -1829,6 +2238,89 @@ int pref_save_reqd(PrefUi *p_ui)
     if (pref_changed(META_DATA, s))
     	return TRUE;
 
+    /* Display while capturing */
+    if (pref_changed(VIEW_CAPT_FPS, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->view_fps))))
+    	return TRUE;
+
+    cc = find_active_by_parent(p_ui->vscale_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    
+    if (pref_changed(VIEW_CAPT_SCALE, s))
+    	return TRUE;
+
+    /* Frame timestamps */
+    cc = find_active_by_parent(p_ui->ftm_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    
+    if (pref_changed(FRAME_TIMES, s))
+    	return TRUE;
+
+    /* Direct disk writes */
+    cc = find_active_by_parent(p_ui->dio_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    
+    if (pref_changed(DIRECT_IO, s))
+    	return TRUE;
+
+    /* Capture RAM buffer */
+    if (pref_changed(RAM_BUDGET, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->ram_budget))))
+    	return TRUE;
+
+    /* Processing stages */
+    if (pref_changed(PROC_STAGES, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->proc_stages))))
+    	return TRUE;
+
+    if (pref_changed(VIEW_STAGES, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->view_stages))))
+    	return TRUE;
+
+    /* Shared memory frame output */
+    cc = find_active_by_parent(p_ui->shm_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    
+    if (pref_changed(SHM_OUT, s))
+    	return TRUE;
+
+    /* Network preview */
+    cc = find_active_by_parent(p_ui->net_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    
+    if (pref_changed(NET_OUT, s))
+    	return TRUE;
+
+    cc = find_active_by_parent(p_ui->net_codec_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    
+    if (pref_changed(NET_MJPEG, s))
+    	return TRUE;
+
+    cc = find_active_by_parent(p_ui->net_tcp_hbox, 'b');
+    s[0] = cc;
+    s[1] = '\0';
+    
+    if (pref_changed(NET_TCP, s))
+    	return TRUE;
+
+    if (pref_changed(NET_HOST, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_host))))
+    	return TRUE;
+
+    if (pref_changed(NET_PORT, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_port))))
+    	return TRUE;
+
+    if (pref_changed(NET_WIDTH, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_width))))
+    	return TRUE;
+
+    if (pref_changed(NET_FPS, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_fps))))
+    	return TRUE;
+
+    if (pref_changed(NET_KBPS, (char *) gtk_entry_get_text(GTK_ENTRY (p_ui->net_kbps))))
+    	return TRUE;
+
     return FALSE;
 }
 
@@ -1873,6 +2365,39 @@ int validate_pref(PrefUi *p_ui)
     if (val_str2numb((char *) s, &i, "Duration", p_ui->window) == FALSE)
 	return FALSE;
 
+    /* Display rate must be numeric */
+    s = gtk_entry_get_text (GTK_ENTRY (p_ui->view_fps));
+
+    if (val_str2numb((char *) s, &i, "Display fps", p_ui->window) == FALSE)
+	return FALSE;
+
+    /* RAM buffer must be numeric */
+    s = gtk_entry_get_text (GTK_ENTRY (p_ui->ram_budget));
+
+    if (val_str2numb((char *) s, &i, "Capture RAM buffer", p_ui->window) == FALSE)
+	return FALSE;
+
+    /* Network preview settings must be numeric */
+    s = gtk_entry_get_text (GTK_ENTRY (p_ui->net_port));
+
+    if (val_str2numb((char *) s, &i, "Preview port", p_ui->window) == FALSE)
+	return FALSE;
+
+    s = gtk_entry_get_text (GTK_ENTRY (p_ui->net_width));
+
+    if (val_str2numb((char *) s, &i, "Preview width", p_ui->window) == FALSE)
+	return FALSE;
+
+    s = gtk_entry_get_text (GTK_ENTRY (p_ui->net_fps));
+
+    if (val_str2numb((char *) s, &i, "Preview fps", p_ui->window) == FALSE)
+	return FALSE;
+
+    s = gtk_entry_get_text (GTK_ENTRY (p_ui->net_kbps));
+
+    if (val_str2numb((char *) s, &i, "Preview kbit/s", p_ui->window) == FALSE)
+	return FALSE;
+
     return TRUE;
 }
 
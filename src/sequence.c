@@ -0,0 +1,649 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+/*
+** Description:	Capture sequences - several captures run back to back from a plan file
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Sequence belongs to one camera (others may be capturing)
+**	19-Oct-2026	No prompts for a sequence started from the control socket
+**	19-Oct-2026	Benchmark check without a prompt from the control socket
+**	19-Oct-2026	Control key buffers sized for every control id
+**
+*/
+
+/*
+    A sequence file has one step per line (or steps separated by ';'). Each step is a comma
+    separated list of items and must have a frame or seconds limit. '#' starts a comment.
+
+	# Jupiter run
+	title Jupiter, gain 40, exposure 200, 2000 frames
+	gain 60, 1000 frames
+	20 darks
+	20 flats, noprompt
+
+    Items:
+	<n> frames | secs		Capture limit
+	<n> darks | flats | lights	Frame limit and frame type (darks and flats are added to the title)
+	title <text>			Object title for the file name (this and later steps)
+	noprompt			Do not ask before a dark or flat step (required from the control socket)
+	<control name> <value>		Camera control ('_' may be used for spaces)
+
+    The camera is not stopped between steps. At the end of a step the capture branch alone is
+    ended, the controls for the next step are set together and the next file is started on the
+    running pipeline (see capt_next_file). The codec, format, size and rate are those in use
+    when the sequence is started.
+*/
+
+
+/* Defines */
+
+#define SEQ_MAX_STEPS 100
+#define SEQ_MAX_CTRLS 16
+#define SEQ_MAX_WORDS 10
+#define SEQ_LINE_SZ 512
+
+
+/* Includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <linux/videodev2.h>
+#include <main.h>
+#include <cam.h>
+#include <defs.h>
+
+
+/* Structures and Typedefs required */
+
+typedef struct _seq_step
+{
+    int line_no;
+    int frames;
+    int secs;
+    char type;							// 'L'ight, 'D'ark, 'F'lat
+    int prompt;
+    char title[100];						// From the file (this or an earlier step)
+    int n_ctrls;
+    struct v4l2_queryctrl *qctrl[SEQ_MAX_CTRLS];
+    long val[SEQ_MAX_CTRLS];
+} seq_step_t;
+
+typedef struct _capt_seq
+{
+    seq_step_t step[SEQ_MAX_STEPS];
+    int n;
+    int cur;
+    int pending;						// Step limit reached, waiting for the file
+    int stopped;						// Next step could not be started
+    char base_title[100];					// Title entry before the sequence
+    CamData *cam_data;						// Camera running the sequence
+} capt_seq_t;
+
+
+/* Prototypes */
+
+int seq_run(char *, CamData *, MainUi *, char *, int, int);
+int seq_load(char *, CamData *, char *, int);
+static int seq_parse_step(char *, int, CamData *, seq_step_t *, char *, char *, int);
+static int seq_parse_item(char *, CamData *, seq_step_t *, char *, char *, int);
+static struct v4l2_queryctrl * seq_find_ctrl(CamData *, char *);
+static int seq_numb(char *, long *);
+static char * seq_trim(char *);
+int seq_start(CamData *, MainUi *, int);
+static int seq_step_prep(CamData *, MainUi *, seq_step_t *);
+static int seq_apply_ctrls(CamData *, MainUi *, seq_step_t *);
+int seq_step_end(CamData *, MainUi *);
+void seq_next_step(CamData *, MainUi *);
+void seq_capture_end(CamData *, MainUi *);
+char * seq_info();
+
+extern void log_msg(char*, char*, char*, GtkWidget*);
+extern int set_session(char*, char*);
+extern void set_scale_val(GtkWidget *, char *, long);
+extern int set_cam_ctrls(camera_t *, struct v4l2_queryctrl **, long *, int, GtkWidget *);
+extern gint query_dialog(GtkWidget *, char *, char *);
+extern int gst_capture(CamData *, MainUi *, int, int, int);
+extern int capt_seg_hot(CamData *);
+extern void capt_close_file(CamData *);
+extern int capt_next_file(CamData *, MainUi *, int, int);
+extern int set_eos(MainUi *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-sequence.c ";
+static capt_seq_t *seq = NULL;
+static char seq_info_txt[40];
+
+
+/* Load a sequence file and start it (menu and control socket - no dark / flat prompts there) */
+
+int seq_run(char *fn, CamData *cam_data, MainUi *m_ui, char *err, int err_sz, int interactive)
+{
+    int i;
+
+    if (seq != NULL)
+    {
+	snprintf(err, err_sz, "A sequence is already running");
+	return FALSE;
+    }
+
+    if (cam_data->pipeline == NULL || cam_data->mode != CAM_MODE_VIEW)
+    {
+	snprintf(err, err_sz, "The camera is busy");
+	return FALSE;
+    }
+
+    if (seq_load(fn, cam_data, err, err_sz) == FALSE)
+    	return FALSE;
+
+    /* A prompt would hold up the main loop with nobody to answer it */
+    for(i = 0; i < seq->n && interactive == FALSE; i++)
+    {
+    	if (seq->step[i].prompt == TRUE && seq->step[i].type != 'L')
+	{
+	    snprintf(err, err_sz, "Line %d: darks and flats need 'noprompt' when not run from the menu",
+		     seq->step[i].line_no);
+	    free(seq);
+	    seq = NULL;
+	    return FALSE;
+	}
+    }
+
+    if (seq_start(cam_data, m_ui, interactive) == FALSE)
+    {
+	snprintf(err, err_sz, "Sequence stopped at step 1 (see log)");
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Read and check the sequence file */
+
+int seq_load(char *fn, CamData *cam_data, char *err, int err_sz)
+{
+    FILE *fd;
+    char line[SEQ_LINE_SZ];
+    char title[100];
+    char *p, *s, *save;
+    int line_no;
+
+    s = NULL;
+
+    if ((fd = fopen(fn, "r")) == NULL)
+    {
+	snprintf(err, err_sz, "Failed to open %s", fn);
+	return FALSE;
+    }
+
+    seq = (capt_seq_t *) calloc(1, sizeof(capt_seq_t));
+    title[0] = '\0';
+    line_no = 0;
+
+    while(fgets(line, sizeof(line), fd) != NULL)
+    {
+    	line_no++;
+
+	if ((p = strchr(line, '#')) != NULL)
+	    *p = '\0';
+
+	/* Steps on the line */
+	for(s = strtok_r(line, ";\n", &save); s != NULL; s = strtok_r(NULL, ";\n", &save))
+	{
+	    if (*seq_trim(s) == '\0')
+	    	continue;
+
+	    if (seq->n >= SEQ_MAX_STEPS)
+	    {
+		snprintf(err, err_sz, "Line %d: more than %d steps", line_no, SEQ_MAX_STEPS);
+		break;
+	    }
+
+	    if (seq_parse_step(s, line_no, cam_data, &(seq->step[seq->n]), title, err, err_sz) == FALSE)
+	    	break;
+
+	    seq->n++;
+	    err[0] = '\0';
+	}
+
+	if (s != NULL)
+	    break;
+    }
+
+    fclose(fd);
+
+    if (s == NULL && seq->n == 0)
+	snprintf(err, err_sz, "No steps found in %s", fn);
+
+    if (s != NULL || seq->n == 0)
+    {
+	free(seq);
+	seq = NULL;
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/* Parse the items for a step (the title carries on to later steps) */
+
+static int seq_parse_step(char *s, int line_no, CamData *cam_data, seq_step_t *step, char *title, char *err, int err_sz)
+{
+    char *item, *save;
+    char item_err[100];
+
+    memset(step, 0, sizeof(seq_step_t));
+    step->line_no = line_no;
+    step->type = 'L';
+    step->prompt = TRUE;
+
+    for(item = strtok_r(s, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save))
+    {
+	if (*(item = seq_trim(item)) == '\0')
+	    continue;
+
+	if (seq_parse_item(item, cam_data, step, title, item_err, sizeof(item_err)) == FALSE)
+	{
+	    snprintf(err, err_sz, "Line %d: %s", line_no, item_err);
+	    return FALSE;
+	}
+    }
+
+    if (step->frames <= 0 && step->secs <= 0)
+    {
+	snprintf(err, err_sz, "Line %d: a frame or seconds limit is required", line_no);
+	return FALSE;
+    }
+
+    snprintf(step->title, sizeof(step->title), "%s", title);
+
+    return TRUE;
+}
+
+
+/* Parse a single item - a limit, title, option or control setting */
+
+static int seq_parse_item(char *item, CamData *cam_data, seq_step_t *step, char *title, char *err, int err_sz)
+{
+    char *word[SEQ_MAX_WORDS];
+    char words[100], nm[100];
+    char *p, *save;
+    struct v4l2_queryctrl *qctrl;
+    long n;
+    int i, nw;
+
+    /* Title is the remainder of the item */
+    if (strncasecmp(item, "title", 5) == 0 && (item[5] == '\0' || isspace(item[5])))
+    {
+	snprintf(title, 100, "%s", seq_trim(item + 5));
+	return TRUE;
+    }
+
+    /* Split into words */
+    snprintf(words, sizeof(words), "%s", item);
+    nw = 0;
+
+    for(p = strtok_r(words, " \t", &save); p != NULL && nw < SEQ_MAX_WORDS; p = strtok_r(NULL, " \t", &save))
+	word[nw++] = p;
+
+    if (nw == 1 && strcasecmp(word[0], "noprompt") == 0)
+    {
+	step->prompt = FALSE;
+	return TRUE;
+    }
+
+    /* Limit - <n> <unit> */
+    if (nw == 2 && seq_numb(word[0], &n) == TRUE)
+    {
+	if (n <= 0)
+	{
+	    snprintf(err, err_sz, "'%s' must be more than zero", item);
+	    return FALSE;
+	}
+
+	p = word[1];
+
+	if (strcasecmp(p, "secs") == 0 || strcasecmp(p, "sec") == 0 || strcasecmp(p, "seconds") == 0)
+	{
+	    step->secs = (int) n;
+	    step->frames = 0;
+	    return TRUE;
+	}
+
+	step->frames = (int) n;
+	step->secs = 0;
+
+	if (strcasecmp(p, "frames") == 0 || strcasecmp(p, "frame") == 0)
+	    return TRUE;
+
+	if (strcasecmp(p, "lights") == 0 || strcasecmp(p, "light") == 0)
+	    step->type = 'L';
+	else if (strcasecmp(p, "darks") == 0 || strcasecmp(p, "dark") == 0)
+	    step->type = 'D';
+	else if (strcasecmp(p, "flats") == 0 || strcasecmp(p, "flat") == 0)
+	    step->type = 'F';
+	else
+	{
+	    snprintf(err, err_sz, "'%s' is not recognised", item);
+	    return FALSE;
+	}
+
+	return TRUE;
+    }
+
+    /* Control - <name ...> <value> */
+    if (nw < 2 || seq_numb(word[nw - 1], &n) == FALSE)
+    {
+	snprintf(err, err_sz, "'%s' is not recognised", item);
+	return FALSE;
+    }
+
+    snprintf(nm, sizeof(nm), "%s", word[0]);
+
+    for(i = 1; i < nw - 1; i++)
+    {
+	strncat(nm, " ", sizeof(nm) - strlen(nm) - 1);
+	strncat(nm, word[i], sizeof(nm) - strlen(nm) - 1);
+    }
+
+    if ((qctrl = seq_find_ctrl(cam_data, nm)) == NULL)
+    {
+	snprintf(err, err_sz, "Control '%s' not found", nm);
+	return FALSE;
+    }
+
+    if (n < qctrl->minimum || n > qctrl->maximum)
+    {
+	snprintf(err, err_sz, "%s value out of range (%d to %d)", qctrl->name, qctrl->minimum, qctrl->maximum);
+	return FALSE;
+    }
+
+    /* A repeated control replaces the earlier value */
+    for(i = 0; i < step->n_ctrls; i++)
+    {
+	if (step->qctrl[i] == qctrl)
+	    break;
+    }
+
+    if (i >= SEQ_MAX_CTRLS)
+    {
+	snprintf(err, err_sz, "More than %d controls", SEQ_MAX_CTRLS);
+	return FALSE;
+    }
+
+    step->qctrl[i] = qctrl;
+    step->val[i] = n;
+
+    if (i == step->n_ctrls)
+	step->n_ctrls++;
+
+    return TRUE;
+}
+
+
+/* Find a camera control by name (case and '_' for space are ignored) */
+
+static struct v4l2_queryctrl * seq_find_ctrl(CamData *cam_data, char *nm)
+{
+    struct v4l2_list *p;
+    struct v4l2_queryctrl *qctrl;
+    char s[100];
+    int i;
+
+    if (cam_data->cam == NULL)
+    	return NULL;
+
+    snprintf(s, sizeof(s), "%s", nm);
+
+    for(i = 0; s[i] != '\0'; i++)
+    {
+    	if (s[i] == '_')
+	    s[i] = ' ';
+    }
+
+    for(i = 0; i < 2; i++)
+    {
+	for(p = (i == 0) ? cam_data->cam->ctl_head : cam_data->cam->pctl_head; p != NULL; p = p->next)
+	{
+	    qctrl = (struct v4l2_queryctrl *) p->v4l2_data;
+
+	    if (g_ascii_strcasecmp(s, (char *) qctrl->name) == 0)
+		return qctrl;
+	}
+    }
+
+    return NULL;
+}
+
+
+/* Whole string must be a number */
+
+static int seq_numb(char *s, long *n)
+{
+    char *end;
+
+    *n = strtol(s, &end, 10);
+
+    return (end != s && *end == '\0');
+}
+
+
+/* Trim leading and trailing white space in place */
+
+static char * seq_trim(char *s)
+{
+    char *e;
+
+    while(isspace(*s))
+    	s++;
+
+    e = s + strlen(s);
+
+    while(e > s && isspace(*(e - 1)))
+    	*(--e) = '\0';
+
+    return s;
+}
+
+
+/* Start the first step (the camera is in view mode) */
+
+int seq_start(CamData *cam_data, MainUi *m_ui, int interactive)
+{
+    seq_step_t *step;
+
+    snprintf(seq->base_title, sizeof(seq->base_title), "%s", gtk_entry_get_text (GTK_ENTRY (m_ui->obj_title)));
+    seq->cur = 0;
+    seq->pending = FALSE;
+    seq->stopped = FALSE;
+    seq->cam_data = cam_data;
+    step = &(seq->step[0]);
+
+    if (seq_step_prep(cam_data, m_ui, step) == FALSE ||
+	gst_capture(cam_data, m_ui, step->secs, step->frames, interactive) == FALSE)
+    {
+	gtk_entry_set_text (GTK_ENTRY (m_ui->obj_title), seq->base_title);
+	free(seq);
+	seq = NULL;
+	return FALSE;
+    }
+
+    /* Keep the camera running for the later steps */
+    if (seq->n > 1)
+	capt_seg_hot(cam_data);
+
+    return TRUE;
+}
+
+
+/* Prepare for a step - check for a change of frame type, set the controls and title */
+
+static int seq_step_prep(CamData *cam_data, MainUi *m_ui, seq_step_t *step)
+{
+    char s[100];
+    char *title;
+
+    if (step->prompt == TRUE && step->type != 'L' &&
+	(seq->cur == 0 || seq->step[seq->cur - 1].type != step->type))
+    {
+	snprintf(s, sizeof(s), "Step %d of %d: ready for %s?", seq->cur + 1, seq->n,
+		 (step->type == 'D') ? "darks" : "flats");
+
+	if (query_dialog(m_ui->window, "%s", s) == GTK_RESPONSE_NO)
+	    return FALSE;
+    }
+
+    if (seq_apply_ctrls(cam_data, m_ui, step) == FALSE)
+    	return FALSE;
+
+    /* Title (darks and flats are kept apart by name) */
+    title = (step->title[0] != '\0') ? step->title : seq->base_title;
+
+    if (step->type == 'D')
+	snprintf(s, sizeof(s), "%s%sdark", title, (*title) ? "_" : "");
+    else if (step->type == 'F')
+	snprintf(s, sizeof(s), "%s%sflat", title, (*title) ? "_" : "");
+    else
+	snprintf(s, sizeof(s), "%s", title);
+
+    gtk_entry_set_text (GTK_ENTRY (m_ui->obj_title), s);
+
+    snprintf(seq_info_txt, sizeof(seq_info_txt), "  [step %d of %d]", seq->cur + 1, seq->n);
+
+    return TRUE;
+}
+
+
+/* Set the step controls together, keep for the session and show on the control panel */
+
+static int seq_apply_ctrls(CamData *cam_data, MainUi *m_ui, seq_step_t *step)
+{
+    char ctl_key[CTL_KEY_SZ], s[25];
+    int i;
+
+    if (step->n_ctrls == 0)
+    	return TRUE;
+
+    if (set_cam_ctrls(cam_data->cam, step->qctrl, step->val, step->n_ctrls, m_ui->window) == FALSE)
+    	return FALSE;
+
+    for(i = 0; i < step->n_ctrls; i++)
+    {
+	snprintf(ctl_key, sizeof(ctl_key), "ctl-%d", step->qctrl[i]->id - V4L2_CID_BASE);
+	snprintf(s, sizeof(s), "%ld", step->val[i]);
+	set_session(ctl_key, s);
+	set_scale_val(m_ui->cntl_grid, ctl_key, step->val[i]);
+    }
+
+    return TRUE;
+}
+
+
+// The step limit has been reached (capture progress). If there is another step the capture
+// continues and the next file is started once the current one is complete.
+
+int seq_step_end(CamData *cam_data, MainUi *m_ui)
+{
+    if (seq == NULL || seq->cam_data != cam_data || seq->cur + 1 >= seq->n)
+    	return FALSE;
+
+    if (cam_data->u.v_capt.seg_hot == FALSE)
+    	return FALSE;
+
+    seq->pending = TRUE;
+
+    return TRUE;
+}
+
+
+/* The step file is complete - start the next step on the running pipeline */
+
+void seq_next_step(CamData *cam_data, MainUi *m_ui)
+{
+    seq_step_t *step;
+
+    if (seq == NULL || seq->cam_data != cam_data || seq->pending == FALSE)
+    	return;
+
+    seq->pending = FALSE;
+    capt_close_file(cam_data);					// Before the title changes
+
+    seq->cur++;
+    step = &(seq->step[seq->cur]);
+
+    if (seq_step_prep(cam_data, m_ui, step) == FALSE ||
+	capt_next_file(cam_data, m_ui, step->secs, step->frames) == FALSE)
+    {
+	seq->stopped = TRUE;
+	set_eos(m_ui);
+    }
+
+    return;
+}
+
+
+/* Capture has stopped (end of the last step or stopped by the user) */
+
+void seq_capture_end(CamData *cam_data, MainUi *m_ui)
+{
+    char s[100];
+
+    if (seq == NULL || seq->cam_data != cam_data)
+    	return;
+
+    if (seq->cur + 1 >= seq->n && seq->pending == FALSE && seq->stopped == FALSE)
+	snprintf(s, sizeof(s), "Capture sequence complete (%d steps)", seq->n);
+    else
+	snprintf(s, sizeof(s), "Capture sequence stopped (step %d of %d)", seq->cur + 1, seq->n);
+
+    gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
+    gtk_entry_set_text (GTK_ENTRY (m_ui->obj_title), seq->base_title);
+
+    free(seq);
+    seq = NULL;
+    seq_info_txt[0] = '\0';
+
+    return;
+}
+
+
+/* Step information for the capture status line (empty if no sequence) */
+
+char * seq_info()
+{
+    if (seq == NULL)
+    	seq_info_txt[0] = '\0';
+
+    return seq_info_txt;
+}
@@ -26,6 +26,13 @@
 **
 ** History
 **	15-Jul-2014	Initial code
+**	19-Oct-2026	Driver frame drop detection from sequence numbers and timestamps
+**	19-Oct-2026	Per frame timestamps file
+**	19-Oct-2026	Snapshots from the running pipeline (view and recording continue)
+**	19-Oct-2026	Live snapshot frames staged in a preallocated RAM ring
+**	19-Oct-2026	Live snapshot state per camera (several cameras at once)
+**	19-Oct-2026	Snapshot control returns TRUE or FALSE
+**	19-Oct-2026	Snapshot thread kept to the main camera
 **
 */
 
@@ -53,6 +60,8 @@
 #include <fitsio.h>
 #include <cairo/cairo.h>
 #include <pthread.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
 #include <main.h>
 #include <cam.h>
 #include <preferences.h>
@@ -64,6 +73,10 @@
 
 /* Defines */
 
+#define LIVE_SNAP_WAIT 5					// Secs (plus any delay) to wait for a frame
+#define LIVE_SNAP_CONVERT 5					// Secs to allow for a conversion
+#define LIVE_SNAP_SLOTS 4096					// Most frames held in the RAM ring
+
 /* Structures and Typedefs required */
 
 struct buffer
@@ -86,6 +99,52 @@ typedef struct SnapArgs
 enum { SN_FAIL, SN_SUCCESS, SN_CANCEL, SN_IN_PROGRESS, SN_DONE };
 
 
+/* A frame copied from the running pipeline */
+
+typedef struct _live_frame
+{
+    GstSample *sample;
+    guint64 ts_ns;						// Monotonic
+} live_frame_t;
+
+
+/* Snapshots from the running pipeline - the capture union may be in use for a recording */
+
+typedef struct _live_slot
+{
+    struct _live_snap *ls;
+    guint idx;
+} live_slot_t;
+
+typedef struct _live_snap
+{
+    CamData *cam_data;
+    MainUi *m_ui;
+    snap_capt_t capt;
+    char *obj_title;
+    char tm_stmp[50];
+    GAsyncQueue *frames;
+    pthread_t tid;
+    gint busy;
+    gint remaining;						// Frames still wanted (probe)
+    gint done;							// Images written
+    gint status;
+    int64_t due_msecs;						// Probe only
+    int grp_cnt;						// Probe only
+    guchar *ram;						// Frame slots (RAM budget)
+    gsize ram_sz;
+    int ram_locked;
+    gsize slot_sz;
+    guint n_slots;
+    live_slot_t *slots;
+    GAsyncQueue *free_slots;					// Slots not in use
+    gint use_ram;
+    gint skipped;						// Ring full - frames passed over
+    gint cancel;
+    guint loop_id;						// Status timer
+} live_snap_t;
+
+
 /* Prototypes */
 int snap_control(CamData *, MainUi *, int, int, int);
 void snap_status(CamData *, MainUi *);
@@ -116,6 +175,22 @@ void img_row(unsigned char *, unsigned char *, int);
 void snap_final(CamData *, MainUi *);
 void show_buffer(int, snap_capt_t *, MainUi *, CamData *);
 int check_cancel(int *, CamData *, MainUi *);
+guint64 buf_ts_ns(struct v4l2_buffer *);
+void snap_frame_times(snap_capt_t *, CamData *, char *);
+static live_snap_t * live_snap_get(CamData *);
+void live_snap_attach(CamData *);
+void live_snap_cancel(CamData *);
+void live_snap_free(CamData *);
+int live_snap_control(CamData *, MainUi *, int, int, int);
+static GstPadProbeReturn live_snap_probe(GstPad *, GstPadProbeInfo *, gpointer);
+void * live_snap_main(void *);
+live_frame_t * live_snap_wait(live_snap_t *);
+int live_snap_rgb(live_snap_t *, live_frame_t *, struct buffer *);
+void live_frame_free(live_frame_t *);
+gboolean live_snap_loop_fn(gpointer);
+void live_snap_ram(live_snap_t *, CamData *);
+GstBuffer * live_slot_copy(live_snap_t *, GstBuffer *, live_slot_t *);
+void live_slot_free(gpointer);
 GdkPixbufDestroyNotify destroy_px (guchar *, gpointer);
 int write_24_to_32_bpp(fitsfile *, long, long, snap_capt_t *, MainUi *);
 int write_24_to_16_bpp(fitsfile *, long, long, snap_capt_t *, MainUi *);
@@ -133,6 +208,7 @@ extern int get_user_pref(char *, char **);
 extern void get_file_name(char *, int, char *, char *, char *, char, char, char);
 extern int64_t msec_time();
 extern void set_capture_btns(MainUi *, int, int);
+extern void btn_sens(GtkWidget *, int);
 extern void printBits(size_t const, void const * const);
 extern int view_clear_pipeline(CamData *, MainUi *);
 extern void get_session(char*, char**);
@@ -140,6 +216,14 @@ extern void res_to_long(char *, long *, long *);
 extern void pxl2fourcc(pixelfmt, char *);
 extern int check_dir(char *);
 extern int write_meta_file(char, CamData *, char *);
+extern void frame_chk_init(frame_chk_t *, int);
+extern void frame_check(frame_chk_t *, gint64, guint64);
+extern void frame_chk_str(frame_chk_t *, char *, int);
+extern struct _frame_times * ftm_open(char *, char *);
+extern void ftm_add(struct _frame_times *, guint64, guint64);
+extern void ftm_close(struct _frame_times *);
+extern void * ram_alloc(size_t, int *);
+extern void ram_free(void *, size_t, int);
 
 
 /* Globals */
@@ -149,6 +233,8 @@ static const int hdr_sz = 14;
 static const int dib_sz = 40;
 unsigned char *bgr_data;
 static int ret_snap;
+
+/* Snapshot thread (main camera only - other cameras take snapshots from their running view) */
 static pthread_t snap_tid;
 static int cancel_indi;
 static pthread_mutex_t snap_mutex = PTHREAD_MUTEX_INITIALIZER;	
@@ -156,7 +242,9 @@ static pthread_mutex_t snap_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 // Control taking snapshots. Need to attach a timer function to the main (gtk) loop
 // as GTK calls from threads are not thread safe or have been deprecated.
-// Set up the snapshot basics, set the timer function and start the thread
+// Set up the snapshot basics, set the timer function and start the thread.
+// The thread uses the file level state above, so only the main camera may take this path.
+// Returns TRUE if the snapshots were started.
 
 int snap_control(CamData *cam_data, MainUi *m_ui, int snap_count, int delay, int delay_grp)
 {
@@ -164,6 +252,18 @@ int snap_control(CamData *cam_data, MainUi *m_ui, int snap_count, int delay, int
     int p_err;
     guint id;
 
+    /* Take from the running pipeline if possible (viewing and any recording continue) */
+    if (cam_data->pipeline != NULL && cam_data->gst_objs.snap_probe_id != 0)
+    {
+	return live_snap_control(cam_data, m_ui, snap_count, delay, delay_grp);
+    }
+
+    if (cam_data->inst != 0)
+    {
+	log_msg("APP0012", cam_data->current_cam_abbr, "APP0012", m_ui->window);
+	return FALSE;
+    }
+
     /* Wipe the current pipeline (free all the resources) */
     if (view_clear_pipeline(cam_data, m_ui) == FALSE)
         return FALSE;
@@ -189,7 +289,7 @@ int snap_control(CamData *cam_data, MainUi *m_ui, int snap_count, int delay, int
     	cam_data->status = SN_FAIL;
 	snap_status(cam_data, m_ui);
 	gst_view(cam_data, m_ui);
-	return p_err;
+	return FALSE;
     }
 
     /* Initiate a timer function on the main loop */
@@ -200,7 +300,7 @@ int snap_control(CamData *cam_data, MainUi *m_ui, int snap_count, int delay, int
     gtk_widget_set_sensitive (m_ui->cap_pause, FALSE);
     gtk_widget_set_sensitive (GTK_WIDGET (m_ui->cap_pause_tb), FALSE);
 
-    return p_err;
+    return TRUE;
 }
 
 
@@ -241,7 +341,8 @@ gboolean snap_main_loop_fn(gpointer user_data)
 
 void snap_status(CamData *cam_data, MainUi *m_ui)
 {
-    char s[100];
+    char s[200];
+    char fchk[80];
 
     switch (cam_data->status)
     {
@@ -254,13 +355,19 @@ void snap_status(CamData *cam_data, MainUi *m_ui)
 		    sprintf(s, "Snapshot %ld of %ld done (successful)", 
 				(cam_data->u.s_capt.snap_count + 1), cam_data->u.s_capt.snap_max);
 
+		/* Driver drops etc. if any */
+		frame_chk_str(&(cam_data->u.s_capt.fchk), fchk, sizeof(fchk));
+		strcat(s, fchk);
+
 		gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
 	    }
 
 	    break;
 
     	case SN_SUCCESS:
-	    gtk_label_set_text (GTK_LABEL (m_ui->status_info), "Snapshot successful");
+	    frame_chk_str(&(cam_data->u.s_capt.fchk), fchk, sizeof(fchk));
+	    sprintf(s, "Snapshot successful%s", fchk);
+	    gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
 	    break;
 
     	case SN_CANCEL:
@@ -287,6 +394,7 @@ void snap_status(CamData *cam_data, MainUi *m_ui)
 void cancel_snapshot(MainUi *m_ui)
 {
     cancel_indi = TRUE;
+    live_snap_cancel(g_object_get_data (G_OBJECT (m_ui->window), "cam_data"));
 
     return;
 }
@@ -317,6 +425,10 @@ void * snap_main(void *arg)
     if (! snap_image(cam_data, m_ui))
     	cam_data->status = SN_FAIL;
 
+    /* Frame timestamps file (if any) */
+    ftm_close(cam_data->u.s_capt.ftm);
+    cam_data->u.s_capt.ftm = NULL;
+
     /* Resume normal viewing */
     snap_final(cam_data, m_ui);
 
@@ -370,6 +482,11 @@ int snap_init(snap_args_t *args, CamData *cam_data, MainUi *m_ui)
     /* Object title for image file name(s) */
     capt->obj_title = args->obj_title;
 
+    /* Driver frame checks */
+    get_session(FPS, &res_str);
+    frame_chk_init(&(capt->fchk), atoi(res_str));
+    capt->ftm = NULL;
+
     /* Make sure camera is capable of capture */
     if (!(cam->vcaps.capabilities & V4L2_CAP_VIDEO_CAPTURE))
     {
@@ -805,6 +922,7 @@ int image_capture(snap_capt_t *capt, CamData *cam_data, MainUi *m_ui)
     /* Allow for a sequence of image captures */
     cam = cam_data->cam;
     dttm_stamp(tm_stmp, sizeof(tm_stmp));
+    snap_frame_times(capt, cam_data, tm_stmp);
 
     /* Set up a temporary image data area */
     capt->tmp_img_buf = (unsigned char *) malloc(capt->img_sz_bytes);
@@ -865,6 +983,9 @@ int image_capture(snap_capt_t *capt, CamData *cam_data, MainUi *m_ui)
 		return FALSE;
 	    }
 
+	    /* Driver sequence and timestamp checks */
+	    frame_check(&(capt->fchk), (gint64) capt->buf.sequence, buf_ts_ns(&(capt->buf)));
+
 	    /* Write image file if no delay or time has passed */
 	    cur_msecs = msec_time();
 
@@ -873,6 +994,7 @@ int image_capture(snap_capt_t *capt, CamData *cam_data, MainUi *m_ui)
 		if (! image_output(i, tm_stmp, capt, m_ui))
 		    return FALSE;
 
+		ftm_add(capt->ftm, (guint64) i, buf_ts_ns(&(capt->buf)));
 	    	grp_cnt++;
 
 	    	if (grp_cnt >= capt->delay_grp)
@@ -904,6 +1026,9 @@ int image_capture(snap_capt_t *capt, CamData *cam_data, MainUi *m_ui)
 		return FALSE;
 	    }
 
+	    /* No sequence with read i/o, timing checks only */
+	    frame_check(&(capt->fchk), -1, (guint64) g_get_monotonic_time() * 1000);
+
 	    /* Write image file if no delay or time has passed */
 	    cur_msecs = msec_time();
 
@@ -912,6 +1037,7 @@ int image_capture(snap_capt_t *capt, CamData *cam_data, MainUi *m_ui)
 		if (! image_output(i, tm_stmp, capt, m_ui))
 		    return FALSE;
 
+		ftm_add(capt->ftm, (guint64) i, (guint64) g_get_monotonic_time() * 1000);
 	    	grp_cnt++;
 
 	    	if (grp_cnt >= capt->delay_grp)
@@ -1672,3 +1798,680 @@ int check_cancel(int *i, CamData *cam_data, MainUi *m_ui)
 
     return TRUE;
 }
+
+
+/* Driver buffer timestamp in nanoseconds (monotonic clock if the driver did not set one) */
+
+guint64 buf_ts_ns(struct v4l2_buffer *buf)
+{
+    if (buf->timestamp.tv_sec == 0 && buf->timestamp.tv_usec == 0)
+	return (guint64) g_get_monotonic_time() * 1000;
+
+    return (guint64) buf->timestamp.tv_sec * 1000000000 + (guint64) buf->timestamp.tv_usec * 1000;
+}
+
+
+/* Open the frame timestamps file if required (named as for the image files) */
+
+void snap_frame_times(snap_capt_t *capt, CamData *cam_data, char *tm_stmp)
+{
+    char *p;
+    char fn[100];
+    char *path;
+
+    capt->ftm = NULL;
+    get_user_pref(FRAME_TIMES, &p);
+
+    if (p == NULL || *p != '1')
+    	return;
+
+    get_file_name(fn, (int) sizeof(fn), (capt->snap_max == 1) ? "000" : "xxx",
+		  (char *) capt->obj_title, tm_stmp, capt->id, capt->tt, capt->ts);
+
+    path = (char *) malloc(strlen(capt->locn) + strlen(fn) + 20);
+    sprintf(path, "%s/%s.times.csv", capt->locn, fn);
+    capt->ftm = ftm_open(path, capt->codec);
+    free(path);
+
+    return;
+}
+
+
+/* Live snapshot state for a camera (created on first use) */
+
+static live_snap_t * live_snap_get(CamData *cam_data)
+{
+    if (cam_data->live_snap == NULL)
+	cam_data->live_snap = (live_snap_t *) calloc(1, sizeof(live_snap_t));
+
+    return cam_data->live_snap;
+}
+
+
+/* Add the live snapshot probe to the running pipeline (after the caps filter) */
+
+void live_snap_attach(CamData *cam_data)
+{
+    GstPad *pad;
+
+    live_snap_get(cam_data);					// Before the probe can run
+    pad = gst_element_get_static_pad (cam_data->gst_objs.v_filter, "src");
+    cam_data->gst_objs.snap_probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+							  (GstPadProbeCallback) live_snap_probe,
+							  cam_data, NULL);
+    gst_object_unref (pad);
+
+    return;
+}
+
+
+/* Cancel any live snapshots in progress for a camera */
+
+void live_snap_cancel(CamData *cam_data)
+{
+    if (cam_data != NULL && cam_data->live_snap != NULL)
+	g_atomic_int_set (&(cam_data->live_snap->cancel), TRUE);
+
+    return;
+}
+
+
+// Release the live snapshot state of a camera that is no longer shown (the pipeline is stopped).
+// Snapshots in progress are cancelled and the status timer removed.
+
+void live_snap_free(CamData *cam_data)
+{
+    live_snap_t *ls;
+    live_frame_t *frame;
+
+    if ((ls = cam_data->live_snap) == NULL)
+    	return;
+
+    if (g_atomic_int_get (&(ls->busy)) == TRUE)
+    {
+	g_atomic_int_set (&(ls->cancel), TRUE);
+	pthread_join(ls->tid, NULL);
+	g_source_remove (ls->loop_id);
+    }
+
+    if (ls->frames != NULL)
+    {
+	while((frame = (live_frame_t *) g_async_queue_try_pop (ls->frames)) != NULL)
+	    live_frame_free(frame);
+
+	g_async_queue_unref (ls->frames);
+    }
+
+    if (ls->ram != NULL)
+    {
+	ram_free(ls->ram, ls->ram_sz, ls->ram_locked);
+	free(ls->slots);
+    }
+
+    if (ls->free_slots != NULL)
+	g_async_queue_unref (ls->free_slots);
+
+    free(ls->obj_title);
+    free(ls);
+    cam_data->live_snap = NULL;
+
+    return;
+}
+
+
+// Take snapshot(s) from the running pipeline. Preferences and delays are as for the direct
+// capture. The probe is armed with the number of frames wanted and the images are written
+// by a separate thread. A timer function on the main loop keeps the status up to date.
+
+int live_snap_control(CamData *cam_data, MainUi *m_ui, int snap_count, int delay, int delay_grp)
+{
+    live_snap_t *ls;
+    snap_capt_t *capt;
+    live_frame_t *frame;
+    int p_err;
+
+    ls = live_snap_get(cam_data);
+
+    if (g_atomic_int_get (&(ls->busy)) == TRUE)
+    {
+	sprintf(app_msg_extra, "Please wait for the current snapshot(s) to finish");
+	log_msg("CAM0017", "Snapshot in progress", "CAM0017", m_ui->window);
+    	return FALSE;
+    }
+
+    /* Preferences */
+    capt = &(ls->capt);
+    memset(capt, 0, sizeof(snap_capt_t));
+    load_prefs(capt);
+
+    if (check_dir(capt->locn) == FALSE)
+    {
+	log_msg("APP0006", capt->locn, "APP0006", m_ui->window);
+    	return FALSE;
+    }
+
+    if (snap_count <= 0)
+    	capt->snap_max = 1;
+    else
+	capt->snap_max = snap_count;
+
+    if (delay != -1)
+    	capt->delay = delay;
+
+    if (capt->delay == 0)
+	capt->delay_grp = 0;
+    else
+	capt->delay_grp = delay_grp;
+
+    /* Image data is always a single packed RGB buffer */
+    capt->io_method = 'R';
+
+    /* Object title for image file name(s) - keep a copy, the entry may change */
+    free(ls->obj_title);
+    ls->obj_title = strdup(gtk_entry_get_text (GTK_ENTRY (m_ui->obj_title)));
+    capt->obj_title = ls->obj_title;
+    dttm_stamp(ls->tm_stmp, sizeof(ls->tm_stmp));
+
+    /* Discard anything left over from a previous set */
+    if (ls->frames == NULL)
+	ls->frames = g_async_queue_new ();
+
+    while((frame = (live_frame_t *) g_async_queue_try_pop (ls->frames)) != NULL)
+	live_frame_free(frame);
+
+    /* Memory for the frame copies */
+    live_snap_ram(ls, cam_data);
+    g_atomic_int_set (&(ls->skipped), 0);
+
+    /* Possible delay (first frame) and grouping, the probe does the timing */
+    if (capt->delay > 0)
+	ls->due_msecs = msec_time() + INT64_C(capt->delay * 1000);
+    else
+    	ls->due_msecs = 0;
+
+    if (capt->delay_grp > 0)
+	ls->grp_cnt = 0;
+    else
+	ls->grp_cnt = (capt->snap_max + 1) * -1;
+
+    ls->cam_data = cam_data;
+    ls->m_ui = m_ui;
+    g_atomic_int_set (&(ls->cancel), FALSE);
+    g_atomic_int_set (&(ls->done), 0);
+    g_atomic_int_set (&(ls->status), SN_IN_PROGRESS);
+    g_atomic_int_set (&(ls->busy), TRUE);
+
+    if ((p_err = pthread_create(&(ls->tid), NULL, &live_snap_main, (void *) ls)) != 0)
+    {
+	sprintf(app_msg_extra, "Error: %s", strerror(p_err));
+	log_msg("SYS9016", NULL, "SYS9016", m_ui->window);
+	g_atomic_int_set (&(ls->busy), FALSE);
+	return FALSE;
+    }
+
+    /* Arm the probe */
+    g_atomic_int_set (&(ls->remaining), (gint) capt->snap_max);
+
+    /* Initiate a timer function on the main loop */
+    ls->loop_id = g_timeout_add (100, live_snap_loop_fn, ls);
+
+    /* Buttons - when only viewing allow cancel, a recording keeps its own buttons */
+    if (cam_data->mode == CAM_MODE_VIEW)
+    {
+	set_capture_btns(m_ui, FALSE, TRUE);
+	btn_sens (m_ui->cap_pause, FALSE);
+	btn_sens (GTK_WIDGET (m_ui->cap_pause_tb), FALSE);
+    }
+    else
+    {
+	btn_sens (m_ui->snap_ui, FALSE); 
+	btn_sens (GTK_WIDGET (m_ui->snap_tb), FALSE);
+    }
+
+    gtk_label_set_text (GTK_LABEL (m_ui->status_info), "Snapshot pending");
+
+    return TRUE;
+}
+
+
+// Probe (streaming thread) - copy a frame if one is wanted and due. Nothing else is done here
+// and the driver buffer is returned to the pool straight away.
+
+static GstPadProbeReturn live_snap_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    CamData *cam_data;
+    live_snap_t *ls;
+    GstBuffer *buf, *copy;
+    GstCaps *caps;
+    live_frame_t *frame;
+    live_slot_t *slot;
+    int64_t cur_msecs;
+
+    cam_data = (CamData *) user_data;
+    ls = cam_data->live_snap;
+
+    if (g_atomic_int_get (&(ls->remaining)) <= 0)
+	return GST_PAD_PROBE_OK;
+
+    cur_msecs = msec_time();
+
+    if (cur_msecs < ls->due_msecs)
+	return GST_PAD_PROBE_OK;
+
+    if ((caps = gst_pad_get_current_caps (pad)) == NULL)
+	return GST_PAD_PROBE_OK;
+
+    /* Copy the frame - into a free RAM slot if there is a ring (if it is full try the next frame) */
+    buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+    if (g_atomic_int_get (&(ls->use_ram)) == TRUE && gst_buffer_get_size (buf) <= ls->slot_sz)
+    {
+	if ((slot = g_async_queue_try_pop (ls->free_slots)) == NULL)
+	{
+	    g_atomic_int_inc (&(ls->skipped));
+	    gst_caps_unref (caps);
+	    return GST_PAD_PROBE_OK;
+	}
+
+	copy = live_slot_copy(ls, buf, slot);
+    }
+    else
+    {
+	copy = gst_buffer_copy_deep (buf);
+    }
+
+    frame = (live_frame_t *) malloc(sizeof(live_frame_t));
+    frame->sample = gst_sample_new (copy, caps, NULL, NULL);
+    gst_buffer_unref (copy);
+    gst_caps_unref (caps);
+
+    if (GST_BUFFER_PTS_IS_VALID (buf))
+	frame->ts_ns = GST_BUFFER_PTS (buf) + gst_element_get_base_time (cam_data->pipeline);
+    else
+	frame->ts_ns = (guint64) g_get_monotonic_time() * 1000;
+
+    g_async_queue_push (ls->frames, frame);
+
+    /* Delay after each group */
+    ls->grp_cnt++;
+
+    if (ls->grp_cnt >= ls->capt.delay_grp)
+    {
+	ls->due_msecs = cur_msecs + INT64_C(ls->capt.delay * 1000);
+	ls->grp_cnt = 0;
+    }
+
+    g_atomic_int_add (&(ls->remaining), -1);
+
+    return GST_PAD_PROBE_OK;
+}
+
+
+/* Live snapshot (thread) processing - convert and write each frame as it arrives */
+
+void * live_snap_main(void *arg)
+{
+    int i, status;
+    live_snap_t *ls;
+    live_frame_t *frame;
+    snap_capt_t *capt;
+    struct buffer img;
+
+    /* Convenience */
+    ls = (live_snap_t *) arg;
+    capt = &(ls->capt);
+    img.start = NULL;
+    img.length = 0;
+    capt->buffers = &img;
+    status = SN_SUCCESS;
+
+    snap_frame_times(capt, ls->cam_data, ls->tm_stmp);
+
+    for(i = 0; i < capt->snap_max; i++)
+    {
+	if ((frame = live_snap_wait(ls)) == NULL)
+	{
+	    status = (g_atomic_int_get (&(ls->cancel)) == TRUE) ? SN_CANCEL : SN_FAIL;
+	    break;
+	}
+
+	if (live_snap_rgb(ls, frame, &img) == FALSE ||
+	    image_output(i, ls->tm_stmp, capt, ls->m_ui) == FALSE)
+	{
+	    live_frame_free(frame);
+	    status = SN_FAIL;
+	    break;
+	}
+
+	ftm_add(capt->ftm, (guint64) i, frame->ts_ns);
+	live_frame_free(frame);
+	g_atomic_int_inc (&(ls->done));
+    }
+
+    /* Disarm the probe and discard anything not used */
+    g_atomic_int_set (&(ls->remaining), 0);
+
+    while((frame = (live_frame_t *) g_async_queue_try_pop (ls->frames)) != NULL)
+	live_frame_free(frame);
+
+    /* Clean up */
+    ftm_close(capt->ftm);
+    capt->ftm = NULL;
+    capt->buffers = NULL;
+    free(img.start);
+
+    g_atomic_int_set (&(ls->status), status);
+
+    pthread_exit(&ret_snap);
+}
+
+
+/* Wait for the next frame from the probe, allowing for cancel and any delay */
+
+live_frame_t * live_snap_wait(live_snap_t *ls)
+{
+    snap_capt_t *capt;
+    live_frame_t *frame;
+    int64_t limit_msecs;
+
+    capt = &(ls->capt);
+
+    limit_msecs = msec_time() + INT64_C((capt->delay + LIVE_SNAP_WAIT) * 1000);
+
+    while(1)
+    {
+	frame = (live_frame_t *) g_async_queue_timeout_pop (ls->frames, 100000);
+
+	if (frame != NULL)
+	    return frame;
+
+	if (g_atomic_int_get (&(ls->cancel)) == TRUE)
+	    return NULL;
+
+	if (msec_time() > limit_msecs)
+	{
+	    sprintf(app_msg_extra, "No frame received from the pipeline in %d secs", 
+	    			   capt->delay + LIVE_SNAP_WAIT);
+	    log_msg("CAM0017", "Snapshot frame", "CAM0017", ls->m_ui->window);
+	    return NULL;
+	}
+    }
+}
+
+
+// Convert a frame to packed RGB24 (the format expected by the image writers). The
+// converted rows may be padded, so they are copied row by row into the image buffer.
+
+int live_snap_rgb(live_snap_t *ls, live_frame_t *frame, struct buffer *img)
+{
+    snap_capt_t *capt;
+    GstVideoInfo vinfo;
+    GstCaps *caps;
+    GstSample *rgb;
+    GstBuffer *buf;
+    GstMapInfo map;
+    GError *err = NULL;
+    int y, row_sz, stride;
+    unsigned char *src;
+
+    capt = &(ls->capt);
+
+    if (! gst_video_info_from_caps (&vinfo, gst_sample_get_caps (frame->sample)))
+    {
+	log_msg("CAM0017", "Unknown frame format", "CAM0017", ls->m_ui->window);
+	return FALSE;
+    }
+
+    caps = gst_caps_new_simple ("video/x-raw",
+				"format", G_TYPE_STRING, "RGB",
+				"width", G_TYPE_INT, GST_VIDEO_INFO_WIDTH (&vinfo),
+				"height", G_TYPE_INT, GST_VIDEO_INFO_HEIGHT (&vinfo),
+				NULL);
+    rgb = gst_video_convert_sample (frame->sample, caps, LIVE_SNAP_CONVERT * GST_SECOND, &err);
+    gst_caps_unref (caps);
+
+    if (rgb == NULL)
+    {
+	sprintf(app_msg_extra, "%s", (err != NULL) ? err->message : "");
+	log_msg("CAM0017", "Frame conversion failed", "CAM0017", ls->m_ui->window);
+	g_clear_error (&err);
+	return FALSE;
+    }
+
+    /* Image details */
+    gst_video_info_from_caps (&vinfo, gst_sample_get_caps (rgb));
+    capt->width = GST_VIDEO_INFO_WIDTH (&vinfo);
+    capt->height = GST_VIDEO_INFO_HEIGHT (&vinfo);
+    capt->img_sz_bytes = capt->width * capt->height * 3;
+    capt->fmt.fmt.pix.width = capt->width;
+    capt->fmt.fmt.pix.height = capt->height;
+
+    if (img->length != (size_t) capt->img_sz_bytes)
+    {
+	free(img->start);
+	img->start = malloc(capt->img_sz_bytes);
+	img->length = capt->img_sz_bytes;
+    }
+
+    /* Packed rows */
+    buf = gst_sample_get_buffer (rgb);
+
+    if (! gst_buffer_map (buf, &map, GST_MAP_READ))
+    {
+	gst_sample_unref (rgb);
+	log_msg("CAM0017", "Frame could not be read", "CAM0017", ls->m_ui->window);
+	return FALSE;
+    }
+
+    row_sz = capt->width * 3;
+    stride = GST_VIDEO_INFO_PLANE_STRIDE (&vinfo, 0);
+    src = map.data + GST_VIDEO_INFO_PLANE_OFFSET (&vinfo, 0);
+
+    for(y = 0; y < capt->height; y++)
+	memcpy((unsigned char *) img->start + (y * row_sz), src + (y * stride), row_sz);
+
+    gst_buffer_unmap (buf, &map);
+    gst_sample_unref (rgb);
+
+    return TRUE;
+}
+
+
+/* Release a copied frame */
+
+void live_frame_free(live_frame_t *frame)
+{
+    gst_sample_unref (frame->sample);
+    free(frame);
+
+    return;
+}
+
+
+/* Timeout function on main loop - live snapshot status and finish */
+
+gboolean live_snap_loop_fn(gpointer user_data)
+{
+    live_snap_t *ls;
+    MainUi *m_ui;
+    CamData *cam_data;
+    char s[100];
+
+    /* Get data */
+    ls = (live_snap_t *) user_data;
+    m_ui = ls->m_ui;
+    cam_data = ls->cam_data;
+
+    switch (g_atomic_int_get (&(ls->status)))
+    {
+    	case SN_IN_PROGRESS:
+	    if (g_atomic_int_get (&(ls->done)) > 0)
+	    {
+		sprintf(s, "Snapshot %d of %ld done (successful)", 
+			   g_atomic_int_get (&(ls->done)), ls->capt.snap_max);
+
+		if (g_atomic_int_get (&(ls->use_ram)) == TRUE)
+		    sprintf(s + strlen(s), "  RAM %d%% free",
+		    	    (int) (g_async_queue_length (ls->free_slots) * 100 / (gint) ls->n_slots));
+
+		gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
+	    }
+
+	    return TRUE;
+
+    	case SN_SUCCESS:
+	    if (g_atomic_int_get (&(ls->skipped)) > 0)
+	    {
+		sprintf(s, "Snapshot successful (%d frames passed over, RAM buffer full)",
+			   g_atomic_int_get (&(ls->skipped)));
+		gtk_label_set_text (GTK_LABEL (m_ui->status_info), s);
+	    }
+	    else
+	    {
+		gtk_label_set_text (GTK_LABEL (m_ui->status_info), "Snapshot successful");
+	    }
+	    break;
+
+    	case SN_CANCEL:
+	    gtk_label_set_text (GTK_LABEL (m_ui->status_info), "Snapshot cancelled");
+	    break;
+
+	default:
+	    gtk_label_set_text (GTK_LABEL (m_ui->status_info), "Snapshot failed");
+    }
+
+    pthread_join(ls->tid, NULL);
+
+    /* Restore the buttons for the current mode */
+    if (cam_data->mode == CAM_MODE_VIEW)
+    {
+	set_capture_btns(m_ui, TRUE, FALSE);
+    }
+    else if (cam_data->mode == CAM_MODE_CAPT)
+    {
+	btn_sens (m_ui->snap_ui, TRUE); 
+	btn_sens (GTK_WIDGET (m_ui->snap_tb), TRUE);
+    }
+
+    g_atomic_int_set (&(ls->busy), FALSE);
+
+    return FALSE;
+}
+
+
+// Set up the memory for live snapshot frames. With a RAM budget the frames are copied into a
+// preallocated (locked, huge page if possible) ring of frame sized slots; a slot is returned
+// when the writer thread has finished with the frame. The ring is kept while the budget and
+// frame size are unchanged. Without a budget, or a frame size (eg. jpeg), each frame is copied.
+
+void live_snap_ram(live_snap_t *ls, CamData *cam_data)
+{
+    GstPad *pad;
+    GstCaps *caps;
+    GstVideoInfo vinfo;
+    char *p;
+    guint64 budget;
+    gsize frame_sz;
+    guint i, n;
+
+    g_atomic_int_set (&(ls->use_ram), FALSE);
+
+    get_user_pref(RAM_BUDGET, &p);
+    budget = (p != NULL && atoi(p) > 0) ? (guint64) atoi(p) * 1024 * 1024 : 0;
+
+    /* Frame size */
+    frame_sz = 0;
+    pad = gst_element_get_static_pad (cam_data->gst_objs.v_filter, "src");
+
+    if ((caps = gst_pad_get_current_caps (pad)) != NULL)
+    {
+	if (gst_video_info_from_caps (&vinfo, caps))
+	    frame_sz = (GST_VIDEO_INFO_SIZE (&vinfo) + 63) & ~((gsize) 63);
+
+	gst_caps_unref (caps);
+    }
+
+    gst_object_unref (pad);
+
+    n = (frame_sz > 0) ? (guint) MIN (budget / frame_sz, LIVE_SNAP_SLOTS) : 0;
+
+    /* Existing ring - keep it if it still fits, otherwise release it (only once all slots are back) */
+    if (ls->ram != NULL)
+    {
+	if (n == ls->n_slots && frame_sz == ls->slot_sz)
+	{
+	    g_atomic_int_set (&(ls->use_ram), TRUE);
+	    return;
+	}
+
+	if (g_async_queue_length (ls->free_slots) != (gint) ls->n_slots)
+	    return;
+
+	while(g_async_queue_try_pop (ls->free_slots) != NULL);
+
+	ram_free(ls->ram, ls->ram_sz, ls->ram_locked);
+	free(ls->slots);
+	ls->ram = NULL;
+	ls->slots = NULL;
+	ls->n_slots = 0;
+    }
+
+    if (n == 0)
+	return;
+
+    /* New ring */
+    ls->ram_sz = n * frame_sz;
+
+    if ((ls->ram = (guchar *) ram_alloc(ls->ram_sz, &(ls->ram_locked))) == NULL)
+	return;
+
+    if (ls->free_slots == NULL)
+	ls->free_slots = g_async_queue_new ();
+
+    ls->slot_sz = frame_sz;
+    ls->n_slots = n;
+    ls->slots = (live_slot_t *) malloc(n * sizeof(live_slot_t));
+
+    for(i = 0; i < n; i++)
+    {
+	ls->slots[i].ls = ls;
+	ls->slots[i].idx = i;
+	g_async_queue_push (ls->free_slots, &(ls->slots[i]));
+    }
+
+    g_atomic_int_set (&(ls->use_ram), TRUE);
+
+    return;
+}
+
+
+/* Copy a frame (probe) into a RAM slot, the slot is freed with the buffer */
+
+GstBuffer * live_slot_copy(live_snap_t *ls, GstBuffer *buf, live_slot_t *slot)
+{
+    GstBuffer *copy;
+    guchar *data;
+    gsize sz;
+
+    data = ls->ram + ((gsize) slot->idx * ls->slot_sz);
+    sz = gst_buffer_extract (buf, 0, data, ls->slot_sz);
+
+    copy = gst_buffer_new_wrapped_full (0, data, ls->slot_sz, 0, sz,
+					slot, (GDestroyNotify) live_slot_free);
+    gst_buffer_copy_into (copy, buf, GST_BUFFER_COPY_METADATA, 0, -1);
+
+    return copy;
+}
+
+
+/* Return a slot to the ring */
+
+void live_slot_free(gpointer user_data)
+{
+    live_slot_t *slot;
+
+    slot = (live_slot_t *) user_data;
+    g_async_queue_push (slot->ls->free_slots, slot);
+
+    return;
+}
@@ -0,0 +1,285 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+** Description: Pipeline statistics panel (live during capture).
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**
+*/
+
+
+/* Includes */
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <main.h>
+#include <cam.h>
+#include <defs.h>
+
+
+/* Defines */
+
+#define STATS_ROWS 8
+#define STATS_COLS 7
+#define STATS_REFRESH 1000
+
+
+/* Types */
+
+typedef struct _stats_ui
+{
+    GtkWidget *window;
+    GtkWidget *grid;
+    GtkWidget *status;
+    GtkWidget *cell[STATS_ROWS][STATS_COLS];
+    guint timer_id;
+    int close_handler;
+} StatsUi;
+
+
+/* Prototypes */
+
+int stats_ui_main(GtkWidget *);
+StatsUi * new_stats_ui();
+void stats_ui(StatsUi *);
+void stats_grid(StatsUi *);
+gboolean stats_refresh(gpointer);
+void stats_fmt_lat(double, char *, int);
+void OnStatsClose(GtkWidget *, gpointer);
+
+extern void register_window(GtkWidget *);
+extern void deregister_window(GtkWidget *);
+extern int stats_get(int, pipe_stat_t *);
+extern int stats_active();
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-stats_ui.c ";
+static const char *col_hdr[STATS_COLS] = { "Element", "FPS", "p50 ms", "p95 ms", "p99 ms", "Queue (max)", "MB/s" };
+
+
+/* Display the pipeline statistics */
+
+int stats_ui_main(GtkWidget *window)
+{
+    StatsUi *ui;
+
+    /* Initial */
+    ui = new_stats_ui();
+
+    /* Create the interface */
+    stats_ui(ui);
+    stats_refresh((gpointer) ui);
+    gtk_widget_show_all(ui->window);
+
+    /* Register the window */
+    register_window(ui->window);
+
+    /* Refresh while open */
+    ui->timer_id = g_timeout_add (STATS_REFRESH, stats_refresh, (gpointer) ui);
+
+    return TRUE;
+}
+
+
+/* Create new screen data variable */
+
+StatsUi * new_stats_ui()
+{
+    StatsUi *ui = (StatsUi *) malloc(sizeof(StatsUi));
+    memset(ui, 0, sizeof(StatsUi));
+
+    return ui;
+}
+
+
+/* Create the user interface and set the CallBacks */
+
+void stats_ui(StatsUi *s_ui)
+{
+    GtkWidget *close_btn;
+    GtkWidget *main_vbox, *btn_box;
+
+    /* Set up the UI window */
+    s_ui->window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(s_ui->window), STATS_UI);
+    gtk_container_set_border_width(GTK_CONTAINER(s_ui->window), 10);
+    g_object_set_data (G_OBJECT (s_ui->window), "ui", s_ui);
+
+    /* Main view */
+    main_vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+
+    /* Statistics grid */
+    stats_grid(s_ui);
+
+    /* Status */
+    s_ui->status = gtk_label_new("");
+    gtk_widget_set_name(s_ui->status, "lbl_8");
+    gtk_widget_set_halign(GTK_WIDGET (s_ui->status), GTK_ALIGN_START);
+
+    /* Close button */
+    btn_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 20);
+    gtk_widget_set_halign(GTK_WIDGET (btn_box), GTK_ALIGN_CENTER);
+    close_btn = gtk_button_new_with_label("  Close  ");
+    g_signal_connect(close_btn, "clicked", G_CALLBACK(OnStatsClose), (gpointer) s_ui->window);
+    gtk_box_pack_end (GTK_BOX (btn_box), close_btn, FALSE, FALSE, 0);
+
+    /* Combine everything onto the window */
+    gtk_box_pack_start (GTK_BOX (main_vbox), s_ui->grid, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (main_vbox), s_ui->status, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (main_vbox), btn_box, FALSE, FALSE, 0);
+    gtk_container_add(GTK_CONTAINER(s_ui->window), main_vbox);
+
+    /* Exit when window closed */
+    s_ui->close_handler = g_signal_connect(s_ui->window, "destroy", G_CALLBACK(OnStatsClose), s_ui->window);
+
+    return;
+}
+
+
+/* Grid of labels - a heading row and a row per statistics point */
+
+void stats_grid(StatsUi *s_ui)
+{
+    int r, c;
+    GtkWidget *label;
+
+    s_ui->grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID (s_ui->grid), 4);
+    gtk_grid_set_column_spacing(GTK_GRID (s_ui->grid), 15);
+
+    for(c = 0; c < STATS_COLS; c++)
+    {
+	label = gtk_label_new(col_hdr[c]);
+	gtk_widget_set_name(label, "lbl_6");
+	gtk_widget_set_halign(GTK_WIDGET (label), (c == 0) ? GTK_ALIGN_START : GTK_ALIGN_END);
+	gtk_grid_attach(GTK_GRID (s_ui->grid), label, c, 0, 1, 1);
+    }
+
+    for(r = 0; r < STATS_ROWS; r++)
+    {
+	for(c = 0; c < STATS_COLS; c++)
+	{
+	    s_ui->cell[r][c] = gtk_label_new("");
+	    gtk_widget_set_name(s_ui->cell[r][c], "lbl_1");
+	    gtk_widget_set_halign(GTK_WIDGET (s_ui->cell[r][c]), (c == 0) ? GTK_ALIGN_START : GTK_ALIGN_END);
+	    gtk_grid_attach(GTK_GRID (s_ui->grid), s_ui->cell[r][c], c, r + 1, 1, 1);
+	}
+    }
+
+    return;
+}
+
+
+/* Timer - update the grid from the latest statistics */
+
+gboolean stats_refresh(gpointer user_data)
+{
+    int r, c;
+    char s[STATS_COLS][30];
+    StatsUi *s_ui;
+    pipe_stat_t ps;
+
+    s_ui = (StatsUi *) user_data;
+
+    for(r = 0; r < STATS_ROWS; r++)
+    {
+	if (stats_get(r, &ps) == FALSE)
+	{
+	    memset(s, 0, sizeof(s));
+	}
+	else
+	{
+	    snprintf(s[0], sizeof(s[0]), "%s", ps.nm);
+	    snprintf(s[1], sizeof(s[1]), "%.1f", ps.fps);
+	    stats_fmt_lat(ps.lat_p50, s[2], sizeof(s[2]));
+	    stats_fmt_lat(ps.lat_p95, s[3], sizeof(s[3]));
+	    stats_fmt_lat(ps.lat_p99, s[4], sizeof(s[4]));
+
+	    if (ps.level < 0)
+		strcpy(s[5], "-");
+	    else
+		snprintf(s[5], sizeof(s[5]), "%d (%d)", ps.level, ps.level_max);
+
+	    snprintf(s[6], sizeof(s[6]), "%.2f", ps.mbps);
+	}
+
+	for(c = 0; c < STATS_COLS; c++)
+	    gtk_label_set_text (GTK_LABEL (s_ui->cell[r][c]), s[c]);
+    }
+
+    if (stats_active() == TRUE)
+	gtk_label_set_text (GTK_LABEL (s_ui->status), "Capture in progress");
+    else if (stats_get(0, &ps) == TRUE)
+	gtk_label_set_text (GTK_LABEL (s_ui->status), "Last capture (totals held, rates as at the end)");
+    else
+	gtk_label_set_text (GTK_LABEL (s_ui->status), "Statistics are collected while capturing");
+
+    return TRUE;
+}
+
+
+/* Latency text */
+
+void stats_fmt_lat(double lat, char *s, int sz)
+{
+    if (lat < 0)
+	snprintf(s, sz, "-");
+    else
+	snprintf(s, sz, "%.1f", lat);
+
+    return;
+}
+
+
+// Callback for window close
+// Stop the refresh, destroy the window and de-register the window
+
+void OnStatsClose(GtkWidget *w, gpointer user_data)
+{
+    StatsUi *s_ui;
+    GtkWidget *window;
+
+    /* Get data */
+    window = (GtkWidget *) user_data;
+    s_ui = (StatsUi *) g_object_get_data (G_OBJECT (window), "ui");
+
+    /* Close the window, free the screen data and block any secondary close signal */
+    g_signal_handler_block (window, s_ui->close_handler);
+
+    if (s_ui->timer_id != 0)
+	g_source_remove (s_ui->timer_id);
+
+    deregister_window(window);
+    gtk_window_close(GTK_WINDOW(window));
+
+    free(s_ui);
+
+    return;
+}
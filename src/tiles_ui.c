@@ -0,0 +1,741 @@
+/*
+**  Copyright (C) 2016 Anthony Buckley
+**
+**  This file is part of AstroCTC.
+**
+**  AstroCTC is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  AstroCTC is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with AstroCTC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+/*
+** Description: Camera tiles - view, record and snapshot other cameras (eg. guide or finder)
+**		alongside the main camera. Each tile has its own pipeline and engine state.
+**
+** Author:	Anthony Buckley
+**
+** History
+**	19-Oct-2026	Initial code
+**	19-Oct-2026	Recording tiles are ended (or left) rather than torn down
+**	19-Oct-2026	Capture is interactive (benchmark check)
+**
+*/
+
+
+/* Includes */
+
+#include <gtk/gtk.h>
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/videodev2.h>
+#include <main.h>
+#include <cam.h>
+#include <defs.h>
+
+
+/* Defines */
+
+#define TILE_COLS 2
+#define TILE_VWIDTH 480
+#define TILE_VHEIGHT 360
+#define TILE_DEF_FPS 30
+#define TILE_EOS_WAIT 10000000				// us for recordings to finish
+
+
+/* Types */
+
+typedef struct _tiles_ui
+{
+    GtkWidget *window;
+    GtkWidget *grid;
+    GtkWidget *cam_cbox;
+    GtkWidget *status;
+    GList *tiles;
+    int n;
+    CamData *main_cam;
+    MainUi *main_ui;
+    int close_handler;
+} TilesUi;
+
+typedef struct _cam_tile
+{
+    CamData cam_data;
+    MainUi m_ui;
+    GtkWidget *frame;
+    TilesUi *t_ui;
+} CamTile;
+
+
+/* Prototypes */
+
+int tiles_ui_main(GtkWidget *);
+TilesUi * new_tiles_ui();
+void tiles_ui(TilesUi *);
+void tiles_cam_list(TilesUi *);
+void tiles_layout(TilesUi *);
+int tiles_cam_used(char *);
+int tiles_recording();
+int tiles_close_all(int);
+CamTile * tile_new(TilesUi *, camera_t *);
+int tile_session(CamTile *);
+void tile_ui(CamTile *);
+void tile_close(CamTile *);
+void OnTileAdd(GtkWidget *, gpointer);
+void OnTileRealise(GtkWidget *, gpointer);
+void OnTileRecord(GtkWidget *, gpointer);
+void OnTileSnap(GtkWidget *, gpointer);
+void OnTileStop(GtkWidget *, gpointer);
+void OnTileClose(GtkWidget *, gpointer);
+gboolean OnTilesDelete(GtkWidget *, GdkEvent *, gpointer);
+void OnTilesClose(GtkWidget *, gpointer);
+
+extern void register_window(GtkWidget *);
+extern void deregister_window(GtkWidget *);
+extern int camera_setup(camera_t *, GtkWidget *);
+extern int get_cam_fmt(camera_t *, struct v4l2_format *, GtkWidget *, int);
+extern int get_cam_streamparm(camera_t *, struct v4l2_streamparm *, GtkWidget *, int);
+extern void pxl2fourcc(pixelfmt, char *);
+extern int calc_fps(pixelfmt, pixelfmt);
+extern int gst_view(CamData *, MainUi *);
+extern int gst_capture(CamData *, MainUi *, int, int, int);
+extern int cam_set_eos(CamData *, MainUi *);
+extern void capt_set_window(CamData *, guintptr);
+extern void cam_engine_close(CamData *, MainUi *);
+extern int live_snap_control(CamData *, MainUi *, int, int, int);
+extern void live_snap_cancel(CamData *);
+extern int title_empty(MainUi *);
+
+
+/* Globals */
+
+static const char *debug_hdr = "DEBUG-tiles_ui.c ";
+static TilesUi *tiles_ui_p = NULL;
+
+
+/* Display the camera tiles window */
+
+int tiles_ui_main(GtkWidget *window)
+{
+    TilesUi *ui;
+
+    /* Initial */
+    ui = new_tiles_ui();
+    ui->main_cam = g_object_get_data (G_OBJECT (window), "cam_data");
+    ui->main_ui = g_object_get_data (G_OBJECT (window), "ui");
+
+    /* Create the interface */
+    tiles_ui(ui);
+    tiles_cam_list(ui);
+    gtk_widget_show_all(ui->window);
+
+    /* Register the window */
+    register_window(ui->window);
+    tiles_ui_p = ui;
+
+    return TRUE;
+}
+
+
+/* Create new screen data variable */
+
+TilesUi * new_tiles_ui()
+{
+    TilesUi *ui = (TilesUi *) malloc(sizeof(TilesUi));
+    memset(ui, 0, sizeof(TilesUi));
+
+    return ui;
+}
+
+
+/* Create the user interface and set the CallBacks */
+
+void tiles_ui(TilesUi *t_ui)
+{
+    GtkWidget *label, *add_btn, *close_btn;
+    GtkWidget *main_vbox, *sel_box, *btn_box;
+
+    /* Set up the UI window */
+    t_ui->window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(t_ui->window), TILES_UI);
+    gtk_container_set_border_width(GTK_CONTAINER(t_ui->window), 10);
+    g_object_set_data (G_OBJECT (t_ui->window), "ui", t_ui);
+
+    /* Main view */
+    main_vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+
+    /* Camera selection */
+    sel_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    label = gtk_label_new("Camera");
+    gtk_widget_set_name(label, "lbl_6");
+    t_ui->cam_cbox = gtk_combo_box_text_new();
+    add_btn = gtk_button_new_with_label("  Add Tile  ");
+    g_signal_connect(add_btn, "clicked", G_CALLBACK(OnTileAdd), (gpointer) t_ui);
+    gtk_box_pack_start (GTK_BOX (sel_box), label, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (sel_box), t_ui->cam_cbox, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (sel_box), add_btn, FALSE, FALSE, 0);
+
+    /* Tiles */
+    t_ui->grid = gtk_grid_new();
+    gtk_grid_set_row_spacing(GTK_GRID (t_ui->grid), 10);
+    gtk_grid_set_column_spacing(GTK_GRID (t_ui->grid), 10);
+
+    /* Status */
+    t_ui->status = gtk_label_new("");
+    gtk_widget_set_name(t_ui->status, "lbl_8");
+    gtk_widget_set_halign(GTK_WIDGET (t_ui->status), GTK_ALIGN_START);
+
+    /* Close button */
+    btn_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 20);
+    gtk_widget_set_halign(GTK_WIDGET (btn_box), GTK_ALIGN_CENTER);
+    close_btn = gtk_button_new_with_label("  Close  ");
+    g_signal_connect_swapped(close_btn, "clicked", G_CALLBACK(gtk_window_close), (gpointer) t_ui->window);
+    gtk_box_pack_end (GTK_BOX (btn_box), close_btn, FALSE, FALSE, 0);
+
+    /* Combine everything onto the window */
+    gtk_box_pack_start (GTK_BOX (main_vbox), sel_box, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (main_vbox), t_ui->grid, TRUE, TRUE, 0);
+    gtk_box_pack_start (GTK_BOX (main_vbox), t_ui->status, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (main_vbox), btn_box, FALSE, FALSE, 0);
+    gtk_container_add(GTK_CONTAINER(t_ui->window), main_vbox);
+
+    /* Exit when window closed (not while a tile is recording) */
+    g_signal_connect(t_ui->window, "delete-event", G_CALLBACK(OnTilesDelete), t_ui);
+    t_ui->close_handler = g_signal_connect(t_ui->window, "destroy", G_CALLBACK(OnTilesClose), t_ui);
+
+    return;
+}
+
+
+/* Cameras available for a tile - not the main camera or one already tiled */
+
+void tiles_cam_list(TilesUi *t_ui)
+{
+    struct camlistNode *node;
+    camera_t *cam;
+
+    gtk_combo_box_text_remove_all (GTK_COMBO_BOX_TEXT (t_ui->cam_cbox));
+
+    for(node = t_ui->main_cam->camlist; node != NULL; node = node->next)
+    {
+	cam = node->cam;
+
+	if (strcmp(cam->video_dev, t_ui->main_cam->current_dev) == 0 || tiles_cam_used(cam->video_dev))
+	    continue;
+
+	gtk_combo_box_text_append (GTK_COMBO_BOX_TEXT (t_ui->cam_cbox), cam->video_dev, (char *) cam->vcaps.card);
+    }
+
+    gtk_combo_box_set_active (GTK_COMBO_BOX (t_ui->cam_cbox), 0);
+
+    return;
+}
+
+
+/* Place the tiles in rows of TILE_COLS */
+
+void tiles_layout(TilesUi *t_ui)
+{
+    GList *l;
+    CamTile *tile;
+    int i;
+
+    for(l = t_ui->tiles, i = 0; l != NULL; l = l->next, i++)
+    {
+	tile = (CamTile *) l->data;
+
+	if (gtk_widget_get_parent (tile->frame) != NULL)
+	    gtk_container_child_set (GTK_CONTAINER (t_ui->grid), tile->frame,
+				     "left-attach", i % TILE_COLS, "top-attach", i / TILE_COLS, NULL);
+	else
+	    gtk_grid_attach(GTK_GRID (t_ui->grid), tile->frame, i % TILE_COLS, i / TILE_COLS, 1, 1);
+    }
+
+    return;
+}
+
+
+/* Check if a camera is shown in a tile */
+
+int tiles_cam_used(char *dev)
+{
+    GList *l;
+    CamTile *tile;
+
+    if (tiles_ui_p == NULL)
+    	return FALSE;
+
+    for(l = tiles_ui_p->tiles; l != NULL; l = l->next)
+    {
+	tile = (CamTile *) l->data;
+
+	if (strcmp(tile->cam_data.current_dev, dev) == 0)
+	    return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+/* Check if any tile is recording */
+
+int tiles_recording()
+{
+    GList *l;
+
+    if (tiles_ui_p == NULL)
+    	return FALSE;
+
+    for(l = tiles_ui_p->tiles; l != NULL; l = l->next)
+    {
+	if (((CamTile *) l->data)->cam_data.mode == CAM_MODE_CAPT)
+	    return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+// Close all the tiles and the window (eg. the camera list is about to be rebuilt or the
+// application is closing). Done straight away as the tiles refer to the camera list.
+// A recording tile is never torn down: either FALSE is returned or, if asked (closing), the
+// recordings are ended and their files finalised first. Tiles still recording after
+// TILE_EOS_WAIT are left alone.
+
+int tiles_close_all(int stop_capt)
+{
+    GList *l;
+    CamTile *tile;
+    gint64 limit;
+
+    if (tiles_ui_p == NULL)
+    	return TRUE;
+
+    if (tiles_recording() == TRUE)
+    {
+	if (stop_capt == FALSE)
+	    return FALSE;
+
+	for(l = tiles_ui_p->tiles; l != NULL; l = l->next)
+	{
+	    tile = (CamTile *) l->data;
+
+	    if (tile->cam_data.mode == CAM_MODE_CAPT)
+		cam_set_eos(&(tile->cam_data), &(tile->m_ui));
+	}
+
+	/* The end of stream is handled on the main loop (bus watch) */
+	limit = g_get_monotonic_time () + TILE_EOS_WAIT;
+
+	while (tiles_recording() == TRUE && g_get_monotonic_time () < limit)
+	{
+	    if (gtk_events_pending ())
+		gtk_main_iteration ();
+	    else
+		g_usleep (10000);
+	}
+
+	if (tiles_recording() == TRUE)
+	    return FALSE;
+    }
+
+    if (tiles_ui_p != NULL)
+	gtk_widget_destroy (tiles_ui_p->window);
+
+    return TRUE;
+}
+
+
+/* Set up a new tile for a camera */
+
+CamTile * tile_new(TilesUi *t_ui, camera_t *cam)
+{
+    CamTile *tile;
+    CamData *cam_data;
+
+    tile = (CamTile *) malloc(sizeof(CamTile));
+    memset(tile, 0, sizeof(CamTile));
+    tile->t_ui = t_ui;
+
+    /* Camera details */
+    cam_data = &(tile->cam_data);
+    cam_data->camlist = t_ui->main_cam->camlist;
+    cam_data->cam = cam;
+    cam_data->inst = ++(t_ui->n);
+
+    strcpy(cam_data->current_cam, (char *) cam->vcaps.card);
+    strcpy(cam_data->current_dev, cam->video_dev);
+
+    memcpy(cam_data->current_cam_abbr, cam_data->current_cam, CAM_ABBR_SZ);
+    cam_data->current_cam_abbr[CAM_ABBR_SZ] = '\0';
+    memcpy(cam_data->current_dev_abbr, cam_data->current_dev, CAM_ABBR_SZ);
+    cam_data->current_dev_abbr[CAM_ABBR_SZ] = '\0';
+
+    if (camera_setup(cam, t_ui->window) == FALSE || tile_session(tile) == FALSE)
+    {
+	if (cam_data->sess != NULL)
+	    g_hash_table_destroy (cam_data->sess);
+
+	free(tile);
+	return NULL;
+    }
+
+    /* Interface */
+    tile_ui(tile);
+
+    return tile;
+}
+
+
+/* The format the camera is currently set to is used for the tile (not the session) */
+
+int tile_session(CamTile *tile)
+{
+    CamData *cam_data;
+    struct v4l2_format fmt;
+    struct v4l2_streamparm s_parm;
+    char fourcc[5];
+    int fps;
+
+    cam_data = &(tile->cam_data);
+    cam_data->sess = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    if (get_cam_fmt(cam_data->cam, &fmt, tile->t_ui->window, TRUE) == FALSE)
+    	return FALSE;
+
+    pxl2fourcc(fmt.fmt.pix.pixelformat, fourcc);
+    g_hash_table_insert (cam_data->sess, g_strdup (CLRFMT), g_strdup (fourcc));
+    g_hash_table_insert (cam_data->sess, g_strdup (RESOLUTION),
+    			 g_strdup_printf ("%d x %d", fmt.fmt.pix.width, fmt.fmt.pix.height));
+
+    /* Frame rate - not all cameras report one */
+    memset(&s_parm, 0, sizeof(s_parm));
+    s_parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fps = 0;
+
+    if (get_cam_streamparm(cam_data->cam, &s_parm, tile->t_ui->window, TRUE) == TRUE)
+    {
+	if (s_parm.parm.capture.timeperframe.numerator > 0 && s_parm.parm.capture.timeperframe.denominator > 0)
+	    fps = calc_fps(s_parm.parm.capture.timeperframe.denominator,
+			   s_parm.parm.capture.timeperframe.numerator);
+    }
+
+    g_hash_table_insert (cam_data->sess, g_strdup (FPS), g_strdup_printf ("%d", (fps > 0) ? fps : TILE_DEF_FPS));
+
+    return TRUE;
+}
+
+
+/* Tile widgets - the video area, title, buttons and a status line */
+
+void tile_ui(CamTile *tile)
+{
+    MainUi *m_ui;
+    TilesUi *t_ui;
+    GtkWidget *vbox, *btn_box, *close_btn;
+    char s[300];
+    const gchar *title;
+
+    m_ui = &(tile->m_ui);
+    t_ui = tile->t_ui;
+    m_ui->window = t_ui->window;
+    m_ui->clrfmt_negotiated = TRUE;
+
+    snprintf(s, sizeof(s), "%s (%s)", tile->cam_data.current_cam_abbr, tile->cam_data.current_dev_abbr);
+    tile->frame = gtk_frame_new(s);
+    vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_set_border_width(GTK_CONTAINER(vbox), 5);
+
+    /* Video area */
+    m_ui->video_window = gtk_drawing_area_new();
+    gtk_widget_set_size_request (m_ui->video_window, TILE_VWIDTH, TILE_VHEIGHT);
+    gtk_widget_set_halign (m_ui->video_window, GTK_ALIGN_CENTER);
+    gtk_widget_set_valign (m_ui->video_window, GTK_ALIGN_CENTER);
+
+    m_ui->scrollwin = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW (m_ui->scrollwin),
+    				   GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_container_add (GTK_CONTAINER (m_ui->scrollwin), m_ui->video_window);
+    gtk_scrolled_window_set_min_content_width (GTK_SCROLLED_WINDOW (m_ui->scrollwin), TILE_VWIDTH);
+    gtk_scrolled_window_set_min_content_height (GTK_SCROLLED_WINDOW (m_ui->scrollwin), TILE_VHEIGHT);
+
+    g_signal_connect (m_ui->video_window, "realize", G_CALLBACK (OnTileRealise), tile);
+
+    /* Object title - defaults to the main title and the camera */
+    m_ui->obj_title = gtk_entry_new();
+    title = gtk_entry_get_text (GTK_ENTRY (t_ui->main_ui->obj_title));
+
+    if (*title)
+    {
+	snprintf(s, sizeof(s), "%s_%s", title, tile->cam_data.current_cam_abbr);
+	gtk_entry_set_text (GTK_ENTRY (m_ui->obj_title), s);
+    }
+
+    /* Buttons */
+    btn_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    m_ui->cap_ui = gtk_button_new_with_label("Record");
+    m_ui->snap_ui = gtk_button_new_with_label("Snap");
+    m_ui->cap_stop = gtk_button_new_with_label("Stop");
+    close_btn = gtk_button_new_with_label("Close");
+    gtk_widget_set_sensitive (m_ui->cap_stop, FALSE);
+
+    g_signal_connect(m_ui->cap_ui, "clicked", G_CALLBACK(OnTileRecord), tile);
+    g_signal_connect(m_ui->snap_ui, "clicked", G_CALLBACK(OnTileSnap), tile);
+    g_signal_connect(m_ui->cap_stop, "clicked", G_CALLBACK(OnTileStop), tile);
+    g_signal_connect(close_btn, "clicked", G_CALLBACK(OnTileClose), tile);
+
+    gtk_box_pack_start (GTK_BOX (btn_box), m_ui->obj_title, TRUE, TRUE, 0);
+    gtk_box_pack_start (GTK_BOX (btn_box), m_ui->cap_ui, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (btn_box), m_ui->snap_ui, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (btn_box), m_ui->cap_stop, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (btn_box), close_btn, FALSE, FALSE, 0);
+
+    /* Status */
+    m_ui->status_info = gtk_label_new("");
+    gtk_widget_set_name(m_ui->status_info, "lbl_1");
+    gtk_widget_set_halign(GTK_WIDGET (m_ui->status_info), GTK_ALIGN_START);
+
+    gtk_box_pack_start (GTK_BOX (vbox), m_ui->scrollwin, TRUE, TRUE, 0);
+    gtk_box_pack_start (GTK_BOX (vbox), btn_box, FALSE, FALSE, 0);
+    gtk_box_pack_start (GTK_BOX (vbox), m_ui->status_info, FALSE, FALSE, 0);
+    gtk_container_add(GTK_CONTAINER(tile->frame), vbox);
+
+    return;
+}
+
+
+/* Stop the camera and remove the tile */
+
+void tile_close(CamTile *tile)
+{
+    TilesUi *t_ui;
+
+    t_ui = tile->t_ui;
+
+    cam_engine_close(&(tile->cam_data), &(tile->m_ui));
+    g_hash_table_destroy (tile->cam_data.sess);
+
+    t_ui->tiles = g_list_remove (t_ui->tiles, tile);
+
+    if (tile->frame != NULL && gtk_widget_in_destruction (tile->frame) == FALSE)
+	gtk_widget_destroy (tile->frame);
+
+    free(tile);
+
+    return;
+}
+
+
+/* Callback - Add a tile for the selected camera */
+
+void OnTileAdd(GtkWidget *btn, gpointer user_data)
+{
+    TilesUi *t_ui;
+    CamTile *tile;
+    struct camlistNode *node;
+    const gchar *dev;
+
+    /* Get data */
+    t_ui = (TilesUi *) user_data;
+
+    if ((dev = gtk_combo_box_get_active_id (GTK_COMBO_BOX (t_ui->cam_cbox))) == NULL)
+    {
+	gtk_label_set_text (GTK_LABEL (t_ui->status), "No other camera available");
+    	return;
+    }
+
+    /* The main camera may have changed since the list was set */
+    if (strcmp(dev, t_ui->main_cam->current_dev) == 0)
+    {
+	gtk_label_set_text (GTK_LABEL (t_ui->status), "This camera is the main camera");
+	tiles_cam_list(t_ui);
+    	return;
+    }
+
+    for(node = t_ui->main_cam->camlist; node != NULL; node = node->next)
+    {
+	if (strcmp(node->cam->video_dev, dev) == 0)
+	    break;
+    }
+
+    if (node == NULL)
+    	return;
+
+    /* New tile, the pipeline starts when the video area is realised */
+    if ((tile = tile_new(t_ui, node->cam)) == NULL)
+    {
+	gtk_label_set_text (GTK_LABEL (t_ui->status), "Camera could not be set up");
+    	return;
+    }
+
+    t_ui->tiles = g_list_append (t_ui->tiles, tile);
+    tiles_layout(t_ui);
+    tiles_cam_list(t_ui);
+    gtk_label_set_text (GTK_LABEL (t_ui->status), "");
+    gtk_widget_show_all (tile->frame);
+
+    return;
+}
+
+
+/* Callback - Tile video area realised, start viewing */
+
+void OnTileRealise(GtkWidget *widget, gpointer user_data)
+{
+    CamTile *tile;
+    GdkWindow *window = gtk_widget_get_window (widget);
+
+    tile = (CamTile *) user_data;
+
+    if (!gdk_window_ensure_native (window))
+    {
+	gtk_label_set_text (GTK_LABEL (tile->m_ui.status_info), "No native window for the video");
+    	return;
+    }
+
+#if defined (GDK_WINDOWING_X11)
+    capt_set_window(&(tile->cam_data), (guintptr) GDK_WINDOW_XID (window));
+#endif
+
+    gst_view(&(tile->cam_data), &(tile->m_ui));
+
+    return;
+}
+
+
+/* Callback - Record until stopped */
+
+void OnTileRecord(GtkWidget *btn, gpointer user_data)
+{
+    CamTile *tile;
+
+    tile = (CamTile *) user_data;
+
+    if (tile->cam_data.mode != CAM_MODE_VIEW)
+    	return;
+
+    if (title_empty(&(tile->m_ui)) == FALSE)
+    	return;
+
+    gst_capture(&(tile->cam_data), &(tile->m_ui), 0, 0, TRUE);
+
+    return;
+}
+
+
+/* Callback - Snapshot from the running pipeline */
+
+void OnTileSnap(GtkWidget *btn, gpointer user_data)
+{
+    CamTile *tile;
+
+    tile = (CamTile *) user_data;
+
+    if (tile->cam_data.pipeline == NULL)
+    	return;
+
+    if (title_empty(&(tile->m_ui)) == FALSE)
+    	return;
+
+    live_snap_control(&(tile->cam_data), &(tile->m_ui), 1, -1, 0);
+
+    return;
+}
+
+
+/* Callback - Stop recording or snapshots */
+
+void OnTileStop(GtkWidget *btn, gpointer user_data)
+{
+    CamTile *tile;
+
+    tile = (CamTile *) user_data;
+
+    if (tile->cam_data.mode == CAM_MODE_CAPT)
+	cam_set_eos(&(tile->cam_data), &(tile->m_ui));
+    else
+	live_snap_cancel(&(tile->cam_data));
+
+    return;
+}
+
+
+/* Callback - Close a tile (not while recording) */
+
+void OnTileClose(GtkWidget *btn, gpointer user_data)
+{
+    CamTile *tile;
+    TilesUi *t_ui;
+
+    tile = (CamTile *) user_data;
+    t_ui = tile->t_ui;
+
+    if (tile->cam_data.mode == CAM_MODE_CAPT)
+    {
+	gtk_label_set_text (GTK_LABEL (tile->m_ui.status_info), "Please stop recording first");
+    	return;
+    }
+
+    tile_close(tile);
+    tiles_layout(t_ui);
+    tiles_cam_list(t_ui);
+
+    return;
+}
+
+
+/* Callback - Window close requested, keep it open while a tile is recording */
+
+gboolean OnTilesDelete(GtkWidget *window, GdkEvent *ev, gpointer user_data)
+{
+    TilesUi *t_ui;
+    GList *l;
+
+    t_ui = (TilesUi *) user_data;
+
+    for(l = t_ui->tiles; l != NULL; l = l->next)
+    {
+	if (((CamTile *) l->data)->cam_data.mode == CAM_MODE_CAPT)
+	{
+	    gtk_label_set_text (GTK_LABEL (t_ui->status), "Please stop recording first");
+	    return TRUE;
+	}
+    }
+
+    return FALSE;
+}
+
+
+// Callback for window close. All the tiles are stopped first - a tile still stopping a
+// recording keeps its engine state (see cam_engine_close).
+
+void OnTilesClose(GtkWidget *window, gpointer user_data)
+{
+    TilesUi *ui;
+
+    ui = (TilesUi *) user_data;
+
+    while(ui->tiles != NULL)
+	tile_close((CamTile *) ui->tiles->data);
+
+    deregister_window(ui->window);
+    tiles_ui_p = NULL;
+    free(ui);
+
+    return;
+}
@@ -31,6 +31,24 @@
 **
 ** History
 **	08-Jan-2014	Initial code
+**	19-Oct-2026	Benchmark message
+**	19-Oct-2026	Pipeline statistics in the video meta data
+**	19-Oct-2026	Driver frame sequence and timing checks
+**	19-Oct-2026	Locked (huge page) memory for RAM staged capture
+**	19-Oct-2026	Capture sequence message
+**	19-Oct-2026	Format values for cameras other than the main one
+**	19-Oct-2026	Camera tile in use message
+**	19-Oct-2026	RAM and frame check functions moved to capt_util.c (engine library)
+**	19-Oct-2026	Processing stages message
+**	19-Oct-2026	Frame output message
+**	19-Oct-2026	Capability cache message
+**	19-Oct-2026	Camera probe time out message
+**	19-Oct-2026	Camera hotplug messages
+**	19-Oct-2026	Message count taken from the table
+**	19-Oct-2026	Tile recording message
+**	19-Oct-2026	Benchmark warning message (no prompt)
+**	19-Oct-2026	Control key buffers sized for every control id
+**	19-Oct-2026	Snapshot camera message
 **
 */
 
@@ -50,6 +68,7 @@
 #include <ctype.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <errno.h>
 #include <time.h>
 #include <session.h>
@@ -71,6 +90,7 @@ int read_saved_session(char *);
 int save_session(char *);
 int set_session(char*, char*);
 void get_session(char*, char**);
+void cam_session(CamData *, char*, char**);
 void get_session_reset(char*, char**);
 void free_session();
 void match_session(char *, char *, int, int *);
@@ -110,11 +130,13 @@ void common_meta(FILE *, const gchar *, char *, char *);
 void settings_meta(FILE *, CamData *);
 void debug_session();
 
+extern void frame_chk_meta(FILE *, frame_chk_t *);
 extern int find_ctl(camera_t *, char *);
 extern void get_file_name(char *, int, char *, char *, char *, char, char, char);
 extern struct v4l2_queryctrl * get_next_ctrl(int);
 extern struct v4l2_list * get_next_oth_ctrl(struct v4l2_list *, CamData *);
 extern void session_ctrl_val(struct v4l2_queryctrl *, char *, long *);
+extern void stats_meta(FILE *);
 
 
 /* Globals */
@@ -150,13 +172,28 @@ static const char *app_messages[][2] =
     { "CAM0030", "Caps negotiation problem. Caps set to %s. "},
     { "CAM0031", "Unknown or error 'fourcc' colour format found: %s. "},
     { "CAM0032", "Failed to match negotiated colour format: %s. "},
+    { "CAM0033", "%s processing stages could not be created and are ignored. "},
+    { "CAM0034", "%s frame output is not available (missing element). "},
+    { "CAM0035", "Camera details for %s have changed, the new details are used when it is next selected. "},
+    { "CAM0036", "Camera %s did not respond in time and is not listed (try Reload Cameras). "},
+    { "CAM0037", "Camera hotplug is not available, unable to watch %s. "},
+    { "CAM0038", "Camera %s connected. "},
+    { "CAM0039", "Camera %s disconnected, waiting for it to return. "},
     { "CAM0040", "The camera / driver does not support %s. "},
+    { "CAM0041", "Camera %s reconnected, session settings restored. "},
+    { "CAM0042", "Camera %s removed. "},
     { "APP0001", "Error: Filename may have only one Prefix, Mid or Suffix. "},
     { "APP0002", "Error: %s has an invalid value. "},
     { "APP0003", "Error: Please enter a value for %s. "},
     { "APP0004", "Error: %s is not unique. "},
     { "APP0005", "Debug: %s. "},
     { "APP0006", "Error: Capture location %s does not exist. Please create and retry. "},
+    { "APP0007", "Encoder benchmark error: %s. "},
+    { "APP0008", "Capture sequence error: %s. "},
+    { "APP0009", "Camera %s is shown in a camera tile, please close the tile first. "},
+    { "APP0010", "A camera tile is recording, please stop it first. "},
+    { "APP0011", "Encoder benchmark: %s "},
+    { "APP0012", "Snapshots from camera %s are only taken while it is viewing. "},
     { "SYS9000", "Failed to start application. "},
     { "SYS9001", "Failed to read $HOME variable. "},
     { "SYS9002", "Failed to create Application directory: %s "},
@@ -183,7 +220,7 @@ static const char *app_messages[][2] =
     { "UKN9999", "Error - Unknown error message given. "}			// NB - MUST be last
 };
 
-static const int Msg_Count = 58;
+static const int Msg_Count = sizeof(app_messages) / sizeof(app_messages[0]);
 static char *Home;
 static char *logfile = NULL;
 static char *app_dir;
@@ -637,6 +674,22 @@ void get_session(char *key, char **val)
 }
 
 
+/* Session value for a camera - a camera tile keeps its own format values */
+
+void cam_session(CamData *cam_data, char *key, char **val)
+{
+    if (cam_data != NULL && cam_data->sess != NULL)
+    {
+	if ((*val = (char *) g_hash_table_lookup (cam_data->sess, key)) != NULL)
+	    return;
+    }
+
+    get_session(key, val);
+
+    return;
+}
+
+
 /* Return a pointer to a session reset value for a key or NULL */
 
 void get_session_reset(char *key, char **val)
@@ -823,6 +876,12 @@ void video_meta(FILE *mf, CamData *cam_data)
 
     fputs(s, mf);
 
+    /* Driver frame checks */
+    frame_chk_meta(mf, &(cam_data->u.v_capt.fchk));
+
+    /* Per element statistics */
+    stats_meta(mf);
+
     return;
 }
 
@@ -868,6 +927,9 @@ void snap_meta(FILE *mf, CamData *cam_data)
     snprintf(s, max_s, "Frames delivered: %ld\n", cam_data->u.s_capt.snap_count);
     fputs(s, mf);
 
+    /* Driver frame checks */
+    frame_chk_meta(mf, &(cam_data->u.s_capt.fchk));
+
     return;
 }
 
@@ -904,7 +966,7 @@ void settings_meta(FILE *mf, CamData *cam_data)
 {
     int init;
     long ctl_val;
-    char ctl_key[10];
+    char ctl_key[CTL_KEY_SZ];
     char s[100];
     char *p;
     struct v4l2_queryctrl *qctrl;
@@ -913,25 +975,32 @@ void settings_meta(FILE *mf, CamData *cam_data)
     fputs("\nVIDEO FORMAT\n", mf);
 
     /* Video format */
-    get_session(CLRFMT, &p);
+    cam_session(cam_data, CLRFMT, &p);
     fputs("Video format: ", mf);
     fputs(p, mf);
     fputs("\n", mf);
 
     /* Resolution */
-    get_session(RESOLUTION, &p);
+    cam_session(cam_data, RESOLUTION, &p);
     fputs("Resolution: ", mf);
     fputs(p, mf);
     fputs("\n", mf);
 
     /* Frame rate */
-    get_session(FPS, &p);
+    cam_session(cam_data, FPS, &p);
     fputs("Frame rate: ", mf);
     fputs(p, mf);
     fputs("\n", mf);
 
-    /* Controls */
+    /* Controls (the session only has the main camera values) */
     fputs("\nCONTROLS\n", mf);
+
+    if (cam_data->inst != 0)
+    {
+	fputs("As set on the camera (not managed for a camera tile)\n", mf);
+	return;
+    }
+
     init = TRUE;
     last = NULL;
 